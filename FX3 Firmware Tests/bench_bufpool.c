@@ -0,0 +1,243 @@
+/*
+ ## bench_bufpool: allocation latency and fragmentation of the DMA buffer heap
+ ## ===========================
+ ##
+ ##  Latency: one 16 KB DMA buffer is allocated and freed repeatedly, from the
+ ##  bitmap allocator and from a CyU3PDmaBufferPoolCreate pool, with the heap
+ ##  0 %, 50 % and 90 % occupied by 1 KB buffers. The bitmap allocator scans
+ ##  the status bits from the start of the heap, so its cost grows with the
+ ##  occupancy; the pool does not depend on it. A failed allocation prints -1. Times are host ns per call and only compare the two paths;
+ ##  the firmware runs the same code on a 201.6 MHz ARM926.
+ ##
+ ##  Fragmentation: a seeded random mix of 1 KB..16 KB buffers is allocated
+ ##  and freed until the heap is under pressure, once with the 16 KB buffers
+ ##  from the bitmap allocator and once from a pool, and the failed
+ ##  allocations, free bytes and the largest buffer that still fits are
+ ##  reported. Fragmentation is 1 - largest / free.
+ ##
+ ##  Usage: bench_bufpool [-n iterations] [-s seed]
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "cyu3os.h"
+#include "cyfxmemmap.h"
+
+#define BIG_BUF_BYTES           (16 * 1024)
+#define FILL_BUF_BYTES          (1024)
+#define FILL_BUF_MAX            (CY_U3P_BUFFER_HEAP_SIZE / FILL_BUF_BYTES)
+#define POOL_COUNT              (4)
+#define FRAG_LIVE_MAX           (256)
+
+static const uint16_t frag_sizes[] = { 1024, 2048, 4096, 8192, BIG_BUF_BYTES };
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Small LCG, so that runs with the same seed are identical everywhere */
+static uint32_t rand_next(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/* Free space of the bitmap: zero bits are free 32 byte chunks. A run of n
+ * free chunks holds a buffer of n - 1 chunks, the first one separates it from
+ * the buffer before. */
+static void heap_free_space(uint32_t *free_p, uint32_t *largest_p)
+{
+    uint32_t chunk, run = 0, longest = 0, zeros = 0;
+    uint32_t chunks = CY_U3P_BUFFER_HEAP_SIZE / 32;
+
+    for (chunk = 0; chunk < chunks; chunk++)
+    {
+        if ((glBufferManager.usedStatus[chunk >> 5] & (1u << (chunk & 31))) == 0)
+        {
+            zeros++;
+            run++;
+            if (run > longest)
+                longest = run;
+        }
+        else
+            run = 0;
+    }
+    *free_p = zeros * 32;
+    *largest_p = (longest > 1) ? (longest - 1) * 32 : 0;
+}
+
+/* Occupy percent of the heap with 1 KB buffers from its start, so that the
+ * bitmap allocator has to scan past them to the free space at the end. Stops
+ * early if the heap is full. */
+static unsigned heap_fill(uint8_t **fill, unsigned percent)
+{
+    unsigned want = CY_U3P_BUFFER_HEAP_SIZE / 100 * percent / (FILL_BUF_BYTES + 32);
+    unsigned n = 0;
+
+    while ((n < want) && ((fill[n] = CyU3PDmaBufferAlloc(FILL_BUF_BYTES)) != NULL))
+        n++;
+    return n;
+}
+
+static void heap_empty(uint8_t **fill, unsigned n)
+{
+    while (n != 0)
+        CyU3PDmaBufferFree(fill[--n]);
+}
+
+static double time_alloc_free(unsigned iterations, double *free_ns)
+{
+    double t0, alloc = 0, release = 0;
+    uint8_t *buf;
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+    {
+        t0 = now_ns();
+        buf = CyU3PDmaBufferAlloc(BIG_BUF_BYTES);
+        alloc += now_ns() - t0;
+        if (buf == NULL)
+        {
+            *free_ns = -1;
+            return -1;
+        }
+        t0 = now_ns();
+        CyU3PDmaBufferFree(buf);
+        release += now_ns() - t0;
+    }
+    *free_ns = release / iterations;
+    return alloc / iterations;
+}
+
+static void bench_latency(unsigned iterations)
+{
+    static const unsigned levels[] = { 0, 50, 90 };
+    uint8_t *fill[FILL_BUF_MAX];
+    double bitmap_alloc, bitmap_free, pool_alloc, pool_free;
+    unsigned i, n;
+
+    printf("Latency of a %u byte buffer, ns per call (%u iterations)\n", BIG_BUF_BYTES, iterations);
+    printf("  occupied   bitmap alloc/free      pool alloc/free\n");
+    for (i = 0; i < sizeof(levels) / sizeof(levels[0]); i++)
+    {
+        n = heap_fill(fill, levels[i]);
+        bitmap_alloc = time_alloc_free(iterations, &bitmap_free);
+        heap_empty(fill, n);
+
+        /* The pool is created first, as the firmware does; the fill then takes
+         * what is left. */
+        if (CyU3PDmaBufferPoolCreate(BIG_BUF_BYTES, POOL_COUNT) != CY_U3P_SUCCESS)
+        {
+            fprintf(stderr, "Creating the pool failed\n");
+            return;
+        }
+        n = heap_fill(fill, levels[i]);
+        pool_alloc = time_alloc_free(iterations, &pool_free);
+        heap_empty(fill, n);
+        CyU3PDmaBufferPoolDestroy(BIG_BUF_BYTES);
+
+        printf("  %5u %%   %8.1f / %-8.1f     %8.1f / %-8.1f\n", levels[i],
+                bitmap_alloc, bitmap_free, pool_alloc, pool_free);
+    }
+}
+
+static void bench_fragmentation(unsigned iterations, uint32_t seed, int use_pool)
+{
+    uint8_t *live[FRAG_LIVE_MAX];
+    unsigned n = 0, i, failed = 0, failed_big = 0, allocs = 0;
+    uint32_t state = seed, r, free_bytes, largest, size;
+
+    if (use_pool && (CyU3PDmaBufferPoolCreate(BIG_BUF_BYTES, POOL_COUNT) != CY_U3P_SUCCESS))
+    {
+        fprintf(stderr, "Creating the pool failed\n");
+        return;
+    }
+
+    /* Allocate a little more often than free, so the heap fills up and stays
+     * under pressure. */
+    for (i = 0; i < iterations; i++)
+    {
+        r = rand_next(&state);
+        if ((n == 0) || ((n < FRAG_LIVE_MAX) && (r % 100 < 55)))
+        {
+            size = frag_sizes[rand_next(&state) % (sizeof(frag_sizes) / sizeof(frag_sizes[0]))];
+            allocs++;
+            live[n] = CyU3PDmaBufferAlloc((uint16_t) size);
+            if (live[n] != NULL)
+                n++;
+            else
+            {
+                failed++;
+                if (size == BIG_BUF_BYTES)
+                    failed_big++;
+            }
+        }
+        else
+        {
+            r = rand_next(&state) % n;
+            CyU3PDmaBufferFree(live[r]);
+            live[r] = live[--n];
+        }
+    }
+
+    heap_free_space(&free_bytes, &largest);
+    printf("  %-7s %6u allocs %6u failed (%5u of 16 KB)  free %6u  largest %6u  fragmentation %.2f\n",
+            use_pool ? "pool" : "bitmap", allocs, failed, failed_big, free_bytes, largest,
+            free_bytes ? 1.0 - (double) largest / free_bytes : 0.0);
+
+    while (n != 0)
+        CyU3PDmaBufferFree(live[--n]);
+    if (use_pool)
+        CyU3PDmaBufferPoolDestroy(BIG_BUF_BYTES);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned iterations = 100000;
+    uint32_t seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            iterations = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t) strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n iterations] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    if (fx3_ram_map() != 0)
+    {
+        fprintf(stderr, "Mapping the FX3 RAM at 0x40000000 failed\n");
+        return 1;
+    }
+    CyU3PMemInit();
+    CyU3PDmaBufferInit();
+
+    bench_latency(iterations);
+    printf("Fragmentation after %u random operations (seed %u, free space in bytes)\n",
+            iterations, seed);
+    bench_fragmentation(iterations, seed, 0);
+    bench_fragmentation(iterations, seed, 1);
+
+    CyU3PDmaBufferDeInit();
+    CyU3PFreeHeaps();
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ ## fx3sdkstub: host implementation of the RTOS services used by cyfxtx.c
+ ## ===========================
+ ##
+ ##  Single threaded stand-ins with enough bookkeeping for the tests: the byte
+ ##  pool hands out malloc memory but refuses requests beyond its size and
+ ##  counts the bytes in use, block pools keep a free stack over the memory
+ ##  they are given, and mutexes count how often they are held. The FX3 RAM
+ ##  is mapped at its own address so that the buffer heap addresses the buffer
+ ##  manager computes in 32 bits are valid pointers.
+ ## ===========================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "cyu3host.h"
+
+#define STUB_RAM_BASE           (0x40000000UL)
+#define STUB_RAM_SIZE           (512 * 1024UL)
+#define STUB_BLOCK_OVERHEAD     (4)         /* CY_U3P_MEM_BLOCK_OVERHEAD of cyfxtx.c */
+#define STUB_BLOCK_POOLS        (8)
+
+/* Byte pool allocations carry their size in front */
+typedef struct stub_byte_header
+{
+    uint32_t size;
+    uint32_t pad[3];
+} stub_byte_header;
+
+typedef struct stub_block_pool
+{
+    uint8_t *start_p;
+    uint32_t stride;
+    uint32_t count;
+    uint32_t free_count;
+    uint32_t *free_p;           /* Stack of free block indices */
+} stub_block_pool;
+
+static CyU3PThread stub_thread;
+static stub_block_pool stub_blocks[STUB_BLOCK_POOLS];
+static uint32_t stub_byte_size;
+static uint32_t stub_byte_used;
+static int stub_mutex_held;
+
+int fx3_ram_map(void)
+{
+    void *ram;
+
+    ram = mmap((void *) STUB_RAM_BASE, STUB_RAM_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ram == MAP_FAILED)
+        return -1;
+    if (ram != (void *) STUB_RAM_BASE)
+    {
+        munmap(ram, STUB_RAM_SIZE);
+        return -1;
+    }
+    return 0;
+}
+
+uint32_t fx3_byte_pool_used(void)
+{
+    return stub_byte_used;
+}
+
+int fx3_mutex_held(void)
+{
+    return stub_mutex_held;
+}
+
+void CyU3PApplicationDefine(void)
+{
+}
+
+CyU3PThread *CyU3PThreadIdentify(void)
+{
+    return &stub_thread;
+}
+
+uint32_t CyU3PVicDisableAllInterrupts(void)
+{
+    return 0;
+}
+
+void CyU3PVicEnableInterrupts(uint32_t mask)
+{
+    (void) mask;
+}
+
+uint32_t CyU3PMutexCreate(CyU3PMutex *mutex_p, uint32_t priorityInherit)
+{
+    (void) priorityInherit;
+    mutex_p->created = 1;
+    mutex_p->owned = 0;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PMutexDestroy(CyU3PMutex *mutex_p)
+{
+    if (!mutex_p->created)
+        return CY_U3P_ERROR_MUTEX_FAILURE;
+    mutex_p->created = 0;
+    return CY_U3P_SUCCESS;
+}
+
+/* Single threaded: a held mutex would block forever, so taking it twice is a
+ * failure (a timeout on the device). */
+uint32_t CyU3PMutexGet(CyU3PMutex *mutex_p, uint32_t waitOption)
+{
+    (void) waitOption;
+    if (!mutex_p->created || mutex_p->owned)
+        return CY_U3P_ERROR_MUTEX_FAILURE;
+    mutex_p->owned = 1;
+    stub_mutex_held++;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PMutexPut(CyU3PMutex *mutex_p)
+{
+    if (!mutex_p->created || !mutex_p->owned)
+        return CY_U3P_ERROR_MUTEX_FAILURE;
+    mutex_p->owned = 0;
+    stub_mutex_held--;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PBytePoolCreate(CyU3PBytePool *pool_p, void *poolStart, uint32_t poolSize)
+{
+    (void) poolStart;
+    pool_p->created = 1;
+    stub_byte_size = poolSize;
+    stub_byte_used = 0;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PBytePoolDestroy(CyU3PBytePool *pool_p)
+{
+    pool_p->created = 0;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PByteAlloc(CyU3PBytePool *pool_p, void **mem_p, uint32_t memSize,
+        uint32_t waitOption)
+{
+    stub_byte_header *hdr_p;
+
+    (void) waitOption;
+    if (!pool_p->created || (memSize == 0) || (memSize > stub_byte_size - stub_byte_used))
+        return CY_U3P_ERROR_MEMORY_ERROR;
+    hdr_p = malloc(sizeof(stub_byte_header) + memSize);
+    if (hdr_p == NULL)
+        return CY_U3P_ERROR_MEMORY_ERROR;
+    hdr_p->size = memSize;
+    stub_byte_used += memSize;
+    *mem_p = hdr_p + 1;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PByteFree(void *mem_p)
+{
+    stub_byte_header *hdr_p = (stub_byte_header *) mem_p - 1;
+
+    if (mem_p == NULL)
+        return CY_U3P_ERROR_NULL_POINTER;
+    stub_byte_used -= hdr_p->size;
+    free(hdr_p);
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PBlockPoolCreate(CyU3PBlockPool *pool_p, uint32_t blockSize,
+        void *poolStart, uint32_t poolSize)
+{
+    stub_block_pool *blk_p;
+    uint32_t i;
+
+    for (i = 0; i < STUB_BLOCK_POOLS; i++)
+        if (stub_blocks[i].start_p == NULL)
+            break;
+    if ((i == STUB_BLOCK_POOLS) || (blockSize == 0))
+        return CY_U3P_ERROR_MEMORY_ERROR;
+
+    blk_p = &stub_blocks[i];
+    blk_p->stride = blockSize + STUB_BLOCK_OVERHEAD;
+    blk_p->count = poolSize / blk_p->stride;
+    blk_p->free_p = malloc(blk_p->count * sizeof(uint32_t));
+    if ((blk_p->count == 0) || (blk_p->free_p == NULL))
+    {
+        free(blk_p->free_p);
+        memset(blk_p, 0, sizeof(*blk_p));
+        return CY_U3P_ERROR_MEMORY_ERROR;
+    }
+    blk_p->start_p = poolStart;
+    for (blk_p->free_count = 0; blk_p->free_count < blk_p->count; blk_p->free_count++)
+        blk_p->free_p[blk_p->free_count] = blk_p->count - 1 - blk_p->free_count;
+
+    pool_p->created = 1;
+    pool_p->index = (int) i;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PBlockPoolDestroy(CyU3PBlockPool *pool_p)
+{
+    if (!pool_p->created)
+        return CY_U3P_ERROR_FAILURE;
+    free(stub_blocks[pool_p->index].free_p);
+    memset(&stub_blocks[pool_p->index], 0, sizeof(stub_block_pool));
+    pool_p->created = 0;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PBlockAlloc(CyU3PBlockPool *pool_p, void **block_p, uint32_t waitOption)
+{
+    stub_block_pool *blk_p;
+
+    (void) waitOption;
+    if (!pool_p->created)
+        return CY_U3P_ERROR_FAILURE;
+    blk_p = &stub_blocks[pool_p->index];
+    if (blk_p->free_count == 0)
+        return CY_U3P_ERROR_MEMORY_ERROR;
+    blk_p->free_count--;
+    *block_p = blk_p->start_p + blk_p->free_p[blk_p->free_count] * blk_p->stride
+            + STUB_BLOCK_OVERHEAD;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t CyU3PBlockFree(void *block_p)
+{
+    stub_block_pool *blk_p;
+    uint8_t *p = (uint8_t *) block_p - STUB_BLOCK_OVERHEAD;
+    uint32_t i;
+
+    for (i = 0; i < STUB_BLOCK_POOLS; i++)
+    {
+        blk_p = &stub_blocks[i];
+        if ((blk_p->start_p != NULL) && (p >= blk_p->start_p)
+                && (p < blk_p->start_p + blk_p->count * blk_p->stride))
+        {
+            blk_p->free_p[blk_p->free_count++] = (uint32_t) ((p - blk_p->start_p) / blk_p->stride);
+            return CY_U3P_SUCCESS;
+        }
+    }
+    return CY_U3P_ERROR_FAILURE;
+}
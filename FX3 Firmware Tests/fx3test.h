@@ -0,0 +1,36 @@
+/*
+ ## Minimal check macros for the firmware host tests
+ ## ===========================
+ ##
+ ##  CHECK records a failure with its location and carries on, so that one run
+ ##  reports every broken case. A test program returns fx3_test_result().
+ ## ===========================
+ */
+
+#ifndef _INCLUDED_FX3TEST_H_
+#define _INCLUDED_FX3TEST_H_
+
+#include <stdio.h>
+
+static unsigned long fx3_test_checks;
+static unsigned long fx3_test_failures;
+
+#define CHECK(cond) \
+    do \
+    { \
+        fx3_test_checks++; \
+        if (!(cond)) \
+        { \
+            fx3_test_failures++; \
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #cond); \
+        } \
+    } while (0)
+
+/* Print the summary line; returns the process exit status. */
+static inline int fx3_test_result(const char *name)
+{
+    printf("%s: %lu checks, %lu failed\n", name, fx3_test_checks, fx3_test_failures);
+    return (fx3_test_failures == 0) ? 0 : 1;
+}
+
+#endif /* _INCLUDED_FX3TEST_H_ */
@@ -0,0 +1,152 @@
+/*
+ ## Host stand-in for the parts of the FX3 SDK used by the host tests
+ ## ===========================
+ ##
+ ##  Only the types, constants and RTOS services that cyfxtx.c and the
+ ##  constants of cyfxslfifosync.h need, with the values of the SDK. The other
+ ##  headers in this directory include this file, so the firmware sources
+ ##  compile unchanged. The services are implemented in fx3sdkstub.c.
+ ## ===========================
+ */
+
+#ifndef _INCLUDED_CYU3HOST_H_
+#define _INCLUDED_CYU3HOST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int CyBool_t;
+#define CyTrue                          (1)
+#define CyFalse                         (0)
+
+#define CY_U3P_GET_LSB(w)               ((uint8_t) ((w) & 0xFF))
+#define CY_U3P_GET_MSB(w)               ((uint8_t) ((w) >> 8))
+#define CY_U3P_MAKEWORD(u, l)           ((uint16_t) (((u) << 8) | (l)))
+
+typedef uint32_t CyU3PReturnStatus_t;
+#define CY_U3P_SUCCESS                  (0x00)
+#define CY_U3P_ERROR_BAD_ARGUMENT       (0x40)
+#define CY_U3P_ERROR_NULL_POINTER       (0x41)
+#define CY_U3P_ERROR_MEMORY_ERROR       (0x44)
+#define CY_U3P_ERROR_TIMEOUT            (0x45)
+#define CY_U3P_ERROR_FAILURE            (0x46)
+#define CY_U3P_ERROR_MUTEX_FAILURE      (0x47)
+#define CY_U3P_ERROR_INVALID_SEQUENCE   (0x48)
+#define CY_U3P_ERROR_ALREADY_STARTED    (0x4C)
+
+/* USB constants, as in cyu3usbconst.h */
+typedef enum CyU3PUSBSpeed_t
+{
+    CY_U3P_NOT_CONNECTED = 0,
+    CY_U3P_FULL_SPEED,
+    CY_U3P_HIGH_SPEED,
+    CY_U3P_SUPER_SPEED
+} CyU3PUSBSpeed_t;
+
+#define CY_U3P_USB_DEVICE_DESCR         (0x01)
+#define CY_U3P_USB_CONFIG_DESCR         (0x02)
+#define CY_U3P_USB_STRING_DESCR         (0x03)
+#define CY_U3P_USB_INTRFC_DESCR         (0x04)
+#define CY_U3P_USB_ENDPNT_DESCR         (0x05)
+#define CY_U3P_USB_DEVQUAL_DESCR        (0x06)
+#define CY_U3P_BOS_DESCR                (0x0F)
+#define CY_U3P_DEVICE_CAPB_DESCR        (0x10)
+#define CY_U3P_SS_EP_COMPN_DESCR        (0x30)
+#define CY_U3P_USB2_EXTN_CAPB_TYPE      (0x02)
+#define CY_U3P_SS_USB_CAPB_TYPE         (0x03)
+#define CY_U3P_USB_EP_BULK              (0x02)
+
+#define CYU3P_NO_WAIT                   (0)
+#define CYU3P_WAIT_FOREVER              (0xFFFFFFFF)
+#define CYU3P_NO_INHERIT                (0)
+#define CYU3P_INHERIT                   (1)
+
+typedef struct CyU3PMutex
+{
+    int created;
+    int owned;
+} CyU3PMutex;
+
+typedef struct CyU3PBytePool
+{
+    int created;
+} CyU3PBytePool;
+
+typedef struct CyU3PBlockPool
+{
+    int created;
+    int index;                  /* Slot in the block pool table of fx3sdkstub.c */
+} CyU3PBlockPool;
+
+typedef struct CyU3PThread
+{
+    int unused;
+} CyU3PThread;
+
+/* Buffer manager state, as in cyu3os.h */
+typedef struct CyU3PDmaBufMgr_t
+{
+    CyU3PMutex lock;
+    uint32_t   startAddr;
+    uint32_t   regionSize;
+    uint32_t  *usedStatus;
+    uint32_t   statusSize;
+    uint32_t   searchPos;
+} CyU3PDmaBufMgr_t;
+
+extern uint32_t CyU3PMutexCreate(CyU3PMutex *mutex_p, uint32_t priorityInherit);
+extern uint32_t CyU3PMutexDestroy(CyU3PMutex *mutex_p);
+extern uint32_t CyU3PMutexGet(CyU3PMutex *mutex_p, uint32_t waitOption);
+extern uint32_t CyU3PMutexPut(CyU3PMutex *mutex_p);
+
+extern uint32_t CyU3PBytePoolCreate(CyU3PBytePool *pool_p, void *poolStart, uint32_t poolSize);
+extern uint32_t CyU3PBytePoolDestroy(CyU3PBytePool *pool_p);
+extern uint32_t CyU3PByteAlloc(CyU3PBytePool *pool_p, void **mem_p, uint32_t memSize,
+        uint32_t waitOption);
+extern uint32_t CyU3PByteFree(void *mem_p);
+
+extern uint32_t CyU3PBlockPoolCreate(CyU3PBlockPool *pool_p, uint32_t blockSize,
+        void *poolStart, uint32_t poolSize);
+extern uint32_t CyU3PBlockPoolDestroy(CyU3PBlockPool *pool_p);
+extern uint32_t CyU3PBlockAlloc(CyU3PBlockPool *pool_p, void **block_p, uint32_t waitOption);
+extern uint32_t CyU3PBlockFree(void *block_p);
+
+extern CyU3PThread *CyU3PThreadIdentify(void);
+extern uint32_t CyU3PVicDisableAllInterrupts(void);
+extern void CyU3PVicEnableInterrupts(uint32_t mask);
+
+extern void CyU3PApplicationDefine(void);
+
+/* Implemented by cyfxtx.c */
+extern void CyU3PMemInit(void);
+extern void *CyU3PMemAlloc(uint32_t size);
+extern void CyU3PMemFree(void *mem_p);
+extern void CyU3PMemSet(uint8_t *ptr, uint8_t data, uint32_t count);
+extern void CyU3PMemCopy(uint8_t *dest, uint8_t *src, uint32_t count);
+extern int32_t CyU3PMemCmp(const void *s1, const void *s2, uint32_t n);
+extern CyU3PReturnStatus_t CyU3PMemBlockPoolGetStats(uint32_t index, uint32_t *blockSize_p,
+        uint32_t *inUse_p, uint32_t *highWater_p, uint32_t *fallbacks_p);
+extern void CyU3PDmaBufferInit(void);
+extern void CyU3PDmaBufferDeInit(void);
+extern void *CyU3PDmaBufferAlloc(uint16_t size);
+extern int CyU3PDmaBufferFree(void *buffer);
+extern CyU3PReturnStatus_t CyU3PDmaBufferPoolCreate(uint16_t size, uint16_t count);
+extern CyU3PReturnStatus_t CyU3PDmaBufferPoolDestroy(uint16_t size);
+extern void CyU3PFreeHeaps(void);
+
+extern CyU3PDmaBufMgr_t glBufferManager;
+
+/* Test support in fx3sdkstub.c */
+
+/* Map the FX3 RAM (0x40000000, 512 KB) at its own address, so that the 32-bit
+ * address arithmetic of the buffer manager works on a 64-bit host. Returns 0
+ * or -1 if the range is taken. */
+extern int fx3_ram_map(void);
+
+/* Bytes currently allocated from the byte pool, to find leaks. */
+extern uint32_t fx3_byte_pool_used(void);
+
+/* Number of mutexes currently held; 0 between API calls. */
+extern int fx3_mutex_held(void);
+
+#endif /* _INCLUDED_CYU3HOST_H_ */
@@ -0,0 +1,2 @@
+/* Host stand-in, see cyu3host.h */
+#include "cyu3host.h"
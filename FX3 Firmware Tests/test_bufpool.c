@@ -0,0 +1,342 @@
+/*
+ ## test_bufpool: unit tests for the DMA buffer heap and pools of cyfxtx.c
+ ## ===========================
+ ##
+ ##  Covers the bitmap allocator, the constant-time DMA buffer pools
+ ##  (CyU3PDmaBufferPoolCreate/Destroy and the pool path of
+ ##  CyU3PDmaBufferAlloc/Free) and the driver heap block pools behind
+ ##  CyU3PMemAlloc, on the buffer heap of cyfxmemmap.h. Every test leaves the
+ ##  heaps empty and checks that the buffer manager lock was released.
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "cyu3os.h"
+#include "cyfxmemmap.h"
+#include "fx3test.h"
+
+#define STREAM_BUF_BYTES        (16 * 1024)     /* STREAM profile: 16 packets of 1024 bytes */
+#define STREAM_BUF_COUNT        (15)            /* 11 P2U + 4 U2P, as the firmware sets up */
+#define POOL_COUNT              (8)             /* Leaves room next to the pool */
+
+static uint32_t heap_base(void)
+{
+    return CY_U3P_BUFFER_HEAP_BASE;
+}
+
+static int in_heap(const void *p, uint32_t size)
+{
+    uint32_t a = (uint32_t) (uintptr_t) p;
+
+    return (a >= heap_base()) && (a + size <= heap_base() + CY_U3P_BUFFER_HEAP_SIZE);
+}
+
+/* No chunk of the buffer heap is marked as used. */
+static int heap_empty(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < glBufferManager.statusSize; i++)
+        if (glBufferManager.usedStatus[i] != 0)
+            return 0;
+    return 1;
+}
+
+/* Every test ends with the heap empty and no lock held. */
+static void check_clean(void)
+{
+    CHECK(heap_empty());
+    CHECK(fx3_mutex_held() == 0);
+}
+
+static void test_init(void)
+{
+    CHECK(glBufferManager.startAddr == CY_U3P_BUFFER_HEAP_BASE);
+    CHECK(glBufferManager.regionSize == CY_U3P_BUFFER_HEAP_SIZE);
+    CHECK(glBufferManager.statusSize == ((CY_U3P_BUFFER_HEAP_SIZE / 32) + 31) / 32);
+    check_clean();
+}
+
+static void test_bitmap_alloc(void)
+{
+    static const uint16_t sizes[] = { 1, 64, 100, 1000, 1024, 4096, STREAM_BUF_BYTES };
+    uint8_t *buf[sizeof(sizes) / sizeof(sizes[0])];
+    unsigned i, j, n = sizeof(sizes) / sizeof(sizes[0]);
+
+    for (i = 0; i < n; i++)
+    {
+        buf[i] = CyU3PDmaBufferAlloc(sizes[i]);
+        CHECK(buf[i] != NULL);
+        if (buf[i] == NULL)
+            return;
+        CHECK(((uintptr_t) buf[i] & 31) == 0);
+        CHECK(in_heap(buf[i], sizes[i]));
+        memset(buf[i], (int) i, sizes[i]);
+    }
+
+    /* The buffers do not overlap: each still holds its own fill byte. */
+    for (i = 0; i < n; i++)
+        for (j = 0; j < sizes[i]; j++)
+            if (buf[i][j] != (uint8_t) i)
+            {
+                CHECK(buf[i][j] == (uint8_t) i);
+                break;
+            }
+
+    for (i = 0; i < n; i++)
+        CHECK(CyU3PDmaBufferFree(buf[i]) == 0);
+
+    /* Addresses outside the heap are refused. */
+    CHECK(CyU3PDmaBufferFree((void *) (uintptr_t) heap_base()) == -1);
+    CHECK(CyU3PDmaBufferFree((void *) (uintptr_t) (heap_base() + CY_U3P_BUFFER_HEAP_SIZE)) == -1);
+    check_clean();
+}
+
+static void test_pool_alloc(void)
+{
+    uint8_t *buf[POOL_COUNT + 1];
+    uint32_t used = fx3_byte_pool_used();
+    uint32_t first, last;
+    unsigned i;
+
+    CHECK(CyU3PDmaBufferPoolCreate(STREAM_BUF_BYTES, POOL_COUNT) == CY_U3P_SUCCESS);
+
+    /* The pool hands out its buffers in address order, back to back. */
+    for (i = 0; i < POOL_COUNT; i++)
+    {
+        buf[i] = CyU3PDmaBufferAlloc(STREAM_BUF_BYTES);
+        CHECK(buf[i] != NULL);
+        if (buf[i] == NULL)
+            return;
+        CHECK(in_heap(buf[i], STREAM_BUF_BYTES));
+        if (i != 0)
+            CHECK(buf[i] == buf[i - 1] + STREAM_BUF_BYTES);
+    }
+    first = (uint32_t) (uintptr_t) buf[0];
+    last = first + POOL_COUNT * STREAM_BUF_BYTES;
+
+    /* An exhausted pool falls back to the bitmap allocator. */
+    buf[POOL_COUNT] = CyU3PDmaBufferAlloc(STREAM_BUF_BYTES);
+    CHECK(buf[POOL_COUNT] != NULL);
+    CHECK(((uint32_t) (uintptr_t) buf[POOL_COUNT] >= last)
+            || ((uint32_t) (uintptr_t) buf[POOL_COUNT] + STREAM_BUF_BYTES <= first));
+    CHECK(CyU3PDmaBufferFree(buf[POOL_COUNT]) == 0);
+
+    /* Freed buffers are reused last in, first out. */
+    CHECK(CyU3PDmaBufferFree(buf[3]) == 0);
+    CHECK(CyU3PDmaBufferFree(buf[7]) == 0);
+    CHECK(CyU3PDmaBufferAlloc(STREAM_BUF_BYTES) == buf[7]);
+    CHECK(CyU3PDmaBufferAlloc(STREAM_BUF_BYTES) == buf[3]);
+
+    /* A pointer into the middle of a pool buffer is not a buffer. */
+    CHECK(CyU3PDmaBufferFree(buf[0] + 32) == -1);
+
+    for (i = 0; i < POOL_COUNT; i++)
+        CHECK(CyU3PDmaBufferFree(buf[i]) == 0);
+    CHECK(CyU3PDmaBufferPoolDestroy(STREAM_BUF_BYTES) == CY_U3P_SUCCESS);
+    CHECK(fx3_byte_pool_used() == used);
+    check_clean();
+}
+
+static void test_pool_recreate(void)
+{
+    CHECK(CyU3PDmaBufferPoolCreate(STREAM_BUF_BYTES, 8) == CY_U3P_SUCCESS);
+
+    /* Creating an existing pool again succeeds as long as it is large enough;
+     * the size is compared after rounding to 32 bytes. */
+    CHECK(CyU3PDmaBufferPoolCreate(STREAM_BUF_BYTES, 8) == CY_U3P_SUCCESS);
+    CHECK(CyU3PDmaBufferPoolCreate(STREAM_BUF_BYTES, 4) == CY_U3P_SUCCESS);
+    CHECK(CyU3PDmaBufferPoolCreate(STREAM_BUF_BYTES - 20, 8) == CY_U3P_SUCCESS);
+    CHECK(CyU3PDmaBufferPoolCreate(STREAM_BUF_BYTES, 9) == CY_U3P_ERROR_ALREADY_STARTED);
+
+    CHECK(CyU3PDmaBufferPoolDestroy(STREAM_BUF_BYTES) == CY_U3P_SUCCESS);
+    check_clean();
+}
+
+static void test_pool_destroy_busy(void)
+{
+    void *buf;
+
+    CHECK(CyU3PDmaBufferPoolCreate(1024, 4) == CY_U3P_SUCCESS);
+    buf = CyU3PDmaBufferAlloc(1024);
+    CHECK(buf != NULL);
+
+    CHECK(CyU3PDmaBufferPoolDestroy(1024) == CY_U3P_ERROR_INVALID_SEQUENCE);
+    CHECK(CyU3PDmaBufferFree(buf) == 0);
+    CHECK(CyU3PDmaBufferPoolDestroy(1024) == CY_U3P_SUCCESS);
+
+    /* Destroying a pool that does not exist is not an error. */
+    CHECK(CyU3PDmaBufferPoolDestroy(1024) == CY_U3P_SUCCESS);
+    check_clean();
+}
+
+static void test_pool_rounding(void)
+{
+    uint8_t *a, *b, *c;
+
+    /* A pool for 1000 byte buffers has 1024 byte blocks and serves every
+     * request that rounds up to 1024, but not smaller ones. */
+    CHECK(CyU3PDmaBufferPoolCreate(1000, 4) == CY_U3P_SUCCESS);
+    a = CyU3PDmaBufferAlloc(1000);
+    b = CyU3PDmaBufferAlloc(1024);
+    c = CyU3PDmaBufferAlloc(992);
+    CHECK((a != NULL) && (b == a + 1024));
+    CHECK((c != NULL) && ((c + 992 <= a) || (c >= a + 4 * 1024)));
+
+    CHECK(CyU3PDmaBufferFree(a) == 0);
+    CHECK(CyU3PDmaBufferFree(b) == 0);
+    CHECK(CyU3PDmaBufferFree(c) == 0);
+    CHECK(CyU3PDmaBufferPoolDestroy(1000) == CY_U3P_SUCCESS);
+    check_clean();
+}
+
+static void test_pool_bad_args(void)
+{
+    uint32_t used = fx3_byte_pool_used();
+
+    CHECK(CyU3PDmaBufferPoolCreate(0, 4) == CY_U3P_ERROR_BAD_ARGUMENT);
+    CHECK(CyU3PDmaBufferPoolCreate(1024, 0) == CY_U3P_ERROR_BAD_ARGUMENT);
+    CHECK(CyU3PDmaBufferPoolCreate(1024, 0xFFFF) == CY_U3P_ERROR_BAD_ARGUMENT);
+    CHECK(fx3_byte_pool_used() == used);
+    check_clean();
+}
+
+static void test_pool_slots(void)
+{
+    static const uint16_t sizes[] = { 64, 512, 1024, 4096 };
+    unsigned i;
+
+    for (i = 0; i < 4; i++)
+        CHECK(CyU3PDmaBufferPoolCreate(sizes[i], 2) == CY_U3P_SUCCESS);
+
+    /* Four pools at most. */
+    CHECK(CyU3PDmaBufferPoolCreate(2048, 2) == CY_U3P_ERROR_MEMORY_ERROR);
+
+    for (i = 0; i < 4; i++)
+        CHECK(CyU3PDmaBufferPoolDestroy(sizes[i]) == CY_U3P_SUCCESS);
+    check_clean();
+}
+
+static void test_pool_no_room(void)
+{
+    uint32_t used = fx3_byte_pool_used();
+    void *buf;
+
+    /* 17 x 16 KB is more than the buffer heap. The free list array taken from
+     * the driver heap is given back. */
+    CHECK(CyU3PDmaBufferPoolCreate(STREAM_BUF_BYTES, 17) == CY_U3P_ERROR_MEMORY_ERROR);
+    CHECK(fx3_byte_pool_used() == used);
+
+    /* The pool is one block: it does not fit while a buffer sits in the middle
+     * of the heap, even if the total would. */
+    buf = CyU3PDmaBufferAlloc(STREAM_BUF_BYTES);
+    CHECK(buf != NULL);
+    CHECK(CyU3PDmaBufferPoolCreate(STREAM_BUF_BYTES, 15) == CY_U3P_ERROR_MEMORY_ERROR);
+    CHECK(CyU3PDmaBufferFree(buf) == 0);
+    check_clean();
+}
+
+static void test_pool_firmware_geometry(void)
+{
+    void *reserve;
+
+    /* The STREAM geometry of the firmware fits as one pool and leaves the
+     * CY_FX_SLFIFO_DMA_HEAP_RESERVE (8 KB) for the EP0 and debug buffers. */
+    CHECK(CyU3PDmaBufferPoolCreate(STREAM_BUF_BYTES, STREAM_BUF_COUNT) == CY_U3P_SUCCESS);
+    reserve = CyU3PDmaBufferAlloc(0x2000);
+    CHECK(reserve != NULL);
+    CHECK(CyU3PDmaBufferFree(reserve) == 0);
+    CHECK(CyU3PDmaBufferPoolDestroy(STREAM_BUF_BYTES) == CY_U3P_SUCCESS);
+    check_clean();
+}
+
+static void test_deinit(void)
+{
+    uint32_t used;
+
+    CyU3PDmaBufferDeInit();
+    used = fx3_byte_pool_used();
+    CyU3PDmaBufferInit();
+
+    /* Pools left at shutdown are released with the heap. */
+    CHECK(CyU3PDmaBufferPoolCreate(1024, 8) == CY_U3P_SUCCESS);
+    CHECK(CyU3PDmaBufferAlloc(1024) != NULL);
+    CyU3PDmaBufferDeInit();
+    CHECK(fx3_byte_pool_used() == used);
+    CHECK(glBufferManager.startAddr == 0);
+    CHECK(CyU3PDmaBufferAlloc(1024) == NULL);
+
+    CyU3PDmaBufferInit();
+    CHECK(glBufferManager.startAddr == CY_U3P_BUFFER_HEAP_BASE);
+    check_clean();
+}
+
+static void test_mem_block_pools(void)
+{
+    uint32_t blockSize, inUse, highWater, fallbacks, fallbacks0;
+    void *small[17], *mid;
+    unsigned i;
+
+    CHECK(CyU3PMemBlockPoolGetStats(0, &blockSize, &inUse, &highWater, &fallbacks0)
+            == CY_U3P_SUCCESS);
+    CHECK(blockSize == 32);
+    CHECK(inUse == 0);
+
+    /* 16 blocks of 32 bytes; the 17th request goes to the byte pool. */
+    for (i = 0; i < 17; i++)
+    {
+        small[i] = CyU3PMemAlloc(20);
+        CHECK(small[i] != NULL);
+    }
+    CyU3PMemBlockPoolGetStats(0, &blockSize, &inUse, &highWater, &fallbacks);
+    CHECK(inUse == 16);
+    CHECK(highWater >= 16);
+    CHECK(fallbacks == fallbacks0 + 1);
+
+    /* 33 bytes need the 128 byte pool. */
+    mid = CyU3PMemAlloc(33);
+    CHECK(mid != NULL);
+    CyU3PMemBlockPoolGetStats(1, &blockSize, &inUse, &highWater, &fallbacks);
+    CHECK(blockSize == 128);
+    CHECK(inUse == 1);
+
+    CyU3PMemFree(mid);
+    for (i = 0; i < 17; i++)
+        CyU3PMemFree(small[i]);
+    CyU3PMemBlockPoolGetStats(0, &blockSize, &inUse, &highWater, &fallbacks);
+    CHECK(inUse == 0);
+    CyU3PMemBlockPoolGetStats(1, &blockSize, &inUse, &highWater, &fallbacks);
+    CHECK(inUse == 0);
+
+    CHECK(CyU3PMemBlockPoolGetStats(3, &blockSize, &inUse, &highWater, &fallbacks)
+            == CY_U3P_ERROR_BAD_ARGUMENT);
+}
+
+int main(void)
+{
+    if (fx3_ram_map() != 0)
+    {
+        fprintf(stderr, "Cannot map the FX3 RAM at 0x40000000\n");
+        return 1;
+    }
+
+    CyU3PMemInit();
+    CyU3PDmaBufferInit();
+
+    test_init();
+    test_bitmap_alloc();
+    test_pool_alloc();
+    test_pool_recreate();
+    test_pool_destroy_busy();
+    test_pool_rounding();
+    test_pool_bad_args();
+    test_pool_slots();
+    test_pool_no_room();
+    test_pool_firmware_geometry();
+    test_deinit();
+    test_mem_block_pools();
+
+    CyU3PFreeHeaps();
+    return fx3_test_result("test_bufpool");
+}
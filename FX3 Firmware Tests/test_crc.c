@@ -0,0 +1,162 @@
+/*
+ ## test_crc: CRC32 and check points of the loopback integrity check
+ ## ===========================
+ ##
+ ##  CyFxSlFifoCrcUpdate must give zlib's crc32 for every start alignment
+ ##  and length, also when the data is fed in pieces. The check points are
+ ##  run on a 1 MB U2P stream in 1 KB buffers, returned on the P2U side in
+ ##  buffers of other sizes: a clean stream passes all 1024 checks, a stream
+ ##  with one flipped bit fails exactly one of them, and one lost byte fails
+ ##  every check after it.
+ ##  Needs zlib (zlib1g-dev on Debian/Ubuntu) for the reference CRC.
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "cyu3os.h"
+#include "cyfxslfifosync.h"
+#include "fx3test.h"
+
+#define OFFSETS                 (8)
+#define SMALL_MAX               (300)
+#define STREAM_BYTES            (1024 * 1024)
+#define STREAM_BUF              (1024)
+
+CyFxSlFifoTelemetry_t glTelemetry;
+
+static unsigned maint_count;
+
+/* cyfxslfifosync.c is not part of the test. */
+void CyFxSlFifoDCacheMaint(uint8_t *buf_p, uint32_t count, CyBool_t isClean)
+{
+    (void) buf_p;
+    (void) count;
+    (void) isClean;
+    maint_count++;
+}
+
+static uint8_t stream[STREAM_BYTES + OFFSETS];
+
+static void fill(uint8_t *p, uint32_t n)
+{
+    uint32_t x = 0x12345678, i;
+
+    for (i = 0; i < n; i++)
+    {
+        x = x * 1103515245 + 12345;
+        p[i] = (uint8_t) (x >> 16);
+    }
+}
+
+static uint32_t crc_of(const uint8_t *p, uint32_t n)
+{
+    return CyFxSlFifoCrcUpdate(0xFFFFFFFF, p, n) ^ 0xFFFFFFFF;
+}
+
+static void test_update(void)
+{
+    uint32_t off, len, split, crc;
+    unsigned long bad = 0;
+
+    CHECK(crc_of((const uint8_t *) "123456789", 9) == 0xCBF43926);
+    CHECK(crc_of(stream, 0) == 0);
+
+    for (off = 0; off < OFFSETS; off++)
+        for (len = 0; len <= SMALL_MAX; len++)
+            if (crc_of(stream + off, len) != crc32(0, stream + off, len))
+                bad++;
+    CHECK(bad == 0);
+
+    bad = 0;
+    for (split = 0; split <= SMALL_MAX; split++)
+    {
+        crc = CyFxSlFifoCrcUpdate(0xFFFFFFFF, stream + 1, split);
+        crc = CyFxSlFifoCrcUpdate(crc, stream + 1 + split, SMALL_MAX - split) ^ 0xFFFFFFFF;
+        if (crc != crc32(0, stream + 1, SMALL_MAX))
+            bad++;
+    }
+    CHECK(bad == 0);
+
+    CHECK(crc_of(stream, STREAM_BYTES) == crc32(0, stream, STREAM_BYTES));
+}
+
+/* Send the stream on the U2P side in STREAM_BUF buffers and return the first
+ * total bytes of p2u on the P2U side in buffers cycling through the sizes
+ * below. P2U data is only returned once as much was sent, as by the FPGA. */
+static void run_stream(const uint8_t *p2u, uint32_t total)
+{
+    static const uint32_t sizes[] = { 3000, 512, 4096, 17, 1024, 2047 };
+    uint32_t sent = 0, back = 0, n;
+    unsigned i = 0;
+
+    memset(&glTelemetry, 0, sizeof(glTelemetry));
+    glCrcCheck = CyTrue;
+    CyFxSlFifoCrcReset();
+
+    while (back < total)
+    {
+        if (sent < STREAM_BYTES)
+        {
+            CyFxSlFifoCrcUtoP(stream + sent, STREAM_BUF);
+            sent += STREAM_BUF;
+        }
+        for (;;)
+        {
+            n = sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+            if (back + n > total)
+                n = total - back;
+            if ((n == 0) || ((sent < STREAM_BYTES) && (back + n > sent)))
+                break;
+            CyFxSlFifoCrcPtoU((uint8_t *) p2u + back, n);
+            back += n;
+            i++;
+        }
+    }
+}
+
+static void test_check_points(void)
+{
+    static uint8_t p2u[STREAM_BYTES];
+    uint32_t flip = STREAM_BYTES / 3 + 5;
+
+    maint_count = 0;
+    memcpy(p2u, stream, STREAM_BYTES);
+    run_stream(p2u, STREAM_BYTES);
+    CHECK(glTelemetry.crcChecked == STREAM_BYTES / STREAM_BUF);
+    CHECK(glTelemetry.crcMismatch == 0);
+    CHECK(maint_count > STREAM_BYTES / STREAM_BUF);
+
+    p2u[flip] ^= 0x10;
+    run_stream(p2u, STREAM_BYTES);
+    CHECK(glTelemetry.crcChecked == STREAM_BYTES / STREAM_BUF);
+    CHECK(glTelemetry.crcMismatch == 1);
+    CHECK(glTelemetry.crcExpected != glTelemetry.crcActual);
+
+    /* One byte missing: every check point after it fails, and the P2U stream
+     * never reaches the last one. */
+    memcpy(p2u, stream, flip);
+    memcpy(p2u + flip, stream + flip + 1, STREAM_BYTES - flip - 1);
+    run_stream(p2u, STREAM_BYTES - 1);
+    CHECK(glTelemetry.crcChecked == STREAM_BYTES / STREAM_BUF - 1);
+    CHECK(glTelemetry.crcMismatch == STREAM_BYTES / STREAM_BUF - 1 - flip / STREAM_BUF);
+
+    /* With the check off nothing is counted. */
+    memset(&glTelemetry, 0, sizeof(glTelemetry));
+    glCrcCheck = CyFalse;
+    CyFxSlFifoCrcUtoP(stream, STREAM_BUF);
+    CyFxSlFifoCrcPtoU(stream, STREAM_BUF);
+    CHECK(glTelemetry.crcChecked == 0);
+}
+
+int main(void)
+{
+    fill(stream, sizeof(stream));
+    CyFxSlFifoCrcInit();
+
+    test_update();
+    test_check_points();
+    return fx3_test_result("test_crc");
+}
@@ -0,0 +1,361 @@
+/*
+ ## test_descriptors: USB descriptors against the endpoint configuration
+ ## ===========================
+ ##
+ ##  Builds cyfxslfifousbdscr.c and cyfxslfifoepcfg.c of the firmware, patches
+ ##  the SS, HS and FS configuration descriptors from the endpoint parameter
+ ##  block as CyFxSlFifoApplnInit does before CyU3PUsbSetDesc, and checks that
+ ##  what the host reads matches what CyFxSlFifoApplnEpConfig programs with
+ ##  CyU3PSetEpConfig: the packet size of every bulk endpoint, a companion
+ ##  descriptor after every SuperSpeed endpoint with the burst length and the
+ ##  stream count of the IN endpoint, and a burst length no profile exceeds.
+ ##  The descriptor chains must add up to wTotalLength and the patched
+ ##  descriptors must be cleaned from the D-cache.
+ ##
+ ##  Usage: test_descriptors [-v]     -v dumps the patched descriptors
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "cyfxslfifosync.h"
+#include "fx3test.h"
+
+#define DSCR_MAX                (512)
+
+static int verbose;
+
+/* Last CyFxSlFifoDCacheMaint call */
+static const uint8_t *maint_p;
+static uint32_t maint_count;
+static CyBool_t maint_clean;
+
+/* Stands in for the D-cache maintenance of cyfxslfifosync.c */
+void CyFxSlFifoDCacheMaint(uint8_t *buf_p, uint32_t count, CyBool_t isClean)
+{
+    maint_p = buf_p;
+    maint_count = count;
+    maint_clean = isClean;
+}
+
+static uint16_t word_at(const uint8_t *p)
+{
+    return CY_U3P_MAKEWORD(p[1], p[0]);
+}
+
+static const char *type_name(uint8_t type)
+{
+    switch (type)
+    {
+    case CY_U3P_USB_DEVICE_DESCR:
+        return "device";
+    case CY_U3P_USB_CONFIG_DESCR:
+        return "configuration";
+    case CY_U3P_USB_STRING_DESCR:
+        return "string";
+    case CY_U3P_USB_INTRFC_DESCR:
+        return "interface";
+    case CY_U3P_USB_ENDPNT_DESCR:
+        return "endpoint";
+    case CY_U3P_USB_DEVQUAL_DESCR:
+        return "device qualifier";
+    case CY_U3P_BOS_DESCR:
+        return "BOS";
+    case CY_U3P_DEVICE_CAPB_DESCR:
+        return "device capability";
+    case CY_U3P_SS_EP_COMPN_DESCR:
+        return "SS endpoint companion";
+    default:
+        return "unknown";
+    }
+}
+
+/* Print a descriptor chain of len bytes, one descriptor per line */
+static void dump(const char *name, const uint8_t *dscr_p, uint16_t len)
+{
+    uint16_t offset = 0, i;
+    const uint8_t *d_p;
+
+    if (!verbose)
+        return;
+    printf("%s, %u bytes\n", name, len);
+    while ((offset + 2 <= len) && (dscr_p[offset] >= 2))
+    {
+        d_p = dscr_p + offset;
+        printf("  %3u %-22s", offset, type_name(d_p[1]));
+        for (i = 0; (i < d_p[0]) && (offset + i < len); i++)
+            printf(" %02x", d_p[i]);
+        if (d_p[1] == CY_U3P_USB_ENDPNT_DESCR)
+            printf("   EP 0x%02x wMaxPacketSize %u", d_p[2], word_at(d_p + 4));
+        else if (d_p[1] == CY_U3P_SS_EP_COMPN_DESCR)
+            printf("   bMaxBurst %u streams %u", d_p[2] + 1, (d_p[3] & 0x1F) ? (1u << (d_p[3] & 0x1F)) : 0);
+        printf("\n");
+        offset += d_p[0];
+    }
+}
+
+/* Walks the chain; returns the length it covers, or 0 if a descriptor is
+ * shorter than 2 bytes or runs past len. */
+static uint16_t chain_length(const uint8_t *dscr_p, uint16_t len)
+{
+    uint16_t offset = 0;
+
+    while (offset < len)
+    {
+        if ((dscr_p[offset] < 2) || (offset + dscr_p[offset] > len))
+            return 0;
+        offset += dscr_p[offset];
+    }
+    return offset;
+}
+
+static void test_device(void)
+{
+    const uint8_t *ss = CyFxUSB30DeviceDscr, *hs = CyFxUSB20DeviceDscr;
+
+    dump("USB 3.0 device", ss, ss[0]);
+    dump("USB 2.0 device", hs, hs[0]);
+    CHECK((ss[0] == 18) && (ss[1] == CY_U3P_USB_DEVICE_DESCR));
+    CHECK((hs[0] == 18) && (hs[1] == CY_U3P_USB_DEVICE_DESCR));
+    CHECK(word_at(ss + 2) == 0x0300);
+    CHECK(word_at(hs + 2) >= 0x0200);
+    CHECK(ss[7] == 9);                  /* 512 byte EP0 as 2^9 */
+    CHECK(hs[7] == 64);
+    CHECK(memcmp(ss + 8, hs + 8, 4) == 0);      /* Same VID and PID */
+    CHECK((ss[17] == 1) && (hs[17] == 1));
+
+    CHECK((CyFxUSBDeviceQualDscr[0] == 10) && (CyFxUSBDeviceQualDscr[1] == CY_U3P_USB_DEVQUAL_DESCR));
+}
+
+static void test_bos(void)
+{
+    uint16_t len = word_at(CyFxUSBBOSDscr + 2);
+    uint16_t offset = CyFxUSBBOSDscr[0];
+    unsigned caps = 0, ss_cap = 0;
+
+    dump("BOS", CyFxUSBBOSDscr, len);
+    CHECK(CyFxUSBBOSDscr[1] == CY_U3P_BOS_DESCR);
+    CHECK(chain_length(CyFxUSBBOSDscr, len) == len);
+    while ((offset < len) && (CyFxUSBBOSDscr[offset] >= 3))
+    {
+        CHECK(CyFxUSBBOSDscr[offset + 1] == CY_U3P_DEVICE_CAPB_DESCR);
+        if (CyFxUSBBOSDscr[offset + 2] == CY_U3P_SS_USB_CAPB_TYPE)
+            ss_cap++;
+        caps++;
+        offset += CyFxUSBBOSDscr[offset];
+    }
+    CHECK(caps == CyFxUSBBOSDscr[4]);
+    CHECK(ss_cap == 1);
+}
+
+/* Return the SuperSpeed device capability of the BOS descriptor. */
+static uint8_t *bos_ss_cap(void)
+{
+    uint16_t len = word_at(CyFxUSBBOSDscr + 2);
+    uint16_t offset = CyFxUSBBOSDscr[0];
+
+    while ((offset < len) && (CyFxUSBBOSDscr[offset] >= 3))
+    {
+        if (CyFxUSBBOSDscr[offset + 2] == CY_U3P_SS_USB_CAPB_TYPE)
+            return CyFxUSBBOSDscr + offset;
+        offset += CyFxUSBBOSDscr[offset];
+    }
+    return NULL;
+}
+
+/* Measured exit latencies reach the BOS descriptor, capped at the field limits,
+ * and nothing else in it changes. */
+static void test_bos_patch(void)
+{
+    uint8_t saved[DSCR_MAX];
+    uint16_t len = word_at(CyFxUSBBOSDscr + 2);
+    uint8_t *cap_p = bos_ss_cap();
+
+    if ((cap_p == NULL) || (len > DSCR_MAX))
+        return;
+    memcpy(saved, CyFxUSBBOSDscr, len);
+
+    CHECK(cap_p[7] == CY_FX_SLFIFO_U1_EXIT_LATENCY);
+    CHECK(word_at(cap_p + 8) == CY_FX_SLFIFO_U2_EXIT_LATENCY);
+
+    maint_p = NULL;
+    CyFxSlFifoApplnPatchBosDscr(CyFxUSBBOSDscr, 3, 0x123);
+    CHECK((maint_p == CyFxUSBBOSDscr) && (maint_count == len) && maint_clean);
+    CHECK((cap_p[7] == 3) && (word_at(cap_p + 8) == 0x123));
+    cap_p[7] = saved[cap_p - CyFxUSBBOSDscr + 7];
+    cap_p[8] = saved[cap_p - CyFxUSBBOSDscr + 8];
+    cap_p[9] = saved[cap_p - CyFxUSBBOSDscr + 9];
+    CHECK(memcmp(saved, CyFxUSBBOSDscr, len) == 0);
+
+    CyFxSlFifoApplnPatchBosDscr(CyFxUSBBOSDscr, 11, 0x10000);
+    CHECK((cap_p[7] == CY_FX_SLFIFO_U1_EXIT_MAX) && (word_at(cap_p + 8) == CY_FX_SLFIFO_U2_EXIT_MAX));
+
+    memcpy(CyFxUSBBOSDscr, saved, len);
+}
+
+static void test_strings(void)
+{
+    CHECK((CyFxUSBStringLangIDDscr[0] == 4) && (CyFxUSBStringLangIDDscr[1] == CY_U3P_USB_STRING_DESCR));
+    CHECK(word_at(CyFxUSBStringLangIDDscr + 2) == 0x0409);
+    CHECK(((CyFxUSBManufactureDscr[0] & 1) == 0) && (CyFxUSBManufactureDscr[1] == CY_U3P_USB_STRING_DESCR));
+    CHECK(((CyFxUSBProductDscr[0] & 1) == 0) && (CyFxUSBProductDscr[1] == CY_U3P_USB_STRING_DESCR));
+}
+
+/* Check a patched configuration descriptor against the parameters of its speed. */
+static void check_config(const char *name, const uint8_t *dscr_p, const CyFxSlFifoEpParams_t *params_p,
+        int super_speed)
+{
+    uint16_t len = word_at(dscr_p + 2), offset;
+    unsigned interfaces = 0, endpoints = 0, expected_eps = 0, companions = 0;
+    uint8_t ep = 0, streams;
+    const uint8_t *d_p;
+
+    dump(name, dscr_p, len);
+    CHECK(dscr_p[1] == CY_U3P_USB_CONFIG_DESCR);
+    CHECK((len > dscr_p[0]) && (len <= DSCR_MAX));
+    CHECK(chain_length(dscr_p, len) == len);
+
+    for (offset = dscr_p[0]; offset < len; offset += d_p[0])
+    {
+        d_p = dscr_p + offset;
+        if (d_p[0] < 2)
+            break;
+        switch (d_p[1])
+        {
+        case CY_U3P_USB_INTRFC_DESCR:
+            CHECK(endpoints == expected_eps);
+            interfaces++;
+            endpoints = 0;
+            expected_eps = d_p[4];
+            break;
+        case CY_U3P_USB_ENDPNT_DESCR:
+            CHECK(d_p[3] == CY_U3P_USB_EP_BULK);
+            CHECK(word_at(d_p + 4) == params_p->pktSize);
+            /* Every SuperSpeed endpoint is followed by its companion. */
+            CHECK(!super_speed || ((offset + d_p[0] < len)
+                    && (d_p[d_p[0] + 1] == CY_U3P_SS_EP_COMPN_DESCR)));
+            ep = d_p[2];
+            endpoints++;
+            break;
+        case CY_U3P_SS_EP_COMPN_DESCR:
+            CHECK(super_speed);
+            CHECK(d_p[2] == params_p->burstLen - 1);
+            streams = d_p[3] & 0x1F;
+            if (ep == CY_FX_EP_CONSUMER)
+                CHECK((streams ? (1u << streams) : 0) == params_p->streams);
+            else
+                CHECK(streams == 0);
+            companions++;
+            break;
+        default:
+            CHECK(!"unexpected descriptor in the configuration");
+            break;
+        }
+    }
+    CHECK(endpoints == expected_eps);
+    CHECK(interfaces == dscr_p[4]);
+    CHECK(!super_speed || (companions != 0));
+}
+
+static void test_config(void)
+{
+    static const struct
+    {
+        const char *name;
+        uint8_t *dscr_p;
+        CyU3PUSBSpeed_t speed;
+        uint16_t pktSize;
+    } configs[] =
+    {
+        { "SuperSpeed configuration", CyFxUSBSSConfigDscr, CY_U3P_SUPER_SPEED, 1024 },
+        { "High speed configuration", CyFxUSBHSConfigDscr, CY_U3P_HIGH_SPEED, 512 },
+        { "Full speed configuration", CyFxUSBFSConfigDscr, CY_U3P_FULL_SPEED, 64 }
+    };
+    const CyFxSlFifoEpParams_t *params_p;
+    uint8_t before[DSCR_MAX];
+    uint16_t len;
+    unsigned i;
+
+    for (i = 0; i < sizeof(configs) / sizeof(configs[0]); i++)
+    {
+        params_p = CyFxSlFifoGetEpParams(configs[i].speed);
+        CHECK(params_p != NULL);
+        if (params_p == NULL)
+            continue;
+
+        /* Bulk packet sizes are fixed by the USB specification. */
+        CHECK(params_p->pktSize == configs[i].pktSize);
+        CHECK((params_p->burstLen >= 1) && (params_p->burstLen <= 16));
+        CHECK((configs[i].speed == CY_U3P_SUPER_SPEED) || ((params_p->burstLen == 1) && (params_p->streams == 0)));
+
+        len = word_at(configs[i].dscr_p + 2);
+        if (len > DSCR_MAX)
+            len = DSCR_MAX;
+        memcpy(before, configs[i].dscr_p, len);
+        maint_p = NULL;
+        CyFxSlFifoApplnPatchConfigDscr(configs[i].dscr_p, params_p);
+        CHECK((maint_p == configs[i].dscr_p) && (maint_count == len) && maint_clean);
+        check_config(configs[i].name, configs[i].dscr_p, params_p, configs[i].speed == CY_U3P_SUPER_SPEED);
+
+        /* The descriptors are built from the same macros, so patching them
+         * must not change anything. */
+        CHECK(memcmp(before, configs[i].dscr_p, len) == 0);
+    }
+    CHECK(CyFxSlFifoGetEpParams(CY_U3P_NOT_CONNECTED) == NULL);
+}
+
+/* Parameters other than those compiled in reach every field that carries them. */
+static void test_patch(void)
+{
+    static const CyFxSlFifoEpParams_t params[] = { { 1024, 4, 2 }, { 1024, 1, 0 }, { 1024, 16, 0 } };
+    uint8_t *dscr_p = CyFxUSBSSConfigDscr;
+    uint8_t saved[DSCR_MAX];
+    uint16_t len = word_at(dscr_p + 2);
+    unsigned i;
+
+    if (len > DSCR_MAX)
+        return;
+    memcpy(saved, dscr_p, len);
+    for (i = 0; i < sizeof(params) / sizeof(params[0]); i++)
+    {
+        CyFxSlFifoApplnPatchConfigDscr(dscr_p, &params[i]);
+        check_config("SuperSpeed configuration, patched", dscr_p, &params[i], 1);
+    }
+    memcpy(dscr_p, saved, len);
+}
+
+/* CyFxSlFifoEpBurst programs the burst of the active profile, capped at the
+ * advertised one; no profile may need more than the descriptors announce. */
+static void test_ep_config(void)
+{
+    CHECK((CY_FX_SLFIFO_SS_BURST_LENGTH >= 1) && (CY_FX_SLFIFO_SS_BURST_LENGTH <= 16));
+    CHECK(CY_FX_SLFIFO_STREAM_BURST_LENGTH <= CY_FX_SLFIFO_SS_BURST_LENGTH);
+    CHECK(CY_FX_SLFIFO_LOOPBACK_BURST_LENGTH <= CY_FX_SLFIFO_SS_BURST_LENGTH);
+    CHECK(glEpParams[2].burstLen == CY_FX_SLFIFO_SS_BURST_LENGTH);
+    CHECK(glEpParams[2].streams == CY_FX_SLFIFO_BULK_STREAMS);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "v")) != -1)
+    {
+        if (opt != 'v')
+        {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+        verbose = 1;
+    }
+
+    test_device();
+    test_bos();
+    test_bos_patch();
+    test_strings();
+    test_config();
+    test_patch();
+    test_ep_config();
+    return fx3_test_result("test_descriptors");
+}
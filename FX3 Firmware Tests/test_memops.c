@@ -0,0 +1,191 @@
+/*
+ ## test_memops: correctness of CyU3PMemCopy, CyU3PMemSet and CyU3PMemCmp
+ ## ===========================
+ ##
+ ##  The word and LDM/STM paths of cyfxtx.c are only taken for some
+ ##  alignments and lengths, so every source and destination offset 0..7 is
+ ##  combined with every length 0..300 and a few large ones up to 16 KB. The
+ ##  destination sits between guard bytes that must stay untouched, and the
+ ##  results are compared with the C library. CyU3PMemCmp must agree with the
+ ##  sign of memcmp, which compares unsigned bytes, and must not look past n.
+ ##
+ ##  Runs on the build machine ("make test") and under qemu-arm ("make qemu"),
+ ##  where the LDM/STM copy loop is the one the firmware uses.
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "cyu3os.h"
+#include "fx3test.h"
+
+#define OFFSETS                 (8)
+#define SMALL_MAX               (300)
+#define GUARD                   (16)
+#define BUF_BYTES               (16 * 1024 + OFFSETS + 2 * GUARD)
+#define GUARD_BYTE              (0xA5)
+
+static const uint32_t large_lengths[] = { 511, 512, 513, 1023, 4096, 16 * 1024 - 1, 16 * 1024 };
+
+/* Word aligned backing store, so the offsets below are the real alignments */
+static uint32_t src_words[BUF_BYTES / 4 + 1];
+static uint32_t dst_words[BUF_BYTES / 4 + 1];
+static uint32_t ref_words[BUF_BYTES / 4 + 1];
+
+static uint8_t *const src_buf = (uint8_t *) src_words;
+static uint8_t *const dst_buf = (uint8_t *) dst_words;
+static uint8_t *const ref_buf = (uint8_t *) ref_words;
+
+static int sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+static void fill_pattern(uint8_t *p, uint32_t n, uint32_t seed)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        p[i] = (uint8_t) ((i * 131 + seed * 17 + (i >> 8)) ^ 0x5A);
+}
+
+/* Run op on dst_buf and the library version on ref_buf, both prepared with
+ * guard bytes, and compare everything including the guards. */
+static int copy_case(uint32_t src_off, uint32_t dst_off, uint32_t len)
+{
+    memset(dst_buf, GUARD_BYTE, BUF_BYTES);
+    memset(ref_buf, GUARD_BYTE, BUF_BYTES);
+    memcpy(ref_buf + GUARD + dst_off, src_buf + GUARD + src_off, len);
+    CyU3PMemCopy(dst_buf + GUARD + dst_off, src_buf + GUARD + src_off, len);
+    return memcmp(dst_buf, ref_buf, len + dst_off + 2 * GUARD) == 0;
+}
+
+static int set_case(uint32_t off, uint32_t len, uint8_t data)
+{
+    memset(dst_buf, GUARD_BYTE, BUF_BYTES);
+    memset(ref_buf, GUARD_BYTE, BUF_BYTES);
+    memset(ref_buf + GUARD + off, data, len);
+    CyU3PMemSet(dst_buf + GUARD + off, data, len);
+    return memcmp(dst_buf, ref_buf, len + off + 2 * GUARD) == 0;
+}
+
+static void report(const char *what, uint32_t a, uint32_t b, uint32_t len)
+{
+    fprintf(stderr, "  %s: offsets %u/%u length %u\n", what, a, b, len);
+}
+
+static void test_copy(void)
+{
+    uint32_t s, d, len, i;
+    int ok;
+
+    fill_pattern(src_buf, BUF_BYTES, 1);
+    for (s = 0; s < OFFSETS; s++)
+        for (d = 0; d < OFFSETS; d++)
+        {
+            for (len = 0; len <= SMALL_MAX; len++)
+            {
+                ok = copy_case(s, d, len);
+                CHECK(ok);
+                if (!ok)
+                    report("copy", s, d, len);
+            }
+            for (i = 0; i < sizeof(large_lengths) / sizeof(large_lengths[0]); i++)
+            {
+                ok = copy_case(s, d, large_lengths[i]);
+                CHECK(ok);
+                if (!ok)
+                    report("copy", s, d, large_lengths[i]);
+            }
+        }
+
+    /* The source is only read. */
+    fill_pattern(ref_buf, BUF_BYTES, 1);
+    CHECK(memcmp(src_buf, ref_buf, BUF_BYTES) == 0);
+}
+
+static void test_set(void)
+{
+    static const uint8_t values[] = { 0x00, 0xFF, 0x80, 0x5A };
+    uint32_t off, len, i, v;
+    int ok;
+
+    for (v = 0; v < sizeof(values) / sizeof(values[0]); v++)
+        for (off = 0; off < OFFSETS; off++)
+        {
+            for (len = 0; len <= SMALL_MAX; len++)
+            {
+                ok = set_case(off, len, values[v]);
+                CHECK(ok);
+                if (!ok)
+                    report("set", off, values[v], len);
+            }
+            for (i = 0; i < sizeof(large_lengths) / sizeof(large_lengths[0]); i++)
+            {
+                ok = set_case(off, large_lengths[i], values[v]);
+                CHECK(ok);
+                if (!ok)
+                    report("set", off, values[v], large_lengths[i]);
+            }
+        }
+}
+
+/* One differing byte at pos, with the values a (first) and b (second). */
+static int cmp_case(uint32_t off1, uint32_t off2, uint32_t len, uint32_t pos, uint8_t a, uint8_t b)
+{
+    uint8_t *p1 = src_buf + GUARD + off1, *p2 = dst_buf + GUARD + off2;
+
+    memcpy(p2, p1, len);
+    if (pos < len)
+    {
+        p1[pos] = a;
+        p2[pos] = b;
+    }
+    return sign(CyU3PMemCmp(p1, p2, len)) == sign(memcmp(p1, p2, len));
+}
+
+static void test_cmp(void)
+{
+    /* Byte pairs that catch a signed compare and a compare of whole words */
+    static const uint8_t pairs[][2] = { { 1, 2 }, { 2, 1 }, { 0x7F, 0x80 }, { 0x80, 0x7F },
+            { 0x00, 0xFF }, { 0xFF, 0x00 } };
+    uint32_t o1, o2, len, pos, i, k;
+    int ok;
+
+    fill_pattern(src_buf, BUF_BYTES, 2);
+    for (o1 = 0; o1 < OFFSETS; o1++)
+        for (o2 = 0; o2 < OFFSETS; o2++)
+            for (len = 0; len <= 70; len++)
+            {
+                ok = cmp_case(o1, o2, len, len, 0, 0);
+                CHECK(ok);
+                for (pos = 0; pos < len; pos++)
+                    for (k = 0; k < sizeof(pairs) / sizeof(pairs[0]); k++)
+                    {
+                        ok = cmp_case(o1, o2, len, pos, pairs[k][0], pairs[k][1]);
+                        CHECK(ok);
+                        if (!ok)
+                            report("cmp", o1, o2, len);
+                    }
+            }
+
+    /* A difference in the last byte of a large buffer, and one just past n. */
+    for (i = 0; i < sizeof(large_lengths) / sizeof(large_lengths[0]); i++)
+    {
+        len = large_lengths[i];
+        CHECK(cmp_case(0, 0, len, len - 1, 0x80, 0x7F));
+        CHECK(cmp_case(1, 1, len, len - 1, 0x10, 0x20));
+        CHECK(cmp_case(3, 0, len, 0, 0xFE, 0xFF));
+        memcpy(dst_buf + GUARD, src_buf + GUARD, len);
+        dst_buf[GUARD + len] = (uint8_t) ~src_buf[GUARD + len];
+        CHECK(CyU3PMemCmp(src_buf + GUARD, dst_buf + GUARD, len) == 0);
+    }
+}
+
+int main(void)
+{
+    test_copy();
+    test_set();
+    test_cmp();
+    return fx3_test_result("test_memops");
+}
@@ -0,0 +1,322 @@
+/*
+ ## test_pingpong: cycle model of the ping-pong P2U channel and the FPGA writer
+ ## ===========================
+ ##
+ ##  Models CY_FX_SLFIFO_P2U_PINGPONG as CyFxSlFifoApplnStart sets it up: a
+ ##  many-to-one channel with glDmaBufCountPtoU / 2 buffers on each of the PIB
+ ##  sockets 0 and 1, consumed by the USB socket strictly in turn, and FLAGC/
+ ##  FLAGD routed to the DMA ready/watermark flags of thread 1. On the other
+ ##  side of the bus it runs slave_fifo_stream_write_to_fx3.vhd clock by clock,
+ ##  with the flag input and strobe output registers of slave_fifo_main.
+ ##
+ ##  On the FX3 side a producer socket takes one write per clock into its
+ ##  current buffer, commits the buffer when it is full and needs switch_cycles
+ ##  to move to the next free one. A thread's DMA ready flag is high while the
+ ##  socket has an active buffer; its watermark flag is high while more than
+ ##  watermark words are left in it. The USB side returns a buffer to its
+ ##  socket after usb_cycles. The watermark is counted from the clock on which
+ ##  the flag changes at the FX3 pin; how the watermark passed to
+ ##  CyU3PGpifSocketConfigure maps onto that depends on the flag latency of
+ ##  the GPIF II state machine, which is not modelled.
+ ##
+ ##  Checks: no write reaches a thread without an active buffer, every burst
+ ##  of the writer ends exactly on a buffer boundary (otherwise the many-to-one
+ ##  channel sends the data out of order), the buffers reach USB in the order
+ ##  they were written, and with ping-pong the bus idles no more than
+ ##  CY_PP_MAX_GAP clocks between two buffers. The bus rate of both modes is
+ ##  printed; a watermark off by one must be caught.
+ ##
+ ##  Usage: test_pingpong [-v]
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "cyfxslfifosync.h"
+#include "fx3test.h"
+
+#define PP_CLOCK_MHZ            (100)
+#define PP_BUS_BYTES            (2)             /* 16-bit bus */
+#define PP_BUF_BYTES            (CY_FX_SLFIFO_STREAM_BUF_SIZE * CY_FX_SLFIFO_SS_PACKET_SIZE)
+#define PP_BUF_WORDS            (PP_BUF_BYTES / PP_BUS_BYTES)
+#define PP_QUEUE                (256)           /* More than CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT */
+
+/* P2U buffers of the STREAM profile, as CyFxSlFifoDmaMaxCountPtoU sizes them in
+ * ping-pong mode */
+#define PP_COUNT_PTOU \
+        (((CY_U3P_BUFFER_HEAP_SIZE - CY_FX_SLFIFO_DMA_HEAP_RESERVE - \
+           CY_FX_SLFIFO_STREAM_COUNT_U_2_P * CY_FX_SLFIFO_DMA_HEAP_BYTES(PP_BUF_BYTES)) / \
+          CY_FX_SLFIFO_DMA_HEAP_BYTES(PP_BUF_BYTES)) & ~1)
+#define PP_SWITCH_CYCLES        (100)           /* About 1 us for the socket to load the next buffer */
+#define PP_WATERMARK            (2)             /* Words the writer still fills after FLAGB/FLAGD drops */
+#define CY_PP_MAX_GAP           (4)             /* Clocks without a write between two buffers */
+#define PP_BUFFERS              (64)            /* Buffers per run */
+
+/* States of slave_fifo_stream_write_to_fx3 */
+typedef enum pp_state
+{
+    PP_IDLE,
+    PP_WAIT_FLAGB,
+    PP_WRITE,
+    PP_WR_DELAY
+} pp_state;
+
+typedef struct pp_config
+{
+    int ping_pong;              /* PING_PONG generic and CY_FX_SLFIFO_P2U_PINGPONG */
+    uint32_t buf_words;
+    uint32_t count;             /* P2U buffers of the channel */
+    uint32_t switch_cycles;
+    uint32_t usb_cycles;        /* Clocks for USB to send one buffer */
+    uint32_t watermark;
+} pp_config;
+
+/* One producer socket of the channel */
+typedef struct pp_socket
+{
+    uint32_t free;              /* Buffers owned by the socket, the active one included */
+    uint32_t words;             /* Words in the active buffer */
+    uint32_t switching;         /* Clocks left until the next buffer is active */
+    uint32_t first_word;        /* Stream position of the first word of the active buffer */
+    uint32_t committed[PP_QUEUE];       /* Committed buffers, by first word */
+    uint32_t head, tail;
+} pp_socket;
+
+typedef struct pp_result
+{
+    uint32_t buffers;           /* Buffers sent to USB */
+    uint32_t overflows;         /* Writes to a thread without an active buffer */
+    uint32_t split;             /* Bursts that did not end on a buffer boundary */
+    uint32_t misordered;        /* Buffers that reached USB out of order */
+    uint32_t max_gap;           /* Longest run of clocks without a write between buffers */
+    double mbps;                /* Bus rate from the first to the last write */
+} pp_result;
+
+static int verbose;
+
+/* The flags of a thread as the FX3 drives them */
+static void socket_flags(const pp_config *cfg, const pp_socket *s, int *ready, int *watermark)
+{
+    *ready = (s->free != 0) && (s->switching == 0);
+    *watermark = *ready && ((cfg->buf_words - s->words) > cfg->watermark);
+}
+
+static void run(const pp_config *cfg, pp_result *res)
+{
+    pp_socket sock[2];
+    uint32_t sockets = cfg->ping_pong ? 2 : 1;
+    pp_state state = PP_IDLE, next;
+    int thread_select = 0, next_select;
+    int flag_pin[4] = { 0, 0, 0, 0 }, flag_get[4] = { 0, 0, 0, 0 };
+    int slwr_pin = 1, addr_pin = 0, slwr_get, flag_ready, flag_wm, last_addr = -1;
+    uint32_t written = 0, sent = 0, usb_socket = 0, usb_left = 0, usb_buffer = 0;
+    uint32_t cycle, first_write = 0, last_write = 0, idle = 0, i;
+
+    memset(res, 0, sizeof(*res));
+    memset(sock, 0, sizeof(sock));
+    for (i = 0; i < sockets; i++)
+        sock[i].free = cfg->count / sockets;
+
+    for (cycle = 0; (res->buffers < PP_BUFFERS) && (cycle < PP_BUFFERS * (cfg->buf_words + cfg->usb_cycles) * 4);
+            cycle++)
+    {
+        /* Writer, combinational part: flag multiplexer, SLWR and next state */
+        flag_ready = thread_select ? flag_get[2] : flag_get[0];
+        flag_wm = thread_select ? flag_get[3] : flag_get[1];
+        slwr_get = ((state == PP_WRITE) && flag_wm) ? 0 : 1;
+        next = state;
+        switch (state)
+        {
+        case PP_IDLE:
+            if (flag_ready)
+                next = PP_WAIT_FLAGB;
+            break;
+        case PP_WAIT_FLAGB:
+            if (flag_wm)
+                next = PP_WRITE;
+            break;
+        case PP_WRITE:
+            if (!flag_wm)
+                next = PP_WR_DELAY;
+            break;
+        case PP_WR_DELAY:
+            next = PP_IDLE;
+            break;
+        }
+        next_select = (cfg->ping_pong && (state == PP_WR_DELAY)) ? !thread_select : thread_select;
+
+        /* FX3: sample the bus as the pin registers drove it during this clock */
+        if (slwr_pin == 0)
+        {
+            pp_socket *s = &sock[addr_pin];
+
+            if ((addr_pin >= (int) sockets) || (s->free == 0) || (s->switching != 0))
+                res->overflows++;
+            else
+            {
+                /* A new burst must start where the previous thread's buffer ended. */
+                if ((last_addr >= 0) && (last_addr != addr_pin) && (sock[last_addr].words != 0))
+                    res->split++;
+                if (s->words == 0)
+                    s->first_word = written;
+                s->words++;
+                if (s->words == cfg->buf_words)
+                {
+                    s->committed[s->tail++ % PP_QUEUE] = s->first_word;
+                    s->words = 0;
+                    s->free--;
+                    s->switching = cfg->switch_cycles;
+                }
+            }
+            if (written == 0)
+                first_write = cycle;
+            last_write = cycle;
+            written++;
+            last_addr = addr_pin;
+            if ((idle > res->max_gap) && (written > 1))
+                res->max_gap = idle;
+            idle = 0;
+        }
+        else
+            idle++;
+
+        for (i = 0; i < sockets; i++)
+            if (sock[i].switching != 0)
+                sock[i].switching--;
+
+        /* USB: the many-to-one consumer takes the sockets in turn and hands the
+         * buffer back to its producer when it has been sent. */
+        if (usb_left != 0)
+        {
+            if (--usb_left == 0)
+            {
+                sock[usb_socket].free++;
+                usb_socket = (usb_socket + 1) % sockets;
+                res->buffers++;
+            }
+        }
+        else if (sock[usb_socket].head != sock[usb_socket].tail)
+        {
+            usb_buffer = sock[usb_socket].committed[sock[usb_socket].head++ % PP_QUEUE];
+            if (usb_buffer != sent)
+                res->misordered++;
+            sent = usb_buffer + cfg->buf_words;
+            usb_left = cfg->usb_cycles;
+        }
+
+        /* The flag registers of slave_fifo_main take the pins as they were
+         * during this clock; then the FX3 updates them. FLAGC/FLAGD follow
+         * thread 1 only in ping-pong mode. */
+        memcpy(flag_get, flag_pin, sizeof(flag_get));
+        socket_flags(cfg, &sock[0], &flag_pin[0], &flag_pin[1]);
+        if (sockets == 2)
+            socket_flags(cfg, &sock[1], &flag_pin[2], &flag_pin[3]);
+
+        /* Registers of the writer and of slave_fifo_main */
+        slwr_pin = slwr_get;
+        addr_pin = thread_select;
+        state = next;
+        thread_select = next_select;
+    }
+
+    if (last_write > first_write)
+        res->mbps = (double) written * PP_BUS_BYTES * PP_CLOCK_MHZ / (last_write - first_write + 1);
+    if (verbose)
+        printf("  %s watermark %u usb %u clk/buffer: %u buffers, %.1f MB/s, gap %u, "
+                "%u overflows, %u split, %u out of order\n",
+                cfg->ping_pong ? "ping-pong" : "single   ", cfg->watermark, cfg->usb_cycles,
+                res->buffers, res->mbps, res->max_gap, res->overflows, res->split, res->misordered);
+}
+
+static int run_clean(const pp_result *res)
+{
+    return (res->buffers == PP_BUFFERS) && (res->overflows == 0) && (res->split == 0)
+            && (res->misordered == 0);
+}
+
+/* The channel setup of the firmware: an even P2U count split over two sockets */
+static void test_setup(void)
+{
+    CHECK(PP_COUNT_PTOU >= 2);
+    CHECK(PP_COUNT_PTOU <= CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT);
+    CHECK((PP_COUNT_PTOU & 1) == 0);
+    CHECK(PP_BUF_WORDS * PP_BUS_BYTES <= CY_FX_SLFIFO_DMA_BUF_MAX_BYTES);
+    CHECK(CY_FX_GPIF_FLAG_DMA_READY(1) == 0x11);
+    CHECK(CY_FX_GPIF_FLAG_DMA_WATERMARK(1) == 0x15);
+}
+
+static void test_stream(void)
+{
+    /* USB 3 at about 400 MB/s drains a buffer in half the time the bus fills it. */
+    pp_config cfg = { 0, PP_BUF_WORDS, PP_COUNT_PTOU, PP_SWITCH_CYCLES, PP_BUF_WORDS / 2, PP_WATERMARK };
+    pp_result single, pingpong;
+
+    run(&cfg, &single);
+    CHECK(run_clean(&single));
+    cfg.ping_pong = 1;
+    run(&cfg, &pingpong);
+    CHECK(run_clean(&pingpong));
+    CHECK(pingpong.max_gap <= CY_PP_MAX_GAP);
+    CHECK(single.max_gap > PP_SWITCH_CYCLES);
+    CHECK(pingpong.mbps > single.mbps);
+    CHECK(pingpong.mbps > 0.99 * PP_BUS_BYTES * PP_CLOCK_MHZ);
+
+    printf("  bus rate: single %.1f MB/s, ping-pong %.1f MB/s (limit %d MB/s)\n",
+            single.mbps, pingpong.mbps, PP_BUS_BYTES * PP_CLOCK_MHZ);
+}
+
+/* USB slower than the bus: the writer has to wait for buffers on both threads. */
+static void test_backpressure(void)
+{
+    pp_config cfg = { 1, PP_BUF_WORDS, PP_COUNT_PTOU, PP_SWITCH_CYCLES, PP_BUF_WORDS * 5, PP_WATERMARK };
+    pp_result res;
+
+    run(&cfg, &res);
+    CHECK(run_clean(&res));
+
+    /* Two buffers only, one per socket */
+    cfg.count = 2;
+    run(&cfg, &res);
+    CHECK(run_clean(&res));
+    cfg.ping_pong = 0;
+    run(&cfg, &res);
+    CHECK(run_clean(&res));
+}
+
+/* A watermark that does not match the writer's pipeline splits the bursts. */
+static void test_watermark(void)
+{
+    pp_config cfg = { 1, 64, 4, 10, 32, PP_WATERMARK - 1 };
+    pp_result res;
+
+    run(&cfg, &res);
+    CHECK(!run_clean(&res));
+    cfg.watermark = PP_WATERMARK + 1;
+    run(&cfg, &res);
+    CHECK(!run_clean(&res));
+    cfg.watermark = PP_WATERMARK;
+    run(&cfg, &res);
+    CHECK(run_clean(&res));
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "v")) != -1)
+    {
+        if (opt != 'v')
+        {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+        verbose = 1;
+    }
+
+    test_setup();
+    test_stream();
+    test_backpressure();
+    test_watermark();
+    return fx3_test_result("test_pingpong");
+}
@@ -1,169 +0,0 @@
-/*
- * Project Name: edit_sync_slave_fifo_2bit.cyfx
- * Time : 12/30/2014 12:08:01
- * Device Type: FX3
- * Project Type: GPIF2
- *
- *
- *
- *
- * This is a generated file and should not be modified
- * This file need to be included only once in the firmware
- * This file is generated by Gpif2 designer tool version - 1.0.1174.2
- * 
- */
-
-#ifndef _INCLUDED_CYFXGPIF2CONFIG_
-#define _INCLUDED_CYFXGPIF2CONFIG_
-#include "cyu3types.h"
-#include "cyu3gpif.h"
-
-/* Summary
-   Number of states in the state machine
- */
-#define CY_NUMBER_OF_STATES 5
-
-/* Summary
-   Mapping of user defined state names to state indices
- */
-#define RESET 0
-#define IDLE 1
-#define READ 2
-#define WRITE 3
-#define DSS_STATE 4
-
-
-/* Summary
-   Initial value of early outputs from the state machine.
- */
-#define ALPHA_RESET 0xC
-
-
-/* Summary
-   Transition function values used in the state machine.
- */
-uint16_t CyFxGpifTransition[]  = {
-    0x0000, 0x2000, 0x0202, 0x7F7F, 0x1F1F
-};
-
-/* Summary
-   Table containing the transition information for various states. 
-   This table has to be stored in the WAVEFORM Registers.
-   This array consists of non-replicated waveform descriptors and acts as a 
-   waveform table. 
- */
-CyU3PGpifWaveData CyFxGpifWavedata[]  = {
-    {{0x110CE001,0x000302C4,0x80000000},{0x00000000,0x00000000,0x00000000}},
-    {{0x3E080302,0x00000300,0x80000000},{0x110CE004,0x000302C4,0x80000000}},
-    {{0x3E080302,0x00000300,0x80000000},{0x110CE001,0x000302C4,0x80000000}},
-    {{0x00000000,0x00000000,0x00000000},{0x00000000,0x00000000,0x00000000}},
-    {{0x00000000,0x00000000,0x00000000},{0x4E002703,0x20000300,0x80000000}}
-};
-
-/* Summary
-   Table that maps state indices to the descriptor table indices.
- */
-uint8_t CyFxGpifWavedataPosition[]  = {
-    0,1,0,0,2,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
-    3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
-    3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
-    3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
-    0,4,0,0,4
-};
-
-/* Summary
-   GPIF II configuration register values.
- */
-uint32_t CyFxGpifRegValue[]  = {
-    0x80000380,  /*  CY_U3P_PIB_GPIF_CONFIG */
-    0x000010A7,  /*  CY_U3P_PIB_GPIF_BUS_CONFIG */
-    0x01000001,  /*  CY_U3P_PIB_GPIF_BUS_CONFIG2 */
-    0x00000044,  /*  CY_U3P_PIB_GPIF_AD_CONFIG */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_STATUS */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INTR */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INTR_MASK */
-    0x00000082,  /*  CY_U3P_PIB_GPIF_SERIAL_IN_CONFIG */
-    0x00000782,  /*  CY_U3P_PIB_GPIF_SERIAL_OUT_CONFIG */
-    0x00011500,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_DIRECTION */
-    0x0000FE8F,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_DEFAULT */
-    0x000001FF,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_POLARITY */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_TOGGLE */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000010,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000014,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000013,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000017,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
-    0x00000006,  /*  CY_U3P_PIB_GPIF_CTRL_COUNT_CONFIG */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_COUNT_RESET */
-    0x0000FFFF,  /*  CY_U3P_PIB_GPIF_CTRL_COUNT_LIMIT */
-    0x0000010A,  /*  CY_U3P_PIB_GPIF_ADDR_COUNT_CONFIG */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_ADDR_COUNT_RESET */
-    0x0000FFFF,  /*  CY_U3P_PIB_GPIF_ADDR_COUNT_LIMIT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_STATE_COUNT_CONFIG */
-    0x0000FFFF,  /*  CY_U3P_PIB_GPIF_STATE_COUNT_LIMIT */
-    0x0000010A,  /*  CY_U3P_PIB_GPIF_DATA_COUNT_CONFIG */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_DATA_COUNT_RESET */
-    0x0000FFFF,  /*  CY_U3P_PIB_GPIF_DATA_COUNT_LIMIT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_COMP_VALUE */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_COMP_MASK */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_DATA_COMP_VALUE */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_DATA_COMP_MASK */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_ADDR_COMP_VALUE */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_ADDR_COMP_MASK */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_DATA_CTRL */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_DATA */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_DATA */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_DATA */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_DATA */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_DATA */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_DATA */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_DATA */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_DATA */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_ADDRESS */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_ADDRESS */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_ADDRESS */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_ADDRESS */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_ADDRESS */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_ADDRESS */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_ADDRESS */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_ADDRESS */
-    0x80010400,  /*  CY_U3P_PIB_GPIF_THREAD_CONFIG */
-    0x80010401,  /*  CY_U3P_PIB_GPIF_THREAD_CONFIG */
-    0x80010402,  /*  CY_U3P_PIB_GPIF_THREAD_CONFIG */
-    0x80010403,  /*  CY_U3P_PIB_GPIF_THREAD_CONFIG */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_LAMBDA_STAT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_ALPHA_STAT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_BETA_STAT */
-    0x000C0000,  /*  CY_U3P_PIB_GPIF_WAVEFORM_CTRL_STAT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_WAVEFORM_SWITCH */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_WAVEFORM_SWITCH_TIMEOUT */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CRC_CONFIG */
-    0x00000000,  /*  CY_U3P_PIB_GPIF_CRC_DATA */
-    0xFFFFFFC1  /*  CY_U3P_PIB_GPIF_BETA_DEASSERT */
-};
-
-/* Summary
-   This structure holds all the configuration inputs for the GPIF II. 
- */
-const CyU3PGpifConfig_t CyFxGpifConfig  = {
-    (uint16_t)(sizeof(CyFxGpifWavedataPosition)/sizeof(uint8_t)),
-    CyFxGpifWavedata,
-    CyFxGpifWavedataPosition,
-    (uint16_t)(sizeof(CyFxGpifTransition)/sizeof(uint16_t)),
-    CyFxGpifTransition,
-    (uint16_t)(sizeof(CyFxGpifRegValue)/sizeof(uint32_t)),
-    CyFxGpifRegValue
-};
-
-#endif   /* _INCLUDED_CYFXGPIF2CONFIG_ */
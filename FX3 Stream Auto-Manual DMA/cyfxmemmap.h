@@ -0,0 +1,110 @@
+/*
+ ## Cypress USB 3.0 Platform header file (cyfxmemmap.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2011,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* This file contains the FX3 RAM map. It is shared by the RTOS porting layer (cyfxtx.c),
+ * which creates the driver and buffer heaps, and the application, which checks at build
+ * time that its DMA buffers fit into the buffer heap. All values are plain integers so
+ * that "make memmap" can evaluate them. */
+
+#ifndef _INCLUDED_CYFXMEMMAP_H_
+#define _INCLUDED_CYFXMEMMAP_H_
+
+/* Memory profile
+* Set CY_FX_RECLAIM_2STAGE_BOOT_AREA = 1 to add the last 32 KB of RAM, which the default
+* Cypress memory map reserves for 2-stage boot, to the DMA buffer heap. This application is
+* loaded directly by the boot loader and never uses 2-stage boot.
+* Set CY_FX_RECLAIM_2STAGE_BOOT_AREA = 0 for the default memory map. */
+#define CY_FX_RECLAIM_2STAGE_BOOT_AREA  (1)
+
+#ifdef CYMEM_256K
+
+/*
+   A reduced memory map is used with the CYUSB3011/CYUSB3012 devices:
+
+   Descriptor area    Base: 0x40000000 Size: 12  KB
+   Code area          Base: 0x40003000 Size: 128 KB
+   Data area          Base: 0x40023000 Size: 24  KB
+   Driver heap        Base: 0x40029000 Size: 28  KB
+   Buffer area        Base: 0x40030000 Size: 32  KB (64 KB with CY_FX_RECLAIM_2STAGE_BOOT_AREA)
+   2-stage boot area  Base: 0x40038000 Size: 32  KB (not reserved with CY_FX_RECLAIM_2STAGE_BOOT_AREA)
+ */
+
+/*
+   The following definitions specify the start address and length of the Driver heap
+   area which is used by the application code as well as the drivers to allocate thread
+   stacks and other internal data structures.
+ */
+#define CY_FX_MEM_HEAP_ADDR          (0x40029000)
+#define CY_U3P_MEM_HEAP_SIZE         (0x7000)
+
+#define CY_FX_MEM_RAM_TOP            (0x40040000)       /* End of the 256 KB of RAM */
+
+#else /* 512 KB RAM is available. */
+
+/*
+   The default application memory map for FX3 firmware is as follows:
+
+   Descriptor area    Base: 0x40000000 Size: 12  KB
+   Code area          Base: 0x40003000 Size: 180 KB
+   Data area          Base: 0x40030000 Size: 32  KB
+   Driver heap        Base: 0x40038000 Size: 32  KB
+   Buffer area        Base: 0x40040000 Size: 224 KB (256 KB with CY_FX_RECLAIM_2STAGE_BOOT_AREA)
+   2-stage boot area  Base: 0x40078000 Size: 32  KB (not reserved with CY_FX_RECLAIM_2STAGE_BOOT_AREA)
+ */
+
+/*
+   The following definitions specify the start address and length of the Driver heap
+   area which is used by the application code as well as the drivers to allocate thread
+   stacks and other internal data structures.
+ */
+#define CY_FX_MEM_HEAP_ADDR          (0x40038000)
+#define CY_U3P_MEM_HEAP_SIZE         (0x8000)
+
+#define CY_FX_MEM_RAM_TOP            (0x40080000)       /* End of the 512 KB of RAM */
+
+#endif
+
+/*
+   The last 32 KB of RAM is reserved for 2-stage boot operation unless the memory
+   profile reclaims it for the buffer heap.
+ */
+#define CY_FX_MEM_2STAGE_BOOT_SIZE   (0x8000)
+#if (CY_FX_RECLAIM_2STAGE_BOOT_AREA == 1)
+#define CY_U3P_SYS_MEM_TOP           (CY_FX_MEM_RAM_TOP)
+#else
+#define CY_U3P_SYS_MEM_TOP           ((CY_FX_MEM_RAM_TOP) - (CY_FX_MEM_2STAGE_BOOT_SIZE))
+#endif
+
+#define CY_U3P_MEM_HEAP_BASE         ((uint8_t *)CY_FX_MEM_HEAP_ADDR)
+
+/*
+   The buffer heap is used to obtain data buffers for DMA transfers in or out of
+   the FX3 device. The reference implementation of the buffer allocator makes use
+   of a reserved area in the SYSTEM RAM and ensures that all allocated DMA buffers
+   are aligned to cache lines.
+ */
+#define CY_U3P_BUFFER_HEAP_BASE      ((CY_FX_MEM_HEAP_ADDR) + (CY_U3P_MEM_HEAP_SIZE))
+#define CY_U3P_BUFFER_HEAP_SIZE      ((CY_U3P_SYS_MEM_TOP) - (CY_U3P_BUFFER_HEAP_BASE))
+
+#endif /* _INCLUDED_CYFXMEMMAP_H_ */
+
+/*[]*/
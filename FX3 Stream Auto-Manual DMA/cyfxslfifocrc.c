@@ -0,0 +1,180 @@
+/*
+ ## Cypress USB 3.0 Platform source file (cyfxslfifocrc.c)
+ ## ===========================
+ ##
+ ##  CRC32 of the loopback integrity check (CY_FX_SLFIFO_CRC_CHECK): the
+ ##  slice-by-4 CRC and the check points that compare the U2P and P2U streams.
+ ##  Called from the DMA callbacks or the worker thread in cyfxslfifosync.c,
+ ##  and kept apart from it so that test_crc in "FX3 Firmware Tests" can build
+ ##  it.
+ ## ===========================
+*/
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyfxslfifosync.h"
+
+/* Loopback CRC32 check. The U2P side writes glCrcMarks at glCrcMarkHead, the P2U
+ * side reads it at glCrcMarkTail; both run in the DMA callback (or worker) context. */
+typedef struct CyFxSlFifoCrcMark_t
+{
+    uint32_t offset;                    /* U2P stream offset at the end of the buffer. */
+    uint32_t crc;                       /* Running U2P CRC at that offset. */
+} CyFxSlFifoCrcMark_t;
+
+CyBool_t glCrcCheck = CY_FX_SLFIFO_CRC_CHECK;
+uint32_t glCrcTable[4][256];            /* Slice-by-4 CRC32 tables, built at init. */
+CyFxSlFifoCrcMark_t glCrcMarks[CY_FX_SLFIFO_CRC_QUEUE_SIZE];
+uint32_t glCrcMarkHead = 0;
+uint32_t glCrcMarkTail = 0;
+uint32_t glCrcUtoP = 0xFFFFFFFF;        /* Running CRC of the U2P stream. */
+uint32_t glCrcPtoU = 0xFFFFFFFF;        /* Running CRC of the P2U stream. */
+uint32_t glCrcOffsetUtoP = 0;           /* U2P bytes seen. */
+uint32_t glCrcOffsetPtoU = 0;           /* P2U bytes seen. */
+
+/* Build the slice-by-4 tables for the reflected CRC32 polynomial 0xEDB88320. */
+void CyFxSlFifoCrcInit(void)
+{
+    uint32_t c, i, k;
+
+    for (i = 0; i < 256; i++)
+    {
+        c = i;
+        for (k = 0; k < 8; k++)
+            c = (c & 1) ? ((c >> 1) ^ 0xEDB88320) : (c >> 1);
+        glCrcTable[0][i] = c;
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        for (k = 1; k < 4; k++)
+            glCrcTable[k][i] = (glCrcTable[k - 1][i] >> 8)
+                    ^ glCrcTable[0][glCrcTable[k - 1][i] & 0xFF];
+    }
+}
+
+/* Continue a CRC32 over count bytes. The state is neither pre- nor post-inverted
+ * here; the callers start at 0xFFFFFFFF and compare states directly. Aligned
+ * data (all DMA buffers) is processed a word at a time. */
+uint32_t CyFxSlFifoCrcUpdate(uint32_t crc, const uint8_t *buf_p, uint32_t count)
+{
+    const uint32_t *word_p;
+
+    while ((count != 0) && (((uint32_t) buf_p & 3) != 0))
+    {
+        crc = (crc >> 8) ^ glCrcTable[0][(crc ^ *buf_p++) & 0xFF];
+        count--;
+    }
+
+    word_p = (const uint32_t *) buf_p;
+    while (count >= 4)
+    {
+        crc ^= *word_p++;
+        crc = glCrcTable[3][crc & 0xFF] ^ glCrcTable[2][(crc >> 8) & 0xFF]
+                ^ glCrcTable[1][(crc >> 16) & 0xFF] ^ glCrcTable[0][crc >> 24];
+        count -= 4;
+    }
+
+    buf_p = (const uint8_t *) word_p;
+    while (count != 0)
+    {
+        crc = (crc >> 8) ^ glCrcTable[0][(crc ^ *buf_p++) & 0xFF];
+        count--;
+    }
+
+    return crc;
+}
+
+/* Restart both CRC streams. Called whenever data in flight may have been lost:
+ * channel creation, channel resets and GPIF error recovery. */
+void CyFxSlFifoCrcReset(void)
+{
+    uint32_t intMask;
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    glCrcMarkHead = 0;
+    glCrcMarkTail = 0;
+    glCrcUtoP = 0xFFFFFFFF;
+    glCrcPtoU = 0xFFFFFFFF;
+    glCrcOffsetUtoP = 0;
+    glCrcOffsetPtoU = 0;
+    CyU3PVicEnableInterrupts(intMask);
+}
+
+/* U2P side of the CRC check: account for a buffer about to be committed to
+ * the GPIF and queue a check point at its end. If the queue is full the check
+ * point is skipped; the next one still covers the data, as the CRC runs over
+ * the whole stream. */
+void CyFxSlFifoCrcUtoP(uint8_t *buf_p, uint32_t count)
+{
+    CyFxSlFifoCrcMark_t *mark_p;
+
+    if (!glCrcCheck)
+        return;
+
+    CyFxSlFifoDCacheMaint(buf_p, count, CyFalse);
+    glCrcUtoP = CyFxSlFifoCrcUpdate(glCrcUtoP, buf_p, count);
+    glCrcOffsetUtoP += count;
+
+    if ((glCrcMarkHead - glCrcMarkTail) < CY_FX_SLFIFO_CRC_QUEUE_SIZE)
+    {
+        mark_p = &glCrcMarks[glCrcMarkHead & (CY_FX_SLFIFO_CRC_QUEUE_SIZE - 1)];
+        mark_p->offset = glCrcOffsetUtoP;
+        mark_p->crc = glCrcUtoP;
+        glCrcMarkHead++;
+    }
+}
+
+/* P2U side of the CRC check: run the returned data through the CRC and compare
+ * at every check point that falls into this buffer. */
+void CyFxSlFifoCrcPtoU(uint8_t *buf_p, uint32_t count)
+{
+    CyFxSlFifoCrcMark_t *mark_p;
+    uint32_t pos = 0, len, intMask;
+
+    if (!glCrcCheck)
+        return;
+
+    CyFxSlFifoDCacheMaint(buf_p, count, CyFalse);
+    while (pos < count)
+    {
+        len = count - pos;
+        if (glCrcMarkTail == glCrcMarkHead)
+        {
+            /* More data came back than was sent so far. */
+            glCrcPtoU = CyFxSlFifoCrcUpdate(glCrcPtoU, buf_p + pos, len);
+            glCrcOffsetPtoU += len;
+            break;
+        }
+
+        mark_p = &glCrcMarks[glCrcMarkTail & (CY_FX_SLFIFO_CRC_QUEUE_SIZE - 1)];
+        if ((int32_t) (mark_p->offset - glCrcOffsetPtoU) > (int32_t) len)
+        {
+            glCrcPtoU = CyFxSlFifoCrcUpdate(glCrcPtoU, buf_p + pos, len);
+            glCrcOffsetPtoU += len;
+            break;
+        }
+
+        /* Run up to the check point. A check point behind the P2U offset can only
+         * have been passed because extra data came back; it fails the compare. */
+        if ((int32_t) (mark_p->offset - glCrcOffsetPtoU) > 0)
+        {
+            len = mark_p->offset - glCrcOffsetPtoU;
+            glCrcPtoU = CyFxSlFifoCrcUpdate(glCrcPtoU, buf_p + pos, len);
+            glCrcOffsetPtoU += len;
+            pos += len;
+        }
+
+        intMask = CyU3PVicDisableAllInterrupts();
+        glTelemetry.crcChecked++;
+        if ((glCrcPtoU != mark_p->crc) || (glCrcOffsetPtoU != mark_p->offset))
+        {
+            glTelemetry.crcMismatch++;
+            glTelemetry.crcExpected = mark_p->crc;
+            glTelemetry.crcActual = glCrcPtoU;
+            glCrcPtoU = mark_p->crc;
+        }
+        CyU3PVicEnableInterrupts(intMask);
+        glCrcMarkTail++;
+    }
+}
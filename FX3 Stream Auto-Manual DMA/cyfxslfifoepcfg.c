@@ -0,0 +1,115 @@
+/*
+ ## Cypress USB 3.0 Platform source file (cyfxslfifoepcfg.c)
+ ## ===========================
+ ##
+ ##  Endpoint parameter block of the slave FIFO application and the patching
+ ##  of the configuration descriptors from it. CyFxSlFifoApplnEpConfig
+ ##  programs the endpoints from the same block, so the descriptors sent with
+ ##  CyU3PUsbSetDesc always match CyU3PSetEpConfig. Kept apart from
+ ##  cyfxslfifousbdscr.c, which may only hold the descriptors themselves, and
+ ##  from the SDK calls in cyfxslfifosync.c, so that the host descriptor test
+ ##  in "FX3 Firmware Tests" can build it.
+ ## ===========================
+*/
+
+#include "cyu3types.h"
+#include "cyu3usbconst.h"
+#include "cyfxslfifosync.h"
+
+/* Endpoint parameters for full, high and super speed. */
+const CyFxSlFifoEpParams_t glEpParams[3] =
+{
+    { CY_FX_SLFIFO_FS_PACKET_SIZE, 1, 0 },
+    { CY_FX_SLFIFO_HS_PACKET_SIZE, 1, 0 },
+    { CY_FX_SLFIFO_SS_PACKET_SIZE, CY_FX_SLFIFO_SS_BURST_LENGTH, CY_FX_SLFIFO_BULK_STREAMS }
+};
+
+/* Return the endpoint parameters for the given USB speed, or NULL if not supported. */
+const CyFxSlFifoEpParams_t *CyFxSlFifoGetEpParams(CyU3PUSBSpeed_t usbSpeed)
+{
+    switch (usbSpeed)
+    {
+    case CY_U3P_FULL_SPEED:
+        return &glEpParams[0];
+    case CY_U3P_HIGH_SPEED:
+        return &glEpParams[1];
+    case CY_U3P_SUPER_SPEED:
+        return &glEpParams[2];
+    default:
+        return NULL;
+    }
+}
+
+/* Walk a configuration descriptor and write the packet size into every bulk endpoint
+ * descriptor and the burst length and stream count into every SS companion descriptor.
+ * The descriptor is sent by the DMA engine, so with the D-cache enabled the patched
+ * lines are written back to memory. */
+void CyFxSlFifoApplnPatchConfigDscr(uint8_t *dscr_p, const CyFxSlFifoEpParams_t *params_p)
+{
+    uint16_t offset = 0;
+    uint16_t totalLen = CY_U3P_MAKEWORD(dscr_p[3], dscr_p[2]);
+    uint8_t epAddr = 0;
+    uint8_t maxStreams = 0;
+
+    /* The companion descriptor holds the stream count as a power of two. */
+    while ((1 << maxStreams) < params_p->streams)
+        maxStreams++;
+
+    while ((offset + 2) <= totalLen)
+    {
+        uint8_t *d_p = dscr_p + offset;
+
+        if (d_p[0] < 2)
+            break;
+
+        if ((d_p[1] == CY_U3P_USB_ENDPNT_DESCR) && (d_p[3] == CY_U3P_USB_EP_BULK))
+        {
+            epAddr = d_p[2];
+            d_p[4] = CY_U3P_GET_LSB(params_p->pktSize);
+            d_p[5] = CY_U3P_GET_MSB(params_p->pktSize);
+        }
+        else if (d_p[1] == CY_U3P_SS_EP_COMPN_DESCR)
+        {
+            d_p[2] = params_p->burstLen - 1;
+            d_p[3] = (epAddr == CY_FX_EP_CONSUMER) ? maxStreams : 0;
+        }
+
+        offset += d_p[0];
+    }
+
+    CyFxSlFifoDCacheMaint(dscr_p, totalLen, CyTrue);
+}
+
+/* Write the U1 and U2 exit latencies (us) into the SuperSpeed device capability of
+ * a BOS descriptor, capped at the limits of the fields. */
+void CyFxSlFifoApplnPatchBosDscr(uint8_t *dscr_p, uint32_t u1Exit, uint32_t u2Exit)
+{
+    uint16_t offset = dscr_p[0];
+    uint16_t totalLen = CY_U3P_MAKEWORD(dscr_p[3], dscr_p[2]);
+
+    if (u1Exit > CY_FX_SLFIFO_U1_EXIT_MAX)
+        u1Exit = CY_FX_SLFIFO_U1_EXIT_MAX;
+    if (u2Exit > CY_FX_SLFIFO_U2_EXIT_MAX)
+        u2Exit = CY_FX_SLFIFO_U2_EXIT_MAX;
+
+    while ((offset + 10) <= totalLen)
+    {
+        uint8_t *d_p = dscr_p + offset;
+
+        if (d_p[0] < 3)
+            break;
+
+        if ((d_p[1] == CY_U3P_DEVICE_CAPB_DESCR) && (d_p[2] == CY_U3P_SS_USB_CAPB_TYPE))
+        {
+            d_p[7] = (uint8_t) u1Exit;
+            d_p[8] = CY_U3P_GET_LSB(u2Exit);
+            d_p[9] = CY_U3P_GET_MSB(u2Exit);
+        }
+
+        offset += d_p[0];
+    }
+
+    CyFxSlFifoDCacheMaint(dscr_p, totalLen, CyTrue);
+}
+
+/*[]*/
@@ -48,6 +48,18 @@
 
  The constant CY_FX_SLFIFO_GPIF_16_32BIT_CONF_SELECT in the header file is used to
  select 16bit or 32bit GPIF data bus configuration.
+
+ The constant CY_FX_SLFIFO_P2U_PINGPONG selects a many-to-one P to U channel that is
+ fed from GPIF threads 0 and 1. The FPGA alternates between the two threads so that
+ it never has to wait for a single producer socket to switch buffers.
+
+ The constant CY_FX_SLFIFO_BULK_STREAMS enables SuperSpeed bulk streams on the IN
+ endpoint. Stream 2 is fed from GPIF thread 1 through its own DMA channel, so the
+ FPGA can send status data next to the main stream without head-of-line blocking.
+
+ The constant CY_FX_SLFIFO_SECOND_EP_PAIR adds a second bulk endpoint pair (EP 2)
+ connected to GPIF threads 1 and 2 through two small AUTO channels, for a command
+ stream that runs next to the data stream on EP 1.
  */
 #include "cyu3system.h"
 #include "cyu3os.h"
@@ -58,6 +70,7 @@
 #include "cyfxslfifosync.h"
 #include "cyu3gpif.h"
 #include "cyu3pib.h"
+#include "cyu3gpio.h"
 #include "pib_regs.h"
 /* This file should be included only once as it contains
  * structure definitions. Including it in multiple places
@@ -65,11 +78,127 @@
 #include "cyfxgpif2config.h" //edit
  
 CyU3PThread slFifoAppThread; /* Slave FIFO application thread structure */
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+CyU3PThread slFifoWorkerThread; /* Deferred buffer processing thread structure */
+#endif
 CyU3PDmaChannel glChHandleSlFifoUtoP; /* DMA Channel handle for U2P transfer. */
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+CyU3PDmaMultiChannel glChHandleSlFifoPtoU; /* Many-to-one DMA Channel handle for P2U transfer. */
+#else
 CyU3PDmaChannel glChHandleSlFifoPtoU; /* DMA Channel handle for P2U transfer. */
+#endif
+CyU3PDmaChannel glChHandleSlFifoStream2; /* DMA Channel handle for bulk stream 2. */
+CyU3PDmaChannel glChHandleSource; /* DMA Channel handle for the CPU pattern source (link test). */
+CyU3PDmaChannel glChHandleSink; /* DMA Channel handle for the CPU sink (link test). */
+uint16_t glDataMode = CY_FX_SLFIFO_DATA_GPIF; /* CY_FX_SLFIFO_DATA_xxx flags. */
+uint16_t glSourcePattern = CY_FX_SLFIFO_PATTERN_CONSTANT; /* Pattern of the CPU source. */
+uint32_t glSourceCounter = 0; /* Next word of the counter pattern. */
+CyBool_t glStreamsActive = CyFalse; /* Whether bulk streams are enabled on the IN endpoint. */
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+CyU3PDmaChannel glChHandleEp2UtoP; /* DMA Channel handle for EP 2 OUT to GPIF thread 2. */
+CyU3PDmaChannel glChHandleEp2PtoU; /* DMA Channel handle for GPIF thread 1 to EP 2 IN. */
+#endif
+
+/* Telemetry counters, updated from the DMA and PIB callbacks. Read through
+ * CyFxSlFifoTelemetrySnapshot, which returns a consistent copy. */
+CyFxSlFifoTelemetry_t glTelemetry;
+uint64_t glTelemetryIntervalSum = 0;    /* Sum of the P2U inter-buffer intervals. */
+uint32_t glTelemetryLastPtoU = 0;       /* Time of the last P2U buffer in us. */
+
+/* State of the microsecond time base (CyFxSlFifoGetTimeUs). */
+CyBool_t glTimerActive = CyFalse;       /* Whether the GPIO timer is running. */
+uint32_t glTimerLastTicks = 0;          /* Timer count at the last conversion. */
+uint32_t glTimerUs = 0;                 /* Microseconds up to glTimerLastTicks. */
+uint32_t glTimerRemainder = 0;          /* Ticks x 1000 not yet converted. */
+
+/* Channel type and profile. Initialized from AUTO_MANUAL_CONF_SELECT and
+ * CY_FX_SLFIFO_BOOT_PROFILE and changed at runtime through CY_FX_RQT_SET_PROFILE. */
+CyBool_t glIsDmaManual = (AUTO_MANUAL_CONF_SELECT == 1) ? CyTrue : CyFalse;
+uint16_t glProfile = CY_FX_SLFIFO_BOOT_PROFILE;
+uint8_t glBurstLen = 0; /* Set through CY_FX_RQT_SET_BURST_LENGTH, 0 = burst length of the profile. */
+const CyFxSlFifoProfile_t glProfiles[2] =
+{
+    { CY_FX_SLFIFO_STREAM_BUF_SIZE, CY_FX_SLFIFO_STREAM_COUNT_P_2_U,
+      CY_FX_SLFIFO_STREAM_COUNT_U_2_P, CY_FX_SLFIFO_STREAM_BURST_LENGTH },
+    { CY_FX_SLFIFO_LOOPBACK_BUF_SIZE, CY_FX_SLFIFO_LOOPBACK_COUNT_P_2_U,
+      CY_FX_SLFIFO_LOOPBACK_COUNT_U_2_P, CY_FX_SLFIFO_LOOPBACK_BURST_LENGTH }
+};
+
+/* DMA buffer geometry. Initialized from the compile time defaults in cyfxslfifosync.h
+ * and changed at runtime through the CY_FX_RQT_SET_DMA_CONFIG vendor request. */
+uint16_t glDmaBufSize = DMA_BUF_SIZE;                          /* DMA buffer size in packets. */
+uint16_t glDmaBufCountPtoU = CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U;  /* P2U channel buffer count. */
+uint16_t glDmaBufCountUtoP = CY_FX_SLFIFO_DMA_BUF_COUNT_U_2_P;  /* U2P channel buffer count. */
+uint16_t glDmaPktSize = 1024;                                  /* Endpoint packet size for the current USB speed. */
+
+/* Framed P2U mode: every P2U buffer starts with a CyFxSlFifoFrameHeader_t. */
+CyBool_t glP2UFramed = CY_FX_SLFIFO_P2U_FRAMED;
+uint32_t glP2USequence = 0; /* Sequence number of the next framed P2U buffer. */
+volatile CyBool_t glP2UDiscontinuity = CyFalse; /* Data was lost since the last framed buffer. */
+
+/* GPIF threads with a pending overrun/underrun, one bit per thread. */
+volatile uint32_t glPibErrorThreads = 0;
+CyBool_t glGpifRestartPending = CyFalse;    /* The GPIF state machine could not be restarted. */
+
+/* Measured U1/U2 exit latencies in us, index 0 = U1, 1 = U2. The samples are
+ * counted per enumeration, the maxima are kept across enumerations. */
+uint32_t glLpmExitMax[2] = { 0, 0 };
+uint8_t glLpmExitSamples[2] = { 0, 0 };
+
+/* P2U wrap-up timer. The timer callback only signals the application thread,
+ * which does the wrap-up, because the DMA APIs cannot be called from a timer. */
+CyU3PTimer glWrapUpTimer;
+CyU3PEvent glSlFifoEvent;               /* Application thread events. */
+uint32_t glWrapUpTimeout = CY_FX_SLFIFO_WRAPUP_TIMEOUT;   /* Wrap-up timeout in us, 0 = off. */
+volatile uint32_t glP2ULastProduce = 0;     /* Time of the last P2U produce event, in us. */
+
+/* Link power management: time of the last data movement on the U2P or P2U channel.
+ * MANUAL channels update it from the DMA callbacks; AUTO channels have no callback
+ * and are polled from the application thread instead. */
+volatile uint32_t glLastActivity = 0;
+uint32_t glLastXferCountUtoP = 0;   /* Producer transfer counts seen at the last poll. */
+uint32_t glLastXferCountPtoU = 0;
+
+/* CPU benchmark result, see CY_FX_RQT_CPU_BENCHMARK. */
+CyFxSlFifoBenchResult_t glBenchResult = { CY_FX_SLFIFO_BENCH_PENDING };
+uint32_t glP2UChecksum = 0;     /* Word sum of the last processed P2U buffer. */
+
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+/* Descriptors of produced buffers waiting for the worker thread. The DMA callback
+ * is the only writer of head. tail is written by the worker thread and, when the
+ * channel is reset, by CyFxSlFifoWorkerDrop, both with the lock of the ring held.
+ * The lock is also held while the worker commits a buffer of the channel. */
+typedef struct CyFxSlFifoBufRing_t
+{
+    volatile uint32_t head;                 /* Next entry to be written by the callback. */
+    volatile uint32_t tail;                 /* Next entry to be read by the worker. */
+    uint32_t drops;                         /* Number of times the ring was dropped. */
+    CyU3PMutex lock;
+    volatile CyU3PDmaBuffer_t desc[CY_FX_SLFIFO_WORKER_RING_SIZE];
+} CyFxSlFifoBufRing_t;
+
+CyFxSlFifoBufRing_t glRingUtoP;         /* U2P buffers to be committed to the GPIF. */
+CyFxSlFifoBufRing_t glRingPtoU;         /* P2U buffers to be committed to USB. */
+CyU3PEvent glWorkerEvent;               /* Wakes up the worker thread. */
+#endif
+uint16_t glWorkerPasses = CY_FX_SLFIFO_P2U_CPU_PROCESS; /* Processing passes per buffer. */
+
+#if (CY_FX_SLFIFO_TRACE_ENABLE == 1)
+/* Event trace ring. Written from any context with interrupts locked out. */
+CyFxSlFifoTraceRecord_t glTraceRing[CY_FX_SLFIFO_TRACE_RING_SIZE];
+uint32_t glTraceHead = 0;               /* Next record to be written. */
+uint32_t glTraceTail = 0;               /* Next record to be read by the host. */
+uint32_t glTraceDropped = 0;            /* Records dropped since the last read. */
+uint16_t glTraceSequence = 0;           /* Sequence number of the next event. */
+#endif
+uint16_t glTraceMask = CY_FX_SLFIFO_TRACE_MASK_DEFAULT; /* Events to be recorded. */
+
+/* Buffer used for vendor request data phases. */
+uint8_t glEp0Buffer[CY_FX_EP0_BUFFER_SIZE] __attribute__ ((aligned (32)));
+
+/* DMA buffer manager defined in cyfxtx.c. Used to check the buffer heap size. */
+extern CyU3PDmaBufMgr_t glBufferManager;
 
-uint32_t glDMARxCount = 0; /* Counter to track the number of buffers received from USB. */
-uint32_t glDMATxCount = 0; /* Counter to track the number of buffers sent to USB. */
 CyBool_t glIsApplnActive = CyFalse; /* Whether the loopback application is active or not. */
 
 /* Application Error Handler */
@@ -135,6 +264,486 @@ void CyFxSlFifoApplnDebugInit(void)
     }
 }
 
+/* Millisecond timestamp for timeouts and the LPM idle time: RTOS tick count. */
+uint32_t CyFxSlFifoGetTimestamp(void)
+{
+    return CyU3PGetTime();
+}
+
+/* Start the free running GPIO timer behind CyFxSlFifoGetTimeUs. If it cannot be
+ * set up, CyFxSlFifoGetTimeUs falls back to the RTOS tick. */
+void CyFxSlFifoTimerInit(void)
+{
+    CyU3PGpioClock_t gpioClock;
+    CyU3PGpioComplexConfig_t timerCfg;
+    CyU3PReturnStatus_t apiRetStatus;
+
+    gpioClock.fastClkDiv = CY_FX_SLFIFO_TIMER_CLK_DIV;
+    gpioClock.slowClkDiv = 0;
+    gpioClock.halfDiv = CyFalse;
+    gpioClock.simpleDiv = CY_U3P_GPIO_SIMPLE_DIV_BY_2;
+    gpioClock.clkSrc = CY_U3P_SYS_CLK_BY_16;
+    apiRetStatus = CyU3PGpioInit(&gpioClock, NULL);
+    if (apiRetStatus == CY_U3P_SUCCESS)
+    {
+        CyU3PMemSet((uint8_t *) &timerCfg, 0, sizeof(timerCfg));
+        timerCfg.outValue = CyFalse;
+        timerCfg.inputEn = CyFalse;
+        timerCfg.driveLowEn = CyFalse;
+        timerCfg.driveHighEn = CyFalse;
+        timerCfg.pinMode = CY_U3P_GPIO_MODE_STATIC;
+        timerCfg.intrMode = CY_U3P_GPIO_NO_INTR;
+        timerCfg.timerMode = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+        timerCfg.timer = 0;
+        timerCfg.period = 0xFFFFFFFF;
+        timerCfg.threshold = 0xFFFFFFFF;
+        apiRetStatus = CyU3PGpioSetComplexConfig(CY_FX_SLFIFO_TIMER_GPIO, &timerCfg);
+    }
+    if (apiRetStatus == CY_U3P_SUCCESS)
+        apiRetStatus = CyU3PGpioComplexSampleNow(CY_FX_SLFIFO_TIMER_GPIO, &glTimerLastTicks);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "GPIO timer init failed, timestamps in ms steps, Error code = %d\n",
+                apiRetStatus);
+        return;
+    }
+
+    glTimerUs = CyU3PGetTime() * 1000;
+    glTimerActive = CyTrue;
+}
+
+/* Microsecond timestamp for the frame headers, the telemetry intervals and the
+ * trace. Safe to call with interrupts locked out. The
+ * ticks elapsed since the last call are converted with the remainder carried
+ * over, so the result does not drift. Wraps after 2^32 us. */
+uint32_t CyFxSlFifoGetTimeUs(void)
+{
+    uint32_t intMask, ticks, elapsed, now;
+
+    if (!glTimerActive)
+        return (CyU3PGetTime() * 1000);
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    CyU3PGpioComplexSampleNow(CY_FX_SLFIFO_TIMER_GPIO, &ticks);
+    elapsed = ticks - glTimerLastTicks;
+    glTimerLastTicks = ticks;
+
+    /* 32-bit arithmetic as long as elapsed * 1000 fits, i.e. for calls less than
+     * 340 ms apart, which is the usual case. */
+    if (elapsed < (0xFFFFFFFF / 1000 - CY_FX_SLFIFO_TIMER_KHZ))
+    {
+        elapsed = elapsed * 1000 + glTimerRemainder;
+        glTimerUs += elapsed / CY_FX_SLFIFO_TIMER_KHZ;
+        glTimerRemainder = elapsed % CY_FX_SLFIFO_TIMER_KHZ;
+    }
+    else
+    {
+        uint64_t scaled = (uint64_t) elapsed * 1000 + glTimerRemainder;
+        glTimerUs += (uint32_t) (scaled / CY_FX_SLFIFO_TIMER_KHZ);
+        glTimerRemainder = (uint32_t) (scaled % CY_FX_SLFIFO_TIMER_KHZ);
+    }
+    now = glTimerUs;
+    CyU3PVicEnableInterrupts(intMask);
+
+    return now;
+}
+
+/* D-cache maintenance for a region of a DMA buffer. The region is widened to whole
+ * cache lines; DMA buffers are line aligned and padded, so this never reaches into
+ * another buffer. Clean writes CPU changes back before the DMA engine reads the
+ * buffer, invalidate drops stale lines before the CPU reads data written by DMA.
+ * Buffers passed to a commit or send are cleaned by the DMA driver and need no
+ * clean here. Compiles to nothing unless CY_FX_SLFIFO_DCACHE_ENABLE is set. */
+void CyFxSlFifoDCacheMaint(uint8_t *buf_p, uint32_t count, CyBool_t isClean)
+{
+#if (CY_FX_SLFIFO_DCACHE_ENABLE == 1)
+    uint32_t start, end;
+
+    start = ((uint32_t) buf_p) & ~(CY_FX_SLFIFO_DCACHE_LINE_SIZE - 1);
+    end = (((uint32_t) buf_p) + count + CY_FX_SLFIFO_DCACHE_LINE_SIZE - 1)
+            & ~(CY_FX_SLFIFO_DCACHE_LINE_SIZE - 1);
+    if (end == start)
+        return;
+
+    if (isClean)
+        CyU3PSysCleanDRegion((uint32_t *) start, end - start);
+    else
+        CyU3PSysClearDRegion((uint32_t *) start, end - start);
+#endif
+}
+
+/* CPU processing step of the P2U path: a 32-bit word sum over the buffer. Stands
+ * in for in-firmware processing and is what the CPU benchmark measures. */
+uint32_t CyFxSlFifoProcessBuffer(const uint8_t *buf_p, uint16_t count)
+{
+    const uint32_t *word_p = (const uint32_t *) buf_p;
+    uint32_t sum = 0, i;
+
+    /* Make sure the CPU sees the data written by the DMA engine. */
+    CyFxSlFifoDCacheMaint((uint8_t *) buf_p, count, CyFalse);
+
+    for (i = 0; i < (count >> 2); i++)
+        sum += word_p[i];
+
+    return sum;
+}
+
+/* Fill the frame header that sits in the space reserved in front of a P2U
+ * buffer (prodHeader). Returns the number of bytes to be committed, which
+ * includes the header. When framing is off, the buffer is left untouched. */
+uint16_t CyFxSlFifoFrameHeaderFill(CyU3PDmaBuffer_t *buf_p)
+{
+    CyFxSlFifoFrameHeader_t *hdr_p;
+
+    if (!glP2UFramed)
+        return buf_p->count;
+
+    hdr_p = (CyFxSlFifoFrameHeader_t *) (buf_p->buffer
+            - CY_FX_SLFIFO_FRAME_HEADER_SIZE);
+    hdr_p->magic = CY_FX_SLFIFO_FRAME_MAGIC;
+    hdr_p->sequence = glP2USequence++;
+    hdr_p->byteCount = buf_p->count;
+    hdr_p->flags = (glP2UDiscontinuity) ? CY_FX_SLFIFO_FRAME_FLAG_DISCONTINUITY : 0;
+    hdr_p->timestamp = CyFxSlFifoGetTimeUs();
+    glP2UDiscontinuity = CyFalse;
+
+    /* The header lies inside the committed range, which the DMA driver cleans. */
+    return (buf_p->count + CY_FX_SLFIFO_FRAME_HEADER_SIZE);
+}
+
+/* This function turns the loopback CRC check on or off. Only MANUAL channels
+ * are supported, as the CPU has to see every buffer. */
+CyU3PReturnStatus_t CyFxSlFifoApplnSetCrcCheck(CyBool_t isEnabled)
+{
+    if (!glIsDmaManual)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    glCrcCheck = CyFalse;
+    CyFxSlFifoCrcReset();
+    glCrcCheck = isEnabled;
+    return CY_U3P_SUCCESS;
+}
+
+/* Burst length to program for the endpoints: the one set by the host or else
+ * the one of the active profile, capped at the burst length advertised in the
+ * descriptors. */
+uint8_t CyFxSlFifoEpBurst(const CyFxSlFifoEpParams_t *params_p)
+{
+    uint16_t burstLen = (glBurstLen != 0) ? glBurstLen : glProfiles[glProfile].burstLen;
+
+    if (burstLen < params_p->burstLen)
+        return (uint8_t) burstLen;
+    return params_p->burstLen;
+}
+
+/* Record one event in the trace ring. Safe to call from the DMA, PIB and USB
+ * callbacks: no formatting, no blocking, interrupts are only locked out while
+ * the record is written. Compiles to nothing unless CY_FX_SLFIFO_TRACE_ENABLE
+ * is set. */
+void CyFxSlFifoTrace(uint16_t event, uint32_t arg0, uint32_t arg1)
+{
+#if (CY_FX_SLFIFO_TRACE_ENABLE == 1)
+    CyFxSlFifoTraceRecord_t *rec_p;
+    uint32_t intMask;
+
+    if ((glTraceMask & (1 << event)) == 0)
+        return;
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    if ((glTraceHead - glTraceTail) < CY_FX_SLFIFO_TRACE_RING_SIZE)
+    {
+        rec_p = &glTraceRing[glTraceHead & (CY_FX_SLFIFO_TRACE_RING_SIZE - 1)];
+        rec_p->event = event;
+        rec_p->sequence = glTraceSequence;
+        rec_p->timestamp = CyFxSlFifoGetTimeUs();
+        rec_p->arg0 = arg0;
+        rec_p->arg1 = arg1;
+        glTraceHead++;
+    }
+    else
+    {
+        glTraceDropped++;
+    }
+    glTraceSequence++;
+    CyU3PVicEnableInterrupts(intMask);
+#endif
+}
+
+/* Move up to maxRecords of the oldest trace records, preceded by a
+ * CyFxSlFifoTraceHeader_t, into buf_p and remove them from the ring.
+ * Returns the number of bytes written. */
+uint16_t CyFxSlFifoTraceRead(uint8_t *buf_p, uint16_t maxRecords)
+{
+    CyFxSlFifoTraceHeader_t *hdr_p = (CyFxSlFifoTraceHeader_t *) buf_p;
+#if (CY_FX_SLFIFO_TRACE_ENABLE == 1)
+    CyFxSlFifoTraceRecord_t *rec_p = (CyFxSlFifoTraceRecord_t *) (buf_p + sizeof(CyFxSlFifoTraceHeader_t));
+    uint32_t intMask;
+    uint16_t count = 0;
+
+    /* Records are copied one at a time, so that interrupts are only ever
+     * locked out for the duration of a single copy. */
+    while (count < maxRecords)
+    {
+        intMask = CyU3PVicDisableAllInterrupts();
+        if (glTraceTail == glTraceHead)
+        {
+            CyU3PVicEnableInterrupts(intMask);
+            break;
+        }
+        rec_p[count++] = glTraceRing[glTraceTail & (CY_FX_SLFIFO_TRACE_RING_SIZE - 1)];
+        glTraceTail++;
+        CyU3PVicEnableInterrupts(intMask);
+    }
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    hdr_p->pending = (uint16_t) (glTraceHead - glTraceTail);
+    hdr_p->dropped = glTraceDropped;
+    glTraceDropped = 0;
+    CyU3PVicEnableInterrupts(intMask);
+
+    hdr_p->recordCount = count;
+    hdr_p->recordSize = sizeof(CyFxSlFifoTraceRecord_t);
+    hdr_p->mask = glTraceMask;
+    hdr_p->timestamp = CyFxSlFifoGetTimeUs();
+
+    return (sizeof(CyFxSlFifoTraceHeader_t) + count * sizeof(CyFxSlFifoTraceRecord_t));
+#else
+    return 0;
+#endif
+}
+
+/* Clear all telemetry counters. */
+void CyFxSlFifoTelemetryReset(void)
+{
+    uint32_t intMask;
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    CyU3PMemSet((uint8_t *) &glTelemetry, 0, sizeof(glTelemetry));
+    glTelemetry.intervalMin = 0xFFFFFFFF;
+    glTelemetryIntervalSum = 0;
+    glTelemetryLastPtoU = 0;
+    CyU3PVicEnableInterrupts(intMask);
+}
+
+/* Account for one buffer committed (or failed to commit) in the U to P direction. */
+void CyFxSlFifoTelemetryUtoP(uint16_t count, CyU3PReturnStatus_t status)
+{
+    uint32_t intMask;
+
+    glLastActivity = CyFxSlFifoGetTimestamp();
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_UTOP_BUF, count, status);
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    if (status == CY_U3P_SUCCESS)
+    {
+        glTelemetry.bytesUtoP += count;
+        glTelemetry.buffersUtoP++;
+    }
+    else
+    {
+        glTelemetry.commitFailUtoP++;
+    }
+    CyU3PVicEnableInterrupts(intMask);
+}
+
+/* Account for one buffer committed (or failed to commit) in the P to U direction
+ * and update the inter-buffer interval statistics. */
+void CyFxSlFifoTelemetryPtoU(uint16_t count, CyU3PReturnStatus_t status)
+{
+    uint32_t intMask, now, interval;
+
+    glLastActivity = CyFxSlFifoGetTimestamp();
+    now = CyFxSlFifoGetTimeUs();
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_PTOU_BUF, count, status);
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    if (status == CY_U3P_SUCCESS)
+    {
+        glTelemetry.bytesPtoU += count;
+        glTelemetry.buffersPtoU++;
+    }
+    else
+    {
+        glTelemetry.commitFailPtoU++;
+    }
+
+    if (glTelemetry.intervalCount++ != 0)
+    {
+        interval = now - glTelemetryLastPtoU;
+        if (interval < glTelemetry.intervalMin)
+            glTelemetry.intervalMin = interval;
+        if (interval > glTelemetry.intervalMax)
+            glTelemetry.intervalMax = interval;
+        glTelemetryIntervalSum += interval;
+    }
+    glTelemetryLastPtoU = now;
+    CyU3PVicEnableInterrupts(intMask);
+}
+
+/* Account for a GPIF thread overrun or underrun reported by the PIB block and
+ * hand the thread over to the application thread for recovery. */
+void CyFxSlFifoTelemetryPibError(uint8_t thread, CyBool_t isOverrun)
+{
+    uint32_t intMask;
+
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_PIB_ERROR, thread, isOverrun);
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    if (isOverrun)
+        glTelemetry.overrun[thread & 3]++;
+    else
+        glTelemetry.underrun[thread & 3]++;
+    glPibErrorThreads |= (1 << (thread & 3));
+    CyU3PVicEnableInterrupts(intMask);
+
+#if (CY_FX_SLFIFO_PIB_RECOVERY == 1)
+    CyU3PEventSet(&glSlFifoEvent, CY_FX_SLFIFO_EVT_PIB_ERROR, CYU3P_EVENT_OR);
+#endif
+}
+
+/* Take a consistent copy of the telemetry counters. Interrupts are locked out
+ * while copying so that no callback can update the block half way through. */
+void CyFxSlFifoTelemetrySnapshot(CyFxSlFifoTelemetry_t *snap_p, CyBool_t clear)
+{
+    uint32_t intMask, inUse, i;
+
+    /* The timestamp and the clear belong to the same critical section as the copy,
+     * so that a host computing rates from successive snapshots loses no bytes. The
+     * nested interrupt locks in the callees leave interrupts disabled. */
+    intMask = CyU3PVicDisableAllInterrupts();
+    CyU3PMemCopy((uint8_t *) snap_p, (uint8_t *) &glTelemetry,
+            sizeof(CyFxSlFifoTelemetry_t));
+    if (glTelemetry.intervalCount > 1)
+        snap_p->intervalAvg = (uint32_t) (glTelemetryIntervalSum
+                / (glTelemetry.intervalCount - 1));
+    snap_p->timestamp = CyFxSlFifoGetTimeUs();
+    if (clear)
+        CyFxSlFifoTelemetryReset();
+    CyU3PVicEnableInterrupts(intMask);
+
+    if (snap_p->intervalMin == 0xFFFFFFFF)
+        snap_p->intervalMin = 0;
+    snap_p->lpmExitU1 = glLpmExitMax[0];
+    snap_p->lpmExitU2 = glLpmExitMax[1];
+
+    /* Driver heap headroom: block pool usage is kept by the allocator in cyfxtx.c. */
+    for (i = 0; i < CY_FX_SLFIFO_MEM_POOL_STATS; i++)
+    {
+        if (CyU3PMemBlockPoolGetStats(i, &snap_p->memBlockSize[i], &inUse,
+                &snap_p->memHighWater[i], &snap_p->memFallbacks[i]) != CY_U3P_SUCCESS)
+        {
+            snap_p->memBlockSize[i] = 0;
+            snap_p->memHighWater[i] = 0;
+            snap_p->memFallbacks[i] = 0;
+        }
+    }
+}
+
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+/* Queue the descriptor of a produced buffer for the worker thread. Called from
+ * the DMA callbacks only. The ring holds at least as many entries as the channel
+ * has buffers, so it cannot overflow. */
+void CyFxSlFifoRingPut(CyFxSlFifoBufRing_t *ring_p, CyU3PDmaBuffer_t *buf_p)
+{
+    uint32_t head = ring_p->head;
+
+    ring_p->desc[head & (CY_FX_SLFIFO_WORKER_RING_SIZE - 1)] = *buf_p;
+    ring_p->head = head + 1;
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_WORKER_QUEUE, (ring_p == &glRingPtoU), buf_p->count);
+    CyU3PEventSet(&glWorkerEvent, CY_FX_SLFIFO_WORKER_EVT_BUFFER, CYU3P_EVENT_OR);
+}
+
+/* Take the oldest queued descriptor and the drop count it was taken at.
+ * Returns CyFalse if the ring is empty. Called from the worker thread only. */
+CyBool_t CyFxSlFifoRingGet(CyFxSlFifoBufRing_t *ring_p, CyU3PDmaBuffer_t *buf_p,
+        uint32_t *drops_p)
+{
+    uint32_t tail;
+    CyBool_t isQueued = CyFalse;
+
+    CyU3PMutexGet(&ring_p->lock, CYU3P_WAIT_FOREVER);
+    tail = ring_p->tail;
+    if (tail != ring_p->head)
+    {
+        *buf_p = ring_p->desc[tail & (CY_FX_SLFIFO_WORKER_RING_SIZE - 1)];
+        ring_p->tail = tail + 1;
+        isQueued = CyTrue;
+    }
+    *drops_p = ring_p->drops;
+    CyU3PMutexPut(&ring_p->lock);
+
+    return isQueued;
+}
+#endif
+
+/* Stop the worker thread from committing buffers of the channels of the given
+ * rings (CY_FX_SLFIFO_RING_xxx) while they are reset or destroyed. The locks are
+ * always taken U2P first. Nothing to do without CY_FX_SLFIFO_DEFERRED_PROCESSING. */
+void CyFxSlFifoWorkerHold(uint8_t rings)
+{
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+    if (rings & CY_FX_SLFIFO_RING_UTOP)
+        CyU3PMutexGet(&glRingUtoP.lock, CYU3P_WAIT_FOREVER);
+    if (rings & CY_FX_SLFIFO_RING_PTOU)
+        CyU3PMutexGet(&glRingPtoU.lock, CYU3P_WAIT_FOREVER);
+#endif
+}
+
+/* Drop the descriptors the worker thread has not handled yet from the given
+ * rings, which must be held. Called after the channel has been reset or
+ * destroyed, when its callback can no longer queue buffers from before the
+ * reset: these were returned to the producer. A descriptor the worker is
+ * processing at this time is not committed either. */
+void CyFxSlFifoWorkerDrop(uint8_t rings)
+{
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+    if (rings & CY_FX_SLFIFO_RING_UTOP)
+    {
+        glRingUtoP.tail = glRingUtoP.head;
+        glRingUtoP.drops++;
+    }
+    if (rings & CY_FX_SLFIFO_RING_PTOU)
+    {
+        glRingPtoU.tail = glRingPtoU.head;
+        glRingPtoU.drops++;
+    }
+#endif
+}
+
+/* Let the worker thread continue after CyFxSlFifoWorkerHold. */
+void CyFxSlFifoWorkerRelease(uint8_t rings)
+{
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+    if (rings & CY_FX_SLFIFO_RING_PTOU)
+        CyU3PMutexPut(&glRingPtoU.lock);
+    if (rings & CY_FX_SLFIFO_RING_UTOP)
+        CyU3PMutexPut(&glRingUtoP.lock);
+#endif
+}
+
+/* Processing step of the worker thread: glWorkerPasses passes of the word sum
+ * over the buffer. Returns the sum of the last pass. */
+uint32_t CyFxSlFifoWorkerProcess(CyU3PDmaBuffer_t *buf_p)
+{
+    uint32_t sum = 0;
+    uint16_t i;
+
+    for (i = 0; i < glWorkerPasses; i++)
+        sum = CyFxSlFifoProcessBuffer(buf_p->buffer, buf_p->count);
+
+    return sum;
+}
+
+/* This function changes the worker thread processing cost. */
+CyU3PReturnStatus_t CyFxSlFifoApplnSetWorkerCost(uint16_t passes)
+{
+    if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 0)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    glWorkerPasses = passes;
+    return CY_U3P_SUCCESS;
+}
+
 /* DMA callback function to handle the produce events for U to P transfers. */
 void CyFxSlFifoUtoPDmaCallback(CyU3PDmaChannel *chHandle, CyU3PDmaCbType_t type,
         CyU3PDmaCBInput_t *input)
@@ -146,18 +755,20 @@ void CyFxSlFifoUtoPDmaCallback(CyU3PDmaChannel *chHandle, CyU3PDmaCbType_t type,
         /* This is a produce event notification to the CPU. This notification is 
          * received upon reception of every buffer. The buffer will not be sent
          * out unless it is explicitly committed. The call shall fail if there
-         * is a bus reset / usb disconnect or if there is any application error. */
+         * is a bus reset / usb disconnect or if there is any application error.
+         * The CPU only reads the data for the CRC check, which does its own
+         * cache maintenance. */
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+        CyFxSlFifoRingPut(&glRingUtoP, &input->buffer_p);
+#else
+        CyFxSlFifoCrcUtoP(input->buffer_p.buffer, input->buffer_p.count);
         status = CyU3PDmaChannelCommitBuffer(chHandle, input->buffer_p.count,
                 0);
-        if (status != CY_U3P_SUCCESS)
-        {
-            CyU3PDebugPrint(4,
-                    "CyU3PDmaChannelCommitBuffer failed, Error code = %d\n",
-                    status);
-        }
 
-        /* Increment the counter. */
-        glDMARxCount++;
+        /* Update the counters. Failures are reported through the telemetry
+         * block instead of the UART, which is too slow for this path. */
+        CyFxSlFifoTelemetryUtoP(input->buffer_p.count, status);
+#endif
     }
 }
 
@@ -172,94 +783,606 @@ void CyFxSlFifoPtoUDmaCallback(CyU3PDmaChannel *chHandle, CyU3PDmaCbType_t type,
         /* This is a produce event notification to the CPU. This notification is 
          * received upon reception of every buffer. The buffer will not be sent
          * out unless it is explicitly committed. The call shall fail if there
-         * is a bus reset / usb disconnect or if there is any application error. */
-        status = CyU3PDmaChannelCommitBuffer(chHandle, input->buffer_p.count,
-                0);
-        if (status != CY_U3P_SUCCESS)
+         * is a bus reset / usb disconnect or if there is any application error.
+         * In framed mode the header is filled in before the commit. */
+        glP2ULastProduce = CyFxSlFifoGetTimeUs();
+
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+        CyFxSlFifoRingPut(&glRingPtoU, &input->buffer_p);
+        return;
+#endif
+
+        /* A wrap-up of an empty socket buffer produces a zero length buffer,
+         * which must not reach the host. */
+        if (input->buffer_p.count == 0)
         {
-            CyU3PDebugPrint(4,
-                    "CyU3PDmaChannelCommitBuffer failed, Error code = %d\n",
-                    status);
+            CyU3PDmaChannelDiscardBuffer(chHandle);
+            CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_PTOU_EMPTY, 0, 0);
+            return;
         }
 
-        /* Increment the counter. */
-        glDMATxCount++;
+#if (CY_FX_SLFIFO_P2U_CPU_PROCESS == 1)
+        glP2UChecksum = CyFxSlFifoProcessBuffer(input->buffer_p.buffer,
+                input->buffer_p.count);
+#endif
+        CyFxSlFifoCrcPtoU(input->buffer_p.buffer, input->buffer_p.count);
+
+        status = CyU3PDmaChannelCommitBuffer(chHandle,
+                CyFxSlFifoFrameHeaderFill(&input->buffer_p), 0);
+
+        /* Update the counters. */
+        CyFxSlFifoTelemetryPtoU(input->buffer_p.count, status);
     }
 }
 
-/* This function starts the slave FIFO loop application. This is called
- * when a SET_CONF event is received from the USB host. The endpoints
- * are configured and the DMA pipe is setup in this function. */
-void CyFxSlFifoApplnStart(void)
+/* DMA callback function to handle the produce events for the ping-pong P to U
+ * channel. The many-to-one channel hands over the buffers from GPIF threads 0
+ * and 1 alternately, so the data reaches the host in the order it was written. */
+void CyFxSlFifoPtoUDmaMultiCallback(CyU3PDmaMultiChannel *chHandle,
+        CyU3PDmaCbType_t type, CyU3PDmaCBInput_t *input)
 {
-    uint16_t size = 0;
-    uint16_t burst_length = 0;
-    CyU3PEpConfig_t epCfg;
-    CyU3PDmaChannelConfig_t dmaCfg;
-    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
-    CyU3PUSBSpeed_t usbSpeed = CyU3PUsbGetSpeed();
-
-    /* First identify the usb speed. Once that is identified,
-     * create a DMA channel and start the transfer on this. */
+    CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 
-    /* Based on the Bus Speed configure the endpoint packet size */
-    switch (usbSpeed)
+    if (type == CY_U3P_DMA_CB_PROD_EVENT)
     {
-    case CY_U3P_FULL_SPEED:
-        size = 64;
-        burst_length = 1;
-        break;
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+        CyFxSlFifoRingPut(&glRingPtoU, &input->buffer_p);
+        return;
+#endif
 
-    case CY_U3P_HIGH_SPEED:
-        size = 512;
-        burst_length = 1;
-        break;
+#if (CY_FX_SLFIFO_P2U_CPU_PROCESS == 1)
+        glP2UChecksum = CyFxSlFifoProcessBuffer(input->buffer_p.buffer,
+                input->buffer_p.count);
+#endif
+        CyFxSlFifoCrcPtoU(input->buffer_p.buffer, input->buffer_p.count);
 
-    case CY_U3P_SUPER_SPEED:
-        size = 1024;
-        burst_length = 16; //edit
-        break;
+        status = CyU3PDmaMultiChannelCommitBuffer(chHandle,
+                CyFxSlFifoFrameHeaderFill(&input->buffer_p), 0);
 
-    default:
-        CyU3PDebugPrint(4, "Error! Invalid USB speed.\n");
-        CyFxAppErrorHandler(CY_U3P_ERROR_FAILURE);
-        break;
+        /* Update the counters. */
+        CyFxSlFifoTelemetryPtoU(input->buffer_p.count, status);
     }
+}
 
-    CyU3PMemSet((uint8_t *) &epCfg, 0, sizeof(epCfg));
-    epCfg.enable = CyTrue;
-    epCfg.epType = CY_U3P_USB_EP_BULK;
-    epCfg.burstLen = burst_length; //edit
-    epCfg.streams = 0;
-    epCfg.pcktSize = size;
+/* Wrap-up timer callback. Runs in the timer context, so only signal the
+ * application thread. */
+void CyFxSlFifoWrapUpTimerCb(uint32_t arg)
+{
+    CyU3PEventSet(&glSlFifoEvent, CY_FX_SLFIFO_EVT_WRAPUP, CYU3P_EVENT_OR);
+}
 
-    /* Producer endpoint configuration */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER, &epCfg);
+/* Called from the application thread when the wrap-up timer has fired. If no
+ * P2U buffer was produced for the wrap-up timeout, the partially filled buffer of
+ * the producer socket is wrapped up so that it is sent to the host. */
+void CyFxSlFifoApplnWrapUp(void)
+{
+    uint32_t now;
+
+    if ((!glIsApplnActive) || (glWrapUpTimeout == 0) || (glDataMode != CY_FX_SLFIFO_DATA_GPIF))
+        return;
+
+    now = CyFxSlFifoGetTimeUs();
+    if ((now - glP2ULastProduce) < glWrapUpTimeout)
+        return;
+
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 0)
+    /* Restart the timeout here, so that the socket is not wrapped up again
+     * before the produce event of this wrap-up has been seen. */
+    glP2ULastProduce = now;
+    CyU3PDmaChannelSetWrapUp(&glChHandleSlFifoPtoU);
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_WRAPUP, 0, 0);
+#endif
+}
+
+/* This function changes the wrap-up timeout (in us). A timeout of 0 stops the
+ * timer. The timer is only used with a single-socket MANUAL P2U channel. */
+CyU3PReturnStatus_t CyFxSlFifoApplnSetWrapUpTimeout(uint32_t timeout)
+{
+    uint32_t period;
+
+    if ((timeout != 0) && ((!glIsDmaManual)
+            || (CY_FX_SLFIFO_P2U_PINGPONG == 1)))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    CyU3PTimerStop(&glWrapUpTimer);
+    glWrapUpTimeout = timeout;
+    glP2ULastProduce = CyFxSlFifoGetTimeUs();
+
+    if ((timeout != 0) && (glIsApplnActive))
+    {
+        /* Poll at a quarter of the timeout, limited by the 1 ms tick. */
+        period = timeout / 4000;
+        if (period < CY_FX_SLFIFO_WRAPUP_POLL_MIN)
+            period = CY_FX_SLFIFO_WRAPUP_POLL_MIN;
+        CyU3PTimerModify(&glWrapUpTimer, period, period);
+        CyU3PTimerStart(&glWrapUpTimer);
+    }
+
+    return CY_U3P_SUCCESS;
+}
+
+/* Load the GPIF configuration and bind the GPIF threads to their sockets. */
+CyU3PReturnStatus_t CyFxSlFifoGpifLoad(void)
+{
+    CyU3PReturnStatus_t apiRetStatus;
+
+    apiRetStatus = CyU3PGpifLoad(&CyFxGpifConfig); //edit
     if (apiRetStatus != CY_U3P_SUCCESS)
+        return apiRetStatus;
+
+    //edit
+    CyU3PGpifSocketConfigure(0, CY_U3P_PIB_SOCKET_0, 3, CyFalse, 1);
+#if ((CY_FX_SLFIFO_USE_THREAD_1 == 1) || (CY_FX_SLFIFO_SECOND_EP_PAIR == 1))
+    CyU3PGpifSocketConfigure(1, CY_U3P_PIB_SOCKET_1, 3, CyFalse, 1);
+#endif
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    CyU3PGpifSocketConfigure(2, CY_U3P_PIB_SOCKET_2, 3, CyFalse, 1);
+#endif
+    CyU3PGpifSocketConfigure(3, CY_U3P_PIB_SOCKET_3, 3, CyFalse, 1);
+
+    return CY_U3P_SUCCESS;
+}
+
+/* Restart the GPIF state machine at IDLE after a recovery. Failed starts are
+ * counted and retried; after CY_FX_SLFIFO_GPIF_RESTART_RETRIES of them the GPIF
+ * is reloaded and started from RESET. If that fails as well, glGpifRestartPending
+ * stays set and the application thread calls this again on its next wake-up. */
+void CyFxSlFifoApplnGpifRestart(void)
+{
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+    uint32_t intMask, i;
+
+    for (i = 0; i < CY_FX_SLFIFO_GPIF_RESTART_RETRIES; i++)
     {
-        CyU3PDebugPrint(4, "CyU3PSetEpConfig failed, Error code = %d\n",
-                apiRetStatus);
-        CyFxAppErrorHandler(apiRetStatus);
+        apiRetStatus = CyU3PGpifSMStart(IDLE, ALPHA_RESET);
+        if (apiRetStatus == CY_U3P_SUCCESS)
+            break;
+
+        intMask = CyU3PVicDisableAllInterrupts();
+        glTelemetry.gpifStartFail++;
+        CyU3PVicEnableInterrupts(intMask);
     }
 
-    /* Consumer endpoint configuration */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint(4, "CyU3PSetEpConfig failed, Error code = %d\n",
+        CyU3PDebugPrint(4, "CyU3PGpifSMStart failed, reloading the GPIF, Error Code = %d\n",
                 apiRetStatus);
-        CyFxAppErrorHandler(apiRetStatus);
+        CyU3PGpifDisable(CyTrue);
+        apiRetStatus = CyFxSlFifoGpifLoad();
+        if (apiRetStatus == CY_U3P_SUCCESS)
+            apiRetStatus = CyU3PGpifSMStart(RESET, ALPHA_RESET);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            intMask = CyU3PVicDisableAllInterrupts();
+            glTelemetry.gpifStartFail++;
+            CyU3PVicEnableInterrupts(intMask);
+        }
     }
 
-    //edit
-    if (AUTO_MANUAL_CONF_SELECT == 0) //auto
+    glGpifRestartPending = (apiRetStatus != CY_U3P_SUCCESS) ? CyTrue : CyFalse;
+}
+
+/* Reset a DMA channel together with its sockets, flush the USB endpoint it is
+ * connected to and re-arm the transfer. rings names the held worker ring of
+ * the channel, which is dropped before the transfer is re-armed. */
+void CyFxSlFifoApplnChannelRearm(CyU3PDmaChannel *chHandle, uint8_t ep,
+        uint32_t xferSize, uint8_t rings)
+{
+    CyU3PDmaChannelReset(chHandle);
+    CyFxSlFifoWorkerDrop(rings);
+    CyU3PUsbFlushEp(ep);
+    CyU3PDmaChannelSetXfer(chHandle, xferSize);
+}
+
+/* Called from the application thread after GPIFErrorCallback has reported an
+ * overrun or underrun. The GPIF state machine is stopped, the channels of the
+ * failing threads are reset and re-armed and the state machine is restarted at
+ * IDLE. Only the data that was in flight on those threads is lost. */
+void CyFxSlFifoApplnPibRecover(void)
+{
+    uint32_t intMask, threads;
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    threads = glPibErrorThreads;
+    glPibErrorThreads = 0;
+    CyU3PVicEnableInterrupts(intMask);
+
+    if ((!glIsApplnActive) || (threads == 0))
+        return;
+
+    /* Both rings are held, as the CRC check spans both directions, but only the
+     * rings of the channels that are reset are dropped. */
+    CyU3PGpifDisable(CyFalse);
+    CyFxSlFifoWorkerHold(CY_FX_SLFIFO_RING_ALL);
+    CyFxSlFifoCrcReset();
+
+    /* Both bulk streams run on CY_FX_EP_CONSUMER, whose endpoint memory can only
+     * be flushed as a whole. An error on either stream therefore resets both:
+     * stream 2 is stopped before the flush in the re-arm of stream 1 and is
+     * re-armed after it. */
+    if ((glStreamsActive) && (threads & 0x3))
     {
-        /* Create a DMA AUTO channel for U2P transfer. */
-        dmaCfg.size = DMA_BUF_SIZE * size;
-        dmaCfg.count = CY_FX_SLFIFO_DMA_BUF_COUNT_U_2_P;
-        dmaCfg.prodSckId = CY_FX_PRODUCER_USB_SOCKET;
-        dmaCfg.consSckId = CY_FX_CONSUMER_PPORT_SOCKET;
-        dmaCfg.prodAvailCount = 0;
+        threads |= 0x3;
+        CyU3PDmaChannelReset(&glChHandleSlFifoStream2);
+    }
+
+    /* Thread 0 (and thread 1 in ping-pong mode): P2U channel */
+    if (threads & ((CY_FX_SLFIFO_P2U_PINGPONG == 1) ? 0x3 : 0x1))
+    {
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+        CyU3PDmaMultiChannelReset(&glChHandleSlFifoPtoU);
+        CyFxSlFifoWorkerDrop(CY_FX_SLFIFO_RING_PTOU);
+        CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+        CyU3PDmaMultiChannelSetXfer(&glChHandleSlFifoPtoU,
+                CY_FX_SLFIFO_DMA_RX_SIZE, 0);
+#else
+        CyFxSlFifoApplnChannelRearm(&glChHandleSlFifoPtoU, CY_FX_EP_CONSUMER,
+                CY_FX_SLFIFO_DMA_RX_SIZE, CY_FX_SLFIFO_RING_PTOU);
+#endif
+        glP2UDiscontinuity = CyTrue;
+    }
+
+    /* Thread 1: bulk stream 2 (reset above) or EP 2 IN */
+    if ((threads & 0x2) && (glStreamsActive))
+    {
+        CyU3PDmaChannelSetXfer(&glChHandleSlFifoStream2, CY_FX_SLFIFO_DMA_RX_SIZE);
+    }
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    if (threads & 0x2)
+    {
+        CyFxSlFifoApplnChannelRearm(&glChHandleEp2PtoU, CY_FX_EP2_CONSUMER,
+                CY_FX_SLFIFO_DMA_RX_SIZE, 0);
+    }
+
+    /* Thread 2: EP 2 OUT */
+    if (threads & 0x4)
+    {
+        CyFxSlFifoApplnChannelRearm(&glChHandleEp2UtoP, CY_FX_EP2_PRODUCER,
+                CY_FX_SLFIFO_DMA_TX_SIZE, 0);
+    }
+#endif
+
+    /* Thread 3: U2P channel */
+    if (threads & 0x8)
+    {
+        CyFxSlFifoApplnChannelRearm(&glChHandleSlFifoUtoP, CY_FX_EP_PRODUCER,
+                CY_FX_SLFIFO_DMA_TX_SIZE, CY_FX_SLFIFO_RING_UTOP);
+    }
+
+    CyFxSlFifoWorkerRelease(CY_FX_SLFIFO_RING_ALL);
+
+    CyFxSlFifoApplnGpifRestart();
+
+    intMask = CyU3PVicDisableAllInterrupts();
+    glTelemetry.recoveries++;
+    CyU3PVicEnableInterrupts(intMask);
+
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_PIB_RECOVERY, threads, 0);
+}
+
+/* This function destroys the DMA channels of the slave FIFO application and
+ * flushes the endpoint memory. The endpoint configuration is left untouched. */
+void CyFxSlFifoApplnDmaStop(void)
+{
+    /* Flush the endpoint memory */
+    CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
+    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    CyU3PUsbFlushEp(CY_FX_EP2_PRODUCER);
+    CyU3PUsbFlushEp(CY_FX_EP2_CONSUMER);
+#endif
+
+    /* Destroy the channel. Destroying a channel that was never created is harmless,
+     * so this can also be used to clean up after a partial CyFxSlFifoApplnDmaStart. */
+    CyFxSlFifoWorkerHold(CY_FX_SLFIFO_RING_ALL);
+    CyU3PDmaChannelDestroy(&glChHandleSlFifoUtoP);
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+    CyU3PDmaMultiChannelDestroy(&glChHandleSlFifoPtoU);
+#else
+    CyU3PDmaChannelDestroy(&glChHandleSlFifoPtoU);
+#endif
+    CyFxSlFifoWorkerDrop(CY_FX_SLFIFO_RING_ALL);
+    CyFxSlFifoWorkerRelease(CY_FX_SLFIFO_RING_ALL);
+    CyU3PDmaChannelDestroy(&glChHandleSource);
+    CyU3PDmaChannelDestroy(&glChHandleSink);
+    if (glStreamsActive)
+        CyU3PDmaChannelDestroy(&glChHandleSlFifoStream2);
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    CyU3PDmaChannelDestroy(&glChHandleEp2UtoP);
+    CyU3PDmaChannelDestroy(&glChHandleEp2PtoU);
+#endif
+
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_DMA_STOP, 0, 0);
+}
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+/* This function creates the two AUTO channels of the second endpoint pair and
+ * starts the transfers on them. The command stream is low-rate and latency
+ * sensitive, so the channels use a few single-packet buffers. */
+CyU3PReturnStatus_t CyFxSlFifoApplnEp2DmaStart(void)
+{
+    CyU3PDmaChannelConfig_t dmaCfg;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    CyU3PMemSet((uint8_t *) &dmaCfg, 0, sizeof(dmaCfg));
+    dmaCfg.size = glDmaPktSize;
+    dmaCfg.count = CY_FX_SLFIFO_DMA_BUF_COUNT_EP2;
+    dmaCfg.prodSckId = CY_FX_EP2_PRODUCER_USB_SOCKET;
+    dmaCfg.consSckId = CY_FX_EP2_CONSUMER_PPORT_SOCKET;
+    dmaCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
+    dmaCfg.notification = 0;
+    dmaCfg.cb = NULL;
+    apiRetStatus = CyU3PDmaChannelCreate(&glChHandleEp2UtoP,
+            CY_U3P_DMA_TYPE_AUTO, &dmaCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PDmaChannelCreate failed, Error code = %d\n",
+                apiRetStatus);
+        return apiRetStatus;
+    }
+
+    dmaCfg.prodSckId = CY_FX_EP2_PRODUCER_PPORT_SOCKET;
+    dmaCfg.consSckId = CY_FX_EP2_CONSUMER_USB_SOCKET;
+    apiRetStatus = CyU3PDmaChannelCreate(&glChHandleEp2PtoU,
+            CY_U3P_DMA_TYPE_AUTO, &dmaCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PDmaChannelCreate failed, Error code = %d\n",
+                apiRetStatus);
+        return apiRetStatus;
+    }
+
+    apiRetStatus = CyU3PDmaChannelSetXfer(&glChHandleEp2UtoP,
+            CY_FX_SLFIFO_DMA_TX_SIZE);
+    if (apiRetStatus == CY_U3P_SUCCESS)
+    {
+        apiRetStatus = CyU3PDmaChannelSetXfer(&glChHandleEp2PtoU,
+                CY_FX_SLFIFO_DMA_RX_SIZE);
+    }
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PDmaChannelSetXfer Failed, Error code = %d\n",
+                apiRetStatus);
+    }
+
+    return apiRetStatus;
+}
+#endif
+
+/* This function creates the AUTO channel from GPIF thread 1 to the USB socket
+ * mapped to bulk stream 2 and starts the transfer on it. Status data is low-rate,
+ * so the channel uses a few single-packet buffers and no CPU intervention. */
+CyU3PReturnStatus_t CyFxSlFifoApplnStream2Start(void)
+{
+    CyU3PDmaChannelConfig_t dmaCfg;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    CyU3PMemSet((uint8_t *) &dmaCfg, 0, sizeof(dmaCfg));
+    dmaCfg.size = glDmaPktSize;
+    dmaCfg.count = CY_FX_SLFIFO_DMA_BUF_COUNT_STREAM;
+    dmaCfg.prodSckId = CY_FX_PRODUCER_PPORT_SOCKET_1;
+    dmaCfg.consSckId = CY_FX_CONSUMER_USB_SOCKET_1;
+    dmaCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
+    dmaCfg.notification = 0;
+    dmaCfg.cb = NULL;
+    apiRetStatus = CyU3PDmaChannelCreate(&glChHandleSlFifoStream2,
+            CY_U3P_DMA_TYPE_AUTO, &dmaCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PDmaChannelCreate failed, Error code = %d\n",
+                apiRetStatus);
+        return apiRetStatus;
+    }
+
+    apiRetStatus = CyU3PDmaChannelSetXfer(&glChHandleSlFifoStream2,
+            CY_FX_SLFIFO_DMA_RX_SIZE);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PDmaChannelSetXfer Failed, Error code = %d\n",
+                apiRetStatus);
+        CyU3PDmaChannelDestroy(&glChHandleSlFifoStream2);
+    }
+
+    return apiRetStatus;
+}
+
+/* Fill and commit every free buffer of the pattern source. The constant pattern
+ * is only written while priming; the buffers keep it when they come back. */
+void CyFxSlFifoSourceFill(CyU3PDmaChannel *chHandle, CyBool_t isPrime)
+{
+    CyU3PDmaBuffer_t buf;
+    uint32_t *word_p;
+    uint32_t i;
+
+    while (CyU3PDmaChannelGetBuffer(chHandle, &buf, CYU3P_NO_WAIT) == CY_U3P_SUCCESS)
+    {
+        if ((isPrime) || (glSourcePattern == CY_FX_SLFIFO_PATTERN_COUNTER))
+        {
+            word_p = (uint32_t *) buf.buffer;
+            for (i = 0; i < buf.size / 4; i++)
+                word_p[i] = (glSourcePattern == CY_FX_SLFIFO_PATTERN_COUNTER)
+                        ? glSourceCounter++ : CY_FX_SLFIFO_PATTERN_WORD;
+        }
+
+        if (CyU3PDmaChannelCommitBuffer(chHandle, buf.size, 0) != CY_U3P_SUCCESS)
+            break;
+    }
+}
+
+/* DMA callback of the pattern source: a buffer has been sent to the host, so
+ * account for it and hand out the next one. */
+void CyFxSlFifoSourceDmaCallback(CyU3PDmaChannel *chHandle, CyU3PDmaCbType_t type,
+        CyU3PDmaCBInput_t *input)
+{
+    if (type == CY_U3P_DMA_CB_CONS_EVENT)
+    {
+        CyFxSlFifoTelemetryPtoU(input->buffer_p.count, CY_U3P_SUCCESS);
+        CyFxSlFifoSourceFill(chHandle, CyFalse);
+    }
+}
+
+/* DMA callback of the sink: count the received buffer and drop it. */
+void CyFxSlFifoSinkDmaCallback(CyU3PDmaChannel *chHandle, CyU3PDmaCbType_t type,
+        CyU3PDmaCBInput_t *input)
+{
+    if (type == CY_U3P_DMA_CB_PROD_EVENT)
+    {
+        CyFxSlFifoTelemetryUtoP(input->buffer_p.count,
+                CyU3PDmaChannelDiscardBuffer(chHandle));
+    }
+}
+
+/* Start the transfers on the link test channels selected by mode and prime
+ * the pattern source. */
+CyU3PReturnStatus_t CyFxSlFifoApplnLinkTestArm(uint16_t mode)
+{
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    if (mode & CY_FX_SLFIFO_DATA_SINK)
+    {
+        apiRetStatus = CyU3PDmaChannelSetXfer(&glChHandleSink, CY_FX_SLFIFO_DMA_TX_SIZE);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+            return apiRetStatus;
+    }
+
+    if (mode & CY_FX_SLFIFO_DATA_SOURCE)
+    {
+        apiRetStatus = CyU3PDmaChannelSetXfer(&glChHandleSource, CY_FX_SLFIFO_DMA_RX_SIZE);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+            return apiRetStatus;
+        CyFxSlFifoSourceFill(&glChHandleSource, CyTrue);
+    }
+
+    return apiRetStatus;
+}
+
+/* This function creates the CPU channels of the link test modes in place of the
+ * GPIF channels: a MANUAL_OUT pattern source for EP 1 IN and a MANUAL_IN sink
+ * for EP 1 OUT, as selected by glDataMode. */
+CyU3PReturnStatus_t CyFxSlFifoApplnLinkTestStart(void)
+{
+    CyU3PDmaChannelConfig_t dmaCfg;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    CyU3PMemSet((uint8_t *) &dmaCfg, 0, sizeof(dmaCfg));
+    dmaCfg.size = glDmaBufSize * glDmaPktSize;
+    dmaCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
+
+    if (glDataMode & CY_FX_SLFIFO_DATA_SINK)
+    {
+        dmaCfg.count = glDmaBufCountUtoP;
+        dmaCfg.prodSckId = CY_FX_PRODUCER_USB_SOCKET;
+        dmaCfg.consSckId = CY_U3P_CPU_SOCKET_CONS;
+        dmaCfg.notification = CY_U3P_DMA_CB_PROD_EVENT;
+        dmaCfg.cb = CyFxSlFifoSinkDmaCallback;
+        apiRetStatus = CyU3PDmaChannelCreate(&glChHandleSink,
+                CY_U3P_DMA_TYPE_MANUAL_IN, &dmaCfg);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint(4, "CyU3PDmaChannelCreate failed, Error code = %d\n",
+                    apiRetStatus);
+            return apiRetStatus;
+        }
+    }
+
+    if (glDataMode & CY_FX_SLFIFO_DATA_SOURCE)
+    {
+        dmaCfg.count = glDmaBufCountPtoU;
+        dmaCfg.prodSckId = CY_U3P_CPU_SOCKET_PROD;
+        dmaCfg.consSckId = CY_FX_CONSUMER_USB_SOCKET;
+        dmaCfg.notification = CY_U3P_DMA_CB_CONS_EVENT;
+        dmaCfg.cb = CyFxSlFifoSourceDmaCallback;
+        apiRetStatus = CyU3PDmaChannelCreate(&glChHandleSource,
+                CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaCfg);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint(4, "CyU3PDmaChannelCreate failed, Error code = %d\n",
+                    apiRetStatus);
+            CyFxSlFifoApplnDmaStop();
+            return apiRetStatus;
+        }
+    }
+
+    /* Flush the Endpoint memory */
+    CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
+    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+
+    glSourceCounter = 0;
+    apiRetStatus = CyFxSlFifoApplnLinkTestArm(glDataMode);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PDmaChannelSetXfer Failed, Error code = %d\n",
+                apiRetStatus);
+        CyFxSlFifoApplnDmaStop();
+        return apiRetStatus;
+    }
+
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_DMA_START, dmaCfg.size,
+            glDmaBufCountPtoU | ((uint32_t) glDmaBufCountUtoP << 16));
+    return CY_U3P_SUCCESS;
+}
+
+/* Clear-halt handling for the link test channels: reset the channel of the
+ * endpoint and start it again. */
+void CyFxSlFifoApplnLinkTestReset(uint16_t ep)
+{
+    if ((ep == CY_FX_EP_PRODUCER) && (glDataMode & CY_FX_SLFIFO_DATA_SINK))
+    {
+        CyU3PDmaChannelReset(&glChHandleSink);
+        CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
+        CyU3PUsbResetEp(CY_FX_EP_PRODUCER);
+        CyFxSlFifoApplnLinkTestArm(CY_FX_SLFIFO_DATA_SINK);
+    }
+
+    if ((ep == CY_FX_EP_CONSUMER) && (glDataMode & CY_FX_SLFIFO_DATA_SOURCE))
+    {
+        CyU3PDmaChannelReset(&glChHandleSource);
+        CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+        CyU3PUsbResetEp(CY_FX_EP_CONSUMER);
+        CyFxSlFifoApplnLinkTestArm(CY_FX_SLFIFO_DATA_SOURCE);
+    }
+}
+
+/* This function creates the U2P and P2U DMA channels with the current buffer
+ * geometry (glDmaBufSize, glDmaBufCountPtoU, glDmaBufCountUtoP) and starts the
+ * transfers on them. On failure nothing is left allocated and the error code
+ * is returned to the caller. */
+CyU3PReturnStatus_t CyFxSlFifoApplnDmaStart(void)
+{
+    CyU3PDmaChannelConfig_t dmaCfg;
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+    CyU3PDmaMultiChannelConfig_t dmaMultiCfg;
+#endif
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    /* Frame headers can only be inserted by the CPU on a MANUAL channel. */
+    if (!glIsDmaManual)
+        glP2UFramed = CyFalse;
+    glP2USequence = 0;
+    CyFxSlFifoCrcReset();
+
+    /* Both main channels use buffers of the same size. Serve them from one buffer
+     * pool, so that re-creating the channels after every SETCONF or reset does not
+     * scan the buffer heap once per buffer. If the pool cannot be set up, the
+     * buffers come from the bitmap allocator as before. */
+    if (CyU3PDmaBufferPoolCreate(glDmaBufSize * glDmaPktSize,
+            glDmaBufCountUtoP + glDmaBufCountPtoU) != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "DMA buffer pool not available, using the buffer heap\n");
+    }
+
+    if (glDataMode != CY_FX_SLFIFO_DATA_GPIF)
+        return CyFxSlFifoApplnLinkTestStart();
+
+    if (!glIsDmaManual) //auto
+    {
+        /* Create a DMA AUTO channel for U2P transfer. */
+        dmaCfg.size = glDmaBufSize * glDmaPktSize;
+        dmaCfg.count = glDmaBufCountUtoP;
+        dmaCfg.prodSckId = CY_FX_PRODUCER_USB_SOCKET;
+        dmaCfg.consSckId = CY_FX_CONSUMER_PPORT_SOCKET;
+        dmaCfg.prodAvailCount = 0;
         dmaCfg.prodHeader = 0;
         dmaCfg.prodFooter = 0;
         dmaCfg.consHeader = 0;
@@ -269,11 +1392,33 @@ void CyFxSlFifoApplnStart(void)
         apiRetStatus = CyU3PDmaChannelCreate(&glChHandleSlFifoUtoP,
                 CY_U3P_DMA_TYPE_AUTO, &dmaCfg);
         if (apiRetStatus != CY_U3P_SUCCESS)
-            CyFxAppErrorHandler(apiRetStatus);
+        {
+            return apiRetStatus;
+        }
 
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+        /* Create a DMA AUTO many-to-one channel for P2U transfer. */
+        CyU3PMemSet((uint8_t *) &dmaMultiCfg, 0, sizeof(dmaMultiCfg));
+        dmaMultiCfg.size = glDmaBufSize * glDmaPktSize;
+        dmaMultiCfg.count = glDmaBufCountPtoU / 2;
+        dmaMultiCfg.validSckCount = 2;
+        dmaMultiCfg.prodSckId[0] = CY_FX_PRODUCER_PPORT_SOCKET;
+        dmaMultiCfg.prodSckId[1] = CY_FX_PRODUCER_PPORT_SOCKET_1;
+        dmaMultiCfg.consSckId[0] = CY_FX_CONSUMER_USB_SOCKET;
+        dmaMultiCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
+        dmaMultiCfg.notification = 0;
+        dmaMultiCfg.cb = NULL;
+        apiRetStatus = CyU3PDmaMultiChannelCreate(&glChHandleSlFifoPtoU,
+                CY_U3P_DMA_TYPE_AUTO_MANY_TO_ONE, &dmaMultiCfg);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDmaChannelDestroy(&glChHandleSlFifoUtoP);
+            return apiRetStatus;
+        }
+#else
         /* Create a DMA MANUAL channel for P2U transfer. */
-        dmaCfg.size = DMA_BUF_SIZE * size;
-        dmaCfg.count = CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U;
+        dmaCfg.size = glDmaBufSize * glDmaPktSize;
+        dmaCfg.count = glDmaBufCountPtoU;
         dmaCfg.prodSckId = CY_FX_PRODUCER_PPORT_SOCKET;
         dmaCfg.consSckId = CY_FX_CONSUMER_USB_SOCKET;
         dmaCfg.prodAvailCount = 0;
@@ -286,13 +1431,17 @@ void CyFxSlFifoApplnStart(void)
         apiRetStatus = CyU3PDmaChannelCreate(&glChHandleSlFifoPtoU,
                 CY_U3P_DMA_TYPE_AUTO, &dmaCfg);
         if (apiRetStatus != CY_U3P_SUCCESS)
-            CyFxAppErrorHandler(apiRetStatus);
+        {
+            CyU3PDmaChannelDestroy(&glChHandleSlFifoUtoP);
+            return apiRetStatus;
+        }
+#endif
     }
     else //manual
     {
         /* Create a DMA AUTO channel for U2P transfer. */
-        dmaCfg.size = DMA_BUF_SIZE * size;
-        dmaCfg.count = CY_FX_SLFIFO_DMA_BUF_COUNT_U_2_P;
+        dmaCfg.size = glDmaBufSize * glDmaPktSize;
+        dmaCfg.count = glDmaBufCountUtoP;
         dmaCfg.prodSckId = CY_FX_PRODUCER_USB_SOCKET;
         dmaCfg.consSckId = CY_FX_CONSUMER_PPORT_SOCKET;
         dmaCfg.prodAvailCount = 0;
@@ -309,16 +1458,40 @@ void CyFxSlFifoApplnStart(void)
             CyU3PDebugPrint(4,
                     "CyU3PDmaChannelCreate failed, Error code = %d\n",
                     apiRetStatus);
-            CyFxAppErrorHandler(apiRetStatus);
+            return apiRetStatus;
         }
 
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+        /* Create a DMA MANUAL many-to-one channel for P2U transfer. */
+        CyU3PMemSet((uint8_t *) &dmaMultiCfg, 0, sizeof(dmaMultiCfg));
+        dmaMultiCfg.size = glDmaBufSize * glDmaPktSize;
+        dmaMultiCfg.count = glDmaBufCountPtoU / 2;
+        dmaMultiCfg.validSckCount = 2;
+        dmaMultiCfg.prodSckId[0] = CY_FX_PRODUCER_PPORT_SOCKET;
+        dmaMultiCfg.prodSckId[1] = CY_FX_PRODUCER_PPORT_SOCKET_1;
+        dmaMultiCfg.consSckId[0] = CY_FX_CONSUMER_USB_SOCKET;
+        dmaMultiCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
+        dmaMultiCfg.prodHeader = (glP2UFramed) ? CY_FX_SLFIFO_FRAME_HEADER_SIZE : 0;
+        dmaMultiCfg.notification = CY_U3P_DMA_CB_PROD_EVENT;
+        dmaMultiCfg.cb = CyFxSlFifoPtoUDmaMultiCallback;
+        apiRetStatus = CyU3PDmaMultiChannelCreate(&glChHandleSlFifoPtoU,
+                CY_U3P_DMA_TYPE_MANUAL_MANY_TO_ONE, &dmaMultiCfg);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint(4,
+                    "CyU3PDmaMultiChannelCreate failed, Error code = %d\n",
+                    apiRetStatus);
+            CyU3PDmaChannelDestroy(&glChHandleSlFifoUtoP);
+            return apiRetStatus;
+        }
+#else
         /* Create a DMA MANUAL channel for P2U transfer. */
-        dmaCfg.size = DMA_BUF_SIZE * size;
-        dmaCfg.count = CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U;
+        dmaCfg.size = glDmaBufSize * glDmaPktSize;
+        dmaCfg.count = glDmaBufCountPtoU;
         dmaCfg.prodSckId = CY_FX_PRODUCER_PPORT_SOCKET;
         dmaCfg.consSckId = CY_FX_CONSUMER_USB_SOCKET;
         dmaCfg.prodAvailCount = 0;
-        dmaCfg.prodHeader = 0;
+        dmaCfg.prodHeader = (glP2UFramed) ? CY_FX_SLFIFO_FRAME_HEADER_SIZE : 0;
         dmaCfg.prodFooter = 0;
         dmaCfg.consHeader = 0;
         dmaCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
@@ -331,76 +1504,525 @@ void CyFxSlFifoApplnStart(void)
             CyU3PDebugPrint(4,
                     "CyU3PDmaChannelCreate failed, Error code = %d\n",
                     apiRetStatus);
+            CyU3PDmaChannelDestroy(&glChHandleSlFifoUtoP);
+            return apiRetStatus;
+        }
+#endif
+    }
+
+    /* Flush the Endpoint memory */
+    CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
+    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+
+    /* Set DMA channel transfer size. */
+    apiRetStatus = CyU3PDmaChannelSetXfer(&glChHandleSlFifoUtoP,
+            CY_FX_SLFIFO_DMA_TX_SIZE);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PDmaChannelSetXfer Failed, Error code = %d\n",
+                apiRetStatus);
+        CyFxSlFifoApplnDmaStop();
+        return apiRetStatus;
+    }
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+    apiRetStatus = CyU3PDmaMultiChannelSetXfer(&glChHandleSlFifoPtoU,
+            CY_FX_SLFIFO_DMA_RX_SIZE, 0);
+#else
+    apiRetStatus = CyU3PDmaChannelSetXfer(&glChHandleSlFifoPtoU,
+            CY_FX_SLFIFO_DMA_RX_SIZE);
+#endif
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PDmaChannelSetXfer Failed, Error code = %d\n",
+                apiRetStatus);
+        CyFxSlFifoApplnDmaStop();
+        return apiRetStatus;
+    }
+
+    if (glStreamsActive)
+    {
+        apiRetStatus = CyFxSlFifoApplnStream2Start();
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyFxSlFifoApplnDmaStop();
+            return apiRetStatus;
+        }
+    }
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    apiRetStatus = CyFxSlFifoApplnEp2DmaStart();
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyFxSlFifoApplnDmaStop();
+        return apiRetStatus;
+    }
+#endif
+
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_DMA_START, (uint32_t) glDmaBufSize * glDmaPktSize,
+            glDmaBufCountPtoU | ((uint32_t) glDmaBufCountUtoP << 16));
+    return CY_U3P_SUCCESS;
+}
+
+/* Configure the bulk endpoints for the current USB speed and profile and map
+ * the bulk streams. Used when the configuration is selected and when the
+ * profile changes. */
+CyU3PReturnStatus_t CyFxSlFifoApplnEpConfig(const CyFxSlFifoEpParams_t *params_p)
+{
+    CyU3PEpConfig_t epCfg;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    CyU3PMemSet((uint8_t *) &epCfg, 0, sizeof(epCfg));
+    epCfg.enable = CyTrue;
+    epCfg.epType = CY_U3P_USB_EP_BULK;
+    epCfg.burstLen = CyFxSlFifoEpBurst(params_p);
+    epCfg.streams = 0;
+    epCfg.pcktSize = params_p->pktSize;
+
+    /* Producer endpoint configuration */
+    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER, &epCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PSetEpConfig failed, Error code = %d\n",
+                apiRetStatus);
+        return apiRetStatus;
+    }
+
+    /* Consumer endpoint configuration. Only the IN endpoint carries streams. */
+    epCfg.streams = params_p->streams;
+    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PSetEpConfig failed, Error code = %d\n",
+                apiRetStatus);
+        return apiRetStatus;
+    }
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    /* Second endpoint pair configuration */
+    epCfg.streams = 0;
+    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP2_PRODUCER, &epCfg);
+    if (apiRetStatus == CY_U3P_SUCCESS)
+    {
+        apiRetStatus = CyU3PSetEpConfig(CY_FX_EP2_CONSUMER, &epCfg);
+    }
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PSetEpConfig failed, Error code = %d\n",
+                apiRetStatus);
+        return apiRetStatus;
+    }
+#endif
+
+    /* Map stream 1 to the main P2U socket and stream 2 to the status socket. */
+    glStreamsActive = (params_p->streams != 0) ? CyTrue : CyFalse;
+    if (glStreamsActive)
+    {
+        apiRetStatus = CyU3PUsbMapStream(CY_FX_EP_CONSUMER,
+                CY_FX_CONSUMER_USB_SOCKET, 1);
+        if (apiRetStatus == CY_U3P_SUCCESS)
+        {
+            apiRetStatus = CyU3PUsbMapStream(CY_FX_EP_CONSUMER,
+                    CY_FX_CONSUMER_USB_SOCKET_1, 2);
+        }
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint(4, "CyU3PUsbMapStream failed, Error code = %d\n",
+                    apiRetStatus);
+            return apiRetStatus;
+        }
+    }
+
+    return apiRetStatus;
+}
+
+/* This function starts the slave FIFO loop application. This is called
+ * when a SET_CONF event is received from the USB host. The endpoints
+ * are configured and the DMA pipe is setup in this function. */
+void CyFxSlFifoApplnStart(void)
+{
+    const CyFxSlFifoEpParams_t *params_p;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+    CyU3PUSBSpeed_t usbSpeed = CyU3PUsbGetSpeed();
+
+    /* First identify the usb speed. Once that is identified,
+     * create a DMA channel and start the transfer on this. */
+
+    /* Based on the Bus Speed configure the endpoint packet size and burst
+     * length. These are the same values the descriptors were patched with. */
+    params_p = CyFxSlFifoGetEpParams(usbSpeed);
+    if (params_p == NULL)
+    {
+        CyU3PDebugPrint(4, "Error! Invalid USB speed.\n");
+        CyFxAppErrorHandler(CY_U3P_ERROR_FAILURE);
+        return;
+    }
+
+    apiRetStatus = CyFxSlFifoApplnEpConfig(params_p);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyFxAppErrorHandler(apiRetStatus);
+    }
+
+    /* Remember the packet size: the DMA buffers are sized in packets. A pool
+     * set up for the packet size of a previous connection is no longer used. */
+    if (glDmaPktSize != params_p->pktSize)
+        CyU3PDmaBufferPoolDestroy(glDmaBufSize * glDmaPktSize);
+    glDmaPktSize = params_p->pktSize;
+
+    /* Create the DMA channels and start the transfers. */
+    apiRetStatus = CyFxSlFifoApplnDmaStart();
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyFxAppErrorHandler(apiRetStatus);
+    }
+
+    /* New channels start with zero transfer counts; treat the start as activity. */
+    glLastXferCountUtoP = 0;
+    glLastXferCountPtoU = 0;
+    glLastActivity = CyFxSlFifoGetTimestamp();
+
+    /* Measure the U1/U2 exit latencies again on this link. */
+    glLpmExitSamples[0] = 0;
+    glLpmExitSamples[1] = 0;
+
+    /* Update the status flag. */
+    glIsApplnActive = CyTrue;
+
+    /* Start the wrap-up timer if it is enabled. */
+    if (glWrapUpTimeout != 0)
+    {
+        CyFxSlFifoApplnSetWrapUpTimeout(glWrapUpTimeout);
+    }
+}
+
+/* This function stops the slave FIFO loop application. This shall be called
+ * whenever a RESET or DISCONNECT event is received from the USB host. The
+ * endpoints are disabled and the DMA pipe is destroyed by this function. */
+void CyFxSlFifoApplnStop(void)
+{
+    CyU3PEpConfig_t epCfg;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    /* Update the flag. */
+    glIsApplnActive = CyFalse;
+    CyU3PTimerStop(&glWrapUpTimer);
+
+    /* Flush the endpoints and destroy the DMA channels. */
+    CyFxSlFifoApplnDmaStop();
+    glStreamsActive = CyFalse;
+
+    /* Disable endpoints. */
+    CyU3PMemSet((uint8_t *) &epCfg, 0, sizeof(epCfg));
+    epCfg.enable = CyFalse;
+
+    /* Producer endpoint configuration. */
+    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER, &epCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PSetEpConfig failed, Error code = %d\n",
+                apiRetStatus);
+        CyFxAppErrorHandler(apiRetStatus);
+    }
+
+    /* Consumer endpoint configuration. */
+    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "CyU3PSetEpConfig failed, Error code = %d\n",
+                apiRetStatus);
+        CyFxAppErrorHandler(apiRetStatus);
+    }
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    /* Second endpoint pair. */
+    CyU3PSetEpConfig(CY_FX_EP2_PRODUCER, &epCfg);
+    CyU3PSetEpConfig(CY_FX_EP2_CONSUMER, &epCfg);
+#endif
+}
+
+/* Buffer heap needed for count main channel buffers of bufBytes each, next to the
+ * stream 2 and EP 2 buffers and the reserve for the EP0 and debug buffers. The
+ * buffer manager rounds every buffer up to 32 bytes and adds one 32 byte guard
+ * chunk. */
+uint32_t CyFxSlFifoDmaHeapBytes(uint32_t bufBytes, uint32_t count)
+{
+    uint32_t heapBytes;
+
+    heapBytes = (((bufBytes + 31) & ~31) + 32) * count + CY_FX_SLFIFO_DMA_HEAP_RESERVE;
+    if (glStreamsActive)
+        heapBytes += (((glDmaPktSize + 31) & ~31) + 32) * CY_FX_SLFIFO_DMA_BUF_COUNT_STREAM;
+    if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+        heapBytes += (((glDmaPktSize + 31) & ~31) + 32) * 2 * CY_FX_SLFIFO_DMA_BUF_COUNT_EP2;
+
+    return heapBytes;
+}
+
+/* Largest P2U buffer count that fits next to countUtoP U2P buffers, at the
+ * current packet size. The runtime counterpart of CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_MAX. */
+uint16_t CyFxSlFifoDmaMaxCountPtoU(uint16_t bufSize, uint16_t countUtoP)
+{
+    uint32_t bufBytes = (uint32_t) bufSize * glDmaPktSize;
+    uint32_t fixed = CyFxSlFifoDmaHeapBytes(bufBytes, countUtoP);
+    uint32_t count;
+
+    if (fixed >= glBufferManager.regionSize)
+        return 0;
+
+    count = (glBufferManager.regionSize - fixed) / (((bufBytes + 31) & ~31) + 32);
+    if (count > CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT)
+        count = CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT;
+
+    return (uint16_t) (count & ~CY_FX_SLFIFO_P2U_PINGPONG);
+}
+
+/* This function changes the DMA buffer geometry of a running application. Both
+ * channels are torn down and re-created with the new buffer size and counts
+ * without touching the endpoint configuration, so the host does not have to
+ * re-enumerate the device. If the new channels cannot be created, the previous
+ * geometry is restored and an error code is returned. */
+CyU3PReturnStatus_t CyFxSlFifoApplnSetDmaConfig(uint16_t bufSize,
+        uint16_t countPtoU, uint16_t countUtoP)
+{
+    uint16_t oldSize = glDmaBufSize;
+    uint16_t oldCountPtoU = glDmaBufCountPtoU;
+    uint16_t oldCountUtoP = glDmaBufCountUtoP;
+    uint32_t bufBytes;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    if (!glIsApplnActive)
+        return CY_U3P_ERROR_NOT_CONFIGURED;
+
+    /* A DMA buffer cannot exceed 64 KB and every channel needs at least one buffer.
+     * The ping-pong P2U channel splits its buffers evenly between two sockets. */
+    bufBytes = (uint32_t) bufSize * glDmaPktSize;
+    if ((bufSize == 0) || (bufBytes > CY_FX_SLFIFO_DMA_BUF_MAX_BYTES)
+            || (countPtoU == 0) || (countUtoP == 0)
+            || ((CY_FX_SLFIFO_P2U_PINGPONG == 1) && ((countPtoU & 1) != 0)))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    /* The worker rings must be able to hold every buffer of a channel. */
+    if ((countPtoU > CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT) || (countUtoP > CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    if (CyFxSlFifoDmaHeapBytes(bufBytes, countPtoU + countUtoP) > glBufferManager.regionSize)
+        return CY_U3P_ERROR_MEMORY_ERROR;
+
+    /* All buffers are free again; give the pool of the old geometry back to the heap. */
+    CyFxSlFifoApplnDmaStop();
+    CyU3PDmaBufferPoolDestroy(glDmaBufSize * glDmaPktSize);
+
+    glDmaBufSize = bufSize;
+    glDmaBufCountPtoU = countPtoU;
+    glDmaBufCountUtoP = countUtoP;
+    apiRetStatus = CyFxSlFifoApplnDmaStart();
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "DMA re-configuration failed, Error code = %d\n",
+                apiRetStatus);
+
+        /* Fall back to the previous geometry, which is known to fit. */
+        CyU3PDmaBufferPoolDestroy(glDmaBufSize * glDmaPktSize);
+        glDmaBufSize = oldSize;
+        glDmaBufCountPtoU = oldCountPtoU;
+        glDmaBufCountUtoP = oldCountUtoP;
+        if (CyFxSlFifoApplnDmaStart() != CY_U3P_SUCCESS)
+        {
             CyFxAppErrorHandler(apiRetStatus);
         }
     }
 
-    /* Flush the Endpoint memory */
-    CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
-    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+    return apiRetStatus;
+}
 
-    /* Set DMA channel transfer size. */
-    apiRetStatus = CyU3PDmaChannelSetXfer(&glChHandleSlFifoUtoP,
-            CY_FX_SLFIFO_DMA_TX_SIZE);
+/* Re-create the endpoint configuration (if params_p is not NULL) and the
+ * channels after a runtime change has failed and its caller has put the
+ * previous settings back. These worked before the change, so a failure here
+ * leaves the device without a data path and is fatal. */
+void CyFxSlFifoApplnRestore(const CyFxSlFifoEpParams_t *params_p)
+{
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    CyFxSlFifoApplnDmaStop();
+    if (params_p != NULL)
+        apiRetStatus = CyFxSlFifoApplnEpConfig(params_p);
+    if (apiRetStatus == CY_U3P_SUCCESS)
+        apiRetStatus = CyFxSlFifoApplnDmaStart();
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint(4, "CyU3PDmaChannelSetXfer Failed, Error code = %d\n",
+        CyU3PDebugPrint(4, "Restoring the previous configuration failed, Error code = %d\n",
                 apiRetStatus);
         CyFxAppErrorHandler(apiRetStatus);
     }
-    apiRetStatus = CyU3PDmaChannelSetXfer(&glChHandleSlFifoPtoU,
-            CY_FX_SLFIFO_DMA_RX_SIZE);
+}
+
+/* This function switches the stream/loopback profile and the channel type of a
+ * running application. The new geometry is checked before anything is torn down;
+ * then the endpoints are re-configured with the burst length of the profile and
+ * the channels are re-created through CyFxSlFifoApplnSetDmaConfig. If that
+ * fails, the previous profile, channel type, burst length and the settings
+ * that need MANUAL channels are restored and the error code is returned, so
+ * that the request is stalled. */
+CyU3PReturnStatus_t CyFxSlFifoApplnSetProfile(uint16_t profile, CyBool_t isManual)
+{
+    const CyFxSlFifoEpParams_t *params_p;
+    const CyFxSlFifoProfile_t *prof_p;
+    uint16_t oldProfile = glProfile;
+    CyBool_t oldManual = glIsDmaManual;
+    uint8_t oldBurstLen = glBurstLen;
+    CyBool_t oldFramed = glP2UFramed;
+    CyBool_t oldCrcCheck = glCrcCheck;
+    uint32_t oldTimeout = glWrapUpTimeout;
+    uint16_t countPtoU;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    if (!glIsApplnActive)
+        return CY_U3P_ERROR_NOT_CONFIGURED;
+    if ((profile > CY_FX_SLFIFO_PROFILE_LOOPBACK)
+            || ((!isManual) && (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    prof_p = &glProfiles[profile];
+    countPtoU = prof_p->countPtoU;
+    if (countPtoU == 0)
+        countPtoU = CyFxSlFifoDmaMaxCountPtoU(prof_p->bufSize, prof_p->countUtoP);
+    if ((countPtoU == 0) || (CyFxSlFifoDmaHeapBytes((uint32_t) prof_p->bufSize * glDmaPktSize,
+            countPtoU + prof_p->countUtoP) > glBufferManager.regionSize))
+        return CY_U3P_ERROR_MEMORY_ERROR;
+
+    /* The wrap-up timer, the frame headers and the CRC check need MANUAL channels. */
+    if (!isManual)
+    {
+        CyFxSlFifoApplnSetWrapUpTimeout(0);
+        glCrcCheck = CyFalse;
+    }
+
+    CyFxSlFifoApplnDmaStop();
+    glIsDmaManual = isManual;
+    glProfile = profile;
+    glBurstLen = 0;
+
+    /* A failed CyFxSlFifoApplnSetDmaConfig has already gone back to the previous
+     * geometry, so only the profile settings have to be undone here. */
+    params_p = CyFxSlFifoGetEpParams(CyU3PUsbGetSpeed());
+    if (params_p != NULL)
+        apiRetStatus = CyFxSlFifoApplnEpConfig(params_p);
+    if (apiRetStatus == CY_U3P_SUCCESS)
+        apiRetStatus = CyFxSlFifoApplnSetDmaConfig(prof_p->bufSize, countPtoU, prof_p->countUtoP);
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint(4, "CyU3PDmaChannelSetXfer Failed, Error code = %d\n",
+        CyU3PDebugPrint(4, "Profile change failed, Error code = %d\n",
                 apiRetStatus);
-        CyFxAppErrorHandler(apiRetStatus);
+        glIsDmaManual = oldManual;
+        glProfile = oldProfile;
+        glBurstLen = oldBurstLen;
+        glP2UFramed = oldFramed;
+        glCrcCheck = oldCrcCheck;
+        CyFxSlFifoApplnRestore(params_p);
+        CyFxSlFifoApplnSetWrapUpTimeout(oldTimeout);
     }
 
-    /* Update the status flag. */
-    glIsApplnActive = CyTrue;
+    return apiRetStatus;
 }
 
-/* This function stops the slave FIFO loop application. This shall be called
- * whenever a RESET or DISCONNECT event is received from the USB host. The
- * endpoints are disabled and the DMA pipe is destroyed by this function. */
-void CyFxSlFifoApplnStop(void)
+/* This function re-configures the endpoints of a running application with a
+ * burst length of burstLen packets, 0 for the one of the profile. The channels
+ * are re-created with the current geometry. On failure the previous burst
+ * length is restored and the error code is returned. */
+CyU3PReturnStatus_t CyFxSlFifoApplnSetBurstLength(uint16_t burstLen)
 {
-    CyU3PEpConfig_t epCfg;
+    const CyFxSlFifoEpParams_t *params_p;
+    uint8_t oldBurstLen = glBurstLen;
     CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
 
-    /* Update the flag. */
-    glIsApplnActive = CyFalse;
+    if (!glIsApplnActive)
+        return CY_U3P_ERROR_NOT_CONFIGURED;
+    params_p = CyFxSlFifoGetEpParams(CyU3PUsbGetSpeed());
+    if ((params_p == NULL) || (burstLen > params_p->burstLen))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    CyFxSlFifoApplnDmaStop();
+    glBurstLen = (uint8_t) burstLen;
+    apiRetStatus = CyFxSlFifoApplnEpConfig(params_p);
+    if (apiRetStatus == CY_U3P_SUCCESS)
+        apiRetStatus = CyFxSlFifoApplnDmaStart();
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint(4, "Burst length change failed, Error code = %d\n",
+                apiRetStatus);
+        glBurstLen = oldBurstLen;
+        CyFxSlFifoApplnRestore(params_p);
+    }
 
-    /* Flush the endpoint memory */
-    CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
-    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+    return apiRetStatus;
+}
 
-    /* Destroy the channel */
-    CyU3PDmaChannelDestroy(&glChHandleSlFifoUtoP);
-    CyU3PDmaChannelDestroy(&glChHandleSlFifoPtoU);
+/* This function turns the P2U frame headers on or off. The P2U buffers have to
+ * be re-created with or without the reserved header space, so both channels
+ * are restarted with the current geometry. Only MANUAL channels are supported.
+ * On failure the previous setting is restored and the error code is returned. */
+CyU3PReturnStatus_t CyFxSlFifoApplnSetFraming(CyBool_t isFramed)
+{
+    CyBool_t oldFramed = glP2UFramed;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
 
-    /* Disable endpoints. */
-    CyU3PMemSet((uint8_t *) &epCfg, 0, sizeof(epCfg));
-    epCfg.enable = CyFalse;
+    if (!glIsApplnActive)
+        return CY_U3P_ERROR_NOT_CONFIGURED;
+    if (!glIsDmaManual)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
 
-    /* Producer endpoint configuration. */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER, &epCfg);
+    CyFxSlFifoApplnDmaStop();
+    glP2UFramed = isFramed;
+    apiRetStatus = CyFxSlFifoApplnDmaStart();
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint(4, "CyU3PSetEpConfig failed, Error code = %d\n",
+        CyU3PDebugPrint(4, "P2U framing change failed, Error code = %d\n",
                 apiRetStatus);
-        CyFxAppErrorHandler(apiRetStatus);
+        glP2UFramed = oldFramed;
+        CyFxSlFifoApplnRestore(NULL);
     }
 
-    /* Consumer endpoint configuration. */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
+    return apiRetStatus;
+}
+
+/* This function switches EP 1 between the GPIF path and the link test modes.
+ * The channels are re-created with the current geometry. On failure the
+ * previous mode and pattern are restored and the error code is returned. */
+CyU3PReturnStatus_t CyFxSlFifoApplnSetDataMode(uint16_t mode, uint16_t pattern)
+{
+    uint16_t oldMode = glDataMode;
+    uint16_t oldPattern = glSourcePattern;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    if (!glIsApplnActive)
+        return CY_U3P_ERROR_NOT_CONFIGURED;
+    if ((mode & ~(CY_FX_SLFIFO_DATA_SOURCE | CY_FX_SLFIFO_DATA_SINK))
+            || (pattern > CY_FX_SLFIFO_PATTERN_COUNTER))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    CyFxSlFifoApplnDmaStop();
+    glDataMode = mode;
+    glSourcePattern = pattern;
+    apiRetStatus = CyFxSlFifoApplnDmaStart();
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint(4, "CyU3PSetEpConfig failed, Error code = %d\n",
+        CyU3PDebugPrint(4, "Data mode change failed, Error code = %d\n",
                 apiRetStatus);
-        CyFxAppErrorHandler(apiRetStatus);
+        glDataMode = oldMode;
+        glSourcePattern = oldPattern;
+        CyFxSlFifoApplnRestore(NULL);
     }
+
+    return apiRetStatus;
+}
+
+/* Send the first len bytes of glEp0Buffer as the data phase of a control read,
+ * truncated to wLength. */
+CyU3PReturnStatus_t CyFxSlFifoSendEp0Buffer(uint16_t wLength, uint16_t len)
+{
+    if (wLength < len)
+        len = wLength;
+
+    return CyU3PUsbSendEP0Data(len, glEp0Buffer);
 }
 
 /* Callback to handle the USB setup requests. */
@@ -408,12 +2030,14 @@ CyBool_t CyFxSlFifoApplnUSBSetupCB(uint32_t setupdat0, uint32_t setupdat1)
 {
     /* Fast enumeration is used. Only requests addressed to the interface, class,
      * vendor and unknown control requests are received by this function.
-     * This application does not support any class or vendor requests. */
+     * This application does not support any class requests. */
 
     uint8_t bRequest, bReqType;
     uint8_t bType, bTarget;
-    uint16_t wValue, wIndex;
+    uint16_t wValue, wIndex, wLength;
     CyBool_t isHandled = CyFalse;
+    CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+    const CyFxSlFifoEpParams_t *params;
 
     /* Decode the fields from the setup request. */
     bReqType = (setupdat0 & CY_U3P_USB_REQUEST_TYPE_MASK);
@@ -423,6 +2047,7 @@ CyBool_t CyFxSlFifoApplnUSBSetupCB(uint32_t setupdat0, uint32_t setupdat1)
             ((setupdat0 & CY_U3P_USB_REQUEST_MASK) >> CY_U3P_USB_REQUEST_POS);
     wValue = ((setupdat0 & CY_U3P_USB_VALUE_MASK) >> CY_U3P_USB_VALUE_POS);
     wIndex = ((setupdat1 & CY_U3P_USB_INDEX_MASK) >> CY_U3P_USB_INDEX_POS);
+    wLength = ((setupdat1 & CY_U3P_USB_LENGTH_MASK) >> CY_U3P_USB_LENGTH_POS);
 
     if (bType == CY_U3P_USB_STANDARD_RQT)
     {
@@ -458,23 +2083,62 @@ CyBool_t CyFxSlFifoApplnUSBSetupCB(uint32_t setupdat0, uint32_t setupdat1)
         {
             if (glIsApplnActive)
             {
-                if (wIndex == CY_FX_EP_PRODUCER)
+                /* As in CyFxSlFifoApplnPibRecover, only the ring of the channel that
+                 * is reset is dropped. */
+                CyFxSlFifoWorkerHold(CY_FX_SLFIFO_RING_ALL);
+                CyFxSlFifoCrcReset();
+                if (glDataMode != CY_FX_SLFIFO_DATA_GPIF)
+                    CyFxSlFifoApplnLinkTestReset(wIndex);
+
+                if ((wIndex == CY_FX_EP_PRODUCER) && (glDataMode == CY_FX_SLFIFO_DATA_GPIF))
                 {
                     CyU3PDmaChannelReset(&glChHandleSlFifoUtoP);
+                    CyFxSlFifoWorkerDrop(CY_FX_SLFIFO_RING_UTOP);
                     CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
                     CyU3PUsbResetEp(CY_FX_EP_PRODUCER);
                     CyU3PDmaChannelSetXfer(&glChHandleSlFifoUtoP,
                             CY_FX_SLFIFO_DMA_TX_SIZE);
                 }
 
-                if (wIndex == CY_FX_EP_CONSUMER)
+                if ((wIndex == CY_FX_EP_CONSUMER) && (glDataMode == CY_FX_SLFIFO_DATA_GPIF))
                 {
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+                    CyU3PDmaMultiChannelReset(&glChHandleSlFifoPtoU);
+                    CyFxSlFifoWorkerDrop(CY_FX_SLFIFO_RING_PTOU);
+                    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+                    CyU3PUsbResetEp(CY_FX_EP_CONSUMER);
+                    CyU3PDmaMultiChannelSetXfer(&glChHandleSlFifoPtoU,
+                            CY_FX_SLFIFO_DMA_RX_SIZE, 0);
+#else
                     CyU3PDmaChannelReset(&glChHandleSlFifoPtoU);
+                    CyFxSlFifoWorkerDrop(CY_FX_SLFIFO_RING_PTOU);
                     CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
                     CyU3PUsbResetEp(CY_FX_EP_CONSUMER);
                     CyU3PDmaChannelSetXfer(&glChHandleSlFifoPtoU,
                             CY_FX_SLFIFO_DMA_RX_SIZE);
+#endif
+                }
+                CyFxSlFifoWorkerRelease(CY_FX_SLFIFO_RING_ALL);
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+                if (wIndex == CY_FX_EP2_PRODUCER)
+                {
+                    CyU3PDmaChannelReset(&glChHandleEp2UtoP);
+                    CyU3PUsbFlushEp(CY_FX_EP2_PRODUCER);
+                    CyU3PUsbResetEp(CY_FX_EP2_PRODUCER);
+                    CyU3PDmaChannelSetXfer(&glChHandleEp2UtoP,
+                            CY_FX_SLFIFO_DMA_TX_SIZE);
+                }
+
+                if (wIndex == CY_FX_EP2_CONSUMER)
+                {
+                    CyU3PDmaChannelReset(&glChHandleEp2PtoU);
+                    CyU3PUsbFlushEp(CY_FX_EP2_CONSUMER);
+                    CyU3PUsbResetEp(CY_FX_EP2_CONSUMER);
+                    CyU3PDmaChannelSetXfer(&glChHandleEp2PtoU,
+                            CY_FX_SLFIFO_DMA_RX_SIZE);
                 }
+#endif
 
                 CyU3PUsbStall(wIndex, CyFalse, CyTrue);
 
@@ -484,12 +2148,178 @@ CyBool_t CyFxSlFifoApplnUSBSetupCB(uint32_t setupdat0, uint32_t setupdat1)
         }
     }
 
+    if (bType == CY_U3P_USB_VENDOR_RQT)
+    {
+        switch (bRequest)
+        {
+        case CY_FX_RQT_SET_DMA_CONFIG:
+            /* wValue: buffer size in packets, wIndex: P2U count (LSB) and U2P count (MSB). */
+            status = CyFxSlFifoApplnSetDmaConfig(wValue, (wIndex & 0xFF),
+                    (wIndex >> 8));
+            if (status == CY_U3P_SUCCESS)
+                CyU3PUsbAckSetup();
+            else
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_GET_DMA_CONFIG:
+            CyU3PMemSet(glEp0Buffer, 0, sizeof(glEp0Buffer));
+            glEp0Buffer[0] = CY_U3P_GET_LSB(glDmaBufSize);
+            glEp0Buffer[1] = CY_U3P_GET_MSB(glDmaBufSize);
+            glEp0Buffer[2] = CY_U3P_GET_LSB(glDmaPktSize);
+            glEp0Buffer[3] = CY_U3P_GET_MSB(glDmaPktSize);
+            glEp0Buffer[4] = (uint8_t) glDmaBufCountPtoU;
+            glEp0Buffer[5] = (uint8_t) glDmaBufCountUtoP;
+            glEp0Buffer[6] = CY_U3P_GET_LSB(glBufferManager.regionSize >> 10);
+            glEp0Buffer[7] = CY_U3P_GET_MSB(glBufferManager.regionSize >> 10);
+            glEp0Buffer[8] = (uint8_t) glProfile;
+            glEp0Buffer[9] = (glIsDmaManual) ? 1 : 0;
+            params = CyFxSlFifoGetEpParams(CyU3PUsbGetSpeed());
+            glEp0Buffer[10] = (params != NULL) ? CyFxSlFifoEpBurst(params) : 0;
+            status = CyFxSlFifoSendEp0Buffer(wLength, CY_FX_RQT_DMA_CONFIG_LEN);
+            if (status != CY_U3P_SUCCESS)
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_SET_P2U_FRAMING:
+            /* wValue: 1 to enable, 0 to disable the P2U frame headers. */
+            status = CyFxSlFifoApplnSetFraming((wValue != 0) ? CyTrue : CyFalse);
+            if (status == CY_U3P_SUCCESS)
+                CyU3PUsbAckSetup();
+            else
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_SET_CRC_CHECK:
+            /* wValue: 1 to enable, 0 to disable the loopback CRC check. */
+            status = CyFxSlFifoApplnSetCrcCheck((wValue != 0) ? CyTrue : CyFalse);
+            if (status == CY_U3P_SUCCESS)
+                CyU3PUsbAckSetup();
+            else
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_SET_DATA_MODE:
+            /* wValue: CY_FX_SLFIFO_DATA_xxx flags, wIndex: source pattern. */
+            status = CyFxSlFifoApplnSetDataMode(wValue, wIndex);
+            if (status == CY_U3P_SUCCESS)
+                CyU3PUsbAckSetup();
+            else
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_SET_PROFILE:
+            /* wValue: profile, wIndex: 0 for AUTO, 1 for MANUAL channels. */
+            status = CyFxSlFifoApplnSetProfile(wValue, (wIndex != 0) ? CyTrue : CyFalse);
+            if (status == CY_U3P_SUCCESS)
+                CyU3PUsbAckSetup();
+            else
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_SET_BURST_LENGTH:
+            /* wValue: burst length in packets, 0 for the one of the profile. */
+            status = CyFxSlFifoApplnSetBurstLength(wValue);
+            if (status == CY_U3P_SUCCESS)
+                CyU3PUsbAckSetup();
+            else
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_SET_WRAPUP_TIMEOUT:
+            /* wIndex:wValue: timeout in us, 0 to disable the wrap-up timer. */
+            status = CyFxSlFifoApplnSetWrapUpTimeout(((uint32_t) wIndex << 16) | wValue);
+            if (status == CY_U3P_SUCCESS)
+                CyU3PUsbAckSetup();
+            else
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_GET_TELEMETRY:
+            /* wValue bit 0: clear the counters after reading them. */
+            CyFxSlFifoTelemetrySnapshot((CyFxSlFifoTelemetry_t *) glEp0Buffer,
+                    (wValue & 1) ? CyTrue : CyFalse);
+            status = CyFxSlFifoSendEp0Buffer(wLength, sizeof(CyFxSlFifoTelemetry_t));
+            if (status != CY_U3P_SUCCESS)
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_SET_WORKER_COST:
+            /* wValue: passes of the processing step over each buffer. */
+            status = CyFxSlFifoApplnSetWorkerCost(wValue);
+            if (status == CY_U3P_SUCCESS)
+                CyU3PUsbAckSetup();
+            else
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_GET_TRACE:
+            /* Hand out as many records as the host asked for and the EP0 buffer holds. */
+            if ((CY_FX_SLFIFO_TRACE_ENABLE == 0) || (wLength < sizeof(CyFxSlFifoTraceHeader_t)))
+            {
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            }
+            else
+            {
+                if (wLength > CY_FX_EP0_BUFFER_SIZE)
+                    wLength = CY_FX_EP0_BUFFER_SIZE;
+                status = CyFxSlFifoSendEp0Buffer(wLength, CyFxSlFifoTraceRead(glEp0Buffer,
+                        (wLength - sizeof(CyFxSlFifoTraceHeader_t)) / sizeof(CyFxSlFifoTraceRecord_t)));
+                if (status != CY_U3P_SUCCESS)
+                    CyU3PUsbStall(0, CyTrue, CyFalse);
+            }
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_SET_TRACE_MASK:
+            if (CY_FX_SLFIFO_TRACE_ENABLE == 1)
+            {
+                glTraceMask = wValue;
+                CyU3PUsbAckSetup();
+            }
+            else
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_RQT_CPU_BENCHMARK:
+            /* wValue bit 0: start a new run after returning the last result. */
+            CyU3PMemCopy(glEp0Buffer, (uint8_t *) &glBenchResult,
+                    sizeof(CyFxSlFifoBenchResult_t));
+            status = CyFxSlFifoSendEp0Buffer(wLength, sizeof(CyFxSlFifoBenchResult_t));
+            if (status != CY_U3P_SUCCESS)
+                CyU3PUsbStall(0, CyTrue, CyFalse);
+            else if (wValue & 1)
+            {
+                glBenchResult.status = CY_FX_SLFIFO_BENCH_PENDING;
+                CyU3PEventSet(&glSlFifoEvent, CY_FX_SLFIFO_EVT_BENCHMARK, CYU3P_EVENT_OR);
+            }
+            isHandled = CyTrue;
+            break;
+
+        default:
+            break;
+        }
+    }
+
     return isHandled;
 }
 
 /* This is the callback function to handle the USB events. */
 void CyFxSlFifoApplnUSBEventCB(CyU3PUsbEventType_t evtype, uint16_t evdata)
 {
+    CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_USB_EVENT, evtype, evdata);
+
     switch (evtype)
     {
     case CY_U3P_USB_EVENT_SETCONF:
@@ -516,57 +2346,199 @@ void CyFxSlFifoApplnUSBEventCB(CyU3PUsbEventType_t evtype, uint16_t evdata)
     }
 }
 
+/* Run the CPU benchmark in the application thread: a DMA buffer of the current P2U
+ * buffer size goes through the same processing step as in the P2U callback
+ * CY_FX_SLFIFO_BENCH_ITERATIONS times. In D-cache builds every iteration includes
+ * the invalidate, as every real buffer would. */
+void CyFxSlFifoApplnCpuBenchmark(void)
+{
+    CyFxSlFifoBenchResult_t result;
+    uint8_t *buf_p;
+    uint32_t start, i;
+
+    CyU3PMemSet((uint8_t *) &result, 0, sizeof(result));
+    result.dcacheEnabled = CY_FX_SLFIFO_DCACHE_ENABLE;
+    result.bufferBytes = (uint32_t) glDmaBufSize * glDmaPktSize;
+    if (result.bufferBytes > CY_FX_SLFIFO_DMA_BUF_MAX_BYTES)
+        result.bufferBytes = CY_FX_SLFIFO_DMA_BUF_MAX_BYTES & ~(CY_FX_SLFIFO_DCACHE_LINE_SIZE - 1);
+    result.iterations = CY_FX_SLFIFO_BENCH_ITERATIONS;
+
+    buf_p = (uint8_t *) CyU3PDmaBufferAlloc((uint16_t) result.bufferBytes);
+    if (buf_p == NULL)
+    {
+        result.status = CY_U3P_ERROR_MEMORY_ERROR;
+        glBenchResult = result;
+        CyU3PDebugPrint(4, "CPU benchmark: no buffer of %d bytes\n", result.bufferBytes);
+        return;
+    }
+    CyU3PMemSet(buf_p, 0x5A, (uint16_t) result.bufferBytes);
+    CyFxSlFifoDCacheMaint(buf_p, result.bufferBytes, CyTrue);
+
+    start = CyFxSlFifoGetTimeUs();
+    for (i = 0; i < result.iterations; i++)
+    {
+        result.checksum += CyFxSlFifoProcessBuffer(buf_p, (uint16_t) result.bufferBytes);
+    }
+    result.elapsedUs = CyFxSlFifoGetTimeUs() - start;
+    result.nsPerBuffer = (uint32_t) (((uint64_t) result.elapsedUs * 1000) / result.iterations);
+    result.status = CY_U3P_SUCCESS;
+
+    CyU3PDmaBufferFree(buf_p);
+    glBenchResult = result;
+
+    CyU3PDebugPrint(4, "CPU benchmark: %d bytes x %d in %d us, %d ns per buffer (D-cache %d)\n",
+            result.bufferBytes, result.iterations, result.elapsedUs, result.nsPerBuffer,
+            result.dcacheEnabled);
+}
+
+/* Check the AUTO DMA channels for data movement. AUTO channels do not call back
+ * into the application, so the producer transfer counts are compared with the
+ * values seen at the last poll. MANUAL channels update glLastActivity directly. */
+void CyFxSlFifoApplnPollActivity(void)
+{
+    CyU3PDmaState_t state;
+    uint32_t prodXferCount, consXferCount;
+    CyBool_t active = CyFalse;
+
+    if ((glIsDmaManual) || (!glIsApplnActive))
+        return;
+
+    if (CyU3PDmaChannelGetStatus(&glChHandleSlFifoUtoP, &state, &prodXferCount,
+            &consXferCount) == CY_U3P_SUCCESS)
+    {
+        if (prodXferCount != glLastXferCountUtoP)
+            active = CyTrue;
+        glLastXferCountUtoP = prodXferCount;
+    }
+
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+    if (CyU3PDmaMultiChannelGetStatus(&glChHandleSlFifoPtoU, &state, &prodXferCount,
+            &consXferCount, 0) == CY_U3P_SUCCESS)
+#else
+    if (CyU3PDmaChannelGetStatus(&glChHandleSlFifoPtoU, &state, &prodXferCount,
+            &consXferCount) == CY_U3P_SUCCESS)
+#endif
+    {
+        if (prodXferCount != glLastXferCountPtoU)
+            active = CyTrue;
+        glLastXferCountPtoU = prodXferCount;
+    }
+
+    if (active)
+        glLastActivity = CyFxSlFifoGetTimestamp();
+}
+
 /* Callback function to handle LPM requests from the USB 3.0 host. This function is invoked by the API
  whenever a state change from U0 -> U1 or U0 -> U2 happens. If we return CyTrue from this function, the
  FX3 device is retained in the low power state. If we return CyFalse, the FX3 device immediately tries
  to trigger an exit back to U0.
 
- This application does not have any state in which we should not allow U1/U2 transitions; and therefore
- the function always return CyTrue.
+ U1/U2 is rejected while data has moved on the U2P or P2U channel within the last
+ CY_FX_SLFIFO_LPM_IDLE_TIME ms, so the exit latency does not show up as jitter in a running stream.
+ An idle device accepts the transition.
  */
 CyBool_t CyFxApplnLPMRqtCB(CyU3PUsbLinkPowerMode link_mode)
 {
-    return CyTrue;
+    if ((CY_FX_SLFIFO_LPM_IDLE_TIME == 0) || (!glIsApplnActive))
+        return CyTrue;
+
+    return ((CyFxSlFifoGetTimestamp() - glLastActivity) >= CY_FX_SLFIFO_LPM_IDLE_TIME);
+}
+
+/* Measure the U1/U2 exit latency of the link, see CY_FX_SLFIFO_U1_EXIT_LATENCY.
+ * Called from the application thread: if the link is in U1 or U2 and that state
+ * still needs samples, U0 is requested and the time until the link reports U0 is
+ * taken. A new maximum is written into the BOS descriptor, which the host reads
+ * on the next enumeration. */
+void CyFxSlFifoApplnLpmExitProbe(void)
+{
+    CyU3PUsbLinkPowerMode mode;
+    uint32_t start, elapsed, u1Exit, u2Exit;
+    uint8_t state;
+
+    if ((CY_FX_SLFIFO_LPM_EXIT_SAMPLES == 0) || (!glIsApplnActive) ||
+            (CyU3PUsbGetSpeed() != CY_U3P_SUPER_SPEED))
+        return;
+
+    if (CyU3PUsbGetLinkPowerState(&mode) != CY_U3P_SUCCESS)
+        return;
+    if (mode == CyU3PUsbLPM_U1)
+        state = 0;
+    else if (mode == CyU3PUsbLPM_U2)
+        state = 1;
+    else
+        return;
+    if (glLpmExitSamples[state] >= CY_FX_SLFIFO_LPM_EXIT_SAMPLES)
+        return;
+
+    start = CyFxSlFifoGetTimeUs();
+    if (CyU3PUsbSetLinkPowerState(CyU3PUsbLPM_U0) != CY_U3P_SUCCESS)
+        return;
+    do
+    {
+        elapsed = CyFxSlFifoGetTimeUs() - start;
+        if (elapsed >= CY_FX_SLFIFO_LPM_EXIT_TIMEOUT)
+            return;
+    } while ((CyU3PUsbGetLinkPowerState(&mode) != CY_U3P_SUCCESS) ||
+            (mode != CyU3PUsbLPM_U0));
+
+    glLpmExitSamples[state]++;
+    if (elapsed <= glLpmExitMax[state])
+        return;
+    glLpmExitMax[state] = elapsed;
+
+    /* Report the measured maximum with a margin; an unmeasured state keeps its
+     * build time value. */
+    u1Exit = CY_FX_SLFIFO_U1_EXIT_LATENCY;
+    u2Exit = CY_FX_SLFIFO_U2_EXIT_LATENCY;
+    if (glLpmExitMax[0] != 0)
+        u1Exit = glLpmExitMax[0] + (glLpmExitMax[0] * CY_FX_SLFIFO_LPM_EXIT_MARGIN + 99) / 100;
+    if (glLpmExitMax[1] != 0)
+        u2Exit = glLpmExitMax[1] + (glLpmExitMax[1] * CY_FX_SLFIFO_LPM_EXIT_MARGIN + 99) / 100;
+    CyFxSlFifoApplnPatchBosDscr(CyFxUSBBOSDscr, u1Exit, u2Exit);
+
+    CyU3PDebugPrint(4, "U%d exit latency %d us\n", state + 1, elapsed);
 }
 
 //edit
 /* Callback function to check for PIB Error */
 void GPIFErrorCallback(CyU3PPibIntrType cbType, uint16_t cbArg)
 {
-
+    /* Overruns and underruns are counted and the failing thread is handed over to
+     * the application thread, which reports and recovers from the error. */
     if (cbType == CYU3P_PIB_INTR_ERROR)
     {
         switch (CYU3P_GET_PIB_ERROR_TYPE(cbArg))
         {
         case CYU3P_PIB_ERR_THR0_WR_OVERRUN:
-            CyU3PDebugPrint(4, "CYU3P_PIB_ERR_THR0_WR_OVERRUN");
+            CyFxSlFifoTelemetryPibError(0, CyTrue);
             break;
         case CYU3P_PIB_ERR_THR1_WR_OVERRUN:
-            CyU3PDebugPrint(4, "CYU3P_PIB_ERR_THR1_WR_OVERRUN");
+            CyFxSlFifoTelemetryPibError(1, CyTrue);
             break;
         case CYU3P_PIB_ERR_THR2_WR_OVERRUN:
-            CyU3PDebugPrint(4, "CYU3P_PIB_ERR_THR2_WR_OVERRUN");
+            CyFxSlFifoTelemetryPibError(2, CyTrue);
             break;
         case CYU3P_PIB_ERR_THR3_WR_OVERRUN:
-            CyU3PDebugPrint(4, "CYU3P_PIB_ERR_THR3_WR_OVERRUN");
+            CyFxSlFifoTelemetryPibError(3, CyTrue);
             break;
 
         case CYU3P_PIB_ERR_THR0_RD_UNDERRUN:
-            CyU3PDebugPrint(4, "CYU3P_PIB_ERR_THR0_RD_UNDERRUN");
+            CyFxSlFifoTelemetryPibError(0, CyFalse);
             break;
         case CYU3P_PIB_ERR_THR1_RD_UNDERRUN:
-            CyU3PDebugPrint(4, "CYU3P_PIB_ERR_THR1_RD_UNDERRUN");
+            CyFxSlFifoTelemetryPibError(1, CyFalse);
             break;
         case CYU3P_PIB_ERR_THR2_RD_UNDERRUN:
-            CyU3PDebugPrint(4, "CYU3P_PIB_ERR_THR2_RD_UNDERRUN");
+            CyFxSlFifoTelemetryPibError(2, CyFalse);
             break;
         case CYU3P_PIB_ERR_THR3_RD_UNDERRUN:
-            CyU3PDebugPrint(4, "CYU3P_PIB_ERR_THR3_RD_UNDERRUN");
+            CyFxSlFifoTelemetryPibError(3, CyFalse);
             break;
 
         default:
-            CyU3PDebugPrint(4, "No Error :%d\n ",
-                    CYU3P_GET_PIB_ERROR_TYPE(cbArg));
+            CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_PIB_OTHER,
+                    CYU3P_GET_PIB_ERROR_TYPE(cbArg), 0);
             break;
         }
     }
@@ -580,6 +2552,8 @@ void CyFxSlFifoApplnInit(void)
     CyU3PPibClock_t pibClock;
     CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
 
+    CyFxSlFifoCrcInit();
+
     /* Initialize the p-port block. */
     pibClock.clkDiv = 2;
     pibClock.clkSrc = CY_U3P_SYS_CLK;
@@ -594,8 +2568,26 @@ void CyFxSlFifoApplnInit(void)
         CyFxAppErrorHandler(apiRetStatus);
     }
 
+#if (CY_FX_SLFIFO_USE_THREAD_1 == 1)
+    /* Route FLAGC/FLAGD to the DMA ready/watermark flags of thread 1 instead of
+     * thread 3, so that the FPGA can see the second producer thread. */
+    CyFxGpifRegValue[CY_FX_GPIF_CTRL_BUS_SELECT_REG + CY_FX_GPIF_FLAGC_CTL] =
+            CY_FX_GPIF_FLAG_DMA_READY(1);
+    CyFxGpifRegValue[CY_FX_GPIF_CTRL_BUS_SELECT_REG + CY_FX_GPIF_FLAGD_CTL] =
+            CY_FX_GPIF_FLAG_DMA_WATERMARK(1);
+#endif
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    /* Route FLAGA/FLAGC to the DMA ready flags of threads 1 and 2. The main paths
+     * are paced by the watermark flags on FLAGB (thread 0) and FLAGD (thread 3). */
+    CyFxGpifRegValue[CY_FX_GPIF_CTRL_BUS_SELECT_REG + CY_FX_GPIF_FLAGA_CTL] =
+            CY_FX_GPIF_FLAG_DMA_READY(1);
+    CyFxGpifRegValue[CY_FX_GPIF_CTRL_BUS_SELECT_REG + CY_FX_GPIF_FLAGC_CTL] =
+            CY_FX_GPIF_FLAG_DMA_READY(2);
+#endif
+
     /* Load the GPIF configuration for Slave FIFO sync mode. */
-    apiRetStatus = CyU3PGpifLoad(&CyFxGpifConfig); //edit
+    apiRetStatus = CyFxSlFifoGpifLoad();
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
         CyU3PDebugPrint(4, "CyU3PGpifLoad failed, Error Code = %d\n",
@@ -603,10 +2595,6 @@ void CyFxSlFifoApplnInit(void)
         CyFxAppErrorHandler(apiRetStatus);
     }
 
-    //edit
-    CyU3PGpifSocketConfigure(0, CY_U3P_PIB_SOCKET_0, 3, CyFalse, 1);
-    CyU3PGpifSocketConfigure(3, CY_U3P_PIB_SOCKET_3, 3, CyFalse, 1);
-
     /* Start the state machine. */
     apiRetStatus = CyU3PGpifSMStart(RESET, ALPHA_RESET); //edit
     if (apiRetStatus != CY_U3P_SUCCESS)
@@ -639,6 +2627,11 @@ void CyFxSlFifoApplnInit(void)
     /* Register a callback to handle LPM requests from the USB 3.0 host. */
     CyU3PUsbRegisterLPMRequestCallback(CyFxApplnLPMRqtCB);
 
+    /* Bring the configuration descriptors in line with the endpoint parameters */
+    CyFxSlFifoApplnPatchConfigDscr(CyFxUSBSSConfigDscr, CyFxSlFifoGetEpParams(CY_U3P_SUPER_SPEED));
+    CyFxSlFifoApplnPatchConfigDscr(CyFxUSBHSConfigDscr, CyFxSlFifoGetEpParams(CY_U3P_HIGH_SPEED));
+    CyFxSlFifoApplnPatchConfigDscr(CyFxUSBFSConfigDscr, CyFxSlFifoGetEpParams(CY_U3P_FULL_SPEED));
+
     /* Set the USB Enumeration descriptors */
 
     /* Super speed device descriptor. */
@@ -761,24 +2754,144 @@ void CyFxSlFifoApplnInit(void)
     }
 }
 
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+/* Entry function for the slFifoWorkerThread. Processes and commits the buffers
+ * queued by the DMA callbacks, oldest first in each direction. Buffers are
+ * committed in the order the channel produced them, as the DMA API requires.
+ * The processing passes run without the ring lock, so that a channel reset does
+ * not have to wait for them; the lock is taken for the commit only, which is
+ * skipped if the ring was dropped in the meantime. */
+void SlFifoWorkerThread_Entry(uint32_t input)
+{
+    CyU3PDmaBuffer_t buf;
+    CyU3PReturnStatus_t status;
+    uint32_t eventFlags, drops, sum;
+
+    for (;;)
+    {
+        if (CyU3PEventGet(&glWorkerEvent, CY_FX_SLFIFO_WORKER_EVT_BUFFER,
+                CYU3P_EVENT_OR_CLEAR, &eventFlags, CYU3P_WAIT_FOREVER) != 0)
+            continue;
+
+        while (CyFxSlFifoRingGet(&glRingUtoP, &buf, &drops))
+        {
+            CyFxSlFifoWorkerProcess(&buf);
+
+            CyU3PMutexGet(&glRingUtoP.lock, CYU3P_WAIT_FOREVER);
+            if (glRingUtoP.drops == drops)
+            {
+                CyFxSlFifoCrcUtoP(buf.buffer, buf.count);
+                status = CyU3PDmaChannelCommitBuffer(&glChHandleSlFifoUtoP, buf.count, 0);
+                CyFxSlFifoTelemetryUtoP(buf.count, status);
+            }
+            CyU3PMutexPut(&glRingUtoP.lock);
+        }
+
+        while (CyFxSlFifoRingGet(&glRingPtoU, &buf, &drops))
+        {
+            sum = CyFxSlFifoWorkerProcess(&buf);
+
+            CyU3PMutexGet(&glRingPtoU.lock, CYU3P_WAIT_FOREVER);
+            if (glRingPtoU.drops != drops)
+            {
+                CyU3PMutexPut(&glRingPtoU.lock);
+                continue;
+            }
+
+#if (CY_FX_SLFIFO_P2U_PINGPONG == 1)
+            glP2UChecksum = sum;
+            CyFxSlFifoCrcPtoU(buf.buffer, buf.count);
+            status = CyU3PDmaMultiChannelCommitBuffer(&glChHandleSlFifoPtoU,
+                    CyFxSlFifoFrameHeaderFill(&buf), 0);
+            CyFxSlFifoTelemetryPtoU(buf.count, status);
+#else
+            /* Empty wrapped-up buffers are dropped, as in the callback. */
+            if (buf.count == 0)
+            {
+                CyU3PDmaChannelDiscardBuffer(&glChHandleSlFifoPtoU);
+                CyFxSlFifoTrace(CY_FX_SLFIFO_TRACE_PTOU_EMPTY, 0, 0);
+            }
+            else
+            {
+                glP2UChecksum = sum;
+                CyFxSlFifoCrcPtoU(buf.buffer, buf.count);
+                status = CyU3PDmaChannelCommitBuffer(&glChHandleSlFifoPtoU,
+                        CyFxSlFifoFrameHeaderFill(&buf), 0);
+                CyFxSlFifoTelemetryPtoU(buf.count, status);
+            }
+#endif
+            CyU3PMutexPut(&glRingPtoU.lock);
+        }
+    }
+}
+#endif
+
 /* Entry function for the slFifoAppThread. */
 void SlFifoAppThread_Entry(uint32_t input)
 {
+    uint32_t eventFlags, now, lastPrint = 0;
+    uint32_t txApiRetStatus;
+
     /* Initialize the debug module */
     CyFxSlFifoApplnDebugInit();
 
+    /* Start the microsecond time base */
+    CyFxSlFifoTimerInit();
+
+    /* Clear the telemetry counters */
+    CyFxSlFifoTelemetryReset();
+
+    /* Create the event group and the wrap-up timer used for deferred work. The
+     * timer is started in CyFxSlFifoApplnStart. */
+    txApiRetStatus = CyU3PEventCreate(&glSlFifoEvent);
+    if (txApiRetStatus == 0)
+    {
+        txApiRetStatus = CyU3PTimerCreate(&glWrapUpTimer, CyFxSlFifoWrapUpTimerCb,
+                0, 1000, 1000, CYU3P_NO_ACTIVATE);
+    }
+    if (txApiRetStatus != 0)
+    {
+        CyU3PDebugPrint(4, "Event/timer creation failed, Error code = %d\n",
+                txApiRetStatus);
+        CyFxAppErrorHandler(txApiRetStatus);
+    }
+
     /* Initialize the slave FIFO application */
     CyFxSlFifoApplnInit();
 
     for (;;)
     {
-        CyU3PThreadSleep(1000);
+        /* Handle deferred work. With AUTO channels the thread also wakes up twice per
+         * LPM idle time to poll the channels for activity. */
+        if (CyU3PEventGet(&glSlFifoEvent, CY_FX_SLFIFO_EVT_ALL,
+                CYU3P_EVENT_OR_CLEAR, &eventFlags, CY_FX_SLFIFO_APP_THREAD_WAIT) == 0)
+        {
+            if (eventFlags & CY_FX_SLFIFO_EVT_PIB_ERROR)
+                CyFxSlFifoApplnPibRecover();
+            if (eventFlags & CY_FX_SLFIFO_EVT_WRAPUP)
+                CyFxSlFifoApplnWrapUp();
+            if (eventFlags & CY_FX_SLFIFO_EVT_BENCHMARK)
+                CyFxSlFifoApplnCpuBenchmark();
+        }
+        if (glGpifRestartPending)
+            CyFxSlFifoApplnGpifRestart();
+        CyFxSlFifoApplnPollActivity();
+        CyFxSlFifoApplnLpmExitProbe();
+
+        /* Keep the microsecond time base from missing a timer wrap while idle. */
+        CyFxSlFifoGetTimeUs();
+
+        now = CyFxSlFifoGetTimestamp();
+        if ((now - lastPrint) < 1000)
+            continue;
+        lastPrint = now;
+
         if (glIsApplnActive)
         {
             /* Print the number of buffers received so far from the USB host. */
             CyU3PDebugPrint(6,
                     "Data tracker: buffers received: %d, buffers sent: %d.\n",
-                    glDMARxCount, glDMATxCount);
+                    glTelemetry.buffersUtoP, glTelemetry.buffersPtoU);
         }
     }
 }
@@ -805,6 +2918,31 @@ void CyFxApplicationDefine(void)
             CYU3P_AUTO_START /* Start the thread immediately */
     );
 
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+    /* Create the worker thread and the objects it shares with the DMA callbacks. */
+    if (retThrdCreate == 0)
+        retThrdCreate = CyU3PEventCreate(&glWorkerEvent);
+    if (retThrdCreate == 0)
+        retThrdCreate = CyU3PMutexCreate(&glRingUtoP.lock, CYU3P_NO_INHERIT);
+    if (retThrdCreate == 0)
+        retThrdCreate = CyU3PMutexCreate(&glRingPtoU.lock, CYU3P_NO_INHERIT);
+    if (retThrdCreate == 0)
+    {
+        ptr = CyU3PMemAlloc(CY_FX_SLFIFO_WORKER_STACK);
+        retThrdCreate = CyU3PThreadCreate (&slFifoWorkerThread, /* Worker thread structure */
+                "22:Slave_FIFO_worker", /* Thread ID and thread name */
+                SlFifoWorkerThread_Entry, /* Worker thread entry function */
+                0, /* No input parameter to thread */
+                ptr, /* Pointer to the allocated thread stack */
+                CY_FX_SLFIFO_WORKER_STACK, /* Worker thread stack size */
+                CY_FX_SLFIFO_WORKER_PRIORITY, /* Worker thread priority */
+                CY_FX_SLFIFO_WORKER_PRIORITY, /* Worker thread pre-emption threshold */
+                CYU3P_NO_TIME_SLICE, /* No time slice for the worker thread */
+                CYU3P_AUTO_START /* Start the thread immediately */
+        );
+    }
+#endif
+
     /* Check the return code */
     if (retThrdCreate != 0)
     {
@@ -841,8 +2979,15 @@ int main(void)
         goto handle_fatal_error;
     }
 
-    /* Initialize the caches. Enable both Instruction and Data Caches. */
+    /* Initialize the caches. The instruction cache is always enabled. With
+     * CY_FX_SLFIFO_DCACHE_ENABLE the data cache is enabled as well; the DMA
+     * driver keeps the buffers passed to it coherent, which also covers the
+     * debug log. */
+#if (CY_FX_SLFIFO_DCACHE_ENABLE == 1)
+    status = CyU3PDeviceCacheControl(CyTrue, CyTrue, CyTrue);
+#else
     status = CyU3PDeviceCacheControl(CyTrue, CyFalse, CyFalse); //edit
+#endif
     if (status != CY_U3P_SUCCESS)
     {
         goto handle_fatal_error;
@@ -866,11 +3011,11 @@ int main(void)
     io_cfg.isDQ32Bit = CyTrue;
     io_cfg.lppMode = CY_U3P_IO_MATRIX_LPP_DEFAULT;
 #endif
-    /* No GPIOs are enabled. */
+    /* The only GPIO is the complex GPIO used as the microsecond timer. */
     io_cfg.gpioSimpleEn[0] = 0;
     io_cfg.gpioSimpleEn[1] = 0;
     io_cfg.gpioComplexEn[0] = 0;
-    io_cfg.gpioComplexEn[1] = 0;
+    io_cfg.gpioComplexEn[1] = (1 << (CY_FX_SLFIFO_TIMER_GPIO - 32));
     status = CyU3PDeviceConfigureIOMatrix(&io_cfg);
     if (status != CY_U3P_SUCCESS)
     {
@@ -28,18 +28,291 @@
 #include "cyu3externcstart.h"
 #include "cyu3types.h"
 #include "cyu3usbconst.h"
+#include "cyfxmemmap.h"
 
 /* 16/32 bit GPIF Configuration select
 * Set CY_FX_SLFIFO_GPIF_16_32BIT_CONF_SELECT = 0 for 16 bit GPIF data bus.
 * Set CY_FX_SLFIFO_GPIF_16_32BIT_CONF_SELECT = 1 for 32 bit GPIF data bus.*/
 #define CY_FX_SLFIFO_GPIF_16_32BIT_CONF_SELECT (0)
 
-/* set up AUTO (0) or MANUAL (1) DMA channel for Stream IN/OUT transfers */
+/* set up AUTO (0) or MANUAL (1) DMA channel for Stream IN/OUT transfers.
+* This is the channel type at boot; the host can change it with CY_FX_RQT_SET_PROFILE. */
 #define AUTO_MANUAL_CONF_SELECT (1)
 
-#define DMA_BUF_SIZE						 (16)
-#define CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U      (8) /* Slave FIFO P_2_U channel buffer count */
-#define CY_FX_SLFIFO_DMA_BUF_COUNT_U_2_P 	  (4) /* Slave FIFO U_2_P channel buffer count */
+/* Stream and loopback profiles
+* The DMA buffer geometry and the SuperSpeed burst length come in two profiles: STREAM (large buffers
+* and long bursts for the stream FPGA images) and LOOPBACK (single packet buffers without bursts for
+* the loopback FPGA image). CY_FX_SLFIFO_BOOT_PROFILE is used at boot and can be set from the makefile
+* (make PROFILE=loopback); CY_FX_RQT_SET_PROFILE switches the profile and the channel type at runtime
+* by re-creating the channels, without re-enumeration.
+* A P2U count of 0 uses as many buffers as fit into the buffer heap. */
+#define CY_FX_SLFIFO_PROFILE_STREAM        (0)
+#define CY_FX_SLFIFO_PROFILE_LOOPBACK      (1)
+#ifndef CY_FX_SLFIFO_BOOT_PROFILE
+#define CY_FX_SLFIFO_BOOT_PROFILE          (CY_FX_SLFIFO_PROFILE_STREAM)
+#endif
+
+#define CY_FX_SLFIFO_STREAM_BUF_SIZE       (16)     /* Packets per buffer */
+#define CY_FX_SLFIFO_STREAM_COUNT_P_2_U    (0)
+#define CY_FX_SLFIFO_STREAM_COUNT_U_2_P    (4)
+#define CY_FX_SLFIFO_STREAM_BURST_LENGTH   (16)
+#define CY_FX_SLFIFO_LOOPBACK_BUF_SIZE     (1)      /* Packets per buffer */
+#define CY_FX_SLFIFO_LOOPBACK_COUNT_P_2_U  (2)
+#define CY_FX_SLFIFO_LOOPBACK_COUNT_U_2_P  (2)
+#define CY_FX_SLFIFO_LOOPBACK_BURST_LENGTH (1)
+
+#if (CY_FX_SLFIFO_BOOT_PROFILE == CY_FX_SLFIFO_PROFILE_STREAM)
+#define DMA_BUF_SIZE						 (CY_FX_SLFIFO_STREAM_BUF_SIZE)
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U      (CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_MAX) /* Slave FIFO P_2_U channel buffer count */
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_U_2_P 	  (CY_FX_SLFIFO_STREAM_COUNT_U_2_P) /* Slave FIFO U_2_P channel buffer count */
+#else
+#define DMA_BUF_SIZE						 (CY_FX_SLFIFO_LOOPBACK_BUF_SIZE)
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U      (CY_FX_SLFIFO_LOOPBACK_COUNT_P_2_U) /* Slave FIFO P_2_U channel buffer count */
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_U_2_P 	  (CY_FX_SLFIFO_LOOPBACK_COUNT_U_2_P) /* Slave FIFO U_2_P channel buffer count */
+#endif
+
+/* Endpoint parameters per USB speed. The endpoint and SS companion descriptors are patched from
+* these values at startup. CY_FX_SLFIFO_SS_BURST_LENGTH is the burst length advertised to the host;
+* CyU3PSetEpConfig is programmed with the burst length of the active profile, capped at this value.
+* The buffer size of each profile should be a multiple of its burst length. */
+#define CY_FX_SLFIFO_SS_PACKET_SIZE     (1024)
+#define CY_FX_SLFIFO_SS_BURST_LENGTH    (16)      /* 1 to 16 packets */
+#define CY_FX_SLFIFO_HS_PACKET_SIZE     (512)
+#define CY_FX_SLFIFO_FS_PACKET_SIZE     (64)
+
+#if (((CY_FX_SLFIFO_STREAM_BUF_SIZE % CY_FX_SLFIFO_STREAM_BURST_LENGTH) != 0) || \
+     ((CY_FX_SLFIFO_LOOPBACK_BUF_SIZE % CY_FX_SLFIFO_LOOPBACK_BURST_LENGTH) != 0))
+#warning "A profile buffer size is not a multiple of its burst length"
+#endif
+
+/* SuperSpeed bulk streams on the P2U (IN) endpoint
+* Set CY_FX_SLFIFO_BULK_STREAMS = 0 for a plain bulk IN endpoint.
+* Set CY_FX_SLFIFO_BULK_STREAMS = 2 to declare two bulk streams on CY_FX_EP_CONSUMER. Stream 1 carries
+* the P2U channel fed from GPIF thread 0. Stream 2 carries an AUTO channel fed from GPIF thread 1
+* (CY_FX_PRODUCER_PPORT_SOCKET_1), meant for low-rate status data that must not queue up behind
+* the main data stream. The FPGA selects the stream by writing to thread 0 or thread 1; FLAGC/FLAGD
+* report thread 1 as in ping-pong mode. Streams only exist at SuperSpeed: at USB 2.0 speeds the
+* stream 2 channel is not created and thread 1 never becomes ready.
+* Cannot be combined with CY_FX_SLFIFO_P2U_PINGPONG, which uses GPIF thread 1 as well. */
+#define CY_FX_SLFIFO_BULK_STREAMS       (0)
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_STREAM (2)     /* Stream 2 channel buffer count, one packet each */
+
+/* Ping-pong P2U path select
+* Set CY_FX_SLFIFO_P2U_PINGPONG = 0 for a single P2U producer socket (GPIF thread 0).
+* Set CY_FX_SLFIFO_P2U_PINGPONG = 1 for a many-to-one P2U channel fed from GPIF threads 0 and 1.
+* The FPGA writer toggles the address bus between the two threads so that one buffer is
+* drained while the other one is filled. FLAGC/FLAGD are re-targeted from thread 3 to
+* thread 1 in this mode, so the stream-read and loopback FPGA modes cannot be used.
+* CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U is split evenly between the two producer sockets. */
+#define CY_FX_SLFIFO_P2U_PINGPONG (0)
+
+/* Second endpoint pair
+* Set CY_FX_SLFIFO_SECOND_EP_PAIR = 1 to add a bulk IN/OUT pair (CY_FX_EP2_PRODUCER/CONSUMER) next to
+* EP 1. EP 2 IN is fed from GPIF thread 1 and EP 2 OUT drains into GPIF thread 2, each through a small
+* AUTO channel, so a command stream can run concurrently with the main data stream. FLAGA and FLAGC
+* are re-targeted to the DMA ready flags of threads 1 and 2; the main paths keep their watermark
+* flags on FLAGB (thread 0) and FLAGD (thread 3). The FPGA must be built with SECOND_EP_PAIR = 1. */
+#define CY_FX_SLFIFO_SECOND_EP_PAIR       (0)
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_EP2    (2)     /* EP 2 channel buffer count, one packet each */
+
+#if ((CY_FX_SLFIFO_BULK_STREAMS != 0) && (CY_FX_SLFIFO_BULK_STREAMS != 2))
+#error "CY_FX_SLFIFO_BULK_STREAMS must be 0 or 2"
+#endif
+#if ((CY_FX_SLFIFO_BULK_STREAMS != 0) && (CY_FX_SLFIFO_P2U_PINGPONG == 1))
+#error "Bulk streams and the ping-pong P2U path both need GPIF thread 1"
+#endif
+#if ((CY_FX_SLFIFO_SECOND_EP_PAIR == 1) && ((CY_FX_SLFIFO_BULK_STREAMS != 0) || (CY_FX_SLFIFO_P2U_PINGPONG == 1)))
+#error "The second endpoint pair needs GPIF threads 1 and 2 and UIB socket 2 for itself"
+#endif
+
+/* GPIF thread 1 (socket 1) is used by the ping-pong path and by bulk stream 2. */
+#if ((CY_FX_SLFIFO_P2U_PINGPONG == 1) || (CY_FX_SLFIFO_BULK_STREAMS != 0))
+#define CY_FX_SLFIFO_USE_THREAD_1 (1)
+#else
+#define CY_FX_SLFIFO_USE_THREAD_1 (0)
+#endif
+
+/* Framed P2U mode (MANUAL channels only)
+* Set CY_FX_SLFIFO_P2U_FRAMED = 1 to reserve CY_FX_SLFIFO_FRAME_HEADER_SIZE bytes at the start of
+* every P2U DMA buffer and fill them with a CyFxSlFifoFrameHeader_t before the buffer is committed.
+* The setting can be changed at runtime with the CY_FX_RQT_SET_P2U_FRAMING vendor request. */
+#define CY_FX_SLFIFO_P2U_FRAMED          (CyFalse)
+#define CY_FX_SLFIFO_FRAME_HEADER_SIZE   (16)         /* Must be a multiple of 16 bytes */
+#define CY_FX_SLFIFO_FRAME_MAGIC         (0x4D465846) /* "FXFM" */
+#define CY_FX_SLFIFO_FRAME_FLAG_DISCONTINUITY (0x0001) /* Data was lost before this buffer */
+
+/* P2U wrap-up timer (MANUAL channels only, not with CY_FX_SLFIFO_P2U_PINGPONG)
+* Once no P2U buffer has been produced for CY_FX_SLFIFO_WRAPUP_TIMEOUT us, the partially filled buffer
+* of the producer socket is wrapped up and sent, so data written by the FPGA reaches the host even at low
+* data rates. The P2U callback stamps every produce event with CyFxSlFifoGetTimeUs; the application
+* thread compares the stamp with the timeout whenever an RTOS timer fires, every timeout / 4 but no
+* more often than every CY_FX_SLFIFO_WRAPUP_POLL_MIN ms, the tick resolution. The wrap-up happens
+* between N and N + max(N / 4, 1 ms) after the last produce event, plus the time the application
+* thread takes to be scheduled. At full rate buffers complete long before the timeout and nothing is
+* wrapped up. Empty wrapped-up buffers are discarded. Set to 0 to disable; can be changed at runtime
+* with the CY_FX_RQT_SET_WRAPUP_TIMEOUT vendor request. */
+#define CY_FX_SLFIFO_WRAPUP_TIMEOUT      (0)
+#define CY_FX_SLFIFO_WRAPUP_POLL_MIN     (1)        /* Shortest timer period in ms */
+
+/* GPIF error recovery
+* Set CY_FX_SLFIFO_PIB_RECOVERY = 1 to recover from GPIF thread overrun/underrun errors without
+* re-enumeration. GPIFErrorCallback records the failing thread and the application thread stops the
+* GPIF state machine, resets and re-arms the DMA channels of that thread and restarts the state
+* machine at IDLE. The next framed P2U buffer carries CY_FX_SLFIFO_FRAME_FLAG_DISCONTINUITY and the
+* telemetry block counts the recoveries. Both bulk streams share the IN endpoint, whose memory can only
+* be flushed as a whole, so an error on either stream resets both. A state machine that does not start
+* again is retried CY_FX_SLFIFO_GPIF_RESTART_RETRIES times, then the GPIF configuration is reloaded and
+* started from RESET; if that fails too, the application thread keeps trying on every wake-up. Every
+* failed start is counted in the telemetry block. */
+#define CY_FX_SLFIFO_PIB_RECOVERY        (1)
+#define CY_FX_SLFIFO_GPIF_RESTART_RETRIES (3)
+
+/* Data cache
+* Set CY_FX_SLFIFO_DCACHE_ENABLE = 1 to run with the D-cache enabled. The DMA driver keeps handling
+* the cache (isDmaHandleDCache), so every buffer that goes through a DMA API call is cleaned on the way
+* out: commits, EP0 data and the debug log. Per buffer the application only adds the invalidate before
+* the CPU reads the data of a produce event (CPU processing, CRC check); it leaves out cleans of the
+* frame header, the source pattern and the EP0 buffer, which the commit or send does anyway. The
+* patched descriptors are still cleaned once per enumeration. AUTO channels never pass buffers
+* through the API and cost nothing. */
+#define CY_FX_SLFIFO_DCACHE_ENABLE       (0)
+#define CY_FX_SLFIFO_DCACHE_LINE_SIZE    (32)    /* ARM926EJ-S cache line size in bytes */
+
+/* CPU processing of P2U buffers
+* Set CY_FX_SLFIFO_P2U_CPU_PROCESS = 1 to have the MANUAL P2U callback read every buffer (32-bit word
+* sum) before it is committed, as a stand-in for in-firmware processing. The CY_FX_RQT_CPU_BENCHMARK
+* vendor request measures the cost of this step per buffer, so builds with and without
+* CY_FX_SLFIFO_DCACHE_ENABLE can be compared. */
+#define CY_FX_SLFIFO_P2U_CPU_PROCESS     (0)
+#define CY_FX_SLFIFO_BENCH_ITERATIONS    (1000)  /* Buffers processed per benchmark run */
+
+/* Deferred buffer processing (MANUAL channels only)
+* Set CY_FX_SLFIFO_DEFERRED_PROCESSING = 1 to move all per-buffer work out of the DMA callbacks.
+* The callbacks only queue the descriptor of each produced buffer in a single-producer ring per
+* direction and wake the worker thread, which processes, accounts and commits the buffers in the
+* order they were produced. The per-buffer cost is set at runtime with CY_FX_RQT_SET_WORKER_COST
+* (passes of CyFxSlFifoProcessBuffer over each buffer), so the throughput reported by the
+* telemetry counters can be measured at several processing costs. */
+#define CY_FX_SLFIFO_DEFERRED_PROCESSING (0)
+#define CY_FX_SLFIFO_WORKER_RING_SIZE    (64)       /* Power of 2, limits the buffer count per channel */
+#define CY_FX_SLFIFO_WORKER_STACK        (0x0400)   /* Worker thread stack size */
+#define CY_FX_SLFIFO_WORKER_PRIORITY     (7)        /* Above the application thread, below the drivers */
+#define CY_FX_SLFIFO_WORKER_EVT_BUFFER   (1 << 0)   /* A buffer descriptor was queued */
+#define CY_FX_SLFIFO_RING_UTOP           (1 << 0)   /* Worker ring of the U2P channel */
+#define CY_FX_SLFIFO_RING_PTOU           (1 << 1)   /* Worker ring of the P2U channel */
+#define CY_FX_SLFIFO_RING_ALL            (CY_FX_SLFIFO_RING_UTOP | CY_FX_SLFIFO_RING_PTOU)
+
+#if ((CY_FX_SLFIFO_DEFERRED_PROCESSING == 1) && (AUTO_MANUAL_CONF_SELECT == 0))
+#error "Deferred buffer processing needs MANUAL DMA channels"
+#endif
+
+/* USB 3.0 link power management
+* The host asks to move the link into U1/U2 whenever it sees the link idle for a short time, which
+* also happens between bursts of a running stream. CyFxApplnLPMRqtCB rejects U1/U2 while the U2P or
+* P2U channel has moved data within the last CY_FX_SLFIFO_LPM_IDLE_TIME ms and accepts it once the
+* device has been idle that long. Set to 0 to always accept U1/U2. */
+#define CY_FX_SLFIFO_LPM_IDLE_TIME       (100)
+
+/* Application thread event wait timeout in ms. The thread wakes up at least this often to print the
+* data tracker and, while AUTO channels are in use, to poll the channels for LPM activity. */
+#if (CY_FX_SLFIFO_LPM_IDLE_TIME >= 2)
+#define CY_FX_SLFIFO_APP_THREAD_WAIT     (CY_FX_SLFIFO_LPM_IDLE_TIME / 2)
+#else
+#define CY_FX_SLFIFO_APP_THREAD_WAIT     (1000)
+#endif
+
+/* Microsecond time base for the frame header timestamps and the telemetry intervals
+* The RTOS tick only resolves 1 ms, so a complex GPIO block runs as a free running 32-bit
+* counter on the GPIO fast clock: SYS_CLK / 16 / CY_FX_SLFIFO_TIMER_CLK_DIV, i.e. 12.6 MHz
+* with the 403.2 MHz system clock. The pin is not driven and must not be used otherwise;
+* complex GPIO 50 is free with the UART-only and the default LPP configuration as long as
+* I2S is off. The counter wraps every 340 s and CyFxSlFifoGetTimeUs has to be called at
+* least that often, which the application thread does on every wake-up. */
+#define CY_FX_SLFIFO_TIMER_GPIO          (50)
+#define CY_FX_SLFIFO_TIMER_CLK_DIV       (2)
+#define CY_FX_SLFIFO_TIMER_KHZ           (403200 / 16 / CY_FX_SLFIFO_TIMER_CLK_DIV)
+
+/* U1/U2 exit latencies reported in the SuperSpeed device capability of the BOS descriptor
+* The host budgets for these when it schedules transfers and picks its U1/U2 timeouts, so they should
+* be those of the actual link rather than the USB 3.0 field limits (U1 0x0A us, U2 0x07FF us). The
+* application thread measures them: while the link sits in U1 or U2 it requests U0 (device-initiated
+* exit, the same LFPS handshake and recovery as a host-initiated one) and times the transition with
+* CyFxSlFifoGetTimeUs. This is done at most CY_FX_SLFIFO_LPM_EXIT_SAMPLES times per state after each
+* SET_CONFIGURATION, so the link is left to save power afterwards. The largest time seen, plus
+* CY_FX_SLFIFO_LPM_EXIT_MARGIN percent, is patched into the BOS descriptor for the next enumeration
+* and reported in the telemetry block (lpmExitU1/U2, printed by fx3telemetry).
+* Until a state has been measured, CY_FX_SLFIFO_U1/U2_EXIT_LATENCY are reported. They default to the
+* field limits; build with the values fx3telemetry shows for the board (make U1_EXIT=us U2_EXIT=us)
+* to report measured values from the first enumeration on. A sample that does not reach U0 within
+* CY_FX_SLFIFO_LPM_EXIT_TIMEOUT us is dropped. Set CY_FX_SLFIFO_LPM_EXIT_SAMPLES to 0 to turn the
+* measurement off. */
+#define CY_FX_SLFIFO_U1_EXIT_MAX         (0x0A)
+#define CY_FX_SLFIFO_U2_EXIT_MAX         (0x07FF)
+#ifndef CY_FX_SLFIFO_U1_EXIT_LATENCY
+#define CY_FX_SLFIFO_U1_EXIT_LATENCY     (CY_FX_SLFIFO_U1_EXIT_MAX)
+#endif
+#ifndef CY_FX_SLFIFO_U2_EXIT_LATENCY
+#define CY_FX_SLFIFO_U2_EXIT_LATENCY     (CY_FX_SLFIFO_U2_EXIT_MAX)
+#endif
+#define CY_FX_SLFIFO_LPM_EXIT_SAMPLES    (8)
+#define CY_FX_SLFIFO_LPM_EXIT_MARGIN     (25)       /* Percent */
+#define CY_FX_SLFIFO_LPM_EXIT_TIMEOUT    (4000)     /* us */
+
+#if ((CY_FX_SLFIFO_U1_EXIT_LATENCY > CY_FX_SLFIFO_U1_EXIT_MAX) || \
+        (CY_FX_SLFIFO_U2_EXIT_LATENCY > CY_FX_SLFIFO_U2_EXIT_MAX))
+#error "The U1 exit latency is limited to 10 us and the U2 exit latency to 2047 us"
+#endif
+
+/* Application thread events */
+#define CY_FX_SLFIFO_EVT_WRAPUP          (1 << 0)   /* Wrap-up timer expired */
+#define CY_FX_SLFIFO_EVT_PIB_ERROR       (1 << 1)   /* GPIF overrun/underrun to recover from */
+#define CY_FX_SLFIFO_EVT_BENCHMARK       (1 << 2)   /* CPU benchmark requested */
+#define CY_FX_SLFIFO_EVT_ALL             (CY_FX_SLFIFO_EVT_WRAPUP | CY_FX_SLFIFO_EVT_PIB_ERROR | \
+                                          CY_FX_SLFIFO_EVT_BENCHMARK)
+
+#define CY_FX_SLFIFO_DMA_BUF_MAX_BYTES   (0xFFFF)  /* Largest DMA buffer supported by the DMA engine */
+#define CY_FX_SLFIFO_DMA_HEAP_RESERVE    (0x2000)  /* Buffer heap kept free for EP0 and debug buffers */
+
+/* Buffer heap budget at SuperSpeed, evaluated at build time and printed by "make memmap".
+* The buffer manager rounds every buffer up to 32 bytes and adds one 32 byte guard chunk.
+* CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_MAX is the largest P2U buffer count that fits next to the
+* U2P buffers, the stream/EP 2 buffers and the reserve, limited to what the vendor requests
+* can express (or the worker ring size) and rounded down to an even count for the ping-pong
+* P2U path. */
+#define CY_FX_SLFIFO_DMA_HEAP_BYTES(size) (((((size) + 31) / 32) * 32) + 32)
+#define CY_FX_SLFIFO_DMA_BUF_BYTES       (DMA_BUF_SIZE * CY_FX_SLFIFO_SS_PACKET_SIZE)
+#define CY_FX_SLFIFO_DMA_HEAP_FIXED      (CY_FX_SLFIFO_DMA_HEAP_RESERVE + \
+        (CY_FX_SLFIFO_DMA_BUF_COUNT_U_2_P * CY_FX_SLFIFO_DMA_HEAP_BYTES(CY_FX_SLFIFO_DMA_BUF_BYTES)) + \
+        (((CY_FX_SLFIFO_BULK_STREAMS != 0) ? CY_FX_SLFIFO_DMA_BUF_COUNT_STREAM : 0) * \
+         CY_FX_SLFIFO_DMA_HEAP_BYTES(CY_FX_SLFIFO_SS_PACKET_SIZE)) + \
+        (CY_FX_SLFIFO_SECOND_EP_PAIR * 2 * CY_FX_SLFIFO_DMA_BUF_COUNT_EP2 * \
+         CY_FX_SLFIFO_DMA_HEAP_BYTES(CY_FX_SLFIFO_SS_PACKET_SIZE)))
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_FIT \
+        ((CY_U3P_BUFFER_HEAP_SIZE - CY_FX_SLFIFO_DMA_HEAP_FIXED) / CY_FX_SLFIFO_DMA_HEAP_BYTES(CY_FX_SLFIFO_DMA_BUF_BYTES))
+#if (CY_FX_SLFIFO_DEFERRED_PROCESSING == 1)
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT (CY_FX_SLFIFO_WORKER_RING_SIZE)
+#else
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT (254)
+#endif
+#define CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_MAX \
+        (((CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_FIT > CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT) ? \
+          CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT : CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_FIT) & \
+         ~CY_FX_SLFIFO_P2U_PINGPONG)
+
+#if (CY_FX_SLFIFO_DMA_BUF_BYTES > CY_FX_SLFIFO_DMA_BUF_MAX_BYTES)
+#error "DMA_BUF_SIZE packets exceed the largest DMA buffer"
+#endif
+#if ((CY_FX_SLFIFO_DMA_HEAP_FIXED > CY_U3P_BUFFER_HEAP_SIZE) || (CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_MAX < 1))
+#error "The DMA buffers do not fit into the buffer heap; reduce DMA_BUF_SIZE or the U2P buffer count"
+#endif
+#if (CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U > CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_MAX)
+#error "CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U exceeds CY_FX_SLFIFO_DMA_BUF_COUNT_P_2_U_MAX"
+#endif
+#if (CY_FX_SLFIFO_DMA_BUF_COUNT_U_2_P > CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT)
+#error "CY_FX_SLFIFO_DMA_BUF_COUNT_U_2_P exceeds CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT"
+#endif
+
+#define CY_FX_EP0_BUFFER_SIZE           (256)      /* Size of the vendor request data buffer */
 
 #define CY_FX_SLFIFO_DMA_TX_SIZE        (0)	                  /* DMA transfer size is set to infinite */
 #define CY_FX_SLFIFO_DMA_RX_SIZE        (0)	                  /* DMA transfer size is set to infinite */
@@ -66,15 +339,287 @@
 /* Used with FX3 Silicon. */
 #define CY_FX_PRODUCER_PPORT_SOCKET    CY_U3P_PIB_SOCKET_0    /* P-port Socket 0 is producer */
 #define CY_FX_CONSUMER_PPORT_SOCKET    CY_U3P_PIB_SOCKET_3    /* P-port Socket 3 is consumer */
+#define CY_FX_PRODUCER_PPORT_SOCKET_1  CY_U3P_PIB_SOCKET_1    /* P-port Socket 1 is second producer (ping-pong, stream 2) */
+#define CY_FX_CONSUMER_USB_SOCKET_1    CY_U3P_UIB_SOCKET_CONS_2    /* USB Socket 2 carries bulk stream 2 */
+
+/* Second endpoint pair (CY_FX_SLFIFO_SECOND_EP_PAIR) */
+#define CY_FX_EP2_PRODUCER              0x02    /* EP 2 OUT */
+#define CY_FX_EP2_CONSUMER              0x82    /* EP 2 IN */
+
+#define CY_FX_EP2_PRODUCER_USB_SOCKET    CY_U3P_UIB_SOCKET_PROD_2    /* USB Socket 2 is producer */
+#define CY_FX_EP2_CONSUMER_USB_SOCKET    CY_U3P_UIB_SOCKET_CONS_2    /* USB Socket 2 is consumer */
+#define CY_FX_EP2_PRODUCER_PPORT_SOCKET  CY_U3P_PIB_SOCKET_1         /* P-port Socket 1 is producer */
+#define CY_FX_EP2_CONSUMER_PPORT_SOCKET  CY_U3P_PIB_SOCKET_2         /* P-port Socket 2 is consumer */
+
+/* GPIF II flag routing. The generated register table (cyfxgpif2config.h) holds one
+ * CY_U3P_PIB_GPIF_CTRL_BUS_SELECT entry per CTL pin, starting at CY_FX_GPIF_CTRL_BUS_SELECT_REG.
+ * The flag source codes follow the GPIF II Designer encoding: 0x10 + thread for
+ * Thread_x_DMA_Ready and 0x14 + thread for Thread_x_DMA_WaterMark. */
+#define CY_FX_GPIF_CTRL_BUS_SELECT_REG  (13)
+#define CY_FX_GPIF_FLAGA_CTL            (4)     /* FLAGA is driven on CTL4 */
+#define CY_FX_GPIF_FLAGC_CTL            (6)     /* FLAGC is driven on CTL6 */
+#define CY_FX_GPIF_FLAGD_CTL            (8)     /* FLAGD is driven on CTL8 */
+#define CY_FX_GPIF_FLAG_DMA_READY(thr)      (0x10 + (thr))
+#define CY_FX_GPIF_FLAG_DMA_WATERMARK(thr)  (0x14 + (thr))
+
+/* Loopback CRC32 integrity check (MANUAL channels only)
+* With the check on, every U2P buffer is run through a CRC32 (IEEE 802.3, slice-by-4 tables) before it
+* is committed to the GPIF, and every P2U buffer is checked against it before it is committed to USB.
+* The data is treated as one byte stream per direction: after each U2P buffer the running CRC and the
+* byte offset are queued as a check point, and the P2U side compares its running CRC when it reaches
+* the same offset, so the FPGA may return the data in buffers of any size. After a mismatch the P2U
+* side continues from the expected value, so each error is counted once. The counters are part of the
+* telemetry block. Lost or extra bytes make every following check fail until the channels are reset.
+* Only meaningful with a loopback FPGA image; can be changed at runtime with CY_FX_RQT_SET_CRC_CHECK. */
+#define CY_FX_SLFIFO_CRC_CHECK           (CyFalse)
+#define CY_FX_SLFIFO_CRC_QUEUE_SIZE      (64)       /* Check points, power of 2 */
+
+/* USB link test modes
+* Instead of the GPIF path, the EP 1 endpoints can be connected to CPU channels so that the USB link is
+* benchmarked without the FPGA: a MANUAL_OUT source fills buffers with a pattern and commits them to the
+* IN endpoint as fast as the host takes them, a MANUAL_IN sink discards all OUT data. Both count their
+* buffers and bytes in the telemetry P2U and U2P counters. Selected at runtime with
+* CY_FX_RQT_SET_DATA_MODE; the GPIF channels, bulk stream 2 and the second endpoint pair are not
+* created while a link test mode is active. */
+#define CY_FX_SLFIFO_DATA_GPIF           (0)        /* Normal operation: EP 1 to and from the GPIF */
+#define CY_FX_SLFIFO_DATA_SOURCE         (1 << 0)   /* EP 1 IN is fed by the CPU pattern source */
+#define CY_FX_SLFIFO_DATA_SINK           (1 << 1)   /* EP 1 OUT is drained by the CPU sink */
+#define CY_FX_SLFIFO_PATTERN_CONSTANT    (0)        /* Constant CY_FX_SLFIFO_PATTERN_WORD, written once */
+#define CY_FX_SLFIFO_PATTERN_COUNTER     (1)        /* 32-bit counter running through the stream, written per buffer */
+#define CY_FX_SLFIFO_PATTERN_WORD        (0x574D574D) /* "MW", as sent by slave_fifo_stream_write_to_fx3 */
+
+/* Binary event trace
+* Set CY_FX_SLFIFO_TRACE_ENABLE = 1 to record events of the DMA, PIB and USB callbacks as fixed-size
+* CyFxSlFifoTraceRecord_t entries in a RAM ring instead of formatting them for the debug UART. A record
+* costs a timer sample and a few stores with interrupts locked out, so it can be taken in every callback
+* without changing its timing. Records are stamped in us (CyFxSlFifoGetTimeUs), which resolves the
+* buffer-to-buffer timing at full rate; the stamps wrap after 71 min. The host drains the ring with CY_FX_RQT_GET_TRACE and decodes it into a timeline. When
+* the ring is full new records are dropped and counted. The events to record are selected at runtime
+* with CY_FX_RQT_SET_TRACE_MASK (bit n enables event n); the per-buffer events are off by default as
+* they fill the ring within a few milliseconds at full rate. */
+#define CY_FX_SLFIFO_TRACE_ENABLE        (1)
+#define CY_FX_SLFIFO_TRACE_RING_SIZE     (256)      /* Records, power of 2 */
+#define CY_FX_SLFIFO_TRACE_MASK_DEFAULT  (0xFFFF & ~((1 << CY_FX_SLFIFO_TRACE_UTOP_BUF) | \
+                                          (1 << CY_FX_SLFIFO_TRACE_PTOU_BUF) | \
+                                          (1 << CY_FX_SLFIFO_TRACE_WORKER_QUEUE)))
+
+/* Trace event ids and their arguments */
+#define CY_FX_SLFIFO_TRACE_UTOP_BUF      (1)    /* U2P buffer committed: byte count, status */
+#define CY_FX_SLFIFO_TRACE_PTOU_BUF      (2)    /* P2U buffer committed: byte count, status */
+#define CY_FX_SLFIFO_TRACE_PTOU_EMPTY    (3)    /* Empty wrapped-up P2U buffer discarded: -, - */
+#define CY_FX_SLFIFO_TRACE_PIB_ERROR     (4)    /* GPIF thread error: thread, 1 = overrun / 0 = underrun */
+#define CY_FX_SLFIFO_TRACE_PIB_OTHER     (5)    /* Other PIB error: CYU3P_GET_PIB_ERROR_TYPE, - */
+#define CY_FX_SLFIFO_TRACE_PIB_RECOVERY  (6)    /* GPIF error recovery done: thread mask, - */
+#define CY_FX_SLFIFO_TRACE_WRAPUP        (7)    /* P2U socket wrapped up: -, - */
+#define CY_FX_SLFIFO_TRACE_USB_EVENT     (8)    /* USB event: CyU3PUsbEventType_t, event data */
+#define CY_FX_SLFIFO_TRACE_DMA_START     (9)    /* DMA channels created: buffer bytes, P2U | U2P << 16 counts */
+#define CY_FX_SLFIFO_TRACE_DMA_STOP      (10)   /* DMA channels destroyed: -, - */
+#define CY_FX_SLFIFO_TRACE_WORKER_QUEUE  (11)   /* Buffer queued for the worker: 0 = U2P / 1 = P2U, byte count */
+
+/* Vendor requests handled by CyFxSlFifoApplnUSBSetupCB */
+
+/* Re-create both DMA channels with a new buffer geometry without re-enumeration.
+ * wValue = buffer size in packets (DMA_BUF_SIZE units), wIndex = P2U buffer count
+ * in the LSB and U2P buffer count in the MSB. No data phase. The request is
+ * stalled if the geometry does not fit into the DMA buffer heap. */
+#define CY_FX_RQT_SET_DMA_CONFIG        (0xB0)
+
+/* Read back the current DMA geometry. Returns CY_FX_RQT_DMA_CONFIG_LEN bytes:
+ * buffer size in packets (16 bit), packet size (16 bit), P2U count (8 bit),
+ * U2P count (8 bit), DMA buffer heap size in KB (16 bit), profile (8 bit),
+ * channel type (8 bit, 0 = AUTO, 1 = MANUAL), endpoint burst length in use
+ * (8 bit). All little endian. */
+#define CY_FX_RQT_GET_DMA_CONFIG        (0xB1)
+#define CY_FX_RQT_DMA_CONFIG_LEN        (11)
+
+/* Enable (wValue = 1) or disable (wValue = 0) the P2U frame headers. No data phase.
+ * Stalled when the application uses AUTO channels. */
+#define CY_FX_RQT_SET_P2U_FRAMING       (0xB2)
+
+/* Read the telemetry block (CyFxSlFifoTelemetry_t). wValue bit 0 set clears the
+ * counters after the snapshot has been taken. */
+#define CY_FX_RQT_GET_TELEMETRY         (0xB3)
+
+/* Set the P2U wrap-up timeout in us: wValue holds the low and wIndex the high 16 bits,
+ * 0 disables the timer. No data phase. Stalled when the application uses AUTO channels
+ * or the ping-pong P2U path. */
+#define CY_FX_RQT_SET_WRAPUP_TIMEOUT    (0xB4)
+
+/* Read the result of the last CPU benchmark run as a CyFxSlFifoBenchResult_t.
+ * wValue bit 0: start a new run in the application thread after reading. The
+ * status field reads CY_FX_SLFIFO_BENCH_PENDING before the first run and until
+ * a requested run has finished. */
+#define CY_FX_RQT_CPU_BENCHMARK         (0xB5)
+#define CY_FX_SLFIFO_BENCH_PENDING      (0xFFFFFFFF)
+
+/* Set the worker thread processing cost to wValue passes over each buffer. No data phase.
+ * Stalled unless the firmware is built with CY_FX_SLFIFO_DEFERRED_PROCESSING. */
+#define CY_FX_RQT_SET_WORKER_COST       (0xB6)
+
+/* Drain the event trace. Returns a CyFxSlFifoTraceHeader_t followed by the oldest
+ * recordCount records, which are removed from the ring; as many as fit into
+ * wLength and the EP0 buffer. Stalled unless the firmware is built with
+ * CY_FX_SLFIFO_TRACE_ENABLE. */
+#define CY_FX_RQT_GET_TRACE             (0xB7)
+
+/* Set the trace event mask to wValue (bit n enables event n). No data phase.
+ * Stalled unless the firmware is built with CY_FX_SLFIFO_TRACE_ENABLE. */
+#define CY_FX_RQT_SET_TRACE_MASK        (0xB8)
+
+/* Enable (wValue = 1) or disable (wValue = 0) the loopback CRC32 check. Either way
+ * the check state is restarted; the counters are cleared with CY_FX_RQT_GET_TELEMETRY.
+ * No data phase. Stalled when the application uses AUTO channels. */
+#define CY_FX_RQT_SET_CRC_CHECK         (0xB9)
+
+/* Select the data path of EP 1: wValue = CY_FX_SLFIFO_DATA_xxx flags, wIndex = source
+ * pattern (CY_FX_SLFIFO_PATTERN_xxx). The DMA channels are re-created. No data phase. */
+#define CY_FX_RQT_SET_DATA_MODE         (0xBA)
+
+/* Switch to profile wValue (CY_FX_SLFIFO_PROFILE_xxx) with AUTO (wIndex = 0) or
+ * MANUAL (wIndex = 1) channels. The endpoints are re-configured with the burst
+ * length of the profile and the channels are re-created. No data phase. Stalled
+ * if the profile does not fit into the buffer heap. */
+#define CY_FX_RQT_SET_PROFILE           (0xBB)
+
+/* Program the bulk endpoints with a burst length of wValue packets instead of the
+ * one of the profile; wValue = 0 goes back to the profile. The endpoints are
+ * re-configured and the channels re-created with the current geometry. No data
+ * phase. Stalled if wValue is larger than the burst length in the descriptors.
+ * A profile change also goes back to the burst length of the profile. */
+#define CY_FX_RQT_SET_BURST_LENGTH      (0xBC)
+
+/* Header placed in front of the payload of every P2U buffer in framed mode.
+ * All fields are little endian. The host can detect lost or reordered buffers
+ * from the sequence number and the device-side latency from the timestamp. */
+typedef struct CyFxSlFifoFrameHeader_t
+{
+    uint32_t magic;         /* CY_FX_SLFIFO_FRAME_MAGIC */
+    uint32_t sequence;      /* Incremented for every P2U buffer, reset when the channels are created */
+    uint16_t byteCount;     /* Payload bytes following the header */
+    uint16_t flags;         /* CY_FX_SLFIFO_FRAME_FLAG_xxx */
+    uint32_t timestamp;     /* Device time at commit, in us (CyFxSlFifoGetTimeUs, wraps after 71 min) */
+} CyFxSlFifoFrameHeader_t;
+
+/* DMA geometry and burst length of a stream/loopback profile */
+typedef struct CyFxSlFifoProfile_t
+{
+    uint16_t bufSize;           /* Buffer size in packets */
+    uint16_t countPtoU;         /* P2U buffer count, 0 = as many as fit */
+    uint16_t countUtoP;         /* U2P buffer count */
+    uint16_t burstLen;          /* SuperSpeed burst length */
+} CyFxSlFifoProfile_t;
+
+/* Endpoint parameter block for one USB speed */
+typedef struct CyFxSlFifoEpParams_t
+{
+    uint16_t pktSize;           /* wMaxPacketSize of the bulk endpoints */
+    uint8_t  burstLen;          /* Packets per burst (1 for USB 2.0 speeds) */
+    uint8_t  streams;           /* Bulk streams on the IN endpoint (SuperSpeed only) */
+} CyFxSlFifoEpParams_t;
+
+/* Telemetry block returned by CY_FX_RQT_GET_TELEMETRY. All fields are little endian.
+ * Buffer and byte counters are only updated for MANUAL channels; the GPIF error
+ * counters are updated in both modes. The timestamp and the intervals are in us
+ * (CyFxSlFifoGetTimeUs).
+ * The driver heap block pool usage is not cleared with the other counters. */
+#define CY_FX_SLFIFO_MEM_POOL_STATS     (3)     /* Block pools reported, unused entries read 0 */
+typedef struct CyFxSlFifoTelemetry_t
+{
+    uint64_t bytesPtoU;         /* Bytes committed towards the USB host */
+    uint64_t bytesUtoP;         /* Bytes committed towards the p-port */
+    uint32_t timestamp;         /* Device time at which the snapshot was taken, in us */
+    uint32_t buffersPtoU;       /* Buffers committed towards the USB host */
+    uint32_t buffersUtoP;       /* Buffers committed towards the p-port */
+    uint32_t commitFailPtoU;    /* Failed P2U commits */
+    uint32_t commitFailUtoP;    /* Failed U2P commits */
+    uint32_t overrun[4];        /* CYU3P_PIB_ERR_THRx_WR_OVERRUN count per GPIF thread */
+    uint32_t underrun[4];       /* CYU3P_PIB_ERR_THRx_RD_UNDERRUN count per GPIF thread */
+    uint32_t intervalMin;       /* Shortest time between two P2U buffers */
+    uint32_t intervalMax;       /* Longest time between two P2U buffers */
+    uint32_t intervalAvg;       /* Average time between two P2U buffers */
+    uint32_t intervalCount;     /* Number of P2U buffers seen by the interval statistics */
+    uint32_t recoveries;        /* GPIF error recoveries (CY_FX_SLFIFO_PIB_RECOVERY) */
+    uint32_t memBlockSize[CY_FX_SLFIFO_MEM_POOL_STATS];     /* Block size of each driver heap block pool */
+    uint32_t memHighWater[CY_FX_SLFIFO_MEM_POOL_STATS];     /* Most blocks in use since boot */
+    uint32_t memFallbacks[CY_FX_SLFIFO_MEM_POOL_STATS];     /* Requests served by the byte pool since boot */
+    uint32_t crcChecked;        /* U2P buffers checked on the P2U side (CY_FX_SLFIFO_CRC_CHECK) */
+    uint32_t crcMismatch;       /* Check points at which the CRCs differed */
+    uint32_t crcExpected;       /* Running U2P CRC at the last mismatch (not inverted) */
+    uint32_t crcActual;         /* Running P2U CRC at the last mismatch (not inverted) */
+    uint32_t gpifStartFail;     /* Failed GPIF state machine starts during recoveries */
+    uint32_t lpmExitU1;         /* Longest measured U1 exit in us, 0 if none yet; not cleared */
+    uint32_t lpmExitU2;         /* Longest measured U2 exit in us, 0 if none yet; not cleared */
+} CyFxSlFifoTelemetry_t;
+
+/* Result block returned by CY_FX_RQT_CPU_BENCHMARK. All fields are little endian.
+ * One run invalidates (D-cache builds) and processes a DMA buffer of the current
+ * P2U buffer size CY_FX_SLFIFO_BENCH_ITERATIONS times, like the P2U callback does. */
+typedef struct CyFxSlFifoBenchResult_t
+{
+    uint32_t status;            /* CY_U3P_SUCCESS, an error code or CY_FX_SLFIFO_BENCH_PENDING */
+    uint32_t dcacheEnabled;     /* CY_FX_SLFIFO_DCACHE_ENABLE of the running firmware */
+    uint32_t bufferBytes;       /* Bytes processed per buffer */
+    uint32_t iterations;        /* Buffers processed */
+    uint32_t elapsedUs;         /* Total run time in us (CyFxSlFifoGetTimeUs) */
+    uint32_t nsPerBuffer;       /* Average CPU cost per buffer */
+    uint32_t checksum;          /* Word sum of the last buffer, keeps the loop from being optimized away */
+} CyFxSlFifoBenchResult_t;
+
+/* One event of the binary trace. All fields are little endian. */
+typedef struct CyFxSlFifoTraceRecord_t
+{
+    uint16_t event;             /* CY_FX_SLFIFO_TRACE_xxx */
+    uint16_t sequence;          /* Incremented for every event, including dropped ones */
+    uint32_t timestamp;         /* Device time of the event, in us (CyFxSlFifoGetTimeUs) */
+    uint32_t arg0;              /* Event specific */
+    uint32_t arg1;              /* Event specific */
+} CyFxSlFifoTraceRecord_t;
+
+/* Header returned by CY_FX_RQT_GET_TRACE in front of the records. */
+typedef struct CyFxSlFifoTraceHeader_t
+{
+    uint16_t recordCount;       /* Records following the header */
+    uint16_t recordSize;        /* sizeof (CyFxSlFifoTraceRecord_t) */
+    uint16_t pending;           /* Records left in the ring after this read */
+    uint16_t mask;              /* Current event mask */
+    uint32_t dropped;           /* Records dropped because the ring was full, since the last read */
+    uint32_t timestamp;         /* Device time at which the ring was read, in us */
+} CyFxSlFifoTraceHeader_t;
+
+/* DMA buffer pools, implemented in cyfxtx.c */
+extern CyU3PReturnStatus_t CyU3PDmaBufferPoolCreate(uint16_t size, uint16_t count);
+extern CyU3PReturnStatus_t CyU3PDmaBufferPoolDestroy(uint16_t size);
+
+/* Driver heap block pool usage, implemented in cyfxtx.c */
+extern CyU3PReturnStatus_t CyU3PMemBlockPoolGetStats(uint32_t index, uint32_t *blockSize_p,
+        uint32_t *inUse_p, uint32_t *highWater_p, uint32_t *fallbacks_p);
+
+/* Endpoint parameters and descriptor patching, implemented in cyfxslfifoepcfg.c */
+extern const CyFxSlFifoEpParams_t glEpParams[3];
+extern const CyFxSlFifoEpParams_t *CyFxSlFifoGetEpParams(CyU3PUSBSpeed_t usbSpeed);
+extern void CyFxSlFifoApplnPatchConfigDscr(uint8_t *dscr_p, const CyFxSlFifoEpParams_t *params_p);
+extern void CyFxSlFifoApplnPatchBosDscr(uint8_t *dscr_p, uint32_t u1Exit, uint32_t u2Exit);
+
+/* Loopback CRC32 check, implemented in cyfxslfifocrc.c */
+extern CyBool_t glCrcCheck;
+extern void CyFxSlFifoCrcInit(void);
+extern uint32_t CyFxSlFifoCrcUpdate(uint32_t crc, const uint8_t *buf_p, uint32_t count);
+extern void CyFxSlFifoCrcReset(void);
+extern void CyFxSlFifoCrcUtoP(uint8_t *buf_p, uint32_t count);
+extern void CyFxSlFifoCrcPtoU(uint8_t *buf_p, uint32_t count);
+
+/* Telemetry counters and D-cache maintenance, implemented in cyfxslfifosync.c */
+extern CyFxSlFifoTelemetry_t glTelemetry;
+extern void CyFxSlFifoDCacheMaint(uint8_t *buf_p, uint32_t count, CyBool_t isClean);
 
 /* Extern definitions for the USB Descriptors */
 extern const uint8_t CyFxUSB20DeviceDscr[];
 extern const uint8_t CyFxUSB30DeviceDscr[];
 extern const uint8_t CyFxUSBDeviceQualDscr[];
-extern const uint8_t CyFxUSBFSConfigDscr[];
-extern const uint8_t CyFxUSBHSConfigDscr[];
-extern const uint8_t CyFxUSBBOSDscr[];
-extern const uint8_t CyFxUSBSSConfigDscr[];
+extern uint8_t CyFxUSBFSConfigDscr[];
+extern uint8_t CyFxUSBHSConfigDscr[];
+extern uint8_t CyFxUSBBOSDscr[];
+extern uint8_t CyFxUSBSSConfigDscr[];
 extern const uint8_t CyFxUSBStringLangIDDscr[];
 extern const uint8_t CyFxUSBManufactureDscr[];
 extern const uint8_t CyFxUSBProductDscr[];
@@ -73,7 +73,7 @@ const uint8_t CyFxUSB20DeviceDscr[] __attribute__ ((aligned (32))) =
 };
 
 /* Binary device object store descriptor */
-const uint8_t CyFxUSBBOSDscr[] __attribute__ ((aligned (32))) =
+uint8_t CyFxUSBBOSDscr[] __attribute__ ((aligned (32))) =
 {
     0x05,                           /* Descriptor size */
     CY_U3P_BOS_DESCR,               /* Device descriptor type */
@@ -93,8 +93,9 @@ const uint8_t CyFxUSBBOSDscr[] __attribute__ ((aligned (32))) =
     0x00,                           /* Supported device level features  */
     0x0E,0x00,                      /* Speeds supported by the device : SS, HS and FS */
     0x03,                           /* Functionality support */
-    0x00,                           /* U1 Device Exit latency */
-    0x00,0x00                       /* U2 Device Exit latency */
+    CY_FX_SLFIFO_U1_EXIT_LATENCY,   /* U1 Device Exit latency */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_U2_EXIT_LATENCY),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_U2_EXIT_LATENCY) /* U2 Device Exit latency */
 };
 
 /* Standard device qualifier descriptor */
@@ -111,13 +112,18 @@ const uint8_t CyFxUSBDeviceQualDscr[] __attribute__ ((aligned (32))) =
     0x00                            /* Reserved */
 };
 
-/* Standard super speed configuration descriptor */
-const uint8_t CyFxUSBSSConfigDscr[] __attribute__ ((aligned (32))) =
+/* Standard super speed configuration descriptor. The endpoint sizes, burst length and streams
+ * are overwritten at startup by CyFxSlFifoApplnPatchConfigDscr. */
+uint8_t CyFxUSBSSConfigDscr[] __attribute__ ((aligned (32))) =
 {
     /* Configuration descriptor */
     0x09,                           /* Descriptor size */
     CY_U3P_USB_CONFIG_DESCR,        /* Configuration descriptor type */
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    0x46,0x00,                      /* Length of this descriptor and all sub descriptors */
+#else
     0x2C,0x00,                      /* Length of this descriptor and all sub descriptors */
+#endif
     0x01,                           /* Number of interfaces */
     0x01,                           /* Configuration number */
     0x00,                           /* COnfiguration string index */
@@ -129,7 +135,7 @@ const uint8_t CyFxUSBSSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_INTRFC_DESCR,        /* Interface Descriptor type */
     0x00,                           /* Interface number */
     0x00,                           /* Alternate setting number */
-    0x02,                           /* Number of end points */
+    0x02 + 2 * CY_FX_SLFIFO_SECOND_EP_PAIR, /* Number of end points */
     0xFF,                           /* Interface class */
     0x00,                           /* Interface sub class */
     0x00,                           /* Interface protocol code */
@@ -140,13 +146,14 @@ const uint8_t CyFxUSBSSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
     CY_FX_EP_PRODUCER,              /* Endpoint address and description */
     CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x00,0x04,                      /* Max packet size = 1024 bytes */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_SS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_SS_PACKET_SIZE), /* Max packet size = 1024 bytes */
     0x00,                           /* Servicing interval for data transfers : 0 for bulk */
 
     /* Super speed endpoint companion descriptor for producer EP */
     0x06,                           /* Descriptor size */
     CY_U3P_SS_EP_COMPN_DESCR,       /* SS endpoint companion descriptor type */
-    0x00,                           /* Max no. of packets in a burst : 0: burst 1 packet at a time */
+    (CY_FX_SLFIFO_SS_BURST_LENGTH - 1), /* Max no. of packets in a burst - 1 */
     0x00,                           /* Max streams for bulk EP = 0 (No streams) */
     0x00,0x00,                      /* Service interval for the EP : 0 for bulk */
 
@@ -155,24 +162,63 @@ const uint8_t CyFxUSBSSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
     CY_FX_EP_CONSUMER,              /* Endpoint address and description */
     CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x00,0x04,                      /* Max packet size = 1024 bytes */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_SS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_SS_PACKET_SIZE), /* Max packet size = 1024 bytes */
     0x00,                           /* Servicing interval for data transfers : 0 for Bulk */
 
     /* Super speed endpoint companion descriptor for consumer EP */
     0x06,                           /* Descriptor size */
     CY_U3P_SS_EP_COMPN_DESCR,       /* SS endpoint companion descriptor type */
-    0x00,                           /* Max no. of packets in a burst : 0: burst 1 packet at a time */
+    (CY_FX_SLFIFO_SS_BURST_LENGTH - 1), /* Max no. of packets in a burst - 1 */
+    0x00,                           /* Max streams (2^n) : set from CY_FX_SLFIFO_BULK_STREAMS */
+    0x00,0x00,                      /* Service interval for the EP : 0 for bulk */
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    /* Endpoint descriptor for EP 2 producer */
+    0x07,                           /* Descriptor size */
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
+    CY_FX_EP2_PRODUCER,             /* Endpoint address and description */
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_SS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_SS_PACKET_SIZE), /* Max packet size = 1024 bytes */
+    0x00,                           /* Servicing interval for data transfers : 0 for bulk */
+
+    /* Super speed endpoint companion descriptor for EP 2 producer */
+    0x06,                           /* Descriptor size */
+    CY_U3P_SS_EP_COMPN_DESCR,       /* SS endpoint companion descriptor type */
+    (CY_FX_SLFIFO_SS_BURST_LENGTH - 1), /* Max no. of packets in a burst - 1 */
+    0x00,                           /* Max streams for bulk EP = 0 (No streams) */
+    0x00,0x00,                      /* Service interval for the EP : 0 for bulk */
+
+    /* Endpoint descriptor for EP 2 consumer */
+    0x07,                           /* Descriptor size */
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
+    CY_FX_EP2_CONSUMER,             /* Endpoint address and description */
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_SS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_SS_PACKET_SIZE), /* Max packet size = 1024 bytes */
+    0x00,                           /* Servicing interval for data transfers : 0 for Bulk */
+
+    /* Super speed endpoint companion descriptor for EP 2 consumer */
+    0x06,                           /* Descriptor size */
+    CY_U3P_SS_EP_COMPN_DESCR,       /* SS endpoint companion descriptor type */
+    (CY_FX_SLFIFO_SS_BURST_LENGTH - 1), /* Max no. of packets in a burst - 1 */
     0x00,                           /* Max streams for bulk EP = 0 (No streams) */
     0x00,0x00                       /* Service interval for the EP : 0 for bulk */
+#endif
 };
 
 /* Standard high speed configuration descriptor */
-const uint8_t CyFxUSBHSConfigDscr[] __attribute__ ((aligned (32))) =
+uint8_t CyFxUSBHSConfigDscr[] __attribute__ ((aligned (32))) =
 {
     /* Configuration descriptor */
     0x09,                           /* Descriptor size */
     CY_U3P_USB_CONFIG_DESCR,        /* Configuration descriptor type */
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    0x2E,0x00,                      /* Length of this descriptor and all sub descriptors */
+#else
     0x20,0x00,                      /* Length of this descriptor and all sub descriptors */
+#endif
     0x01,                           /* Number of interfaces */
     0x01,                           /* Configuration number */
     0x00,                           /* COnfiguration string index */
@@ -184,7 +230,7 @@ const uint8_t CyFxUSBHSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_INTRFC_DESCR,        /* Interface Descriptor type */
     0x00,                           /* Interface number */
     0x00,                           /* Alternate setting number */
-    0x02,                           /* Number of endpoints */
+    0x02 + 2 * CY_FX_SLFIFO_SECOND_EP_PAIR, /* Number of endpoints */
     0xFF,                           /* Interface class */
     0x00,                           /* Interface sub class */
     0x00,                           /* Interface protocol code */
@@ -195,7 +241,8 @@ const uint8_t CyFxUSBHSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
     CY_FX_EP_PRODUCER,              /* Endpoint address and description */
     CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x00,0x02,                      /* Max packet size = 512 bytes */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_HS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_HS_PACKET_SIZE), /* Max packet size = 512 bytes */
     0x00,                           /* Servicing interval for data transfers : 0 for bulk */
 
     /* Endpoint descriptor for consumer EP */
@@ -203,17 +250,42 @@ const uint8_t CyFxUSBHSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
     CY_FX_EP_CONSUMER,              /* Endpoint address and description */
     CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x00,0x02,                      /* Max packet size = 512 bytes */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_HS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_HS_PACKET_SIZE), /* Max packet size = 512 bytes */
+    0x00,                           /* Servicing interval for data transfers : 0 for bulk */
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    /* Endpoint descriptor for EP 2 producer */
+    0x07,                           /* Descriptor size */
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
+    CY_FX_EP2_PRODUCER,             /* Endpoint address and description */
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_HS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_HS_PACKET_SIZE), /* Max packet size = 512 bytes */
+    0x00,                           /* Servicing interval for data transfers : 0 for bulk */
+
+    /* Endpoint descriptor for EP 2 consumer */
+    0x07,                           /* Descriptor size */
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
+    CY_FX_EP2_CONSUMER,             /* Endpoint address and description */
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_HS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_HS_PACKET_SIZE), /* Max packet size = 512 bytes */
     0x00                            /* Servicing interval for data transfers : 0 for bulk */
+#endif
 };
 
 /* Standard full speed configuration descriptor */
-const uint8_t CyFxUSBFSConfigDscr[] __attribute__ ((aligned (32))) =
+uint8_t CyFxUSBFSConfigDscr[] __attribute__ ((aligned (32))) =
 {
     /* Configuration descriptor */
     0x09,                           /* Descriptor size */
     CY_U3P_USB_CONFIG_DESCR,        /* Configuration descriptor type */
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    0x2E,0x00,                      /* Length of this descriptor and all sub descriptors */
+#else
     0x20,0x00,                      /* Length of this descriptor and all sub descriptors */
+#endif
     0x01,                           /* Number of interfaces */
     0x01,                           /* Configuration number */
     0x00,                           /* COnfiguration string index */
@@ -225,7 +297,7 @@ const uint8_t CyFxUSBFSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_INTRFC_DESCR,        /* Interface descriptor type */
     0x00,                           /* Interface number */
     0x00,                           /* Alternate setting number */
-    0x02,                           /* Number of endpoints */
+    0x02 + 2 * CY_FX_SLFIFO_SECOND_EP_PAIR, /* Number of endpoints */
     0xFF,                           /* Interface class */
     0x00,                           /* Interface sub class */
     0x00,                           /* Interface protocol code */
@@ -236,7 +308,8 @@ const uint8_t CyFxUSBFSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
     CY_FX_EP_PRODUCER,              /* Endpoint address and description */
     CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x40,0x00,                      /* Max packet size = 64 bytes */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_FS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_FS_PACKET_SIZE), /* Max packet size = 64 bytes */
     0x00,                           /* Servicing interval for data transfers : 0 for bulk */
 
     /* Endpoint descriptor for consumer EP */
@@ -244,8 +317,29 @@ const uint8_t CyFxUSBFSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
     CY_FX_EP_CONSUMER,              /* Endpoint address and description */
     CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x40,0x00,                      /* Max packet size = 64 bytes */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_FS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_FS_PACKET_SIZE), /* Max packet size = 64 bytes */
+    0x00,                           /* Servicing interval for data transfers : 0 for bulk */
+
+#if (CY_FX_SLFIFO_SECOND_EP_PAIR == 1)
+    /* Endpoint descriptor for EP 2 producer */
+    0x07,                           /* Descriptor size */
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
+    CY_FX_EP2_PRODUCER,             /* Endpoint address and description */
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_FS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_FS_PACKET_SIZE), /* Max packet size = 64 bytes */
+    0x00,                           /* Servicing interval for data transfers : 0 for bulk */
+
+    /* Endpoint descriptor for EP 2 consumer */
+    0x07,                           /* Descriptor size */
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
+    CY_FX_EP2_CONSUMER,             /* Endpoint address and description */
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
+    CY_U3P_GET_LSB(CY_FX_SLFIFO_FS_PACKET_SIZE),
+    CY_U3P_GET_MSB(CY_FX_SLFIFO_FS_PACKET_SIZE), /* Max packet size = 64 bytes */
     0x00                            /* Servicing interval for data transfers : 0 for bulk */
+#endif
 };
 
 /* Standard language ID string descriptor */
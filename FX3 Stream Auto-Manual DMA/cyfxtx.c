@@ -27,81 +27,75 @@
 
 #include <cyu3os.h>
 #include <cyu3error.h>
+#include <cyu3system.h>
 
-#ifdef CYMEM_256K
+/* The RAM map, including the driver and buffer heap areas, is defined in cyfxmemmap.h. */
+#include "cyfxmemmap.h"
 
-/*
-   A reduced memory map is used with the CYUSB3011/CYUSB3012 devices:
-
-   Descriptor area    Base: 0x40000000 Size: 12  KB
-   Code area          Base: 0x40003000 Size: 128 KB
-   Data area          Base: 0x40023000 Size: 24  KB
-   Driver heap        Base: 0x40029000 Size: 28  KB
-   Buffer area        Base: 0x40030000 Size: 32  KB
-   2-stage boot area  Base: 0x40038000 Size: 32  KB
- */
-
-/*
-   The following definitions specify the start address and length of the Driver heap
-   area which is used by the application code as well as the drivers to allocate thread
-   stacks and other internal data structures.
- */
-#define CY_U3P_MEM_HEAP_BASE         ((uint8_t *)0x40029000)
-#define CY_U3P_MEM_HEAP_SIZE         (0x7000)
-
-/*
-   The last 32 KB of RAM is reserved for 2-stage boot operation. This value can be
-   changed to 0x40040000 if 2-stage boot is not used by the application.
- */
-#define CY_U3P_SYS_MEM_TOP           (0x40038000)
-
-#else /* 512 KB RAM is available. */
-
-/*
-   The default application memory map for FX3 firmware is as follows:
-
-   Descriptor area    Base: 0x40000000 Size: 12  KB
-   Code area          Base: 0x40003000 Size: 180 KB
-   Data area          Base: 0x40030000 Size: 32  KB
-   Driver heap        Base: 0x40038000 Size: 32  KB
-   Buffer area        Base: 0x40040000 Size: 224 KB
-   2-stage boot area  Base: 0x40078000 Size: 32  KB
- */
-
-/*
-   The following definitions specify the start address and length of the Driver heap
-   area which is used by the application code as well as the drivers to allocate thread
-   stacks and other internal data structures.
- */
-#define CY_U3P_MEM_HEAP_BASE         ((uint8_t *)0x40038000)
-#define CY_U3P_MEM_HEAP_SIZE         (0x8000)
+#define CY_U3P_BUFFER_ALLOC_TIMEOUT  (10)
+#define CY_U3P_MEM_ALLOC_TIMEOUT     (10)
 
 /*
-   The last 32 KB of RAM is reserved for 2-stage boot operation. This value can be
-   changed to 0x40080000 if 2-stage boot is not used by the application.
+   Fixed-block pools for small allocations. CyU3PMemAlloc serves requests up to the
+   largest block size from the smallest block pool that fits and only falls back to
+   the byte pool when that block pool is empty or the request is larger. Block pools
+   allocate in constant time and do not fragment over long uptimes. The pool memory
+   is taken from the driver heap when the heap is created. Set CY_U3P_MEM_BLOCK_POOLS
+   to 0 to use the byte pool only.
  */
-#define CY_U3P_SYS_MEM_TOP           (0x40078000)
+#define CY_U3P_MEM_BLOCK_POOLS       (1)
+#define CY_U3P_MEM_BLOCK_POOL_COUNT  (3)
+#define CY_U3P_MEM_BLOCK_OVERHEAD    (4)        /* Per block header kept by the RTOS */
 
-#endif
+#define CY_U3P_MAX(a,b)                 (((a) > (b)) ? (a) : (b))
+#define CY_U3P_MIN(a,b)                 (((a) < (b)) ? (a) : (b))
 
 /*
-   The buffer heap is used to obtain data buffers for DMA transfers in or out of
-   the FX3 device. The reference implementation of the buffer allocator makes use
-   of a reserved area in the SYSTEM RAM and ensures that all allocated DMA buffers
-   are aligned to cache lines.
+   DMA buffer pools. The application can set up a pool for each of the few buffer
+   sizes its DMA channels use. A pool is carved out of the buffer heap in one piece
+   and keeps its free buffers on an index list, so that allocating and freeing a
+   pool sized buffer takes constant time. All other sizes, and pool sizes while the
+   pool is exhausted, fall back to the bitmap allocator.
  */
-#define CY_U3P_BUFFER_HEAP_BASE      (((uint32_t)(CY_U3P_MEM_HEAP_BASE) + (CY_U3P_MEM_HEAP_SIZE)))
-#define CY_U3P_BUFFER_HEAP_SIZE      ((CY_U3P_SYS_MEM_TOP) - (CY_U3P_BUFFER_HEAP_BASE))
+#define CY_U3P_BUFFER_POOL_COUNT     (4)
+#define CY_U3P_BUFFER_POOL_END       (0xFFFF)
 
-#define CY_U3P_BUFFER_ALLOC_TIMEOUT  (10)
-#define CY_U3P_MEM_ALLOC_TIMEOUT     (10)
-
-#define CY_U3P_MAX(a,b)                 (((a) > (b)) ? (a) : (b))
-#define CY_U3P_MIN(a,b)                 (((a) < (b)) ? (a) : (b))
+typedef struct CyU3PDmaBufPool_t
+{
+    uint32_t  startAddr;                /* Address of the first buffer, 0 if the pool is unused. */
+    uint32_t  blockSize;                /* Size of each buffer in bytes, a multiple of 32. */
+    uint16_t  count;                    /* Number of buffers in the pool. */
+    uint16_t  inUse;                    /* Number of buffers currently allocated. */
+    uint16_t  freeHead;                 /* Index of the first free buffer. */
+    uint16_t *next_p;                   /* Free list link for each buffer. */
+} CyU3PDmaBufPool_t;
+
+typedef struct CyU3PMemBlockPool_t
+{
+    CyU3PBlockPool pool;                /* RTOS block pool. */
+    uint32_t       blockSize;           /* Size of each block in bytes. */
+    uint32_t       blockCount;          /* Number of blocks in the pool. */
+    uint8_t       *start_p;             /* Pool memory, used to find the pool of a block on free. */
+    uint8_t       *end_p;
+    uint32_t       inUse;               /* Blocks currently allocated. */
+    uint32_t       highWater;           /* Largest inUse value seen. */
+    uint32_t       fallbacks;           /* Requests of this size served by the byte pool. */
+} CyU3PMemBlockPool_t;
+
+/* Block size and count of each block pool, smallest first. Sized for event records and
+   other small driver objects, the application vendor request buffers and thread stacks. */
+const uint32_t glMemBlockPoolConfig[CY_U3P_MEM_BLOCK_POOL_COUNT][2] =
+{
+    {   32, 16 },
+    {  128,  8 },
+    { 1024,  2 }
+};
 
 CyBool_t         glMemPoolInit = CyFalse;
 CyU3PBytePool    glMemBytePool;
+CyU3PMemBlockPool_t glMemBlockPools[CY_U3P_MEM_BLOCK_POOL_COUNT];
 CyU3PDmaBufMgr_t glBufferManager = {{0}, 0, 0, 0, 0, 0};
+CyU3PDmaBufPool_t glBufferPools[CY_U3P_BUFFER_POOL_COUNT];
 
 /* These functions are exception handlers. These are default
  * implementations and the application firmware can have a
@@ -161,10 +155,40 @@ void
 CyU3PMemInit (
         void)
 {
+    CyU3PMemBlockPool_t *pool_p;
+    uint32_t i, size;
+    void *mem_p;
+
     if (!glMemPoolInit)
     {
 	glMemPoolInit = CyTrue;
 	CyU3PBytePoolCreate (&glMemBytePool, CY_U3P_MEM_HEAP_BASE, CY_U3P_MEM_HEAP_SIZE);
+
+#if (CY_U3P_MEM_BLOCK_POOLS == 1)
+        /* Carve the block pools out of the byte pool. A pool that cannot be created
+           is left empty and its requests go to the byte pool. */
+        CyU3PMemSet ((uint8_t *)glMemBlockPools, 0, sizeof (glMemBlockPools));
+        for (i = 0; i < CY_U3P_MEM_BLOCK_POOL_COUNT; i++)
+        {
+            pool_p = &glMemBlockPools[i];
+            pool_p->blockSize = glMemBlockPoolConfig[i][0];
+            size = glMemBlockPoolConfig[i][1] * (pool_p->blockSize + CY_U3P_MEM_BLOCK_OVERHEAD);
+            if (CyU3PByteAlloc (&glMemBytePool, &mem_p, size, CYU3P_NO_WAIT) != CY_U3P_SUCCESS)
+            {
+                continue;
+            }
+
+            if (CyU3PBlockPoolCreate (&pool_p->pool, pool_p->blockSize, mem_p, size) != CY_U3P_SUCCESS)
+            {
+                CyU3PByteFree (mem_p);
+                continue;
+            }
+
+            pool_p->blockCount = glMemBlockPoolConfig[i][1];
+            pool_p->start_p    = (uint8_t *)mem_p;
+            pool_p->end_p      = (uint8_t *)mem_p + size;
+        }
+#endif
     }
 }
 
@@ -172,8 +196,45 @@ void *
 CyU3PMemAlloc (
         uint32_t size)
 {
+    CyU3PMemBlockPool_t *pool_p;
     void     *ret_p;
-    uint32_t status;
+    uint32_t status, intMask, i;
+
+#if (CY_U3P_MEM_BLOCK_POOLS == 1)
+    /* Try the smallest block pool that fits. Block pools never wait; an empty pool
+       is counted and the request goes to the byte pool. */
+    for (i = 0; i < CY_U3P_MEM_BLOCK_POOL_COUNT; i++)
+    {
+        pool_p = &glMemBlockPools[i];
+        if ((pool_p->blockCount == 0) || (size > pool_p->blockSize))
+        {
+            continue;
+        }
+
+        status = CyU3PBlockAlloc (&pool_p->pool, &ret_p, CYU3P_NO_WAIT);
+
+        intMask = CyU3PVicDisableAllInterrupts ();
+        if (status == CY_U3P_SUCCESS)
+        {
+            pool_p->inUse++;
+            if (pool_p->inUse > pool_p->highWater)
+            {
+                pool_p->highWater = pool_p->inUse;
+            }
+        }
+        else
+        {
+            pool_p->fallbacks++;
+        }
+        CyU3PVicEnableInterrupts (intMask);
+
+        if (status == CY_U3P_SUCCESS)
+        {
+            return ret_p;
+        }
+        break;
+    }
+#endif
 
     /* Cannot wait in interrupt context */
     if (CyU3PThreadIdentify ())
@@ -197,31 +258,105 @@ void
 CyU3PMemFree (
         void *mem_p)
 {
+    CyU3PMemBlockPool_t *pool_p;
+    uint32_t intMask, i;
+
+#if (CY_U3P_MEM_BLOCK_POOLS == 1)
+    /* Blocks go back to the pool whose memory they are in. */
+    for (i = 0; i < CY_U3P_MEM_BLOCK_POOL_COUNT; i++)
+    {
+        pool_p = &glMemBlockPools[i];
+        if (((uint8_t *)mem_p >= pool_p->start_p) && ((uint8_t *)mem_p < pool_p->end_p))
+        {
+            CyU3PBlockFree (mem_p);
+
+            intMask = CyU3PVicDisableAllInterrupts ();
+            pool_p->inUse--;
+            CyU3PVicEnableInterrupts (intMask);
+            return;
+        }
+    }
+#endif
+
     CyU3PByteFree (mem_p);
 }
 
+/* Usage of block pool index: block size, blocks in use, high-water mark of the
+   blocks in use and the number of requests of that size that the byte pool had to
+   serve. Returns CY_U3P_ERROR_BAD_ARGUMENT for an index past the last pool. */
+CyU3PReturnStatus_t
+CyU3PMemBlockPoolGetStats (
+        uint32_t  index,
+        uint32_t *blockSize_p,
+        uint32_t *inUse_p,
+        uint32_t *highWater_p,
+        uint32_t *fallbacks_p)
+{
+    CyU3PMemBlockPool_t *pool_p;
+    uint32_t intMask;
+
+    if ((CY_U3P_MEM_BLOCK_POOLS == 0) || (index >= CY_U3P_MEM_BLOCK_POOL_COUNT))
+    {
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    }
+
+    pool_p = &glMemBlockPools[index];
+    intMask = CyU3PVicDisableAllInterrupts ();
+    *blockSize_p = pool_p->blockSize;
+    *inUse_p     = pool_p->inUse;
+    *highWater_p = pool_p->highWater;
+    *fallbacks_p = pool_p->fallbacks;
+    CyU3PVicEnableInterrupts (intMask);
+
+    return CY_U3P_SUCCESS;
+}
+
+/* The memory functions below move 32 bit words when both pointers allow it and
+   fall back to single bytes for the unaligned head and tail and for pointers with
+   different alignment. Copies move 32 bytes per iteration, with LDM/STM on ARM. */
+#define CY_U3P_MEM_IS_ALIGNED(p)        ((((uint32_t)(p)) & 3) == 0)
+
 void
 CyU3PMemSet (
         uint8_t *ptr,
         uint8_t data,
         uint32_t count)
 {
-    /* Loop unrolling for faster operation */
-    while (count >> 3)
+    uint32_t *word_p;
+    uint32_t  word;
+
+    /* Bytes up to the first word boundary. */
+    while ((count != 0) && (!CY_U3P_MEM_IS_ALIGNED (ptr)))
     {
-        ptr[0] = data;
-        ptr[1] = data;
-        ptr[2] = data;
-        ptr[3] = data;
-        ptr[4] = data;
-        ptr[5] = data;
-        ptr[6] = data;
-        ptr[7] = data;
+        *ptr++ = data;
+        count--;
+    }
 
-        count -= 8;
-        ptr += 8;
+    /* Whole words, eight at a time. */
+    word   = data * 0x01010101U;
+    word_p = (uint32_t *)ptr;
+    while (count >> 5)
+    {
+        word_p[0] = word;
+        word_p[1] = word;
+        word_p[2] = word;
+        word_p[3] = word;
+        word_p[4] = word;
+        word_p[5] = word;
+        word_p[6] = word;
+        word_p[7] = word;
+
+        count  -= 32;
+        word_p += 8;
+    }
+
+    while (count >> 2)
+    {
+        *word_p++ = word;
+        count -= 4;
     }
 
+    ptr = (uint8_t *)word_p;
     while (count--)
     {
         *ptr = data;
@@ -235,6 +370,55 @@ CyU3PMemCopy (
         uint8_t *src,
         uint32_t count)
 {
+    uint32_t *dest_p, *src_p;
+
+    /* Words can only be used when both pointers have the same alignment. */
+    if (((((uint32_t)dest) ^ ((uint32_t)src)) & 3) == 0)
+    {
+        while ((count != 0) && (!CY_U3P_MEM_IS_ALIGNED (dest)))
+        {
+            *dest++ = *src++;
+            count--;
+        }
+
+        dest_p = (uint32_t *)dest;
+        src_p  = (uint32_t *)src;
+        while (count >> 5)
+        {
+#if defined(__GNUC__) && defined(__arm__)
+            __asm__ __volatile__ (
+                    "ldmia %0!, {r3, r4, r5, r12}\n\t"
+                    "stmia %1!, {r3, r4, r5, r12}\n\t"
+                    "ldmia %0!, {r3, r4, r5, r12}\n\t"
+                    "stmia %1!, {r3, r4, r5, r12}\n\t"
+                    : "+r" (src_p), "+r" (dest_p)
+                    :
+                    : "r3", "r4", "r5", "r12", "memory");
+#else
+            dest_p[0] = src_p[0];
+            dest_p[1] = src_p[1];
+            dest_p[2] = src_p[2];
+            dest_p[3] = src_p[3];
+            dest_p[4] = src_p[4];
+            dest_p[5] = src_p[5];
+            dest_p[6] = src_p[6];
+            dest_p[7] = src_p[7];
+            dest_p += 8;
+            src_p  += 8;
+#endif
+            count -= 32;
+        }
+
+        while (count >> 2)
+        {
+            *dest_p++ = *src_p++;
+            count -= 4;
+        }
+
+        dest = (uint8_t *)dest_p;
+        src  = (uint8_t *)src_p;
+    }
+
     /* Loop unrolling for faster operation */
     while (count >> 3)
     {
@@ -268,6 +452,30 @@ CyU3PMemCmp (
 {
     const uint8_t *ptr1 = s1, *ptr2 = s2;
 
+    /* Compare words while they are equal if both pointers have the same alignment.
+       The first difference is then located by the byte loop. */
+    if (((((uint32_t)ptr1) ^ ((uint32_t)ptr2)) & 3) == 0)
+    {
+        while ((n != 0) && (!CY_U3P_MEM_IS_ALIGNED (ptr1)))
+        {
+            if (*ptr1 != *ptr2)
+            {
+                return *ptr1 - *ptr2;
+            }
+
+            ptr1++;
+            ptr2++;
+            n--;
+        }
+
+        while ((n >= 4) && (*(const uint32_t *)ptr1 == *(const uint32_t *)ptr2))
+        {
+            ptr1 += 4;
+            ptr2 += 4;
+            n    -= 4;
+        }
+    }
+
     while(n--)
     {
         if(*ptr1 != *ptr2)
@@ -344,7 +552,7 @@ void
 CyU3PDmaBufferDeInit (
         void)
 {
-    uint32_t status;
+    uint32_t status, i;
 
     /* Get the mutex lock. */
     if (CyU3PThreadIdentify ())
@@ -361,7 +569,15 @@ CyU3PDmaBufferDeInit (
         return;
     }
 
-    /* Free memory and zero out variables. */
+    /* Free memory and zero out variables. The pools live in the buffer heap and go with it. */
+    for (i = 0; i < CY_U3P_BUFFER_POOL_COUNT; i++)
+    {
+        if (glBufferPools[i].next_p != 0)
+        {
+            CyU3PMemFree (glBufferPools[i].next_p);
+        }
+    }
+    CyU3PMemSet ((uint8_t *)glBufferPools, 0, sizeof (glBufferPools));
     CyU3PMemFree (glBufferManager.usedStatus);
     glBufferManager.usedStatus = 0;
     glBufferManager.startAddr  = 0;
@@ -420,41 +636,19 @@ CyU3PDmaBufMgrSetStatus (
     }
 }
 
-/* This function shall be invoked from the DMA module for buffer allocation */
-void *
-CyU3PDmaBufferAlloc (
-        uint16_t size)
+/* Bitmap allocator: find and mark a free block of numChunks 32 byte chunks.
+   The buffer manager lock must be held by the caller. */
+static void *
+CyU3PDmaBufMgrAlloc (
+        uint32_t numChunks)
 {
     uint32_t tmp;
     uint32_t wordnum, bitnum;
     uint32_t count, start = 0;
     void *ptr = 0;
 
-    /* Get the lock for the buffer manager. */
-    if (CyU3PThreadIdentify ())
-    {
-        tmp = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
-    }
-    else
-    {
-        tmp = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
-    }
-
-    if (tmp != CY_U3P_SUCCESS)
-    {
-        return ptr;
-    }
-
-    /* Make sure the buffer manager has been initialized. */
-    if ((glBufferManager.startAddr == 0) || (glBufferManager.regionSize == 0))
-    {
-        CyU3PMutexPut (&glBufferManager.lock);
-        return ptr;
-    }
-
-    /* Find the number of 32 byte chunks required. The minimum size that can be handled is
-       64 bytes. */
-    size = (size <= 32) ? 2 : (size + 31) / 32;
+    /* The minimum size that can be handled is 64 bytes. */
+    numChunks = CY_U3P_MAX (numChunks, 2);
 
     /* Search through the status array to find the first block that fits the need. */
     wordnum = glBufferManager.searchPos;
@@ -472,7 +666,7 @@ CyU3PDmaBufferAlloc (
                 start = (wordnum << 5) + bitnum + 1;
             }
             count++;
-            if (count == (size + 1))
+            if (count == (numChunks + 1))
             {
                 /* The last bit corresponding to the allocated memory is left as zero.
                    This allows us to identify the end of the allocated block while freeing
@@ -502,13 +696,114 @@ CyU3PDmaBufferAlloc (
         }
     }
 
-    if (count == (size + 1))
+    if (count == (numChunks + 1))
     {
         /* Mark the memory region identified as occupied and return the pointer. */
-        CyU3PDmaBufMgrSetStatus (start, size - 1, CyTrue);
+        CyU3PDmaBufMgrSetStatus (start, numChunks - 1, CyTrue);
         ptr = (void *)(glBufferManager.startAddr + (start << 5));
     }
 
+    return (ptr);
+}
+
+/* Bitmap allocator: release a block allocated by CyU3PDmaBufMgrAlloc.
+   The buffer manager lock must be held by the caller. */
+static int
+CyU3PDmaBufMgrFree (
+        uint32_t start)
+{
+    uint32_t count;
+    uint32_t wordnum, bitnum;
+
+    /* If the buffer address is within the range specified, count the number of consecutive ones and
+       clear them. */
+    if ((start <= glBufferManager.startAddr) || (start >= (glBufferManager.startAddr + glBufferManager.regionSize)))
+    {
+        return -1;
+    }
+
+    start = ((start - glBufferManager.startAddr) >> 5);
+
+    wordnum = (start >> 5);
+    bitnum  = (start & 0x1F);
+    count   = 0;
+
+    while ((wordnum < glBufferManager.statusSize) && ((glBufferManager.usedStatus[wordnum] & (1 << bitnum)) != 0))
+    {
+        count++;
+        bitnum++;
+        if (bitnum == 32)
+        {
+            bitnum = 0;
+            wordnum++;
+        }
+    }
+
+    CyU3PDmaBufMgrSetStatus (start, count, CyFalse);
+
+    /* Start the next buffer search at the top of the heap. This can help reduce fragmentation in cases where
+       most of the heap is allocated and then freed as a whole. */
+    glBufferManager.searchPos = 0;
+    return 0;
+}
+
+/* Helper function for the DMA buffer manager. Gets the lock, waiting only
+   when called from a thread. */
+static uint32_t
+CyU3PDmaBufMgrLock (
+        void)
+{
+    if (CyU3PThreadIdentify ())
+    {
+        return CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
+    }
+
+    return CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+}
+
+/* This function shall be invoked from the DMA module for buffer allocation */
+void *
+CyU3PDmaBufferAlloc (
+        uint16_t size)
+{
+    CyU3PDmaBufPool_t *pool_p;
+    uint32_t blockSize, i;
+    void *ptr = 0;
+
+    /* Get the lock for the buffer manager. */
+    if (CyU3PDmaBufMgrLock () != CY_U3P_SUCCESS)
+    {
+        return ptr;
+    }
+
+    /* Make sure the buffer manager has been initialized. */
+    if ((glBufferManager.startAddr == 0) || (glBufferManager.regionSize == 0))
+    {
+        CyU3PMutexPut (&glBufferManager.lock);
+        return ptr;
+    }
+
+    /* Take the buffer from the pool of this size if there is one with a free buffer. */
+    blockSize = ((uint32_t)size + 31) & ~31;
+    for (i = 0; i < CY_U3P_BUFFER_POOL_COUNT; i++)
+    {
+        pool_p = &glBufferPools[i];
+        if ((pool_p->startAddr != 0) && (pool_p->blockSize == blockSize) &&
+                (pool_p->freeHead != CY_U3P_BUFFER_POOL_END))
+        {
+            ptr = (void *)(pool_p->startAddr + pool_p->freeHead * blockSize);
+            pool_p->freeHead = pool_p->next_p[pool_p->freeHead];
+            pool_p->inUse++;
+            break;
+        }
+    }
+
+    /* Find the number of 32 byte chunks required and fall back to the bitmap. */
+    if (ptr == 0)
+    {
+        ptr = CyU3PDmaBufMgrAlloc (blockSize >> 5);
+    }
+
     CyU3PMutexPut (&glBufferManager.lock);
     return (ptr);
 }
@@ -518,66 +813,177 @@ int
 CyU3PDmaBufferFree (
         void *buffer)
 {
-    uint32_t status, start, count;
-    uint32_t wordnum, bitnum;
+    CyU3PDmaBufPool_t *pool_p;
+    uint32_t start, index, i;
     int      retVal = -1;
 
     /* Get the lock for the buffer manager. */
-    if (CyU3PThreadIdentify ())
+    if (CyU3PDmaBufMgrLock () != CY_U3P_SUCCESS)
     {
-        status = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
+        return retVal;
     }
-    else
+
+    /* Buffers from a pool go back on the free list of the pool. */
+    start = (uint32_t)buffer;
+    for (i = 0; i < CY_U3P_BUFFER_POOL_COUNT; i++)
     {
-        status = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+        pool_p = &glBufferPools[i];
+        if ((pool_p->startAddr != 0) && (start >= pool_p->startAddr) &&
+                (start < (pool_p->startAddr + pool_p->count * pool_p->blockSize)))
+        {
+            index = (start - pool_p->startAddr) / pool_p->blockSize;
+            if ((pool_p->startAddr + index * pool_p->blockSize) == start)
+            {
+                pool_p->next_p[index] = pool_p->freeHead;
+                pool_p->freeHead = index;
+                pool_p->inUse--;
+                retVal = 0;
+            }
+            break;
+        }
     }
 
-    if (status != CY_U3P_SUCCESS)
+    if (i == CY_U3P_BUFFER_POOL_COUNT)
     {
-        return retVal;
+        retVal = CyU3PDmaBufMgrFree (start);
     }
 
-    /* If the buffer address is within the range specified, count the number of consecutive ones and
-       clear them. */
-    start = (uint32_t)buffer;
-    if ((start > glBufferManager.startAddr) && (start < (glBufferManager.startAddr + glBufferManager.regionSize)))
+    /* Free the lock before we go. */
+    CyU3PMutexPut (&glBufferManager.lock);
+    return retVal;
+}
+
+/* Set up a pool of count DMA buffers of the given size. Buffers of this size are
+   then served from the pool while it has free buffers. Creating a pool that exists
+   with at least as many buffers succeeds without any change, so the function can be
+   called every time the DMA channels are created. Should only be called from a thread. */
+CyU3PReturnStatus_t
+CyU3PDmaBufferPoolCreate (
+        uint16_t size,
+        uint16_t count)
+{
+    CyU3PDmaBufPool_t *pool_p = 0;
+    uint32_t blockSize, i;
+    CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+    if ((size == 0) || (count == 0) || (count >= CY_U3P_BUFFER_POOL_END))
     {
-        start = ((start - glBufferManager.startAddr) >> 5);
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    }
 
-        wordnum = (start >> 5);
-        bitnum  = (start & 0x1F);
-        count   = 0;
+    if (CyU3PDmaBufMgrLock () != CY_U3P_SUCCESS)
+    {
+        return CY_U3P_ERROR_MUTEX_FAILURE;
+    }
 
-        while ((wordnum < glBufferManager.statusSize) && ((glBufferManager.usedStatus[wordnum] & (1 << bitnum)) != 0))
+    blockSize = ((uint32_t)size + 31) & ~31;
+    for (i = 0; i < CY_U3P_BUFFER_POOL_COUNT; i++)
+    {
+        if ((glBufferPools[i].startAddr != 0) && (glBufferPools[i].blockSize == blockSize))
         {
-            count++;
-            bitnum++;
-            if (bitnum == 32)
-            {
-                bitnum = 0;
-                wordnum++;
-            }
+            /* A pool of this size exists already. It cannot grow in place. */
+            status = (glBufferPools[i].count >= count) ? CY_U3P_SUCCESS : CY_U3P_ERROR_ALREADY_STARTED;
+            CyU3PMutexPut (&glBufferManager.lock);
+            return status;
         }
 
-        CyU3PDmaBufMgrSetStatus (start, count, CyFalse);
+        if ((pool_p == 0) && (glBufferPools[i].startAddr == 0))
+        {
+            pool_p = &glBufferPools[i];
+        }
+    }
+
+    if ((pool_p == 0) || (glBufferManager.startAddr == 0))
+    {
+        CyU3PMutexPut (&glBufferManager.lock);
+        return CY_U3P_ERROR_MEMORY_ERROR;
+    }
 
-        /* Start the next buffer search at the top of the heap. This can help reduce fragmentation in cases where
-           most of the heap is allocated and then freed as a whole. */
-        glBufferManager.searchPos = 0;
-        retVal = 0;
+    pool_p->next_p = (uint16_t *)CyU3PMemAlloc (count * sizeof (uint16_t));
+    if (pool_p->next_p != 0)
+    {
+        pool_p->startAddr = (uint32_t)CyU3PDmaBufMgrAlloc ((blockSize >> 5) * count);
+    }
+
+    if ((pool_p->next_p == 0) || (pool_p->startAddr == 0))
+    {
+        if (pool_p->next_p != 0)
+        {
+            CyU3PMemFree (pool_p->next_p);
+        }
+        pool_p->next_p = 0;
+        pool_p->startAddr = 0;
+        CyU3PMutexPut (&glBufferManager.lock);
+        return CY_U3P_ERROR_MEMORY_ERROR;
+    }
+
+    /* All buffers start out on the free list in address order. */
+    pool_p->blockSize = blockSize;
+    pool_p->count     = count;
+    pool_p->inUse     = 0;
+    pool_p->freeHead  = 0;
+    for (i = 0; i < count; i++)
+    {
+        pool_p->next_p[i] = ((i + 1) < count) ? (i + 1) : CY_U3P_BUFFER_POOL_END;
     }
 
-    /* Free the lock before we go. */
     CyU3PMutexPut (&glBufferManager.lock);
-    return retVal;
+    return status;
+}
+
+/* Return the pool of DMA buffers of the given size to the buffer heap. Fails if
+   any buffer of the pool is still allocated. Destroying a pool that does not exist
+   succeeds. Should only be called from a thread. */
+CyU3PReturnStatus_t
+CyU3PDmaBufferPoolDestroy (
+        uint16_t size)
+{
+    uint32_t blockSize, i;
+    CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+    if (CyU3PDmaBufMgrLock () != CY_U3P_SUCCESS)
+    {
+        return CY_U3P_ERROR_MUTEX_FAILURE;
+    }
+
+    blockSize = ((uint32_t)size + 31) & ~31;
+    for (i = 0; i < CY_U3P_BUFFER_POOL_COUNT; i++)
+    {
+        if ((glBufferPools[i].startAddr != 0) && (glBufferPools[i].blockSize == blockSize))
+        {
+            if (glBufferPools[i].inUse != 0)
+            {
+                status = CY_U3P_ERROR_INVALID_SEQUENCE;
+                break;
+            }
+
+            CyU3PDmaBufMgrFree (glBufferPools[i].startAddr);
+            CyU3PMemFree (glBufferPools[i].next_p);
+            CyU3PMemSet ((uint8_t *)&glBufferPools[i], 0, sizeof (CyU3PDmaBufPool_t));
+            break;
+        }
+    }
+
+    CyU3PMutexPut (&glBufferManager.lock);
+    return status;
 }
 
 void
 CyU3PFreeHeaps (
 	void)
 {
-    /* Free up the mem and buffer heaps. */
+    uint32_t i;
+
+    /* Free up the mem and buffer heaps. The block pools live in the byte pool. */
     CyU3PDmaBufferDeInit ();
+    for (i = 0; i < CY_U3P_MEM_BLOCK_POOL_COUNT; i++)
+    {
+        if (glMemBlockPools[i].blockCount != 0)
+        {
+            CyU3PBlockPoolDestroy (&glMemBlockPools[i].pool);
+        }
+    }
+    CyU3PMemSet ((uint8_t *)glMemBlockPools, 0, sizeof (glMemBlockPools));
     CyU3PBytePoolDestroy (&glMemBytePool);
     glMemPoolInit = CyFalse;
 }
@@ -0,0 +1,75 @@
+----------------------------------------------------------------------------------
+-- Synchronous Slave FIFO Interface - Buffer Simulation Model
+-- Behavioural stand-in for the slave_fifo_buffer core, which is generated by
+-- the ISE core generator and not part of the sources. First word fall through:
+-- dout shows the oldest word and rd_en removes it. Simulation only.
+----------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+----------------------------------------------------------------------------------
+-- Entity
+----------------------------------------------------------------------------------
+entity slave_fifo_buffer is
+generic
+(
+	DEPTH : natural := 1024
+);
+port
+(
+	clk : in std_logic;
+	rst : in std_logic;
+	din : in std_logic_vector(15 downto 0);
+	wr_en : in std_logic;
+	rd_en : in std_logic;
+	dout : out std_logic_vector(15 downto 0);
+	full : out std_logic;
+	empty : out std_logic
+); end slave_fifo_buffer;
+----------------------------------------------------------------------------------
+-- Architecture
+----------------------------------------------------------------------------------
+architecture slave_fifo_buffer_model_arch of slave_fifo_buffer is
+----------------------------------------------------------------------------------
+-- Signals
+----------------------------------------------------------------------------------
+type buffer_memory is array (0 to DEPTH-1) of std_logic_vector(15 downto 0);
+signal memory : buffer_memory;
+signal head : natural range 0 to DEPTH-1 := 0;
+signal tail : natural range 0 to DEPTH-1 := 0;
+signal count : natural range 0 to DEPTH := 0;
+----------------------------------------------------------------------------------
+-- Main code begin
+----------------------------------------------------------------------------------
+begin
+dout <= memory(head);
+full <= '1' when (count = DEPTH) else '0';
+empty <= '1' when (count = 0) else '0';
+
+process(clk) begin
+	if (rising_edge(clk)) then
+		if (rst = '1') then
+			head <= 0;
+			tail <= 0;
+			count <= 0;
+		else
+			if (wr_en = '1') and (count < DEPTH) then
+				memory(tail) <= din;
+				tail <= (tail + 1) mod DEPTH;
+			end if;
+			if (rd_en = '1') and (count > 0) then
+				head <= (head + 1) mod DEPTH;
+			end if;
+			if (wr_en = '1') and (count < DEPTH) and not ((rd_en = '1') and (count > 0)) then
+				count <= count + 1;
+			elsif not ((wr_en = '1') and (count < DEPTH)) and (rd_en = '1') and (count > 0) then
+				count <= count - 1;
+			end if;
+		end if;
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- End Architecture
+----------------------------------------------------------------------------------
+end slave_fifo_buffer_model_arch;
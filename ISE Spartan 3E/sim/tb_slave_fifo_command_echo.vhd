@@ -0,0 +1,172 @@
+----------------------------------------------------------------------------------
+-- Synchronous Slave FIFO Interface - Command Echo Testbench
+-- Runs slave_fifo_command_echo against a model of the FX3 slave FIFO. The
+-- strobes, address and output data are registered on the way to the pins and
+-- the data bus on the way in, as in slave_fifo_main. The FX3 drives a word
+-- two cycles after it samples SLRD, and only while SLOE is low; otherwise the
+-- bus floats. WORD_COUNT command words are queued on thread 2 and must come
+-- back on thread 1 in order, followed by a PKTEND.
+----------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+----------------------------------------------------------------------------------
+-- Entity
+----------------------------------------------------------------------------------
+entity tb_slave_fifo_command_echo is
+end tb_slave_fifo_command_echo;
+----------------------------------------------------------------------------------
+-- Architecture
+----------------------------------------------------------------------------------
+architecture tb_command_echo_arch of tb_slave_fifo_command_echo is
+----------------------------------------------------------------------------------
+-- Constants
+----------------------------------------------------------------------------------
+constant CLOCK_PERIOD : time := 10 ns;
+constant WORD_COUNT : natural := 8;
+constant FIRST_WORD : natural := 16#C000#;
+constant CMD_IN_THREAD : std_logic_vector(1 downto 0):="01";
+constant CMD_OUT_THREAD : std_logic_vector(1 downto 0):="10";
+----------------------------------------------------------------------------------
+-- Signals
+----------------------------------------------------------------------------------
+signal clock100 : std_logic := '0';
+signal reset : std_logic := '0';
+signal done : boolean := false;
+
+-- Module ports
+signal command_grant : std_logic := '0';
+signal flag_cmd_in_ready : std_logic := '1';
+signal flag_cmd_out_ready : std_logic := '0';
+signal data_command_in : std_logic_vector(15 downto 0) := (others => '0');
+signal data_command_out : std_logic_vector(15 downto 0);
+signal command_request : std_logic;
+signal slwr_command : std_logic;
+signal sloe_command : std_logic;
+signal slrd_command : std_logic;
+signal pktend_command : std_logic;
+signal command_address : std_logic_vector(1 downto 0);
+
+-- Pins
+signal slwr : std_logic := '1';
+signal sloe : std_logic := '1';
+signal slrd : std_logic := '1';
+signal pktend : std_logic := '1';
+signal address : std_logic_vector(1 downto 0) := "11";
+signal data : std_logic_vector(15 downto 0);
+signal data_out_get2 : std_logic_vector(15 downto 0) := (others => '0');
+
+-- FX3 model
+signal fx3_read_data1 : std_logic_vector(15 downto 0) := (others => '0');
+signal fx3_read_data2 : std_logic_vector(15 downto 0) := (others => '0');
+signal words_read : natural := 0;
+signal words_written : natural := 0;
+signal pktend_seen : boolean := false;
+----------------------------------------------------------------------------------
+-- Main code begin
+----------------------------------------------------------------------------------
+begin
+----------------------------------------------------------------------------------
+-- Device under test
+----------------------------------------------------------------------------------
+inst_command_echo : entity work.slave_fifo_command_echo port map
+(
+	clock100 => clock100,
+	reset => reset,
+	command_mode_active => '1',
+	command_grant => command_grant,
+	flag_cmd_in_ready => flag_cmd_in_ready,
+	flag_cmd_out_ready => flag_cmd_out_ready,
+	data_command_in => data_command_in,
+	data_command_out => data_command_out,
+	command_request => command_request,
+	slwr_command => slwr_command,
+	sloe_command => sloe_command,
+	slrd_command => slrd_command,
+	pktend_command => pktend_command,
+	command_address => command_address
+);
+----------------------------------------------------------------------------------
+-- Clock and Reset
+----------------------------------------------------------------------------------
+clock100 <= not clock100 after CLOCK_PERIOD / 2 when not done else '0';
+reset <= '1' after 10 * CLOCK_PERIOD;
+----------------------------------------------------------------------------------
+-- Main module: bus grant, pin registers and input register
+----------------------------------------------------------------------------------
+process(clock100) begin
+	if (rising_edge(clock100)) then
+		command_grant <= command_request;
+		slwr <= slwr_command;
+		sloe <= sloe_command;
+		slrd <= slrd_command;
+		pktend <= pktend_command;
+		address <= command_address;
+		data_out_get2 <= data_command_out;
+		data_command_in <= data;
+	end if;
+end process;
+data <= data_out_get2 when (slwr = '0') else (others => 'Z');
+----------------------------------------------------------------------------------
+-- FX3 read side: thread 2 holds WORD_COUNT words; the word read with SLRD is
+-- on the bus two cycles later while SLOE is low
+----------------------------------------------------------------------------------
+process(clock100) begin
+	if (rising_edge(clock100)) then
+		if (slrd = '0') then
+			assert (address = CMD_OUT_THREAD)
+				report "SLRD on thread " & integer'image(conv_integer(address)) severity error;
+			assert (words_read < WORD_COUNT)
+				report "SLRD on an empty thread" severity error;
+			fx3_read_data1 <= conv_std_logic_vector(FIRST_WORD + words_read, 16);
+			words_read <= words_read + 1;
+		end if;
+		fx3_read_data2 <= fx3_read_data1;
+
+		-- DMA ready flag of thread 2, registered as in slave_fifo_main
+		if (words_read < WORD_COUNT) then
+			flag_cmd_out_ready <= '1';
+		else
+			flag_cmd_out_ready <= '0';
+		end if;
+	end if;
+end process;
+data <= fx3_read_data2 when (sloe = '0') else (others => 'Z');
+----------------------------------------------------------------------------------
+-- FX3 write side: every word written to thread 1 must be the next command word
+----------------------------------------------------------------------------------
+process(clock100) begin
+	if (rising_edge(clock100)) then
+		if (slwr = '0') then
+			assert (address = CMD_IN_THREAD)
+				report "SLWR on thread " & integer'image(conv_integer(address)) severity error;
+			assert (data = conv_std_logic_vector(FIRST_WORD + words_written, 16))
+				report "Echoed word " & integer'image(words_written) & " is wrong" severity error;
+			words_written <= words_written + 1;
+		end if;
+		if (pktend = '0') then
+			assert (address = CMD_IN_THREAD)
+				report "PKTEND on thread " & integer'image(conv_integer(address)) severity error;
+			pktend_seen <= true;
+		end if;
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- Result
+----------------------------------------------------------------------------------
+process begin
+	wait until pktend_seen for 20 us;
+	assert pktend_seen report "No short packet committed" severity error;
+	assert (words_read = WORD_COUNT)
+		report integer'image(words_read) & " words read" severity error;
+	assert (words_written = WORD_COUNT)
+		report integer'image(words_written) & " words echoed" severity error;
+	report "Command echo passed";
+	done <= true;
+	wait;
+end process;
+----------------------------------------------------------------------------------
+-- End Architecture
+----------------------------------------------------------------------------------
+end tb_command_echo_arch;
@@ -0,0 +1,271 @@
+----------------------------------------------------------------------------------
+-- Synchronous Slave FIFO Interface - Stream Write to FX3 Testbench
+-- Runs slave_fifo_stream_write_to_fx3 against a model of the FX3 P2U channel.
+-- The flags are registered on the way in and SLWR and the address on the way
+-- out, as in slave_fifo_main. With PING_PONG = 1 the model is the many-to-one
+-- channel of CY_FX_SLFIFO_P2U_PINGPONG: BUF_COUNT / 2 buffers on each of the
+-- threads 0 (FLAGA/FLAGB) and 1 (FLAGC/FLAGD), sent to USB strictly in turn.
+-- With PING_PONG = 0 thread 0 owns all BUF_COUNT buffers.
+--
+-- A thread's DMA ready flag is high while its socket has an active buffer, its
+-- watermark flag while more than WATERMARK words are left in it. A full buffer
+-- is committed and the socket needs SWITCH_CYCLES to activate the next free
+-- one; USB returns a buffer to its socket after USB_CYCLES. The writer must
+-- never write to a thread without an active buffer, every burst must end on a
+-- buffer boundary (otherwise the many-to-one channel reorders the data) and
+-- the buffers must reach USB in the order they were written. With ping-pong
+-- the bus may idle no more than MAX_GAP clocks between two buffers.
+-- The host model FX3 Firmware Tests/test_pingpong.c runs the same checks with
+-- the buffer geometry of the firmware.
+----------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+----------------------------------------------------------------------------------
+-- Entity
+----------------------------------------------------------------------------------
+entity tb_slave_fifo_stream_write_to_fx3 is
+generic
+(
+	PING_PONG : natural := 1
+);
+end tb_slave_fifo_stream_write_to_fx3;
+----------------------------------------------------------------------------------
+-- Architecture
+----------------------------------------------------------------------------------
+architecture tb_stream_write_arch of tb_slave_fifo_stream_write_to_fx3 is
+----------------------------------------------------------------------------------
+-- Constants
+----------------------------------------------------------------------------------
+constant CLOCK_PERIOD : time := 10 ns;
+constant BUF_WORDS : natural := 64;
+constant BUF_COUNT : natural := 4;
+constant WATERMARK : natural := 2; -- words the writer still fills after the flag drops
+constant SWITCH_CYCLES : natural := 10;
+constant USB_CYCLES : natural := 32;
+constant BUFFERS : natural := 16;
+constant MAX_GAP : natural := 4;
+----------------------------------------------------------------------------------
+-- Types
+----------------------------------------------------------------------------------
+type thread_naturals is array (0 to 1) of natural;
+type thread_bits is array (0 to 1) of std_logic;
+type committed_queue is array (0 to BUFFERS) of natural;
+type committed_queues is array (0 to 1) of committed_queue;
+----------------------------------------------------------------------------------
+-- Signals
+----------------------------------------------------------------------------------
+signal clock100 : std_logic := '0';
+signal reset : std_logic := '0';
+signal done : boolean := false;
+
+-- Module ports
+signal flaga_get : std_logic := '0';
+signal flagb_get : std_logic := '0';
+signal flagc_get : std_logic := '0';
+signal flagd_get : std_logic := '0';
+signal slwr_stream_in : std_logic;
+signal stream_in_address : std_logic;
+signal stream_in_idle_state : std_logic;
+signal data_stream_in : std_logic_vector(15 downto 0);
+
+-- Pins
+signal flaga : std_logic := '0';
+signal flagb : std_logic := '0';
+signal flagc : std_logic := '0';
+signal flagd : std_logic := '0';
+signal slwr : std_logic := '1';
+signal address : std_logic := '0';
+
+-- FX3 model
+signal buffers_sent : natural := 0;
+signal overflows : natural := 0;
+signal splits : natural := 0;
+signal misordered : natural := 0;
+signal max_gap_seen : natural := 0;
+----------------------------------------------------------------------------------
+-- Main code begin
+----------------------------------------------------------------------------------
+begin
+----------------------------------------------------------------------------------
+-- Device under test
+----------------------------------------------------------------------------------
+inst_stream_write : entity work.slave_fifo_stream_write_to_fx3
+generic map
+(
+	PING_PONG => PING_PONG
+)
+port map
+(
+	clock100 => clock100,
+	flaga_get => flaga_get,
+	flagb_get => flagb_get,
+	flagc_get => flagc_get,
+	flagd_get => flagd_get,
+	reset => reset,
+	stream_in_mode_active => '1',
+	stream_in_hold => '0',
+	slwr_stream_in => slwr_stream_in,
+	stream_in_address => stream_in_address,
+	stream_in_idle_state => stream_in_idle_state,
+	data_stream_in => data_stream_in
+);
+----------------------------------------------------------------------------------
+-- Clock and Reset
+----------------------------------------------------------------------------------
+clock100 <= not clock100 after CLOCK_PERIOD / 2 when not done else '0';
+reset <= '1' after 10 * CLOCK_PERIOD;
+----------------------------------------------------------------------------------
+-- Main module: flag input registers and pin output registers
+----------------------------------------------------------------------------------
+process(clock100) begin
+	if (rising_edge(clock100)) then
+		flaga_get <= flaga;
+		flagb_get <= flagb;
+		flagc_get <= flagc;
+		flagd_get <= flagd;
+		slwr <= slwr_stream_in;
+		address <= stream_in_address;
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- FX3 P2U channel: producer sockets of threads 0 and 1 and the USB consumer
+----------------------------------------------------------------------------------
+process(clock100)
+	variable sockets : natural := PING_PONG + 1;
+	variable free : thread_naturals := (others => 0);
+	variable words : thread_naturals := (others => 0);
+	variable switching : thread_naturals := (others => 0);
+	variable first_word : thread_naturals := (others => 0);
+	variable committed : committed_queues;
+	variable head : thread_naturals := (others => 0);
+	variable tail : thread_naturals := (others => 0);
+	variable ready : thread_bits;
+	variable high : thread_bits;
+	variable thread : natural;
+	variable last_thread : integer := -1;
+	variable written : natural := 0;
+	variable next_word : natural := 0;
+	variable idle : natural := 0;
+	variable usb_thread : natural := 0;
+	variable usb_left : natural := 0;
+	variable started : boolean := false;
+begin
+	if (rising_edge(clock100)) then
+		if (not started) then
+			for t in 0 to 1 loop
+				if (t < sockets) then
+					free(t) := BUF_COUNT / sockets;
+				end if;
+			end loop;
+			started := true;
+		end if;
+
+		-- Bus: one word per clock into the active buffer of the addressed thread
+		if (slwr = '0') then
+			thread := conv_integer(address);
+			if (thread >= sockets) or (free(thread) = 0) or (switching(thread) /= 0) then
+				report "Write to thread " & integer'image(thread) & " without a buffer" severity error;
+				overflows <= overflows + 1;
+			else
+				if (last_thread >= 0) and (last_thread /= thread) and (words(last_thread) /= 0) then
+					report "Burst on thread " & integer'image(last_thread) & " ended after "
+						& integer'image(words(last_thread)) & " words of a buffer" severity error;
+					splits <= splits + 1;
+				end if;
+				if (words(thread) = 0) then
+					first_word(thread) := written;
+				end if;
+				words(thread) := words(thread) + 1;
+				if (words(thread) = BUF_WORDS) then
+					committed(thread)(tail(thread) mod (BUFFERS + 1)) := first_word(thread);
+					tail(thread) := tail(thread) + 1;
+					words(thread) := 0;
+					free(thread) := free(thread) - 1;
+					switching(thread) := SWITCH_CYCLES;
+				end if;
+			end if;
+			if (written > 0) and (idle > max_gap_seen) then
+				max_gap_seen <= idle;
+			end if;
+			written := written + 1;
+			last_thread := thread;
+			idle := 0;
+		else
+			idle := idle + 1;
+		end if;
+
+		for t in 0 to 1 loop
+			if (switching(t) /= 0) then
+				switching(t) := switching(t) - 1;
+			end if;
+		end loop;
+
+		-- USB: the consumer takes the threads in turn
+		if (usb_left /= 0) then
+			usb_left := usb_left - 1;
+			if (usb_left = 0) then
+				free(usb_thread) := free(usb_thread) + 1;
+				usb_thread := (usb_thread + 1) mod sockets;
+				buffers_sent <= buffers_sent + 1;
+			end if;
+		elsif (head(usb_thread) /= tail(usb_thread)) then
+			if (committed(usb_thread)(head(usb_thread) mod (BUFFERS + 1)) /= next_word) then
+				report "Buffer out of order on thread " & integer'image(usb_thread) severity error;
+				misordered <= misordered + 1;
+			end if;
+			next_word := committed(usb_thread)(head(usb_thread) mod (BUFFERS + 1)) + BUF_WORDS;
+			head(usb_thread) := head(usb_thread) + 1;
+			usb_left := USB_CYCLES;
+		end if;
+
+		-- Flags after this clock
+		for t in 0 to 1 loop
+			if (free(t) /= 0) and (switching(t) = 0) then
+				ready(t) := '1';
+			else
+				ready(t) := '0';
+			end if;
+			if (ready(t) = '1') and ((BUF_WORDS - words(t)) > WATERMARK) then
+				high(t) := '1';
+			else
+				high(t) := '0';
+			end if;
+		end loop;
+		flaga <= ready(0);
+		flagb <= high(0);
+		if (PING_PONG = 1) then
+			flagc <= ready(1);
+			flagd <= high(1);
+		else
+			flagc <= '0';
+			flagd <= '0';
+		end if;
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- Result
+----------------------------------------------------------------------------------
+process begin
+	wait until (buffers_sent = BUFFERS) for 100 us;
+	assert (buffers_sent = BUFFERS)
+		report integer'image(buffers_sent) & " buffers sent" severity error;
+	assert (overflows = 0) and (splits = 0) and (misordered = 0)
+		report "Channel errors" severity error;
+	if (PING_PONG = 1) then
+		assert (max_gap_seen <= MAX_GAP)
+			report "Bus idle for " & integer'image(max_gap_seen) & " clocks between buffers" severity error;
+	else
+		assert (max_gap_seen > SWITCH_CYCLES)
+			report "Single thread did not wait for the buffer switch" severity error;
+	end if;
+	report "Stream write PING_PONG=" & integer'image(PING_PONG) & " passed, longest gap "
+		& integer'image(max_gap_seen) & " clocks";
+	done <= true;
+	wait;
+end process;
+----------------------------------------------------------------------------------
+-- End Architecture
+----------------------------------------------------------------------------------
+end tb_stream_write_arch;
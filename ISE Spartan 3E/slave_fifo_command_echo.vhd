@@ -0,0 +1,291 @@
+----------------------------------------------------------------------------------
+-- Synchronous Slave FIFO Interface - Command Echo Module
+-- Second endpoint pair: reads command words from thread 2 (EP 2 OUT) and
+-- writes them back to thread 1 (EP 2 IN), then commits a short packet.
+-- Only DMA ready flags are available for threads 1 and 2, so every word is
+-- followed by a gap that covers the flag latency of the FX3.
+----------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+----------------------------------------------------------------------------------
+-- Entity
+----------------------------------------------------------------------------------
+entity slave_fifo_command_echo is
+generic
+(
+	DATA_BITS : natural := 16
+);
+port
+(
+	clock100 : in std_logic;
+	reset : in std_logic;
+	command_mode_active : in std_logic;
+	command_grant : in std_logic; -- bus granted by the main module
+	flag_cmd_in_ready : in std_logic; -- thread 1 DMA ready (FLAGA)
+	flag_cmd_out_ready : in std_logic; -- thread 2 DMA ready (FLAGC)
+	data_command_in : in std_logic_vector(DATA_BITS-1 downto 0);
+	data_command_out : out std_logic_vector(DATA_BITS-1 downto 0);
+	command_request : out std_logic; -- bus requested
+	slwr_command : out std_logic;
+	sloe_command : out std_logic;
+	slrd_command : out std_logic;
+	pktend_command : out std_logic;
+	command_address : out std_logic_vector(1 downto 0)
+); end slave_fifo_command_echo;
+----------------------------------------------------------------------------------
+-- Architecture
+----------------------------------------------------------------------------------
+architecture command_echo_arch of slave_fifo_command_echo is
+----------------------------------------------------------------------------------
+-- Constants
+----------------------------------------------------------------------------------
+constant DATA_BIT : natural := 16;
+constant CNT_BIT : natural := 2;
+constant CMD_IN_THREAD : std_logic_vector(1 downto 0):="01";
+constant CMD_OUT_THREAD : std_logic_vector(1 downto 0):="10";
+----------------------------------------------------------------------------------
+-- Signals
+----------------------------------------------------------------------------------
+signal buffer_write_enable : std_logic;
+signal buffer_read_enable : std_logic;
+signal buffer_full : std_logic;
+signal buffer_empty : std_logic;
+
+signal gap_cnt : std_logic_vector(CNT_BIT-1 downto 0):="00";
+signal read_pipe : std_logic_vector(3 downto 0):="0000";
+
+signal slrd_command_get : std_logic;
+signal slwr_command_get : std_logic;
+signal sloe_command_get : std_logic;
+----------------------------------------------------------------------------------
+-- Command Echo Finished State Machine
+----------------------------------------------------------------------------------
+type command_echo_states is
+(
+	command_idle,
+	command_wait_grant,
+	command_read_address,
+	command_read,
+	command_read_oe_delay,
+	command_read_gap,
+	command_wait_in_ready,
+	command_write,
+	command_write_gap,
+	command_pktend,
+	command_release
+);
+signal current_state, next_state : command_echo_states;
+----------------------------------------------------------------------------------
+-- Components
+----------------------------------------------------------------------------------
+COMPONENT slave_fifo_buffer PORT
+(
+    clk : IN STD_LOGIC;
+    rst : IN STD_LOGIC;
+    din : IN STD_LOGIC_VECTOR(DATA_BIT-1 DOWNTO 0);
+    wr_en : IN STD_LOGIC;
+    rd_en : IN STD_LOGIC;
+    dout : OUT STD_LOGIC_VECTOR(DATA_BIT-1 DOWNTO 0);
+    full : OUT STD_LOGIC;
+    empty : OUT STD_LOGIC
+); END COMPONENT;
+----------------------------------------------------------------------------------
+-- Main code begin
+----------------------------------------------------------------------------------
+begin
+----------------------------------------------------------------------------------
+-- Port map
+----------------------------------------------------------------------------------
+inst_command_buffer : slave_fifo_buffer PORT MAP
+(
+	clk => clock100,
+    rst => not reset,
+    din => data_command_in,
+    wr_en => buffer_write_enable,
+    rd_en => buffer_read_enable,
+    dout => data_command_out,
+    full => buffer_full,
+    empty => buffer_empty
+);
+----------------------------------------------------------------------------------
+-- Signals
+----------------------------------------------------------------------------------
+slwr_command <= slwr_command_get;
+slrd_command <= slrd_command_get;
+sloe_command <= sloe_command_get;
+----------------------------------------------------------------------------------
+-- Bus Request
+----------------------------------------------------------------------------------
+process(current_state) begin
+	if (current_state = command_idle) then
+		command_request <= '0';
+	else
+		command_request <= '1';
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- Command Address: thread 2 while reading, thread 1 while writing
+----------------------------------------------------------------------------------
+process(current_state) begin
+	if (current_state = command_wait_in_ready) or (current_state = command_write)
+	or (current_state = command_write_gap) or (current_state = command_pktend) then
+		command_address <= CMD_IN_THREAD;
+	else
+		command_address <= CMD_OUT_THREAD;
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- SLRD Command
+----------------------------------------------------------------------------------
+process(current_state) begin
+	if (current_state = command_read) then
+		slrd_command_get <= '0';
+	else
+		slrd_command_get <= '1';
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- SLOE Command: the FX3 drives the word two cycles after it sees SLRD, and the
+-- word is only captured at read_pipe(3), so OE is held through the gap
+----------------------------------------------------------------------------------
+process(current_state) begin
+	if (current_state = command_read) or (current_state = command_read_oe_delay)
+	or (current_state = command_read_gap) then
+		sloe_command_get <= '0';
+	else
+		sloe_command_get <= '1';
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- SLWR Command
+----------------------------------------------------------------------------------
+process(current_state) begin
+	if (current_state = command_write) then
+		slwr_command_get <= '0';
+	else
+		slwr_command_get <= '1';
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- PKTEND Command: commit the short packet once the buffer is drained
+----------------------------------------------------------------------------------
+process(current_state) begin
+	if (current_state = command_pktend) then
+		pktend_command <= '0';
+	else
+		pktend_command <= '1';
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- Buffer Read Enable
+----------------------------------------------------------------------------------
+process(current_state) begin
+	if (current_state = command_write) then
+		buffer_read_enable <= '1';
+	else
+		buffer_read_enable <= '0';
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- Buffer Write Enable: the word appears on data_command_in a fixed number of
+-- cycles after SLRD (output register, FX3 read latency, input register)
+----------------------------------------------------------------------------------
+process(clock100, reset) begin
+	if (reset = '0') then
+		read_pipe <= (others => '0');
+	elsif rising_edge(clock100) then
+		read_pipe <= read_pipe(2 downto 0) & (not slrd_command_get);
+	end if;
+end process;
+buffer_write_enable <= read_pipe(3) and command_mode_active;
+----------------------------------------------------------------------------------
+-- Gap Counter: flag latency after every single word access
+----------------------------------------------------------------------------------
+process(clock100, reset) begin
+	if (reset = '0') then
+		gap_cnt <= (others => '0');
+	elsif (rising_edge(clock100)) then
+		if (current_state = command_read) or (current_state = command_write) then
+			gap_cnt <= "11";
+		elsif (gap_cnt > 0) then
+			gap_cnt <= gap_cnt - '1';
+		else
+			gap_cnt <= gap_cnt;
+		end if;
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- Command Echo State Change
+----------------------------------------------------------------------------------
+process (clock100, reset) begin
+	if (reset = '0') then
+		current_state <= command_idle;
+	elsif (rising_edge(clock100)) then
+		current_state <= next_state;
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- Command Echo Main FSM
+----------------------------------------------------------------------------------
+process(current_state, command_mode_active, command_grant, flag_cmd_in_ready, flag_cmd_out_ready,
+	buffer_full, buffer_empty, gap_cnt) begin
+	next_state <= current_state;
+	case current_state is
+		when command_idle =>
+			if (flag_cmd_out_ready = '1') and (command_mode_active = '1') then
+				next_state <= command_wait_grant;
+			else
+				next_state <= command_idle;
+			end if;
+		when command_wait_grant =>
+			if (command_grant = '1') then
+				next_state <= command_read_address;
+			else
+				next_state <= command_wait_grant;
+			end if;
+		when command_read_address =>
+			next_state <= command_read;
+		when command_read =>
+			next_state <= command_read_oe_delay;
+		when command_read_oe_delay =>
+			next_state <= command_read_gap;
+		when command_read_gap =>
+			if (gap_cnt = "00") then
+				if (flag_cmd_out_ready = '1') and (buffer_full = '0') then
+					next_state <= command_read;
+				else
+					next_state <= command_wait_in_ready;
+				end if;
+			else
+				next_state <= command_read_gap;
+			end if;
+		when command_wait_in_ready =>
+			if (buffer_empty = '1') then
+				next_state <= command_pktend;
+			elsif (flag_cmd_in_ready = '1') then
+				next_state <= command_write;
+			else
+				next_state <= command_wait_in_ready;
+			end if;
+		when command_write =>
+			next_state <= command_write_gap;
+		when command_write_gap =>
+			if (gap_cnt = "00") then
+				next_state <= command_wait_in_ready;
+			else
+				next_state <= command_write_gap;
+			end if;
+		when command_pktend =>
+			next_state <= command_release;
+		when command_release =>
+			next_state <= command_idle;
+		when others =>
+			next_state <= command_idle;
+	end case;
+end process;
+----------------------------------------------------------------------------------
+-- End Architecture
+----------------------------------------------------------------------------------
+end command_echo_arch;
@@ -4,6 +4,8 @@
 -- 1) FPGA continuously writes full packets (Stream from FPGA to FX3)
 -- 2) FPGA continuously reads full packets (Stream from FX3 to FPGA)
 -- 3) Loopback transfer mode
+-- SECOND_EP_PAIR = 1: a command echo on threads 1/2 (EP 2) shares the bus with
+-- the stream write mode
 -- Author: Mariusz Wisniewski (www.kocurkolandia.pl)
 -- December 2014 - January 2015
 ----------------------------------------------------------------------------------
@@ -23,7 +25,9 @@ generic
 	ADDRESS_BITS : natural := 2;
 	DATA_BITS : natural := 16;
 	PMODE_BITS : natural := 2;
-	LCD_BITS : natural := 4
+	LCD_BITS : natural := 4;
+	STREAM_IN_PING_PONG : natural := 0; -- must match CY_FX_SLFIFO_P2U_PINGPONG in the firmware
+	SECOND_EP_PAIR : natural := 0 -- must match CY_FX_SLFIFO_SECOND_EP_PAIR in the firmware
 );
 port
 (
@@ -127,6 +131,23 @@ signal data_out_get2 : std_logic_vector(DATA_BIT-1 downto 0);
 signal stream_in_mode_active: std_logic;
 signal data_stream_in : std_logic_vector(DATA_BIT-1 downto 0):="1111000011110000";
 signal slwr_stream_in: std_logic;
+signal stream_in_address : std_logic;
+signal stream_in_idle_state : std_logic;
+signal stream_in_hold : std_logic;
+signal stream_in_flaga : std_logic;
+----------------------------------------------------------------------------------
+-- Command (Second Endpoint Pair) Signals
+----------------------------------------------------------------------------------
+signal command_mode_active : std_logic;
+signal command_request : std_logic;
+signal command_grant : std_logic:='0';
+signal data_command_in : std_logic_vector(DATA_BIT-1 downto 0);
+signal data_command_out : std_logic_vector(DATA_BIT-1 downto 0);
+signal slwr_command : std_logic;
+signal sloe_command : std_logic;
+signal slrd_command : std_logic;
+signal pktend_command : std_logic;
+signal command_address : std_logic_vector(1 downto 0);
 ----------------------------------------------------------------------------------
 -- Stream Out Signals
 ----------------------------------------------------------------------------------
@@ -173,16 +194,43 @@ component lcd_controller port
 	lcd_request_served : out std_logic;
 	lcd_display_ready : buffer std_logic
 ); end component;
-component slave_fifo_stream_write_to_fx3 port 
+component slave_fifo_stream_write_to_fx3
+generic
+(
+	PING_PONG : natural
+);
+port 
 (
 	clock100 : in std_logic;
 	flaga_get : in std_logic;
 	flagb_get : in std_logic;
+	flagc_get : in std_logic;
+	flagd_get : in std_logic;
 	reset : in std_logic;
 	stream_in_mode_active : in std_logic;
+	stream_in_hold : in std_logic;
 	slwr_stream_in : out std_logic;
+	stream_in_address : out std_logic;
+	stream_in_idle_state : out std_logic;
 	data_stream_in : out std_logic_vector(DATA_BIT-1 downto 0)
 ); end component;
+component slave_fifo_command_echo port
+(
+	clock100 : in std_logic;
+	reset : in std_logic;
+	command_mode_active : in std_logic;
+	command_grant : in std_logic;
+	flag_cmd_in_ready : in std_logic;
+	flag_cmd_out_ready : in std_logic;
+	data_command_in : in std_logic_vector(DATA_BIT-1 downto 0);
+	data_command_out : out std_logic_vector(DATA_BIT-1 downto 0);
+	command_request : out std_logic;
+	slwr_command : out std_logic;
+	sloe_command : out std_logic;
+	slrd_command : out std_logic;
+	pktend_command : out std_logic;
+	command_address : out std_logic_vector(1 downto 0)
+); end component;
 component slave_fifo_stream_read_from_fx3 port 
 (
 	clock100 					: in std_logic;
@@ -260,16 +308,42 @@ inst_lcd_controller : lcd_controller port map
 	lcd_request_served => lcd_request_served,
 	lcd_display_ready => lcd_display_ready
 );
-inst_stream_write_to_fx3 : slave_fifo_stream_write_to_fx3 port map
+inst_stream_write_to_fx3 : slave_fifo_stream_write_to_fx3 generic map
+(
+	PING_PONG => STREAM_IN_PING_PONG
+)
+port map
 (
 	clock100 => clock100,
-	flaga_get => flaga_get,
+	flaga_get => stream_in_flaga,
 	flagb_get => flagb_get,
+	flagc_get => flagc_get,
+	flagd_get => flagd_get,
 	reset => not reset_fpga,
 	stream_in_mode_active => stream_in_mode_active,
+	stream_in_hold => stream_in_hold,
 	slwr_stream_in => slwr_stream_in,
+	stream_in_address => stream_in_address,
+	stream_in_idle_state => stream_in_idle_state,
 	data_stream_in => data_stream_in
 );
+inst_command_echo : slave_fifo_command_echo port map
+(
+	clock100 => clock100,
+	reset => not reset_fpga,
+	command_mode_active => command_mode_active,
+	command_grant => command_grant,
+	flag_cmd_in_ready => flaga_get,
+	flag_cmd_out_ready => flagc_get,
+	data_command_in => data_command_in,
+	data_command_out => data_command_out,
+	command_request => command_request,
+	slwr_command => slwr_command,
+	sloe_command => sloe_command,
+	slrd_command => slrd_command,
+	pktend_command => pktend_command,
+	command_address => command_address
+);
 int_stream_read_from_fx3 : slave_fifo_stream_read_from_fx3 port map
 (
 	clock100 => clock100,
@@ -308,7 +382,27 @@ reset_fpga <= reset_from_slide;
 lcd_srataflash_disable <= '1';
 reset_to_fx3 <= '1';
 pmode <= "11";
-pktend_get <= '1';
+pktend_get <= pktend_command when (command_grant = '1') else '1';
+----------------------------------------------------------------------------------
+-- Second Endpoint Pair: FLAGA is thread 1 ready, so the stream writer is paced
+-- by the thread 0 watermark (FLAGB) alone
+----------------------------------------------------------------------------------
+stream_in_flaga <= flagb_get when (SECOND_EP_PAIR = 1) else flaga_get;
+stream_in_hold <= command_request or command_grant;
+----------------------------------------------------------------------------------
+-- Bus Arbitration: the command echo gets the bus between two stream buffers
+----------------------------------------------------------------------------------
+process (reset_fpga, clock100) begin
+	if reset_fpga = '1' then
+		command_grant <= '0';
+	elsif (rising_edge(clock100)) then
+		if (command_request = '0') then
+			command_grant <= '0';
+		elsif (stream_in_idle_state = '1') then
+			command_grant <= '1';
+		end if;
+	end if;
+end process;
 ----------------------------------------------------------------------------------
 -- FPGA Send All Signals
 ----------------------------------------------------------------------------------
@@ -332,8 +426,10 @@ end process;
 ----------------------------------------------------------------------------------
 -- Get Output Data
 ----------------------------------------------------------------------------------
-process (current_state) begin
-	if current_state = stream_write_to_fx3_state then
+process (current_state, command_grant, data_command_out, data_stream_in, data_loopback_out) begin
+	if (current_state = stream_write_to_fx3_state) and (command_grant = '1') then
+		data_out_get <= data_command_out;
+	elsif current_state = stream_write_to_fx3_state then
 		data_out_get <= data_stream_in;
     elsif current_state = loopback_state then
 		data_out_get <= data_loopback_out;
@@ -374,7 +470,8 @@ end process;
 ----------------------------------------------------------------------------------
 -- Get Input Data 2
 ----------------------------------------------------------------------------------
-process (current_state, slrd_stream_out) begin
+process (current_state, slrd_stream_out, data_in_get) begin
+	data_command_in <= data_in_get;
 	if current_state = loopback_state then
 		data_loopback_in <= data_in_get;
 		data_stream_out <= (others => '0');
@@ -421,12 +518,23 @@ process (current_state) begin
 	else 
 		stream_in_mode_active <= '0';
 	end if;
+	if (SECOND_EP_PAIR = 1) and (current_state = stream_write_to_fx3_state) then
+		command_mode_active <= '1';
+	else 
+		command_mode_active <= '0';
+	end if;
 end process;
 ----------------------------------------------------------------------------------
 -- Get Output/Enable, Read/Write and Write Signals
 ----------------------------------------------------------------------------------
-process (current_state) begin
-	if current_state = stream_write_to_fx3_state then
+process (current_state, command_grant, slwr_stream_in, sloe_stream_out, slrd_stream_out,
+	sloe_loopback, slrd_loopback, slwr_loopback, sloe_command, slrd_command, slwr_command) begin
+	if (current_state = stream_write_to_fx3_state) and (command_grant = '1') then
+		slcs_get <= '0';
+		sloe_get <= sloe_command;
+		slrd_get <= slrd_command;
+		slwr_get <= slwr_command;
+	elsif current_state = stream_write_to_fx3_state then
 		slcs_get <= '0';
 		sloe_get <= '1';
 		slrd_get <= '1';
@@ -451,9 +559,13 @@ end process;
 ----------------------------------------------------------------------------------
 -- Get Address Signals
 ----------------------------------------------------------------------------------
-process (current_state, loopback_address) begin
+process (current_state, loopback_address, stream_in_address, command_grant, command_address) begin
 	if (current_state = stream_read_from_fx3_state) or (loopback_address = '1') then
 		address_get <= "11";
+	elsif (current_state = stream_write_to_fx3_state) and (command_grant = '1') then
+		address_get <= command_address;
+	elsif (current_state = stream_write_to_fx3_state) then
+		address_get <= '0' & stream_in_address;
 	else	
 		address_get <= "00";
 	end if;
@@ -1,6 +1,7 @@
 ----------------------------------------------------------------------------------
 -- Synchronous Slave FIFO Interface - Stream Write to FX3 Module
 -- FPGA Writing to Slave FIFO
+-- PING_PONG = 1: alternate between thread 0 (FLAGA/FLAGB) and thread 1 (FLAGC/FLAGD)
 ----------------------------------------------------------------------------------
 library ieee;
 use ieee.std_logic_1164.all;
@@ -12,16 +13,22 @@ use ieee.std_logic_unsigned.all;
 entity slave_fifo_stream_write_to_fx3 is 
 generic
 (
-	DATA_BITS : natural := 16
+	DATA_BITS : natural := 16;
+	PING_PONG : natural := 0
 );
 port 
 (
 	clock100 : in std_logic;
 	flaga_get : in std_logic;
 	flagb_get : in std_logic;
+	flagc_get : in std_logic;
+	flagd_get : in std_logic;
 	reset : in std_logic;
 	stream_in_mode_active : in std_logic;
+	stream_in_hold : in std_logic; -- do not start a new buffer (bus lent to another master)
 	slwr_stream_in : out std_logic;
+	stream_in_address : out std_logic;
+	stream_in_idle_state : out std_logic; -- between buffers, bus can be lent
 	data_stream_in : out std_logic_vector(DATA_BITS-1 downto 0)
 ); end slave_fifo_stream_write_to_fx3;
 ----------------------------------------------------------------------------------
@@ -37,6 +44,9 @@ constant DATA_BIT : natural := 16;
 ----------------------------------------------------------------------------------
 signal slwr_stream_in_get : std_logic;
 signal data_stream_in_get : std_logic_vector(DATA_BIT-1 downto 0);
+signal thread_select : std_logic:='0';
+signal flag_ready : std_logic;
+signal flag_watermark : std_logic;
 ----------------------------------------------------------------------------------
 -- Stream Write to FX3 Finished State Machine
 ----------------------------------------------------------------------------------
@@ -57,6 +67,34 @@ begin
 ----------------------------------------------------------------------------------
 slwr_stream_in <= slwr_stream_in_get;
 data_stream_in <= data_stream_in_get; 
+stream_in_address <= thread_select;
+stream_in_idle_state <= '1' when (current_state = stream_in_idle) else '0';
+----------------------------------------------------------------------------------
+-- Flags of the Currently Addressed Thread
+----------------------------------------------------------------------------------
+process(thread_select, flaga_get, flagb_get, flagc_get, flagd_get) begin
+	if (thread_select = '1') then
+		flag_ready <= flagc_get;
+		flag_watermark <= flagd_get;
+	else 
+		flag_ready <= flaga_get;
+		flag_watermark <= flagb_get;
+	end if;
+end process;
+----------------------------------------------------------------------------------
+-- Ping-Pong Thread Select: switch thread after every full buffer
+----------------------------------------------------------------------------------
+process(clock100, reset) begin
+	if (reset = '0') then
+		thread_select <= '0';
+	elsif rising_edge(clock100) then
+		if (stream_in_mode_active = '0') then
+			thread_select <= '0';
+		elsif (PING_PONG = 1) and (current_state = stream_in_wr_delay) then
+			thread_select <= not thread_select;
+		end if;
+	end if;
+end process;
 ----------------------------------------------------------------------------------
 -- Stream Write to FX3 State Change
 ----------------------------------------------------------------------------------
@@ -70,8 +108,8 @@ end process;
 ----------------------------------------------------------------------------------
 -- SLWR Signal Enable/Disable
 ----------------------------------------------------------------------------------
-process(current_state, flagb_get) begin
-	if (current_state = stream_in_write) and (flagb_get = '1') then
+process(current_state, flag_watermark) begin
+	if (current_state = stream_in_write) and (flag_watermark = '1') then
 		slwr_stream_in_get <= '0';
 	else 
 		slwr_stream_in_get <= '1';
@@ -94,23 +132,23 @@ end process;
 ----------------------------------------------------------------------------------
 -- Stream Write to FX3 Main FSM
 ----------------------------------------------------------------------------------
-process(current_state, flaga_get, flagb_get, stream_in_mode_active) begin
+process(current_state, flag_ready, flag_watermark, stream_in_mode_active, stream_in_hold) begin
 	next_state <= current_state;
 	case current_state is
 		when stream_in_idle =>
-			if (flaga_get = '1') and (stream_in_mode_active = '1') then
+			if (flag_ready = '1') and (stream_in_mode_active = '1') and (stream_in_hold = '0') then
 				next_state <= stream_in_wait_flagb;
 			else 
 				next_state <= stream_in_idle;
 			end if;
 		when stream_in_wait_flagb =>
-			if (flagb_get = '1') then
+			if (flag_watermark = '1') then
 				next_state <= stream_in_write;
 			else 
 				next_state <= stream_in_wait_flagb;
 			end if;
 		when stream_in_write =>
-			if (flagb_get = '0') then
+			if (flag_watermark = '0') then
 				next_state <= stream_in_wr_delay;
 			else 
 				next_state <= stream_in_write;
@@ -0,0 +1,622 @@
+/*
+ ## fx3capture: record the P2U stream to disk with io_uring and O_DIRECT
+ ## ===========================
+ ##
+ ##  A pool of page aligned buffers is registered with io_uring once. Each
+ ##  buffer is filled by a bulk IN transfer and written to the file from the
+ ##  same memory with IORING_OP_WRITE_FIXED on an O_DIRECT descriptor, so the
+ ##  data is never copied in user space and bypasses the page cache. A buffer
+ ##  goes back to the USB queue once its write has completed.
+ ##
+ ##  Usage: fx3capture -o file [-q depth] [-b buffers] [-n slots] [-t seconds]
+ ##                    [-i interval_ms] [-S MB/s]
+ ##
+ ##  -q  bulk IN transfers kept queued (default 16)
+ ##  -b  transfer size in DMA buffers (default 4)
+ ##  -n  buffers in the pool (default 64); the slots not queued on USB absorb
+ ##      disk latency
+ ##  -S  synthetic producer instead of the device, at the given rate (0 for as
+ ##      fast as the disk takes it); measures the disk path alone. The queue
+ ##      column then shows the fewest free buffers in the interval
+ ##
+ ##  Backpressure: when the disk lags, the pool runs out of free buffers and
+ ##  fewer transfers than -q stay queued on USB. Every interval in which that
+ ##  happened is flagged; once the USB queue is empty the FX3 and the FPGA FIFO
+ ##  fill up and data is lost at the source. The synthetic producer counts the
+ ##  data it had to drop instead.
+ ##
+ ##  A transfer that is not a multiple of 4 KB (a wrap-up buffer) leaves the
+ ##  file offset unaligned; the rest of the capture is then written through the
+ ##  page cache, still from the registered buffers.
+ ## ===========================
+ */
+
+#define _GNU_SOURCE                 /* O_DIRECT */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include "fx3host.h"
+
+#define CAPTURE_ALIGN           (4096)      /* O_DIRECT alignment of lengths and offsets */
+#define CAPTURE_TIMEOUT         (1000)      /* Bulk transfer timeout in ms */
+#define CAPTURE_PATTERN         (0x574D)    /* "MW", used by the synthetic producer */
+
+/* Minimal io_uring, driven through the raw system calls. */
+typedef struct uring
+{
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned pending;               /* Entries queued but not yet submitted */
+} uring;
+
+enum
+{
+    SLOT_FREE = 0,
+    SLOT_USB,
+    SLOT_DISK
+};
+
+typedef struct slot
+{
+    unsigned char *buf;
+    struct libusb_transfer *xfer;
+    unsigned len;                   /* Bytes in the buffer, while SLOT_DISK */
+    int state;
+} slot;
+
+typedef struct capture
+{
+    uring ring;
+    slot *slots;
+    int *free_list;
+    int free_count;
+    int nslots;
+    int length;                     /* Buffer size */
+    int depth;                      /* USB queue target */
+
+    int fd_direct;                  /* -1 once direct I/O is off */
+    int fd_buffered;
+    unsigned long long offset;      /* Next file offset */
+
+    int usb_inflight;
+    int disk_inflight;
+
+    /* Totals */
+    unsigned long long received;
+    unsigned long long written;
+    unsigned long long dropped;
+    unsigned long starved;          /* Times the pool ran dry */
+    int is_starved;
+    int error;
+
+    /* Per interval */
+    int min_usb;
+    int max_disk;
+    unsigned long last_starved;
+} capture;
+
+static volatile sig_atomic_t stop = 0;
+static capture cap;
+
+static void on_signal(int sig)
+{
+    (void) sig;
+    stop = 1;
+}
+
+static int uring_init(uring *r, unsigned entries)
+{
+    struct io_uring_params p;
+    unsigned char *sq, *cq;
+    size_t sq_size, cq_size;
+
+    memset(&p, 0, sizeof(p));
+    r->fd = (int) syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0)
+        return -errno;
+
+    sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if ((p.features & IORING_FEAT_SINGLE_MMAP) && (cq_size > sq_size))
+        sq_size = cq_size;
+
+    sq = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            r->fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED)
+        return -errno;
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        cq = sq;
+    else
+    {
+        cq = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                r->fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED)
+            return -errno;
+    }
+    r->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED)
+        return -errno;
+
+    r->sq_head = (unsigned *) (sq + p.sq_off.head);
+    r->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+    r->sq_mask = *(unsigned *) (sq + p.sq_off.ring_mask);
+    r->sq_entries = p.sq_entries;
+    r->sq_array = (unsigned *) (sq + p.sq_off.array);
+    r->cq_head = (unsigned *) (cq + p.cq_off.head);
+    r->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+    r->cq_mask = *(unsigned *) (cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+    r->pending = 0;
+    return 0;
+}
+
+/* Next free submission entry, or NULL if the ring is full. */
+static struct io_uring_sqe *uring_get_sqe(uring *r)
+{
+    unsigned tail = *r->sq_tail;
+    unsigned idx;
+
+    if (tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries)
+        return NULL;
+
+    idx = tail & r->sq_mask;
+    r->sq_array[idx] = idx;
+    memset(&r->sqes[idx], 0, sizeof(r->sqes[idx]));
+    __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    r->pending++;
+    return &r->sqes[idx];
+}
+
+/* Submit the queued entries and, with wait set, block until at least one
+ * completion is available. */
+static int uring_enter(uring *r, int wait)
+{
+    unsigned submit = r->pending;
+    int status;
+
+    if ((submit == 0) && !wait)
+        return 0;
+    status = (int) syscall(__NR_io_uring_enter, r->fd, submit, wait ? 1 : 0,
+            wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    if (status < 0)
+        return (errno == EINTR) ? 0 : -errno;
+    r->pending -= (unsigned) status;
+    return 0;
+}
+
+static void on_write_done(int index, int res);
+
+static void uring_reap(uring *r)
+{
+    unsigned head = *r->cq_head;
+    unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    struct io_uring_cqe *cqe;
+
+    while (head != tail)
+    {
+        cqe = &r->cqes[head & r->cq_mask];
+        on_write_done((int) cqe->user_data, cqe->res);
+        head++;
+    }
+    __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* Queue the write of a filled buffer at the current file offset. */
+static void slot_to_disk(int index, unsigned len)
+{
+    struct io_uring_sqe *sqe;
+    slot *s = &cap.slots[index];
+    int fd;
+
+    if ((cap.fd_direct >= 0) && (((len | cap.offset) & (CAPTURE_ALIGN - 1)) != 0))
+    {
+        fprintf(stderr, "%u byte transfer at offset %llu, continuing without O_DIRECT\n",
+                len, cap.offset);
+        close(cap.fd_direct);
+        cap.fd_direct = -1;
+    }
+    fd = (cap.fd_direct >= 0) ? cap.fd_direct : cap.fd_buffered;
+
+    /* The ring has an entry per slot, so this cannot fail. */
+    sqe = uring_get_sqe(&cap.ring);
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long) s->buf;
+    sqe->len = len;
+    sqe->off = cap.offset;
+    sqe->buf_index = (uint16_t) index;
+    sqe->user_data = (uint64_t) index;
+
+    s->state = SLOT_DISK;
+    s->len = len;
+    cap.offset += len;
+    cap.received += len;
+    cap.disk_inflight++;
+    if (cap.disk_inflight > cap.max_disk)
+        cap.max_disk = cap.disk_inflight;
+}
+
+static void slot_free(int index)
+{
+    cap.slots[index].state = SLOT_FREE;
+    cap.free_list[cap.free_count++] = index;
+}
+
+static void usb_refill(void);
+
+/* Count each stretch of time without a free buffer once. */
+static void pool_starved(void)
+{
+    if (!cap.is_starved)
+        cap.starved++;
+    cap.is_starved = 1;
+}
+
+static void on_write_done(int index, int res)
+{
+    slot *s = &cap.slots[index];
+
+    cap.disk_inflight--;
+    if (res != (int) s->len)
+    {
+        fprintf(stderr, "Write of %u bytes failed: %s\n", s->len,
+                (res < 0) ? strerror(-res) : "short write");
+        cap.error = 1;
+        stop = 1;
+    }
+    else
+        cap.written += res;
+
+    slot_free(index);
+}
+
+static void LIBUSB_CALL capture_callback(struct libusb_transfer *xfer)
+{
+    int index = (int) (intptr_t) xfer->user_data;
+
+    cap.usb_inflight--;
+    if ((xfer->status != LIBUSB_TRANSFER_COMPLETED) && (xfer->status != LIBUSB_TRANSFER_TIMED_OUT)
+            && (xfer->status != LIBUSB_TRANSFER_CANCELLED))
+    {
+        fprintf(stderr, "Bulk IN transfer failed with status %d\n", xfer->status);
+        cap.error = 1;
+        stop = 1;
+    }
+
+    if (xfer->actual_length > 0)
+        slot_to_disk(index, (unsigned) xfer->actual_length);
+    else
+        slot_free(index);
+
+    /* Pick up finished writes before looking for a free buffer. */
+    uring_reap(&cap.ring);
+    usb_refill();
+}
+
+/* Keep depth transfers queued on USB, as far as the pool allows. */
+static void usb_refill(void)
+{
+    int index;
+
+    while (!stop && (cap.usb_inflight < cap.depth))
+    {
+        if (cap.free_count == 0)
+        {
+            pool_starved();
+            break;
+        }
+
+        index = cap.free_list[--cap.free_count];
+        if (libusb_submit_transfer(cap.slots[index].xfer) != 0)
+        {
+            fprintf(stderr, "Submitting a bulk IN transfer failed\n");
+            slot_free(index);
+            cap.error = 1;
+            stop = 1;
+            break;
+        }
+        cap.slots[index].state = SLOT_USB;
+        cap.usb_inflight++;
+    }
+
+    if (cap.usb_inflight == cap.depth)
+        cap.is_starved = 0;
+    if (cap.usb_inflight < cap.min_usb)
+        cap.min_usb = cap.usb_inflight;
+}
+
+/* Synthetic producer: hands out a buffer every length / rate seconds, or as
+ * soon as one is free if rate is 0. A buffer that is due while the pool is
+ * empty is dropped, as the FPGA FIFO would overflow. */
+static void synthetic_step(double rate, double start)
+{
+    double due, now;
+    unsigned long long produced = cap.received + cap.dropped;
+
+    if (rate > 0)
+    {
+        due = start + produced / rate;
+        now = fx3_now();
+        if (now < due)
+        {
+            usleep((useconds_t) ((due - now) * 1e6));
+            uring_reap(&cap.ring);
+            return;
+        }
+    }
+
+    if (cap.free_count == 0)
+    {
+        pool_starved();
+        if (rate > 0)
+            cap.dropped += cap.length;
+        else
+            uring_enter(&cap.ring, 1);
+        uring_reap(&cap.ring);
+        return;
+    }
+
+    cap.is_starved = 0;
+    slot_to_disk(cap.free_list[--cap.free_count], (unsigned) cap.length);
+    if (cap.free_count < cap.min_usb)
+        cap.min_usb = cap.free_count;
+}
+
+static void report(double now, double start, double last, unsigned long long last_received,
+        unsigned long long last_written)
+{
+    double dt = now - last;
+
+    printf("%8.1f s  in %8.2f MB/s  disk %8.2f MB/s  queue min %3d  writes max %3d%s\n",
+            now - start, (cap.received - last_received) / dt / 1e6,
+            (cap.written - last_written) / dt / 1e6, cap.min_usb, cap.max_disk,
+            (cap.starved != cap.last_starved) ? "  BACKPRESSURE" : "");
+    fflush(stdout);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s -o file [-q depth] [-b buffers] [-n slots] [-t seconds]\n"
+            "       %*s [-i interval_ms] [-S MB/s]\n", prog, (int) strlen(prog), "");
+}
+
+int main(int argc, char **argv)
+{
+    libusb_context *ctx = NULL;
+    libusb_device_handle *dev = NULL;
+    unsigned char ep_in = FX3_EP_IN, ep_out;
+    struct iovec *iov;
+    struct timeval tv;
+    struct rusage ru;
+    const char *path = NULL;
+    unsigned char *pool;
+    uint16_t *word;
+    int buffers = 4, synthetic = 0;
+    double rate = 0;
+    unsigned seconds = 0, interval = 1000;
+    unsigned buf_bytes = FX3_DEFAULT_BUF_BYTES;
+    unsigned long long last_received = 0, last_written = 0;
+    double start, last, now, cpu;
+    int opt, i, j, status;
+
+    cap.depth = 16;
+    cap.nslots = 64;
+    while ((opt = getopt(argc, argv, "o:q:b:n:t:i:S:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'o':
+            path = optarg;
+            break;
+        case 'q':
+            cap.depth = atoi(optarg);
+            break;
+        case 'b':
+            buffers = atoi(optarg);
+            break;
+        case 'n':
+            cap.nslots = atoi(optarg);
+            break;
+        case 't':
+            seconds = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 'i':
+            interval = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 'S':
+            synthetic = 1;
+            rate = atof(optarg) * 1e6;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if ((path == NULL) || (cap.depth <= 0) || (buffers <= 0) || (cap.nslots < cap.depth)
+            || (interval == 0))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (!synthetic)
+    {
+        if (libusb_init(&ctx) != 0)
+            return 1;
+        dev = fx3_open(ctx);
+        if (dev == NULL)
+        {
+            libusb_exit(ctx);
+            return 1;
+        }
+        buf_bytes = fx3_dma_buf_bytes(dev);
+        fx3_find_endpoints(dev, &ep_in, &ep_out);
+    }
+    cap.length = buffers * buf_bytes;
+    if ((cap.length % CAPTURE_ALIGN) != 0)
+        fprintf(stderr, "Warning: %d byte transfers are not 4 KB aligned, O_DIRECT will be off\n",
+                cap.length);
+
+    /* Output file: O_DIRECT for the aligned writes, a buffered descriptor for
+     * the first unaligned one and everything after it. */
+    cap.fd_buffered = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (cap.fd_buffered < 0)
+    {
+        perror(path);
+        return 1;
+    }
+    cap.fd_direct = open(path, O_WRONLY | O_DIRECT);
+    if (cap.fd_direct < 0)
+        fprintf(stderr, "%s: no O_DIRECT (%s), writing through the page cache\n", path,
+                strerror(errno));
+
+    /* Buffer pool, one io_uring entry and one transfer per buffer. */
+    pool = mmap(NULL, (size_t) cap.nslots * cap.length, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    cap.slots = calloc(cap.nslots, sizeof(*cap.slots));
+    cap.free_list = calloc(cap.nslots, sizeof(*cap.free_list));
+    iov = calloc(cap.nslots, sizeof(*iov));
+    if ((pool == MAP_FAILED) || (cap.slots == NULL) || (cap.free_list == NULL) || (iov == NULL))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    status = uring_init(&cap.ring, (unsigned) cap.nslots);
+    if (status != 0)
+    {
+        fprintf(stderr, "io_uring setup failed: %s\n", strerror(-status));
+        return 1;
+    }
+
+    for (i = 0; i < cap.nslots; i++)
+    {
+        cap.slots[i].buf = pool + (size_t) i * cap.length;
+        iov[i].iov_base = cap.slots[i].buf;
+        iov[i].iov_len = cap.length;
+        if (synthetic)
+        {
+            word = (uint16_t *) cap.slots[i].buf;
+            for (j = 0; j < cap.length / 2; j++)
+                word[j] = CAPTURE_PATTERN;
+        }
+        else
+        {
+            cap.slots[i].xfer = libusb_alloc_transfer(0);
+            if (cap.slots[i].xfer == NULL)
+                return 1;
+            libusb_fill_bulk_transfer(cap.slots[i].xfer, dev, ep_in, cap.slots[i].buf,
+                    cap.length, capture_callback, (void *) (intptr_t) i, CAPTURE_TIMEOUT);
+        }
+        slot_free(i);
+    }
+
+    /* Pin the pool once instead of on every write. */
+    if (syscall(__NR_io_uring_register, cap.ring.fd, IORING_REGISTER_BUFFERS, iov,
+            cap.nslots) < 0)
+    {
+        perror("Registering the buffers");
+        return 1;
+    }
+
+    if (synthetic)
+        printf("%s: %d buffers of %d bytes, synthetic producer\n", path, cap.nslots, cap.length);
+    else
+        printf("%s: %d buffers of %d bytes, %d queued on USB\n", path, cap.nslots, cap.length,
+                cap.depth);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    cap.min_usb = cap.depth;
+    start = last = fx3_now();
+    if (!synthetic)
+        usb_refill();
+    while (!stop)
+    {
+        if (synthetic)
+            synthetic_step(rate, start);
+        else
+        {
+            tv.tv_sec = 0;
+            tv.tv_usec = 1000;
+            libusb_handle_events_timeout_completed(ctx, &tv, NULL);
+            uring_reap(&cap.ring);
+            usb_refill();
+        }
+        if (uring_enter(&cap.ring, 0) != 0)
+        {
+            perror("io_uring_enter");
+            break;
+        }
+
+        now = fx3_now();
+        if ((seconds != 0) && (now - start >= seconds))
+            stop = 1;
+        if ((now - last) * 1000 >= interval)
+        {
+            report(now, start, last, last_received, last_written);
+            last = now;
+            last_received = cap.received;
+            last_written = cap.written;
+            cap.min_usb = synthetic ? cap.free_count : cap.usb_inflight;
+            cap.max_disk = cap.disk_inflight;
+            cap.last_starved = cap.starved;
+        }
+    }
+
+    /* Let the queued transfers and writes finish. */
+    for (i = 0; (i < cap.nslots) && !synthetic; i++)
+        if (cap.slots[i].state == SLOT_USB)
+            libusb_cancel_transfer(cap.slots[i].xfer);
+    while (((cap.usb_inflight > 0) && !synthetic) || (cap.disk_inflight > 0))
+    {
+        if (!synthetic && (cap.usb_inflight > 0))
+            libusb_handle_events(ctx);
+        uring_enter(&cap.ring, cap.disk_inflight > 0);
+        uring_reap(&cap.ring);
+    }
+    now = fx3_now();
+
+    getrusage(RUSAGE_SELF, &ru);
+    cpu = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 + ru.ru_stime.tv_sec
+            + ru.ru_stime.tv_usec * 1e-6;
+    printf("%llu bytes in %.2f s, %.2f MB/s, CPU %.1f%%, pool ran dry %lu times",
+            cap.written, now - start, cap.written / (now - start) / 1e6,
+            100.0 * cpu / (now - start), cap.starved);
+    if (synthetic && (rate > 0))
+        printf(", %llu bytes dropped", cap.dropped);
+    printf("\n");
+
+    for (i = 0; (i < cap.nslots) && !synthetic; i++)
+        libusb_free_transfer(cap.slots[i].xfer);
+    if (cap.fd_direct >= 0)
+        close(cap.fd_direct);
+    close(cap.fd_buffered);
+    if (dev != NULL)
+    {
+        fx3_close(dev);
+        libusb_exit(ctx);
+    }
+    return cap.error;
+}
@@ -0,0 +1,239 @@
+/*
+ ## fx3check: check captured data against the stream patterns
+ ## ===========================
+ ##
+ ##  Checks files written by fx3capture (or any raw dump of the IN stream) with
+ ##  the checker of fx3verify.c and prints the error count and the first
+ ##  mismatch. With -B it benchmarks the checker instead: a generated buffer
+ ##  with a few injected bit errors is checked with every implementation the
+ ##  CPU has, which must all agree and count every corrupted word once.
+ ##  With -f the files hold a framed IN stream (fx3config -f on): the frame
+ ##  headers are parsed and reported as by fx3stream -f and only the payload
+ ##  is checked against the pattern.
+ ##
+ ##  Usage: fx3check [-p pattern] [-c constant] [-x impl] [-f] file...
+ ##         fx3check -B [-p pattern] [-m MB] [-e errors]
+ ##
+ ##  pattern: constant (default, with the "MW" word), counter, prbs31
+ ##  impl:    scalar, sse2, avx2 (default: the best the CPU has)
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fx3host.h"
+#include "fx3verify.h"
+#include "fx3frame.h"
+
+#define CHECK_CHUNK             (4 * 1024 * 1024)
+#define CHECK_BENCH_PASSES      (8)
+
+static void print_result(const char *name, const fx3_verifier *v)
+{
+    printf("%s: %llu bytes, %llu errors", name, v->bytes, v->errors);
+    if (v->errors != 0)
+        printf(", first at byte %llu: expected 0x%08x, got 0x%08x", v->first_offset,
+                v->first_expected, v->first_actual);
+    printf("\n");
+}
+
+static int check_file(const char *path, int pattern, uint32_t constant, int framed,
+        uint8_t *buf)
+{
+    fx3_verifier v;
+    fx3_frame_parser frames;
+    size_t len;
+    int status;
+    FILE *f;
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    fx3_verify_init(&v, pattern, constant);
+    fx3_frame_init(&frames, &v);
+    while ((len = fread(buf, 1, CHECK_CHUNK, f)) > 0)
+    {
+        if (framed)
+            fx3_frame_parse(&frames, buf, len);
+        else
+            fx3_verify(&v, buf, len);
+    }
+
+    fclose(f);
+    print_result(path, &v);
+    status = (v.errors != 0) ? 1 : 0;
+    if (framed)
+    {
+        fx3_frame_print(&frames, path);
+        if (fx3_frame_errors(&frames))
+            status = 1;
+    }
+    return status;
+}
+
+/* Words of buf that differ from the pattern. Errors injected into the same word
+ * count once, and two errors in the same bit cancel out. */
+static unsigned long long corrupted_words(int pattern, uint32_t constant,
+        const uint8_t *buf, size_t len)
+{
+    uint32_t chunk[1024];
+    uint32_t state = 1;
+    unsigned long long words = 0;
+    size_t pos, n, i;
+
+    for (pos = 0; pos < len; pos += n)
+    {
+        n = (len - pos < sizeof(chunk)) ? len - pos : sizeof(chunk);
+        fx3_pattern_fill(pattern, constant, &state, chunk, n);
+        for (i = 0; i + 4 <= n; i += 4)
+            if (memcmp(buf + pos + i, (const uint8_t *) chunk + i, 4) != 0)
+                words++;
+    }
+    return words;
+}
+
+static int benchmark(int pattern, uint32_t constant, size_t megabytes, unsigned inject)
+{
+    fx3_verifier v, ref;
+    unsigned long long expected;
+    uint32_t state = 1;
+    uint8_t *buf;
+    size_t len = megabytes * 1024 * 1024;
+    size_t pos;
+    double start, elapsed;
+    int impl, used, i, status = 0;
+
+    buf = malloc(len);
+    if (buf == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    fx3_pattern_fill(pattern, constant, &state, buf, len);
+    srand(1);
+    for (i = 0; i < (int) inject; i++)
+    {
+        pos = (size_t) rand() % len;
+        buf[pos] ^= (uint8_t) (1 << (rand() % 8));
+    }
+
+    expected = corrupted_words(pattern, constant, buf, len);
+    printf("%s pattern, %zu MB, %u injected bit errors in %llu words\n",
+            fx3_pattern_name(pattern), megabytes, inject, expected);
+    memset(&ref, 0, sizeof(ref));
+    for (impl = FX3_VERIFY_SCALAR; impl <= FX3_VERIFY_AVX2; impl++)
+    {
+        used = fx3_verify_select(impl);
+        if (used != impl)
+            continue;
+
+        start = fx3_now();
+        for (i = 0; i < CHECK_BENCH_PASSES; i++)
+        {
+            fx3_verify_init(&v, pattern, constant);
+            fx3_verify(&v, buf, len);
+        }
+        elapsed = fx3_now() - start;
+
+        printf("%-7s %8.2f GB/s  ", fx3_verify_impl_name(impl),
+                (double) len * CHECK_BENCH_PASSES / elapsed / 1e9);
+        print_result("result", &v);
+
+        if (v.errors != expected)
+        {
+            fprintf(stderr, "%s counted %llu errors, expected %llu\n", fx3_verify_impl_name(impl),
+                    v.errors, expected);
+            status = 1;
+        }
+        if (impl == FX3_VERIFY_SCALAR)
+            ref = v;
+        else if ((v.errors != ref.errors) || (v.first_offset != ref.first_offset))
+        {
+            fprintf(stderr, "%s disagrees with the scalar checker\n", fx3_verify_impl_name(impl));
+            status = 1;
+        }
+    }
+
+    free(buf);
+    return status;
+}
+
+int main(int argc, char **argv)
+{
+    int pattern = FX3_PATTERN_CONSTANT;
+    uint32_t constant = FX3_PATTERN_MW;
+    int impl = FX3_VERIFY_AUTO;
+    int bench = 0, framed = 0;
+    size_t megabytes = 256;
+    unsigned inject = 16;
+    uint8_t *buf;
+    int opt, status = 0, result;
+
+    while ((opt = getopt(argc, argv, "p:c:x:fBm:e:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            pattern = fx3_pattern_parse(optarg);
+            if (pattern < 0)
+            {
+                fprintf(stderr, "Unknown pattern %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'c':
+            constant = (uint32_t) strtoul(optarg, NULL, 0);
+            break;
+        case 'x':
+            if (strcmp(optarg, "scalar") == 0)
+                impl = FX3_VERIFY_SCALAR;
+            else if (strcmp(optarg, "sse2") == 0)
+                impl = FX3_VERIFY_SSE2;
+            else if (strcmp(optarg, "avx2") == 0)
+                impl = FX3_VERIFY_AVX2;
+            break;
+        case 'f':
+            framed = 1;
+            break;
+        case 'B':
+            bench = 1;
+            break;
+        case 'm':
+            megabytes = (size_t) strtoul(optarg, NULL, 0);
+            break;
+        case 'e':
+            inject = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-p pattern] [-c constant] [-x impl] [-f] file...\n"
+                    "       %s -B [-p pattern] [-m MB] [-e errors]\n", argv[0], argv[0]);
+            return 2;
+        }
+    }
+
+    if (bench)
+        return benchmark(pattern, constant, megabytes, inject);
+
+    impl = fx3_verify_select(impl);
+    printf("Checking the %s pattern with the %s checker\n", fx3_pattern_name(pattern),
+            fx3_verify_impl_name(impl));
+
+    buf = malloc(CHECK_CHUNK);
+    if (buf == NULL)
+        return 1;
+    for (; optind < argc; optind++)
+    {
+        result = check_file(argv[optind], pattern, constant, framed, buf);
+        if (result != 0)
+            status = 1;
+    }
+    free(buf);
+    return status;
+}
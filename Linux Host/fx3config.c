@@ -0,0 +1,331 @@
+/*
+ ## fx3config: set and show the DMA configuration of the FX3
+ ## ===========================
+ ##
+ ##  Applies the requested settings in the order the firmware needs them: the
+ ##  profile and channel type first (CY_FX_RQT_SET_PROFILE resets the geometry
+ ##  and the burst length to those of the profile), then the geometry, then
+ ##  the burst length, then the data mode, the P2U framing, the CRC check, the
+ ##  wrap-up timeout and the worker cost. Prints the configuration the device
+ ##  reports afterwards.
+ ##  -b then runs the CPU benchmark of the firmware (CY_FX_RQT_CPU_BENCHMARK) on
+ ##  a buffer of the new size and prints its result.
+ ##  Exits with 1 if the device refuses a setting, e.g. a geometry that does
+ ##  not fit into the DMA buffer heap.
+ ##
+ ##  Usage: fx3config [-p stream|loopback] [-m auto|manual]
+ ##                   [-g size,p2u,u2p] [-B burst] [-d data_mode [-P pattern]]
+ ##                   [-f on|off] [-k on|off] [-w wrapup_us] [-c passes] [-b]
+ ##
+ ##  size is the buffer size in packets; burst 0 goes back to the burst length
+ ##  of the profile. A profile or channel type given alone keeps the other.
+ ##  data_mode is gpif, source, sink or source+sink: the USB link test modes
+ ##  (CY_FX_RQT_SET_DATA_MODE) connect EP 1 IN to a CPU pattern source and
+ ##  EP 1 OUT to a CPU sink instead of the GPIF, so the link is measured without
+ ##  the FPGA. The mode stays set across profile changes; -d gpif goes back.
+ ##  pattern is constant (the "MW" word, default) or counter (a 32 bit counter,
+ ##  checked by fx3stream -v counter).
+ ##  -f on puts a frame header in front of every P2U buffer (parsed by
+ ##  fx3stream -f and fx3check -f); it needs MANUAL channels.
+ ##  -k on turns on the loopback CRC32 check of the U2P against the P2U data,
+ ##  counted in the telemetry block (fx3telemetry); it needs MANUAL channels
+ ##  and a loopback FPGA image.
+ ##  wrapup_us 0 turns the wrap-up timer off; it needs MANUAL channels.
+ ##  passes is the number of CyFxSlFifoProcessBuffer passes the worker thread
+ ##  makes over every buffer of MANUAL channels; the firmware only accepts it
+ ##  when built with CY_FX_SLFIFO_DEFERRED_PROCESSING.
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fx3host.h"
+
+#define FX3_BENCH_TIMEOUT       (10)        /* Longest wait for a benchmark result in s */
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-p stream|loopback] [-m auto|manual] [-g size,p2u,u2p] [-B burst]\n"
+            "       %*s [-d gpif|source|sink|source+sink [-P constant|counter]]\n"
+            "       %*s [-f on|off] [-k on|off] [-w wrapup_us] [-c passes] [-b]\n",
+            prog, (int) strlen(prog), "", (int) strlen(prog), "");
+}
+
+/* FX3_DATA_xxx flags of a data mode name, -1 for an unknown one. */
+static int data_mode(const char *arg)
+{
+    if (strcmp(arg, "gpif") == 0)
+        return FX3_DATA_GPIF;
+    if (strcmp(arg, "source") == 0)
+        return FX3_DATA_SOURCE;
+    if (strcmp(arg, "sink") == 0)
+        return FX3_DATA_SINK;
+    if (strcmp(arg, "source+sink") == 0)
+        return FX3_DATA_SOURCE | FX3_DATA_SINK;
+    return -1;
+}
+
+static const char *data_mode_name(int mode)
+{
+    switch (mode)
+    {
+    case FX3_DATA_SOURCE:                   return "source";
+    case FX3_DATA_SINK:                     return "sink";
+    case FX3_DATA_SOURCE | FX3_DATA_SINK:   return "source+sink";
+    default:                                return "gpif";
+    }
+}
+
+/* 1 for "on", 0 for "off", -1 for anything else. */
+static int on_off(const char *arg)
+{
+    if (strcmp(arg, "on") == 0)
+        return 1;
+    if (strcmp(arg, "off") == 0)
+        return 0;
+    return -1;
+}
+
+static int apply(libusb_device_handle *dev, const char *what, uint8_t request,
+        uint16_t value, uint16_t index)
+{
+    int status;
+
+    status = fx3_vendor_out(dev, request, value, index);
+    if (status != 0)
+        fprintf(stderr, "Setting the %s failed: %s\n", what, libusb_error_name(status));
+    return status;
+}
+
+/* Start a CPU benchmark run and wait for its result. */
+static int benchmark(libusb_device_handle *dev)
+{
+    fx3_bench_result res;
+    double start;
+    int len;
+
+    len = fx3_vendor_in(dev, FX3_RQT_CPU_BENCHMARK, 1, 0, &res, sizeof(res));
+    start = fx3_now();
+    do
+    {
+        if (len < 0)
+        {
+            fprintf(stderr, "CPU_BENCHMARK failed: %s\n", libusb_error_name(len));
+            return 1;
+        }
+        if (fx3_now() - start > FX3_BENCH_TIMEOUT)
+        {
+            fprintf(stderr, "CPU benchmark did not finish within %d s\n", FX3_BENCH_TIMEOUT);
+            return 1;
+        }
+        usleep(100000);
+        len = fx3_vendor_in(dev, FX3_RQT_CPU_BENCHMARK, 0, 0, &res, sizeof(res));
+    } while ((len < (int) sizeof(res)) || (res.status == FX3_BENCH_PENDING));
+
+    if (res.status != 0)
+    {
+        fprintf(stderr, "CPU benchmark failed on the device, error %u\n", res.status);
+        return 1;
+    }
+    printf("CPU benchmark: %u bytes x %u in %u us, %u ns per buffer, %.1f MB/s, D-cache %s\n",
+            res.bufferBytes, res.iterations, res.elapsedUs, res.nsPerBuffer,
+            (res.nsPerBuffer != 0) ? res.bufferBytes * 1e3 / res.nsPerBuffer : 0.0,
+            res.dcacheEnabled ? "on" : "off");
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    libusb_context *ctx = NULL;
+    libusb_device_handle *dev;
+    fx3_dma_config cfg;
+    int profile = -1, mode = -1, burst = -1, framed = -1, crc = -1, cost = -1, bench = 0;
+    int data = -1, pattern = -1;
+    long long wrapup = -1;
+    unsigned size = 0, p2u = 0, u2p = 0;
+    int opt, status = 0;
+
+    while ((opt = getopt(argc, argv, "p:m:g:B:d:P:f:k:w:c:b")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            if (strcmp(optarg, "stream") == 0)
+                profile = FX3_PROFILE_STREAM;
+            else if (strcmp(optarg, "loopback") == 0)
+                profile = FX3_PROFILE_LOOPBACK;
+            else
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'm':
+            if (strcmp(optarg, "auto") == 0)
+                mode = FX3_DMA_AUTO;
+            else if (strcmp(optarg, "manual") == 0)
+                mode = FX3_DMA_MANUAL;
+            else
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'g':
+            if ((sscanf(optarg, "%u,%u,%u", &size, &p2u, &u2p) != 3) || (size == 0)
+                    || (size > 0xFFFF) || (p2u == 0) || (p2u > 0xFF) || (u2p == 0) || (u2p > 0xFF))
+            {
+                fprintf(stderr, "Bad geometry %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'B':
+            burst = atoi(optarg);
+            if ((burst < 0) || (burst > 0xFFFF))
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'd':
+            data = data_mode(optarg);
+            if (data < 0)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'P':
+            if (strcmp(optarg, "constant") == 0)
+                pattern = FX3_SOURCE_CONSTANT;
+            else if (strcmp(optarg, "counter") == 0)
+                pattern = FX3_SOURCE_COUNTER;
+            else
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'f':
+            framed = on_off(optarg);
+            if (framed < 0)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'k':
+            crc = on_off(optarg);
+            if (crc < 0)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'w':
+            wrapup = strtoll(optarg, NULL, 0);
+            if ((wrapup < 0) || (wrapup > 0xFFFFFFFFLL))
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'c':
+            cost = atoi(optarg);
+            if ((cost < 0) || (cost > 0xFFFF))
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'b':
+            bench = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if ((pattern >= 0) && (data < 0))
+    {
+        fprintf(stderr, "-P needs -d\n");
+        return 2;
+    }
+    if (pattern < 0)
+        pattern = FX3_SOURCE_CONSTANT;
+
+    if (libusb_init(&ctx) != 0)
+        return 1;
+    dev = fx3_open(ctx);
+    if (dev == NULL)
+    {
+        libusb_exit(ctx);
+        return 1;
+    }
+
+    if ((profile >= 0) || (mode >= 0))
+    {
+        if (fx3_get_dma_config(dev, &cfg) != 0)
+        {
+            fprintf(stderr, "Reading the DMA configuration failed\n");
+            status = 1;
+        }
+        else
+        {
+            if (profile < 0)
+                profile = cfg.profile;
+            if (mode < 0)
+                mode = cfg.manual;
+            if (apply(dev, "profile", FX3_RQT_SET_PROFILE, (uint16_t) profile, (uint16_t) mode) != 0)
+                status = 1;
+        }
+    }
+    if ((status == 0) && (size != 0)
+            && (apply(dev, "DMA geometry", FX3_RQT_SET_DMA_CONFIG, (uint16_t) size,
+                    (uint16_t) (p2u | (u2p << 8))) != 0))
+        status = 1;
+    if ((status == 0) && (burst >= 0)
+            && (apply(dev, "burst length", FX3_RQT_SET_BURST_LENGTH, (uint16_t) burst, 0) != 0))
+        status = 1;
+    if ((status == 0) && (data >= 0)
+            && (apply(dev, "data mode", FX3_RQT_SET_DATA_MODE, (uint16_t) data,
+                    (uint16_t) pattern) != 0))
+        status = 1;
+    if ((status == 0) && (framed >= 0)
+            && (apply(dev, "P2U framing", FX3_RQT_SET_P2U_FRAMING, (uint16_t) framed, 0) != 0))
+        status = 1;
+    if ((status == 0) && (crc >= 0)
+            && (apply(dev, "CRC check", FX3_RQT_SET_CRC_CHECK, (uint16_t) crc, 0) != 0))
+        status = 1;
+    if ((status == 0) && (wrapup >= 0)
+            && (apply(dev, "wrap-up timeout", FX3_RQT_SET_WRAPUP_TIMEOUT,
+                    (uint16_t) (wrapup & 0xFFFF), (uint16_t) (wrapup >> 16)) != 0))
+        status = 1;
+    if ((status == 0) && (cost >= 0)
+            && (apply(dev, "worker cost", FX3_RQT_SET_WORKER_COST, (uint16_t) cost, 0) != 0))
+        status = 1;
+
+    if (fx3_get_dma_config(dev, &cfg) == 0)
+        printf("Profile %s, %s channels, %u byte buffers, %u P2U, %u U2P, burst %u, heap %u KB\n",
+                (cfg.profile == FX3_PROFILE_LOOPBACK) ? "LOOPBACK" : "STREAM",
+                cfg.manual ? "MANUAL" : "AUTO", cfg.buf_size * cfg.pkt_size, cfg.count_p2u,
+                cfg.count_u2p, cfg.burst, cfg.heap_kb);
+    if ((status == 0) && (data >= 0))
+        printf("Data mode %s%s\n", data_mode_name(data), !(data & FX3_DATA_SOURCE) ? ""
+                : (pattern == FX3_SOURCE_COUNTER) ? ", counter pattern" : ", constant pattern");
+    if ((status == 0) && (framed >= 0))
+        printf("P2U framing %s\n", framed ? "on" : "off");
+    if ((status == 0) && (crc >= 0))
+        printf("Loopback CRC check %s\n", crc ? "on" : "off");
+    if ((status == 0) && (cost >= 0))
+        printf("Worker cost %d passes per buffer\n", cost);
+    if ((status == 0) && bench)
+        status = benchmark(dev);
+
+    fx3_close(dev);
+    libusb_exit(ctx);
+    return status;
+}
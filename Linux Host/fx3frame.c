@@ -0,0 +1,139 @@
+/*
+ ## Frame header parser for the framed P2U stream
+ ## ===========================
+ ##
+ ##  The header is collected in p->header until it is complete, so a header
+ ##  split over two transfers is parsed like any other. Sequence numbers are
+ ##  compared modulo 2^32: a difference below 2^31 is a jump forward, above it
+ ##  a frame from the past. A reordered frame moves neither the expected
+ ##  sequence number nor the time the next delta is taken from.
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "fx3frame.h"
+
+static uint32_t get16(const uint8_t *b)
+{
+    return (uint32_t) b[0] | ((uint32_t) b[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *b)
+{
+    return get16(b) | (get16(b + 2) << 16);
+}
+
+void fx3_frame_init(fx3_frame_parser *p, fx3_verifier *verify)
+{
+    memset(p, 0, sizeof(*p));
+    p->verify = verify;
+    p->synced = 1;
+    p->delta_min = 0xFFFFFFFF;
+}
+
+/* Account a complete header and start its payload. */
+static void frame_header(fx3_frame_parser *p)
+{
+    uint32_t seq = get32(p->header + 4);
+    uint32_t flags = get16(p->header + 10);
+    uint32_t time = get32(p->header + 12);
+    uint32_t diff, delta;
+
+    p->frames++;
+    p->payload_left = get16(p->header + 8);
+    if (flags & FX3_FRAME_FLAG_DISCONTINUITY)
+        p->discontinuities++;
+
+    if (p->have_seq)
+    {
+        diff = seq - p->next_seq;
+        if (diff >= 0x80000000)
+        {
+            p->reordered++;
+            return;
+        }
+        if (diff != 0)
+        {
+            p->gaps++;
+            p->lost += diff;
+        }
+
+        delta = time - p->last_time;
+        if (delta < p->delta_min)
+            p->delta_min = delta;
+        if (delta > p->delta_max)
+            p->delta_max = delta;
+        p->delta_sum += delta;
+        p->delta_count++;
+    }
+
+    p->have_seq = 1;
+    p->next_seq = seq + 1;
+    p->last_time = time;
+}
+
+void fx3_frame_parse(fx3_frame_parser *p, const void *buf, size_t len)
+{
+    const uint8_t *b = (const uint8_t *) buf;
+    size_t n;
+
+    while (len > 0)
+    {
+        if (p->payload_left > 0)
+        {
+            n = (len < p->payload_left) ? len : p->payload_left;
+            if (p->verify != NULL)
+                fx3_verify(p->verify, b, n);
+            p->payload += n;
+            p->payload_left -= (unsigned) n;
+            b += n;
+            len -= n;
+            continue;
+        }
+
+        n = FX3_FRAME_HEADER_SIZE - p->have;
+        if (n > len)
+            n = len;
+        memcpy(p->header + p->have, b, n);
+        p->have += (unsigned) n;
+        b += n;
+        len -= n;
+        if (p->have < FX3_FRAME_HEADER_SIZE)
+            break;
+
+        if (get32(p->header) != FX3_FRAME_MAGIC)
+        {
+            if (p->synced)
+                p->bad_headers++;
+            p->synced = 0;
+            memmove(p->header, p->header + 1, FX3_FRAME_HEADER_SIZE - 1);
+            p->have = FX3_FRAME_HEADER_SIZE - 1;
+            p->skipped++;
+            continue;
+        }
+
+        p->synced = 1;
+        p->have = 0;
+        frame_header(p);
+    }
+}
+
+void fx3_frame_print(const fx3_frame_parser *p, const char *name)
+{
+    printf("%s: %llu frames, %llu payload bytes, %llu lost in %llu gaps, %llu reordered, "
+            "%llu discontinuities, %llu bad headers", name, p->frames, p->payload, p->lost,
+            p->gaps, p->reordered, p->discontinuities, p->bad_headers);
+    if (p->skipped != 0)
+        printf(" (%llu bytes skipped)", p->skipped);
+    if (p->delta_count != 0)
+        printf(", frame interval %u/%llu/%u us", p->delta_min,
+                p->delta_sum / p->delta_count, p->delta_max);
+    printf("\n");
+}
+
+int fx3_frame_errors(const fx3_frame_parser *p)
+{
+    return ((p->lost != 0) || (p->reordered != 0) || (p->discontinuities != 0)
+            || (p->bad_headers != 0)) ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+/*
+ ## Frame header parser for the framed P2U stream
+ ## ===========================
+ ##
+ ##  With CY_FX_RQT_SET_P2U_FRAMING on, every P2U DMA buffer starts with a
+ ##  CyFxSlFifoFrameHeader_t (16 bytes: magic, sequence, byte count, flags, device
+ ##  time in us) followed by byteCount bytes of payload. The parser takes the IN
+ ##  stream in pieces of any size, splits it into frames and hands the payload
+ ##  alone to a pattern checker, so the checker sees the stream the FPGA wrote.
+ ##
+ ##  Per frame it checks the sequence number against the one expected:
+ ##  higher     the frames in between were lost (gaps, lost)
+ ##  lower      the frame arrived out of order (reordered)
+ ##  It counts the frames flagged with a discontinuity (the device lost data,
+ ##  e.g. in a GPIF recovery) and keeps min/avg/max of the device timestamp
+ ##  delta between consecutive frames. A header without the magic loses the
+ ##  frame sync; the parser counts it once and searches the stream byte by byte
+ ##  for the next magic, skipping the bytes in between.
+ ##
+ ##  Payloads are checked as whole 32 bit words; the partial last word of a
+ ##  payload that is not a multiple of 4 bytes (a wrap-up of an odd 16 bit word
+ ##  count) is not checked.
+ ## ===========================
+ */
+
+#ifndef _INCLUDED_FX3FRAME_H_
+#define _INCLUDED_FX3FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fx3verify.h"
+
+#define FX3_FRAME_HEADER_SIZE           (16)            /* CY_FX_SLFIFO_FRAME_HEADER_SIZE */
+#define FX3_FRAME_MAGIC                 (0x4D465846)    /* CY_FX_SLFIFO_FRAME_MAGIC */
+#define FX3_FRAME_FLAG_DISCONTINUITY    (0x0001)        /* CY_FX_SLFIFO_FRAME_FLAG_DISCONTINUITY */
+
+typedef struct fx3_frame_parser
+{
+    fx3_verifier *verify;           /* Payload check, NULL if off */
+    uint8_t header[FX3_FRAME_HEADER_SIZE];
+    unsigned have;                  /* Header bytes collected so far */
+    unsigned payload_left;          /* Payload bytes of the current frame still to come */
+    int synced;                     /* 0 while searching for a magic after a bad header */
+    int have_seq;                   /* next_seq and last_time are valid */
+    uint32_t next_seq;
+    uint32_t last_time;
+
+    unsigned long long frames;      /* Headers parsed */
+    unsigned long long payload;     /* Payload bytes */
+    unsigned long long gaps;        /* Sequence jumps forward */
+    unsigned long long lost;        /* Frames missing in those jumps */
+    unsigned long long reordered;   /* Frames with a sequence number below the expected one */
+    unsigned long long discontinuities;
+    unsigned long long bad_headers; /* Losses of the frame sync */
+    unsigned long long skipped;     /* Bytes skipped while searching for a magic */
+    uint32_t delta_min;             /* Device time between frames in us */
+    uint32_t delta_max;
+    unsigned long long delta_sum;
+    unsigned long long delta_count;
+} fx3_frame_parser;
+
+extern void fx3_frame_init(fx3_frame_parser *p, fx3_verifier *verify);
+
+/* Parse the next len bytes of the stream. */
+extern void fx3_frame_parse(fx3_frame_parser *p, const void *buf, size_t len);
+
+/* Print the frame counters on one line, prefixed with name. */
+extern void fx3_frame_print(const fx3_frame_parser *p, const char *name);
+
+/* 1 if the parser has seen lost, reordered, discontinuous or bad frames. */
+extern int fx3_frame_errors(const fx3_frame_parser *p);
+
+#endif /* _INCLUDED_FX3FRAME_H_ */
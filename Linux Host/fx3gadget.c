@@ -0,0 +1,451 @@
+/*
+ ## fx3gadget: FunctionFS stand-in for the FX3 slave FIFO device
+ ## ===========================
+ ##
+ ##  A userspace USB function that presents the interface of cyfxslfifousbdscr.c
+ ##  (one vendor class interface with a bulk IN and a bulk OUT endpoint, 1024
+ ##  byte packets and bursts of 16 at SuperSpeed) and answers the DMA geometry
+ ##  vendor requests of cyfxslfifosync.h. Together with dummy_hcd it lets the
+ ##  host tools run on a machine without an FX3; see fx3gadget.sh.
+ ##
+ ##  Usage: fx3gadget [-l] [-p packet_size] ffs_mount_dir
+ ##
+ ##  In the STREAM profile the IN endpoint sends the FPGA "MW" word and the OUT
+ ##  endpoint discards its data, like the stream FPGA image. In the LOOPBACK
+ ##  profile (-l, or CY_FX_RQT_SET_PROFILE) OUT data is sent back on IN, like
+ ##  the loopback image. Each read or write moves one DMA buffer.
+ ##
+ ##  The model does not reproduce the FX3 timing; rates measured against it
+ ##  show the host side cost only.
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <endian.h>
+#include <linux/usb/ch9.h>
+#include <linux/usb/functionfs.h>
+#include "fx3host.h"
+
+#define MODEL_BURST             (16)        /* CY_FX_SLFIFO_SS_BURST_LENGTH */
+#define MODEL_PATTERN           (0x574D)    /* "MW" */
+
+/* Descriptors handed to FunctionFS: the interface of cyfxslfifousbdscr.c at
+ * full, high and SuperSpeed. */
+typedef struct model_fs_descs
+{
+    struct usb_interface_descriptor intf;
+    struct usb_endpoint_descriptor_no_audio ep_in;
+    struct usb_endpoint_descriptor_no_audio ep_out;
+} __attribute__ ((packed)) model_fs_descs;
+
+typedef struct model_ss_descs
+{
+    struct usb_interface_descriptor intf;
+    struct usb_endpoint_descriptor_no_audio ep_in;
+    struct usb_ss_ep_comp_descriptor ep_in_comp;
+    struct usb_endpoint_descriptor_no_audio ep_out;
+    struct usb_ss_ep_comp_descriptor ep_out_comp;
+} __attribute__ ((packed)) model_ss_descs;
+
+typedef struct model_descriptors
+{
+    struct usb_functionfs_descs_head_v2 header;
+    __le32 fs_count;
+    __le32 hs_count;
+    __le32 ss_count;
+    model_fs_descs fs;
+    model_fs_descs hs;
+    model_ss_descs ss;
+} __attribute__ ((packed)) model_descriptors;
+
+#define MODEL_STRING            "FX3"
+
+typedef struct model_strings
+{
+    struct usb_functionfs_strings_head header;
+    struct
+    {
+        __le16 code;
+        char str1[sizeof(MODEL_STRING)];
+    } __attribute__ ((packed)) lang0;
+} __attribute__ ((packed)) model_strings;
+
+/* Device state changed by the vendor requests */
+typedef struct model_state
+{
+    pthread_mutex_t lock;
+    fx3_dma_config cfg;
+    int ep_in;
+    int ep_out;
+} model_state;
+
+static model_state model;
+
+static void fill_intf(struct usb_interface_descriptor *intf)
+{
+    intf->bLength = USB_DT_INTERFACE_SIZE;
+    intf->bDescriptorType = USB_DT_INTERFACE;
+    intf->bNumEndpoints = 2;
+    intf->bInterfaceClass = USB_CLASS_VENDOR_SPEC;
+    intf->iInterface = 1;
+}
+
+static void fill_ep(struct usb_endpoint_descriptor_no_audio *ep, uint8_t address, uint16_t size)
+{
+    ep->bLength = USB_DT_ENDPOINT_SIZE;
+    ep->bDescriptorType = USB_DT_ENDPOINT;
+    ep->bEndpointAddress = address;
+    ep->bmAttributes = USB_ENDPOINT_XFER_BULK;
+    ep->wMaxPacketSize = htole16(size);
+}
+
+static void fill_comp(struct usb_ss_ep_comp_descriptor *comp)
+{
+    comp->bLength = USB_DT_SS_EP_COMP_SIZE;
+    comp->bDescriptorType = USB_DT_SS_ENDPOINT_COMP;
+    comp->bMaxBurst = MODEL_BURST - 1;
+}
+
+/* Write the descriptors and strings to ep0. FUNCTIONFS_ALL_CTRL_RECIP makes the
+ * device recipient vendor requests of the FX3 firmware reach this function. */
+static int write_descriptors(int ep0)
+{
+    model_descriptors d;
+    model_strings s;
+
+    memset(&d, 0, sizeof(d));
+    d.header.magic = htole32(FUNCTIONFS_DESCRIPTORS_MAGIC_V2);
+    d.header.length = htole32(sizeof(d));
+    d.header.flags = htole32(FUNCTIONFS_HAS_FS_DESC | FUNCTIONFS_HAS_HS_DESC
+            | FUNCTIONFS_HAS_SS_DESC | FUNCTIONFS_ALL_CTRL_RECIP);
+    d.fs_count = htole32(3);
+    d.hs_count = htole32(3);
+    d.ss_count = htole32(5);
+
+    fill_intf(&d.fs.intf);
+    fill_ep(&d.fs.ep_in, USB_DIR_IN | 1, 64);
+    fill_ep(&d.fs.ep_out, USB_DIR_OUT | 1, 64);
+    fill_intf(&d.hs.intf);
+    fill_ep(&d.hs.ep_in, USB_DIR_IN | 1, 512);
+    fill_ep(&d.hs.ep_out, USB_DIR_OUT | 1, 512);
+    fill_intf(&d.ss.intf);
+    fill_ep(&d.ss.ep_in, USB_DIR_IN | 1, 1024);
+    fill_comp(&d.ss.ep_in_comp);
+    fill_ep(&d.ss.ep_out, USB_DIR_OUT | 1, 1024);
+    fill_comp(&d.ss.ep_out_comp);
+
+    memset(&s, 0, sizeof(s));
+    s.header.magic = htole32(FUNCTIONFS_STRINGS_MAGIC);
+    s.header.length = htole32(sizeof(s));
+    s.header.str_count = htole32(1);
+    s.header.lang_count = htole32(1);
+    s.lang0.code = htole16(0x0409);
+    memcpy(s.lang0.str1, MODEL_STRING, sizeof(MODEL_STRING));
+
+    if ((write(ep0, &d, sizeof(d)) < 0) || (write(ep0, &s, sizeof(s)) < 0))
+    {
+        perror("Writing the descriptors");
+        return -1;
+    }
+    return 0;
+}
+
+static unsigned model_buf_bytes(int *loopback)
+{
+    unsigned bytes;
+
+    pthread_mutex_lock(&model.lock);
+    bytes = (unsigned) model.cfg.buf_size * model.cfg.pkt_size;
+    *loopback = (model.cfg.profile == FX3_PROFILE_LOOPBACK);
+    pthread_mutex_unlock(&model.lock);
+    return bytes;
+}
+
+/* Geometry check of CyFxSlFifoApplnSetDmaConfig. */
+static int model_set_geometry(uint16_t buf_size, uint16_t count_p2u, uint16_t count_u2p)
+{
+    if (fx3_dma_geometry_fits(buf_size, model.cfg.pkt_size, count_p2u, count_u2p) != 0)
+        return -1;
+
+    pthread_mutex_lock(&model.lock);
+    model.cfg.buf_size = buf_size;
+    model.cfg.count_p2u = (uint8_t) count_p2u;
+    model.cfg.count_u2p = (uint8_t) count_u2p;
+    pthread_mutex_unlock(&model.lock);
+    return 0;
+}
+
+/* The STREAM profile gets as many P2U buffers as fit, like the firmware. */
+static int model_set_profile(uint16_t profile, uint16_t manual)
+{
+    unsigned count_p2u;
+
+    if (profile > FX3_PROFILE_LOOPBACK)
+        return -1;
+    if (profile == FX3_PROFILE_LOOPBACK)
+    {
+        if (model_set_geometry(FX3_LOOPBACK_BUF_SIZE, FX3_LOOPBACK_COUNT_P2U,
+                FX3_LOOPBACK_COUNT_U2P) != 0)
+            return -1;
+    }
+    else
+    {
+        count_p2u = fx3_dma_max_count_p2u(FX3_STREAM_BUF_SIZE * model.cfg.pkt_size,
+                FX3_STREAM_COUNT_U2P);
+        if (model_set_geometry(FX3_STREAM_BUF_SIZE, (uint16_t) count_p2u,
+                FX3_STREAM_COUNT_U2P) != 0)
+            return -1;
+    }
+
+    pthread_mutex_lock(&model.lock);
+    model.cfg.profile = (uint8_t) profile;
+    model.cfg.manual = (manual != 0) ? FX3_DMA_MANUAL : FX3_DMA_AUTO;
+    model.cfg.burst = (profile == FX3_PROFILE_LOOPBACK) ? 1 : MODEL_BURST;
+    pthread_mutex_unlock(&model.lock);
+    return 0;
+}
+
+/* The burst length is only reported back; the gadget side has no say in it. */
+static int model_set_burst(uint16_t burst)
+{
+    if (burst > MODEL_BURST)
+        return -1;
+
+    pthread_mutex_lock(&model.lock);
+    if (burst == 0)
+        burst = (model.cfg.profile == FX3_PROFILE_LOOPBACK) ? 1 : MODEL_BURST;
+    model.cfg.burst = (uint8_t) burst;
+    pthread_mutex_unlock(&model.lock);
+    return 0;
+}
+
+/* Answer one setup request. Requests the model does not know are stalled, the
+ * remaining FX3 requests are accepted and ignored. */
+static void handle_setup(int ep0, const struct usb_ctrlrequest *ctrl)
+{
+    uint8_t buf[FX3_EP0_BUFFER_SIZE];
+    uint16_t value = le16toh(ctrl->wValue);
+    uint16_t index = le16toh(ctrl->wIndex);
+    uint16_t length = le16toh(ctrl->wLength);
+    int is_in = (ctrl->bRequestType & USB_DIR_IN) != 0;
+    int status = 0;
+    int len = 0;
+
+    if ((ctrl->bRequestType & USB_TYPE_MASK) != USB_TYPE_VENDOR)
+        status = -1;
+    else
+    {
+        switch (ctrl->bRequest)
+        {
+        case FX3_RQT_SET_DMA_CONFIG:
+            status = model_set_geometry(value, index & 0xFF, index >> 8);
+            break;
+        case FX3_RQT_GET_DMA_CONFIG:
+            pthread_mutex_lock(&model.lock);
+            buf[0] = model.cfg.buf_size & 0xFF;
+            buf[1] = model.cfg.buf_size >> 8;
+            buf[2] = model.cfg.pkt_size & 0xFF;
+            buf[3] = model.cfg.pkt_size >> 8;
+            buf[4] = model.cfg.count_p2u;
+            buf[5] = model.cfg.count_u2p;
+            buf[6] = FX3_HEAP_KB & 0xFF;
+            buf[7] = FX3_HEAP_KB >> 8;
+            buf[8] = model.cfg.profile;
+            buf[9] = model.cfg.manual;
+            buf[10] = model.cfg.burst;
+            pthread_mutex_unlock(&model.lock);
+            len = FX3_DMA_CONFIG_LEN;
+            break;
+        case FX3_RQT_SET_PROFILE:
+            status = model_set_profile(value, index);
+            break;
+        case FX3_RQT_SET_BURST_LENGTH:
+            status = model_set_burst(value);
+            break;
+        case FX3_RQT_SET_P2U_FRAMING:
+        case FX3_RQT_SET_WRAPUP_TIMEOUT:
+        case FX3_RQT_SET_WORKER_COST:
+        case FX3_RQT_SET_TRACE_MASK:
+        case FX3_RQT_SET_CRC_CHECK:
+        case FX3_RQT_SET_DATA_MODE:
+            break;
+        default:
+            status = -1;
+            break;
+        }
+    }
+
+    /* A transfer in the wrong direction stalls the control pipe. */
+    if (status != 0)
+    {
+        if (is_in)
+            status = read(ep0, buf, 0);
+        else
+            status = write(ep0, buf, 0);
+        return;
+    }
+
+    if (is_in)
+    {
+        if (len > length)
+            len = length;
+        if (write(ep0, buf, len) < 0)
+            perror("ep0 write");
+    }
+    else if (read(ep0, buf, (length < sizeof(buf)) ? length : sizeof(buf)) < 0)
+        perror("ep0 read");
+}
+
+/* IN endpoint of the STREAM profile: send "MW" buffers as fast as the host takes them. */
+static void *in_thread(void *arg)
+{
+    static uint16_t buf[64 * 1024];
+    unsigned bytes, i;
+    int loopback;
+
+    (void) arg;
+    for (i = 0; i < sizeof(buf) / sizeof(buf[0]); i++)
+        buf[i] = htole16(MODEL_PATTERN);
+
+    for (;;)
+    {
+        bytes = model_buf_bytes(&loopback);
+        if (loopback || (bytes > sizeof(buf)))
+        {
+            usleep(10000);
+            continue;
+        }
+        if (write(model.ep_in, buf, bytes) < 0)
+            usleep(10000);      /* Not enabled yet, or the host went away */
+    }
+    return NULL;
+}
+
+/* OUT endpoint: discard the data, or send it back in the LOOPBACK profile. */
+static void *out_thread(void *arg)
+{
+    static uint8_t buf[128 * 1024];
+    unsigned bytes;
+    ssize_t len;
+    int loopback;
+
+    (void) arg;
+    for (;;)
+    {
+        bytes = model_buf_bytes(&loopback);
+        if (bytes > sizeof(buf))
+            bytes = sizeof(buf);
+        len = read(model.ep_out, buf, bytes);
+        if (len < 0)
+        {
+            usleep(10000);
+            continue;
+        }
+        if (loopback && (len > 0) && (write(model.ep_in, buf, len) < 0))
+            usleep(10000);
+    }
+    return NULL;
+}
+
+static int open_ep(const char *dir, const char *name)
+{
+    char path[256];
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+        perror(path);
+    return fd;
+}
+
+int main(int argc, char **argv)
+{
+    struct usb_functionfs_event events[4];
+    pthread_t in_tid, out_tid;
+    uint16_t pkt_size = 1024;
+    int loopback = 0;
+    int ep0, opt, i;
+    ssize_t len;
+
+    while ((opt = getopt(argc, argv, "lp:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            loopback = 1;
+            break;
+        case 'p':
+            pkt_size = (uint16_t) strtoul(optarg, NULL, 0);
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if ((optind != argc - 1) || (pkt_size == 0))
+    {
+        fprintf(stderr, "usage: %s [-l] [-p packet_size] ffs_mount_dir\n", argv[0]);
+        return 2;
+    }
+
+    pthread_mutex_init(&model.lock, NULL);
+    model.cfg.pkt_size = pkt_size;
+    if (model_set_profile(loopback ? FX3_PROFILE_LOOPBACK : FX3_PROFILE_STREAM, FX3_DMA_MANUAL) != 0)
+    {
+        fprintf(stderr, "Packet size %u does not fit into the model heap\n", pkt_size);
+        return 2;
+    }
+
+    ep0 = open_ep(argv[optind], "ep0");
+    if ((ep0 < 0) || (write_descriptors(ep0) != 0))
+        return 1;
+
+    /* The endpoint files appear once the descriptors are written, in descriptor order. */
+    model.ep_in = open_ep(argv[optind], "ep1");
+    model.ep_out = open_ep(argv[optind], "ep2");
+    if ((model.ep_in < 0) || (model.ep_out < 0))
+        return 1;
+
+    pthread_create(&in_tid, NULL, in_thread, NULL);
+    pthread_create(&out_tid, NULL, out_thread, NULL);
+
+    for (;;)
+    {
+        len = read(ep0, events, sizeof(events));
+        if (len < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("ep0 read");
+            return 1;
+        }
+
+        for (i = 0; i < (int) (len / sizeof(events[0])); i++)
+        {
+            switch (events[i].type)
+            {
+            case FUNCTIONFS_SETUP:
+                handle_setup(ep0, &events[i].u.setup);
+                break;
+            case FUNCTIONFS_ENABLE:
+                printf("Configured\n");
+                break;
+            case FUNCTIONFS_DISABLE:
+                printf("Unconfigured\n");
+                break;
+            default:
+                break;
+            }
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
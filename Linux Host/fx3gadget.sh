@@ -0,0 +1,66 @@
+#!/bin/sh
+#
+# Start or stop the FX3 stand-in on dummy_hcd (run as root):
+#
+#   ./fx3gadget.sh start [fx3gadget options]
+#   ./fx3gadget.sh stop
+#
+# dummy_hcd connects a virtual UDC to a virtual host controller on the same
+# machine. A configfs gadget with the FX3 VID/PID and one FunctionFS function
+# is bound to it, and fx3gadget serves that function. The host tools then find
+# the model exactly like the FX3 itself.
+
+G=/sys/kernel/config/usb_gadget/fx3
+FFS=/dev/ffs-fx3
+DIR=$(cd "$(dirname "$0")" && pwd)
+
+start()
+{
+    set -e
+    modprobe libcomposite
+    modprobe dummy_hcd is_super_speed=1
+    mountpoint -q /sys/kernel/config || mount -t configfs none /sys/kernel/config
+
+    mkdir -p $G
+    echo 0x04b4 > $G/idVendor
+    echo 0x00f1 > $G/idProduct
+    echo 0x0300 > $G/bcdUSB
+    mkdir -p $G/strings/0x409
+    echo "Cypress" > $G/strings/0x409/manufacturer
+    echo "FX3" > $G/strings/0x409/product
+    mkdir -p $G/configs/c.1 $G/functions/ffs.fx3
+    [ -e $G/configs/c.1/ffs.fx3 ] || ln -s $G/functions/ffs.fx3 $G/configs/c.1/
+
+    mkdir -p $FFS
+    mountpoint -q $FFS || mount -t functionfs fx3 $FFS
+    "$DIR/fx3gadget" "$@" $FFS &
+    echo $! > $FFS.pid
+
+    # The UDC can only be bound once the function has its descriptors.
+    sleep 1
+    ls /sys/class/udc | grep dummy_udc | head -n 1 > $G/UDC
+}
+
+stop()
+{
+    [ -e $G/UDC ] && echo "" > $G/UDC
+    [ -e $FFS.pid ] && kill "$(cat $FFS.pid)" && rm -f $FFS.pid
+    mountpoint -q $FFS && umount $FFS
+    rm -f $G/configs/c.1/ffs.fx3
+    rmdir $G/configs/c.1 $G/functions/ffs.fx3 $G/strings/0x409 $G 2>/dev/null
+    modprobe -r dummy_hcd
+}
+
+case "$1" in
+start)
+    shift
+    start "$@"
+    ;;
+stop)
+    stop
+    ;;
+*)
+    echo "usage: $0 start [fx3gadget options] | stop" >&2
+    exit 2
+    ;;
+esac
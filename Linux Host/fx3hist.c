@@ -0,0 +1,133 @@
+/*
+ ## Latency histogram for the host tools
+ ## ===========================
+ ##
+ ##  Slot layout with sub = 2^bits:
+ ##  slot v                                  for v < sub
+ ##  slot sub + (s - 1) * sub / 2 + (v >> s) - sub / 2
+ ##                                          for v >= sub, s = msb(v) - bits + 1
+ ## ===========================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "fx3hist.h"
+
+static int msb(uint64_t v)
+{
+    return 63 - __builtin_clzll(v);
+}
+
+static int slot_of(const fx3_histogram *h, uint64_t v)
+{
+    uint64_t sub = 1ULL << h->bits;
+    int shift;
+
+    if (v < sub)
+        return (int) v;
+    shift = msb(v) - h->bits + 1;
+    return (int) (sub + (uint64_t) (shift - 1) * (sub / 2) + (v >> shift) - sub / 2);
+}
+
+/* Largest value that falls into the slot. */
+static uint64_t slot_upper(const fx3_histogram *h, int slot)
+{
+    uint64_t sub = 1ULL << h->bits;
+    uint64_t half = sub / 2;
+    int shift;
+
+    if ((uint64_t) slot < sub)
+        return (uint64_t) slot;
+    shift = (int) ((slot - sub) / half) + 1;
+    return (((slot - sub) % half + half) << shift) + (1ULL << shift) - 1;
+}
+
+int fx3_hist_init(fx3_histogram *h, uint64_t highest, int bits)
+{
+    memset(h, 0, sizeof(*h));
+    h->bits = bits;
+    h->highest = highest;
+    h->slots = slot_of(h, highest) + 1;
+    h->counts = calloc(h->slots, sizeof(*h->counts));
+    if (h->counts == NULL)
+        return -1;
+    fx3_hist_reset(h);
+    return 0;
+}
+
+void fx3_hist_free(fx3_histogram *h)
+{
+    free(h->counts);
+    h->counts = NULL;
+}
+
+void fx3_hist_reset(fx3_histogram *h)
+{
+    memset(h->counts, 0, h->slots * sizeof(*h->counts));
+    h->total = 0;
+    h->min = UINT64_MAX;
+    h->max = 0;
+    h->sum = 0;
+}
+
+void fx3_hist_record(fx3_histogram *h, uint64_t value)
+{
+    if (value > h->highest)
+        value = h->highest;
+
+    h->counts[slot_of(h, value)]++;
+    h->total++;
+    h->sum += (double) value;
+    if (value < h->min)
+        h->min = value;
+    if (value > h->max)
+        h->max = value;
+}
+
+uint64_t fx3_hist_percentile(const fx3_histogram *h, double percentile)
+{
+    uint64_t target, seen = 0;
+    uint64_t value;
+    int i;
+
+    if (h->total == 0)
+        return 0;
+
+    target = (uint64_t) (percentile / 100.0 * h->total + 0.5);
+    if (target == 0)
+        target = 1;
+    for (i = 0; i < h->slots; i++)
+    {
+        seen += h->counts[i];
+        if (seen >= target)
+            break;
+    }
+
+    value = slot_upper(h, (i < h->slots) ? i : h->slots - 1);
+    return (value > h->max) ? h->max : value;
+}
+
+double fx3_hist_mean(const fx3_histogram *h)
+{
+    return (h->total != 0) ? h->sum / h->total : 0;
+}
+
+void fx3_hist_print(const fx3_histogram *h, FILE *f, double scale)
+{
+    uint64_t seen = 0;
+    uint64_t value;
+    int i;
+
+    fprintf(f, "%12s %12s %12s\n", "value", "percentile", "count");
+    for (i = 0; i < h->slots; i++)
+    {
+        if (h->counts[i] == 0)
+            continue;
+        seen += h->counts[i];
+        value = slot_upper(h, i);
+        if (value > h->max)
+            value = h->max;
+        fprintf(f, "%12.3f %12.6f %12llu\n", value / scale, 100.0 * seen / h->total,
+                (unsigned long long) h->counts[i]);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ ## Latency histogram for the host tools
+ ## ===========================
+ ##
+ ##  A log-linear histogram in the style of HdrHistogram: values below 2^bits
+ ##  are counted exactly, above that every power of two is split into 2^(bits-1)
+ ##  slots, so any recorded value is known to within 2^(1-bits) of itself
+ ##  (0.8% with the default of 8 bits) over the whole range, with a fixed and
+ ##  small amount of memory. Percentiles report the upper end of a slot.
+ ## ===========================
+ */
+
+#ifndef _INCLUDED_FX3HIST_H_
+#define _INCLUDED_FX3HIST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define FX3_HIST_BITS                   (8)
+
+typedef struct fx3_histogram
+{
+    int bits;                       /* Precision, see above */
+    int slots;
+    uint64_t highest;               /* Largest value that can be recorded */
+    uint64_t *counts;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} fx3_histogram;
+
+/* Values from 0 to highest are recorded; larger ones are clamped to highest.
+ * Returns -1 if the counts cannot be allocated. */
+extern int fx3_hist_init(fx3_histogram *h, uint64_t highest, int bits);
+
+extern void fx3_hist_free(fx3_histogram *h);
+
+extern void fx3_hist_reset(fx3_histogram *h);
+
+extern void fx3_hist_record(fx3_histogram *h, uint64_t value);
+
+/* Smallest slot upper bound below which percentile % of the values lie,
+ * 0 if the histogram is empty. */
+extern uint64_t fx3_hist_percentile(const fx3_histogram *h, double percentile);
+
+extern double fx3_hist_mean(const fx3_histogram *h);
+
+/* Print "value percentile count" for every non-empty slot, values divided by
+ * scale, for plotting the distribution. */
+extern void fx3_hist_print(const fx3_histogram *h, FILE *f, double scale);
+
+#endif /* _INCLUDED_FX3HIST_H_ */
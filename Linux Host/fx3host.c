@@ -0,0 +1,158 @@
+/*
+ ## Host side helpers for the FX3 slave FIFO firmware
+ ## ===========================
+ ##
+ ##  Device lookup and vendor request wrappers shared by the host tools.
+ ## ===========================
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "fx3host.h"
+
+libusb_device_handle *fx3_open(libusb_context *ctx)
+{
+    libusb_device_handle *dev;
+    int status;
+
+    dev = libusb_open_device_with_vid_pid(ctx, FX3_VID, FX3_PID);
+    if (dev == NULL)
+    {
+        fprintf(stderr, "No device %04x:%04x found\n", FX3_VID, FX3_PID);
+        return NULL;
+    }
+
+    libusb_set_auto_detach_kernel_driver(dev, 1);
+    status = libusb_claim_interface(dev, FX3_INTERFACE);
+    if (status != 0)
+    {
+        fprintf(stderr, "Claiming interface %d failed: %s\n", FX3_INTERFACE,
+                libusb_error_name(status));
+        libusb_close(dev);
+        return NULL;
+    }
+
+    return dev;
+}
+
+void fx3_close(libusb_device_handle *dev)
+{
+    libusb_release_interface(dev, FX3_INTERFACE);
+    libusb_close(dev);
+}
+
+void fx3_find_endpoints(libusb_device_handle *dev, unsigned char *ep_in,
+        unsigned char *ep_out)
+{
+    struct libusb_config_descriptor *config;
+    const struct libusb_interface_descriptor *intf;
+    const struct libusb_endpoint_descriptor *ep;
+    int in_found = 0, out_found = 0;
+    int i;
+
+    *ep_in = FX3_EP_IN;
+    *ep_out = FX3_EP_OUT;
+    if (libusb_get_active_config_descriptor(libusb_get_device(dev), &config) != 0)
+        return;
+
+    if ((config->bNumInterfaces > FX3_INTERFACE)
+            && (config->interface[FX3_INTERFACE].num_altsetting > 0))
+    {
+        intf = &config->interface[FX3_INTERFACE].altsetting[0];
+        for (i = 0; i < intf->bNumEndpoints; i++)
+        {
+            ep = &intf->endpoint[i];
+            if ((ep->bmAttributes & LIBUSB_TRANSFER_TYPE_MASK) != LIBUSB_TRANSFER_TYPE_BULK)
+                continue;
+            if ((ep->bEndpointAddress & LIBUSB_ENDPOINT_DIR_MASK) == LIBUSB_ENDPOINT_IN)
+            {
+                if (!in_found)
+                    *ep_in = ep->bEndpointAddress;
+                in_found = 1;
+            }
+            else
+            {
+                if (!out_found)
+                    *ep_out = ep->bEndpointAddress;
+                out_found = 1;
+            }
+        }
+    }
+
+    libusb_free_config_descriptor(config);
+}
+
+int fx3_vendor_out(libusb_device_handle *dev, uint8_t request,
+        uint16_t value, uint16_t index)
+{
+    int status;
+
+    status = libusb_control_transfer(dev,
+            LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+            request, value, index, NULL, 0, FX3_CTRL_TIMEOUT);
+    return (status < 0) ? status : 0;
+}
+
+int fx3_vendor_in(libusb_device_handle *dev, uint8_t request,
+        uint16_t value, uint16_t index, void *buf, uint16_t len)
+{
+    return libusb_control_transfer(dev,
+            LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+            request, value, index, (unsigned char *) buf, len, FX3_CTRL_TIMEOUT);
+}
+
+int fx3_get_dma_config(libusb_device_handle *dev, fx3_dma_config *cfg)
+{
+    uint8_t buf[FX3_DMA_CONFIG_LEN];
+    int len;
+
+    memset(buf, 0, sizeof(buf));
+    buf[9] = FX3_DMA_MANUAL;
+    len = fx3_vendor_in(dev, FX3_RQT_GET_DMA_CONFIG, 0, 0, buf, sizeof(buf));
+    if (len < 0)
+        return len;
+    if (len < 8)
+        return LIBUSB_ERROR_IO;
+
+    cfg->buf_size = (uint16_t) (buf[0] | (buf[1] << 8));
+    cfg->pkt_size = (uint16_t) (buf[2] | (buf[3] << 8));
+    cfg->count_p2u = buf[4];
+    cfg->count_u2p = buf[5];
+    cfg->heap_kb = (uint16_t) (buf[6] | (buf[7] << 8));
+    cfg->profile = buf[8];
+    cfg->manual = buf[9];
+    cfg->burst = buf[10];
+    return 0;
+}
+
+int fx3_get_telemetry(libusb_device_handle *dev, fx3_telemetry *tel, int clear)
+{
+    int len;
+
+    memset(tel, 0, sizeof(*tel));
+    len = fx3_vendor_in(dev, FX3_RQT_GET_TELEMETRY, clear ? 1 : 0, 0, tel, sizeof(*tel));
+    if (len < 0)
+        return len;
+    if (len < (int) offsetof(fx3_telemetry, recoveries))
+        return LIBUSB_ERROR_IO;
+    return 0;
+}
+
+unsigned fx3_dma_buf_bytes(libusb_device_handle *dev)
+{
+    fx3_dma_config cfg;
+
+    if ((fx3_get_dma_config(dev, &cfg) != 0) || (cfg.buf_size == 0) || (cfg.pkt_size == 0))
+        return FX3_DEFAULT_BUF_BYTES;
+    return (unsigned) cfg.buf_size * cfg.pkt_size;
+}
+
+double fx3_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,248 @@
+/*
+ ## Host side definitions for the FX3 slave FIFO firmware
+ ## ===========================
+ ##
+ ##  The vendor request codes and data blocks below mirror cyfxslfifosync.h of the
+ ##  firmware. All multi-byte fields on the wire are little endian, which matches
+ ##  the x86 and ARM Linux hosts these tools are built for.
+ ## ===========================
+ */
+
+#ifndef _INCLUDED_FX3HOST_H_
+#define _INCLUDED_FX3HOST_H_
+
+#include <stdint.h>
+#include <libusb-1.0/libusb.h>
+
+#define FX3_VID                         (0x04B4)
+#define FX3_PID                         (0x00F1)
+#define FX3_INTERFACE                   (0)
+
+#define FX3_EP_OUT                      (0x01)      /* CY_FX_EP_PRODUCER */
+#define FX3_EP_IN                       (0x81)      /* CY_FX_EP_CONSUMER */
+
+#define FX3_CTRL_TIMEOUT                (1000)      /* Control transfer timeout in ms */
+
+/* Vendor requests, see cyfxslfifosync.h */
+#define FX3_RQT_SET_DMA_CONFIG          (0xB0)
+#define FX3_RQT_GET_DMA_CONFIG          (0xB1)
+#define FX3_RQT_SET_P2U_FRAMING         (0xB2)
+#define FX3_RQT_GET_TELEMETRY           (0xB3)
+#define FX3_RQT_SET_WRAPUP_TIMEOUT      (0xB4)
+#define FX3_RQT_CPU_BENCHMARK           (0xB5)
+#define FX3_RQT_SET_WORKER_COST         (0xB6)
+#define FX3_RQT_GET_TRACE               (0xB7)
+#define FX3_RQT_SET_TRACE_MASK          (0xB8)
+#define FX3_RQT_SET_CRC_CHECK           (0xB9)
+#define FX3_RQT_SET_DATA_MODE           (0xBA)
+#define FX3_RQT_SET_PROFILE             (0xBB)
+#define FX3_RQT_SET_BURST_LENGTH        (0xBC)
+
+#define FX3_DMA_CONFIG_LEN              (11)        /* CY_FX_RQT_DMA_CONFIG_LEN */
+
+/* CY_FX_RQT_SET_PROFILE arguments */
+#define FX3_PROFILE_STREAM              (0)
+#define FX3_PROFILE_LOOPBACK            (1)
+#define FX3_DMA_AUTO                    (0)
+#define FX3_DMA_MANUAL                  (1)
+
+/* CY_FX_RQT_SET_DATA_MODE arguments: CY_FX_SLFIFO_DATA_xxx flags and
+ * CY_FX_SLFIFO_PATTERN_xxx source patterns */
+#define FX3_DATA_GPIF                   (0)
+#define FX3_DATA_SOURCE                 (1 << 0)
+#define FX3_DATA_SINK                   (1 << 1)
+#define FX3_SOURCE_CONSTANT             (0)
+#define FX3_SOURCE_COUNTER              (1)
+
+#define FX3_EP0_BUFFER_SIZE             (256)       /* CY_FX_EP0_BUFFER_SIZE */
+
+/* Trace event ids, see CY_FX_SLFIFO_TRACE_xxx */
+#define FX3_TRACE_UTOP_BUF              (1)
+#define FX3_TRACE_PTOU_BUF              (2)
+#define FX3_TRACE_PTOU_EMPTY            (3)
+#define FX3_TRACE_PIB_ERROR             (4)
+#define FX3_TRACE_PIB_OTHER             (5)
+#define FX3_TRACE_PIB_RECOVERY          (6)
+#define FX3_TRACE_WRAPUP                (7)
+#define FX3_TRACE_USB_EVENT             (8)
+#define FX3_TRACE_DMA_START             (9)
+#define FX3_TRACE_DMA_STOP              (10)
+#define FX3_TRACE_WORKER_QUEUE          (11)
+
+/* CyFxSlFifoTraceRecord_t. The timestamps of records and header are in us and wrap
+ * after 2^32 us. */
+typedef struct fx3_trace_record
+{
+    uint16_t event;
+    uint16_t sequence;
+    uint32_t timestamp;
+    uint32_t arg0;
+    uint32_t arg1;
+} __attribute__ ((packed)) fx3_trace_record;
+
+/* CyFxSlFifoTraceHeader_t */
+typedef struct fx3_trace_header
+{
+    uint16_t recordCount;
+    uint16_t recordSize;
+    uint16_t pending;
+    uint16_t mask;
+    uint32_t dropped;
+    uint32_t timestamp;
+} __attribute__ ((packed)) fx3_trace_header;
+
+/* CyFxSlFifoTelemetry_t, read with CY_FX_RQT_GET_TELEMETRY. Byte and buffer
+ * counters only move with MANUAL channels. The timestamp and the intervals are
+ * in us and wrap after 2^32 us. */
+#define FX3_MEM_POOL_STATS              (3)         /* CY_FX_SLFIFO_MEM_POOL_STATS */
+typedef struct fx3_telemetry
+{
+    uint64_t bytesPtoU;
+    uint64_t bytesUtoP;
+    uint32_t timestamp;
+    uint32_t buffersPtoU;
+    uint32_t buffersUtoP;
+    uint32_t commitFailPtoU;
+    uint32_t commitFailUtoP;
+    uint32_t overrun[4];
+    uint32_t underrun[4];
+    uint32_t intervalMin;
+    uint32_t intervalMax;
+    uint32_t intervalAvg;
+    uint32_t intervalCount;
+    uint32_t recoveries;
+    uint32_t memBlockSize[FX3_MEM_POOL_STATS];
+    uint32_t memHighWater[FX3_MEM_POOL_STATS];
+    uint32_t memFallbacks[FX3_MEM_POOL_STATS];
+    uint32_t crcChecked;
+    uint32_t crcMismatch;
+    uint32_t crcExpected;
+    uint32_t crcActual;
+    uint32_t gpifStartFail;
+    uint32_t lpmExitU1;
+    uint32_t lpmExitU2;
+} __attribute__ ((packed)) fx3_telemetry;
+
+/* CyFxSlFifoBenchResult_t, read with CY_FX_RQT_CPU_BENCHMARK */
+#define FX3_BENCH_PENDING               (0xFFFFFFFF) /* CY_FX_SLFIFO_BENCH_PENDING */
+typedef struct fx3_bench_result
+{
+    uint32_t status;
+    uint32_t dcacheEnabled;
+    uint32_t bufferBytes;
+    uint32_t iterations;
+    uint32_t elapsedUs;
+    uint32_t nsPerBuffer;
+    uint32_t checksum;
+} __attribute__ ((packed)) fx3_bench_result;
+
+/* Payload of CY_FX_RQT_GET_DMA_CONFIG */
+typedef struct fx3_dma_config
+{
+    uint16_t buf_size;          /* Buffer size in packets */
+    uint16_t pkt_size;          /* Packet size in bytes */
+    uint8_t count_p2u;
+    uint8_t count_u2p;
+    uint16_t heap_kb;
+    uint8_t profile;            /* FX3_PROFILE_xxx */
+    uint8_t manual;             /* FX3_DMA_AUTO or FX3_DMA_MANUAL */
+    uint8_t burst;              /* Endpoint burst length, 0 if not reported */
+} fx3_dma_config;
+
+/* DMA buffer heap accounting of the firmware, shared by the device stand-ins so
+ * that they accept the same geometries and pick the same buffer counts as
+ * CyFxSlFifoApplnSetDmaConfig and CyFxSlFifoDmaMaxCountPtoU. The firmware is
+ * built with CY_FX_RECLAIM_2STAGE_BOOT_AREA, the stream 2 and EP 2 channels off
+ * and without deferred processing (which limits the count to 64 per channel). */
+#define FX3_HEAP_KB                     (256)       /* CY_U3P_BUFFER_HEAP_SIZE / 1024 */
+#define FX3_HEAP_RESERVE                (0x2000)    /* CY_FX_SLFIFO_DMA_HEAP_RESERVE */
+#define FX3_DMA_BUF_MAX_BYTES           (0xFFFF)    /* CY_FX_SLFIFO_DMA_BUF_MAX_BYTES */
+#define FX3_DMA_BUF_COUNT_LIMIT         (254)       /* CY_FX_SLFIFO_DMA_BUF_COUNT_LIMIT */
+
+/* Profile geometries, CY_FX_SLFIFO_STREAM_xxx and CY_FX_SLFIFO_LOOPBACK_xxx. The
+ * STREAM profile gets as many P2U buffers as fit. */
+#define FX3_STREAM_BUF_SIZE             (16)        /* Packets per buffer */
+#define FX3_STREAM_COUNT_U2P            (4)
+#define FX3_LOOPBACK_BUF_SIZE           (1)
+#define FX3_LOOPBACK_COUNT_P2U          (2)
+#define FX3_LOOPBACK_COUNT_U2P          (2)
+
+/* Heap taken by count buffers of buf_bytes each and the reserve: the buffer
+ * manager rounds every buffer up to 32 bytes and adds a 32 byte guard chunk. */
+static inline unsigned long fx3_dma_heap_bytes(unsigned buf_bytes, unsigned count)
+{
+    return (((buf_bytes + 31UL) & ~31UL) + 32) * count + FX3_HEAP_RESERVE;
+}
+
+/* Largest P2U buffer count that fits next to count_u2p U2P buffers, 0 if none. */
+static inline unsigned fx3_dma_max_count_p2u(unsigned buf_bytes, unsigned count_u2p)
+{
+    unsigned long fixed = fx3_dma_heap_bytes(buf_bytes, count_u2p);
+    unsigned long count;
+
+    if (fixed >= FX3_HEAP_KB * 1024UL)
+        return 0;
+    count = (FX3_HEAP_KB * 1024UL - fixed) / (((buf_bytes + 31UL) & ~31UL) + 32);
+    return (count > FX3_DMA_BUF_COUNT_LIMIT) ? FX3_DMA_BUF_COUNT_LIMIT : (unsigned) count;
+}
+
+/* Geometry check of CyFxSlFifoApplnSetDmaConfig. Returns 0 if the device
+ * accepts buffers of buf_size packets of pkt_size bytes in these counts. */
+static inline int fx3_dma_geometry_fits(unsigned buf_size, unsigned pkt_size,
+        unsigned count_p2u, unsigned count_u2p)
+{
+    unsigned long buf_bytes = (unsigned long) buf_size * pkt_size;
+
+    if ((buf_size == 0) || (buf_bytes > FX3_DMA_BUF_MAX_BYTES) || (count_p2u == 0)
+            || (count_u2p == 0) || (count_p2u > FX3_DMA_BUF_COUNT_LIMIT)
+            || (count_u2p > FX3_DMA_BUF_COUNT_LIMIT))
+        return -1;
+    if (fx3_dma_heap_bytes((unsigned) buf_bytes, count_p2u + count_u2p) > FX3_HEAP_KB * 1024UL)
+        return -1;
+    return 0;
+}
+
+/* Default DMA buffer size in bytes (DMA_BUF_SIZE x SuperSpeed packet size), used
+ * when the device does not answer GET_DMA_CONFIG. */
+#define FX3_DEFAULT_BUF_BYTES           (16 * 1024)
+
+/* Open the first FX3 running the slave FIFO firmware and claim its interface.
+ * Returns NULL and prints the reason on failure. */
+extern libusb_device_handle *fx3_open(libusb_context *ctx);
+
+/* Look up the first bulk IN and OUT endpoint of the interface. The FX3 uses
+ * FX3_EP_IN and FX3_EP_OUT; a gadget stand-in gets whatever addresses its UDC
+ * hands out. Falls back to the FX3 addresses if the descriptor cannot be read. */
+extern void fx3_find_endpoints(libusb_device_handle *dev, unsigned char *ep_in,
+        unsigned char *ep_out);
+
+/* Release the interface and close the device. */
+extern void fx3_close(libusb_device_handle *dev);
+
+/* Vendor request without data phase. Returns 0 or a libusb error code. */
+extern int fx3_vendor_out(libusb_device_handle *dev, uint8_t request,
+        uint16_t value, uint16_t index);
+
+/* Vendor request with an IN data phase. Returns the number of bytes
+ * received or a libusb error code. */
+extern int fx3_vendor_in(libusb_device_handle *dev, uint8_t request,
+        uint16_t value, uint16_t index, void *buf, uint16_t len);
+
+/* Read the DMA geometry. Firmware without the profile bytes reports the
+ * STREAM profile with MANUAL channels, firmware without the burst length
+ * byte a burst length of 0. Returns 0 or a libusb error code. */
+extern int fx3_get_dma_config(libusb_device_handle *dev, fx3_dma_config *cfg);
+
+/* Read the telemetry block, clearing the counters on the device if clear is
+ * set. Fields a firmware without them does not send read 0. Returns 0 or a
+ * libusb error code. */
+extern int fx3_get_telemetry(libusb_device_handle *dev, fx3_telemetry *tel, int clear);
+
+/* Size of one DMA buffer in bytes, or FX3_DEFAULT_BUF_BYTES if the device
+ * cannot be asked. */
+extern unsigned fx3_dma_buf_bytes(libusb_device_handle *dev);
+
+/* Monotonic time in seconds. */
+extern double fx3_now(void);
+
+#endif /* _INCLUDED_FX3HOST_H_ */
@@ -0,0 +1,418 @@
+/*
+ ## fx3latency: loopback round-trip latency of the FX3 slave FIFO path
+ ## ===========================
+ ##
+ ##  Sends probes on the bulk OUT endpoint and matches them on the bulk IN
+ ##  endpoint while the device runs the loopback FPGA image (or fx3gadget -l).
+ ##  Every probe starts with a header holding a sequence number and the host
+ ##  time it was submitted, so the round trip is measured from the probe itself
+ ##  and lost or reordered probes are detected. The round trips go into an HDR
+ ##  style histogram (fx3hist.h), one per probe size.
+ ##
+ ##  Usage: fx3latency [-s size[,size...]] [-n probes] [-w warmup] [-L depth]
+ ##                    [-m auto|manual] [-H file]
+ ##
+ ##  -s  probe sizes in bytes (default 1024,16384), multiples of 1024
+ ##  -n  probes measured per size (default 10000), after -w warmup probes (100)
+ ##  -L  probes kept in flight (default 1). 1 measures the idle path; a deeper
+ ##      queue measures the round trip under load, queueing included
+ ##  -m  switch the device to the LOOPBACK profile with AUTO or MANUAL channels
+ ##      first (CY_FX_RQT_SET_PROFILE)
+ ##  -H  write the full distribution of each size to file.<size>
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "fx3host.h"
+#include "fx3hist.h"
+
+#define PROBE_MAGIC             (0x424F5250)    /* "PROB" */
+#define PROBE_TIMEOUT           (1000)          /* Transfer timeout in ms */
+#define PROBE_STALL_LIMIT       (2.0)           /* Seconds without progress before giving up */
+#define PROBE_PATTERN           (0x574D)        /* "MW" */
+#define PROBE_MAX_SIZES         (8)
+
+typedef struct probe_header
+{
+    uint32_t magic;
+    uint32_t sequence;
+    uint64_t sent_ns;
+} __attribute__ ((packed)) probe_header;
+
+typedef struct probe_run
+{
+    libusb_device_handle *dev;
+    unsigned char ep_in;
+    unsigned char ep_out;
+    int size;
+    int depth;
+    uint32_t total;             /* Probes to send, warmup included */
+    uint32_t warmup;
+
+    struct libusb_transfer **out;
+    struct libusb_transfer **in;
+    int *out_free;              /* Stack of idle OUT transfers */
+    int out_free_count;
+    int in_active;
+    int out_active;
+
+    uint32_t sent;
+    uint32_t to_send;           /* Probes released by returning ones, not yet sent */
+    uint32_t received;
+    uint32_t expected;          /* Next sequence number expected on IN */
+    uint32_t lost;
+    uint32_t bad;               /* IN transfers that did not hold a probe */
+    int error;
+
+    fx3_histogram *hist;
+} probe_run;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig)
+{
+    (void) sig;
+    stop = 1;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int run_done(const probe_run *run)
+{
+    return (run->received + run->lost >= run->total) || (run->error != 0) || stop;
+}
+
+/* Send as many released probes as there are idle OUT transfers. */
+static void send_probes(probe_run *run)
+{
+    struct libusb_transfer *xfer;
+    probe_header hdr;
+    int index;
+
+    while ((run->to_send > 0) && (run->out_free_count > 0) && (run->sent < run->total) && !stop)
+    {
+        index = run->out_free[--run->out_free_count];
+        xfer = run->out[index];
+
+        hdr.magic = PROBE_MAGIC;
+        hdr.sequence = run->sent;
+        hdr.sent_ns = now_ns();
+        memcpy(xfer->buffer, &hdr, sizeof(hdr));
+        if (libusb_submit_transfer(xfer) != 0)
+        {
+            run->out_free[run->out_free_count++] = index;
+            run->error = 1;
+            return;
+        }
+
+        run->out_active++;
+        run->sent++;
+        run->to_send--;
+    }
+}
+
+static void LIBUSB_CALL out_callback(struct libusb_transfer *xfer)
+{
+    probe_run *run = (probe_run *) xfer->user_data;
+    int i;
+
+    run->out_active--;
+    if ((xfer->status != LIBUSB_TRANSFER_COMPLETED) && (xfer->status != LIBUSB_TRANSFER_CANCELLED))
+    {
+        fprintf(stderr, "Probe OUT transfer failed with status %d\n", xfer->status);
+        run->error = 1;
+    }
+
+    for (i = 0; i < run->depth; i++)
+        if (run->out[i] == xfer)
+            run->out_free[run->out_free_count++] = i;
+    send_probes(run);
+}
+
+static void LIBUSB_CALL in_callback(struct libusb_transfer *xfer)
+{
+    probe_run *run = (probe_run *) xfer->user_data;
+    uint64_t received_ns = now_ns();
+    probe_header hdr;
+
+    run->in_active--;
+    if (xfer->status == LIBUSB_TRANSFER_CANCELLED)
+        return;
+    if ((xfer->status != LIBUSB_TRANSFER_COMPLETED) && (xfer->status != LIBUSB_TRANSFER_TIMED_OUT))
+    {
+        fprintf(stderr, "Probe IN transfer failed with status %d\n", xfer->status);
+        run->error = 1;
+        return;
+    }
+
+    if (xfer->actual_length > 0)
+    {
+        memcpy(&hdr, xfer->buffer, sizeof(hdr));
+        if ((xfer->actual_length != run->size) || (hdr.magic != PROBE_MAGIC)
+                || (hdr.sequence < run->expected) || (hdr.sequence >= run->sent))
+            run->bad++;
+        else
+        {
+            /* Probes that were overtaken count as lost; each one found
+             * releases the next probe. */
+            run->lost += hdr.sequence - run->expected;
+            run->to_send += hdr.sequence - run->expected + 1;
+            run->expected = hdr.sequence + 1;
+            run->received++;
+            if (hdr.sequence >= run->warmup)
+                fx3_hist_record(run->hist, received_ns - hdr.sent_ns);
+        }
+    }
+
+    if (!run_done(run) && (libusb_submit_transfer(xfer) == 0))
+        run->in_active++;
+    send_probes(run);
+}
+
+static struct libusb_transfer *alloc_xfer(probe_run *run, unsigned char endpoint,
+        libusb_transfer_cb_fn callback)
+{
+    struct libusb_transfer *xfer;
+    unsigned char *buf;
+    uint16_t *word;
+    int i;
+
+    xfer = libusb_alloc_transfer(0);
+    buf = malloc(run->size);
+    if ((xfer == NULL) || (buf == NULL))
+    {
+        free(buf);
+        if (xfer != NULL)
+            libusb_free_transfer(xfer);
+        return NULL;
+    }
+
+    word = (uint16_t *) buf;
+    for (i = 0; i < run->size / 2; i++)
+        word[i] = PROBE_PATTERN;
+    libusb_fill_bulk_transfer(xfer, run->dev, endpoint, buf, run->size, callback, run,
+            PROBE_TIMEOUT);
+    xfer->flags = LIBUSB_TRANSFER_FREE_BUFFER;
+    return xfer;
+}
+
+static int measure(libusb_context *ctx, probe_run *run)
+{
+    struct timeval tv;
+    uint32_t last_received = 0;
+    double last_progress;
+    int i;
+
+    run->out = calloc(run->depth, sizeof(*run->out));
+    run->in = calloc(run->depth, sizeof(*run->in));
+    run->out_free = calloc(run->depth, sizeof(*run->out_free));
+    if ((run->out == NULL) || (run->in == NULL) || (run->out_free == NULL))
+        return -1;
+
+    for (i = 0; i < run->depth; i++)
+    {
+        run->out[i] = alloc_xfer(run, run->ep_out, out_callback);
+        run->in[i] = alloc_xfer(run, run->ep_in, in_callback);
+        if ((run->out[i] == NULL) || (run->in[i] == NULL))
+            return -1;
+        run->out_free[run->out_free_count++] = i;
+    }
+
+    /* Queue the IN side first, so no probe waits for a transfer to land in. */
+    for (i = 0; i < run->depth; i++)
+    {
+        if (libusb_submit_transfer(run->in[i]) != 0)
+            return -1;
+        run->in_active++;
+    }
+    run->to_send = run->depth;
+    send_probes(run);
+
+    last_progress = fx3_now();
+    while (!run_done(run))
+    {
+        tv.tv_sec = 0;
+        tv.tv_usec = 100000;
+        libusb_handle_events_timeout_completed(ctx, &tv, NULL);
+
+        if (run->received != last_received)
+        {
+            last_received = run->received;
+            last_progress = fx3_now();
+        }
+        else if (fx3_now() - last_progress > PROBE_STALL_LIMIT)
+        {
+            /* Whatever is still in flight is gone; probes are lost. */
+            fprintf(stderr, "No probe returned for %.0f s, %u outstanding\n",
+                    PROBE_STALL_LIMIT, run->sent - run->expected);
+            run->lost += run->sent - run->expected;
+            run->error = 1;
+        }
+    }
+
+    for (i = 0; i < run->depth; i++)
+    {
+        libusb_cancel_transfer(run->in[i]);
+        libusb_cancel_transfer(run->out[i]);
+    }
+    while ((run->in_active > 0) || (run->out_active > 0))
+        libusb_handle_events(ctx);
+
+    for (i = 0; i < run->depth; i++)
+    {
+        libusb_free_transfer(run->in[i]);
+        libusb_free_transfer(run->out[i]);
+    }
+    free(run->in);
+    free(run->out);
+    free(run->out_free);
+    return run->error ? -1 : 0;
+}
+
+static void report(const probe_run *run)
+{
+    const fx3_histogram *h = run->hist;
+
+    printf("%6d B  depth %2d  %7llu probes  p50 %9.1f  p90 %9.1f  p99 %9.1f  p99.9 %9.1f"
+            "  max %9.1f  mean %9.1f us",
+            run->size, run->depth, (unsigned long long) h->total,
+            fx3_hist_percentile(h, 50) / 1e3, fx3_hist_percentile(h, 90) / 1e3,
+            fx3_hist_percentile(h, 99) / 1e3, fx3_hist_percentile(h, 99.9) / 1e3,
+            h->max / 1e3, fx3_hist_mean(h) / 1e3);
+    if (run->lost || run->bad)
+        printf("  (%u lost, %u bad)", run->lost, run->bad);
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    libusb_context *ctx = NULL;
+    libusb_device_handle *dev;
+    fx3_histogram hist;
+    fx3_dma_config cfg;
+    probe_run run;
+    int sizes[PROBE_MAX_SIZES] = { 1024, 16384 };
+    int nsizes = 2;
+    uint32_t probes = 10000, warmup = 100;
+    int depth = 1, mode = -1;
+    const char *hist_path = NULL;
+    char path[256], *tok;
+    FILE *f;
+    int opt, i, status = 0;
+
+    while ((opt = getopt(argc, argv, "s:n:w:L:m:H:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            nsizes = 0;
+            for (tok = strtok(optarg, ","); (tok != NULL) && (nsizes < PROBE_MAX_SIZES);
+                    tok = strtok(NULL, ","))
+                sizes[nsizes++] = atoi(tok);
+            break;
+        case 'n':
+            probes = (uint32_t) strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            warmup = (uint32_t) strtoul(optarg, NULL, 0);
+            break;
+        case 'L':
+            depth = atoi(optarg);
+            break;
+        case 'm':
+            mode = (strcmp(optarg, "manual") == 0) ? FX3_DMA_MANUAL : FX3_DMA_AUTO;
+            break;
+        case 'H':
+            hist_path = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s size[,size...]] [-n probes] [-w warmup] [-L depth]\n"
+                    "       %*s [-m auto|manual] [-H file]\n", argv[0], (int) strlen(argv[0]), "");
+            return 2;
+        }
+    }
+
+    for (i = 0; i < nsizes; i++)
+    {
+        if ((sizes[i] < (int) sizeof(probe_header)) || ((sizes[i] % 1024) != 0))
+        {
+            fprintf(stderr, "Probe sizes must be multiples of 1024\n");
+            return 2;
+        }
+    }
+    if ((depth <= 0) || (probes == 0))
+        return 2;
+
+    if (libusb_init(&ctx) != 0)
+        return 1;
+    dev = fx3_open(ctx);
+    if (dev == NULL)
+    {
+        libusb_exit(ctx);
+        return 1;
+    }
+
+    if ((mode >= 0) && (fx3_vendor_out(dev, FX3_RQT_SET_PROFILE, FX3_PROFILE_LOOPBACK, mode) != 0))
+    {
+        fprintf(stderr, "Switching to the LOOPBACK profile failed\n");
+        status = 1;
+    }
+    if (fx3_get_dma_config(dev, &cfg) == 0)
+        printf("Profile %s, %s channels, %u x %u byte U2P and %u P2U buffers\n",
+                (cfg.profile == FX3_PROFILE_LOOPBACK) ? "LOOPBACK" : "STREAM",
+                cfg.manual ? "MANUAL" : "AUTO", cfg.count_u2p, cfg.buf_size * cfg.pkt_size,
+                cfg.count_p2u);
+
+    /* Round trips up to 10 s, in ns. */
+    if (fx3_hist_init(&hist, 10000000000ULL, FX3_HIST_BITS) != 0)
+        return 1;
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    for (i = 0; (i < nsizes) && (status == 0) && !stop; i++)
+    {
+        memset(&run, 0, sizeof(run));
+        run.dev = dev;
+        fx3_find_endpoints(dev, &run.ep_in, &run.ep_out);
+        run.size = sizes[i];
+        run.depth = depth;
+        run.warmup = warmup;
+        run.total = warmup + probes;
+        run.hist = &hist;
+        fx3_hist_reset(&hist);
+
+        if (measure(ctx, &run) != 0)
+            status = 1;
+        report(&run);
+
+        if (hist_path != NULL)
+        {
+            snprintf(path, sizeof(path), "%s.%d", hist_path, sizes[i]);
+            f = fopen(path, "w");
+            if (f == NULL)
+                perror(path);
+            else
+            {
+                fx3_hist_print(&hist, f, 1e3);
+                fclose(f);
+            }
+        }
+    }
+
+    fx3_hist_free(&hist);
+    fx3_close(dev);
+    libusb_exit(ctx);
+    return status;
+}
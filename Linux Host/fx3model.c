@@ -0,0 +1,893 @@
+/*
+ ## fx3model: software model of the FX3 slave FIFO device
+ ## ===========================
+ ##
+ ##  Implements the part of libusb-1.0 the host tools use on top of a model of
+ ##  the device instead of a USB device. "make model" links it in place of
+ ##  -lusb-1.0 and builds fx3xxx-model binaries from the unchanged tool sources,
+ ##  so that they run on a machine with neither an FX3 nor dummy_hcd.
+ ##
+ ##  Unlike fx3gadget, the model reproduces the timing of the DMA path. Every
+ ##  DMA buffer of B bytes passes these stages, each of which handles one
+ ##  buffer at a time:
+ ##
+ ##  GPIF      B / MODEL_GPIF_MBPS (16 bit bus at 100 MHz); one lane per
+ ##            direction, the loopback FIFO in the FPGA is unbounded
+ ##  commit    MODEL_AUTO_NS for AUTO channels, MODEL_MANUAL_NS of CPU time
+ ##            for MANUAL channels (one CPU timeline per direction), plus
+ ##            MODEL_PASS_NS per KB for each worker pass set with
+ ##            SET_WORKER_COST
+ ##  USB       MODEL_PACKET_NS per packet plus MODEL_BURST_NS per burst; IN
+ ##            data only moves while the host has a transfer queued
+ ##
+ ##  A buffer is handed to the next stage when the stage is free and, on the
+ ##  way into the FX3, when one of the count_p2u or count_u2p buffers is free.
+ ##  Transfers complete MODEL_HOST_NS plus an exponentially distributed
+ ##  MODEL_HOST_JITTER_NS (the xHCI interrupt and event handling) after their
+ ##  last packet. The completion callbacks run at these times in real time,
+ ##  so throughput and latency are measured by the tools the usual way.
+ ##
+ ##  The constants are ballpark figures for an FX3 on a SuperSpeed host, not
+ ##  measurements; the model is good for trends and for exercising tools, not
+ ##  for predicting absolute numbers.
+ ##
+ ##  With SET_DATA_MODE the CPU source and sink replace the GPIF stage: a source
+ ##  buffer costs MODEL_MANUAL_NS of CPU time before it goes to USB, a sink
+ ##  buffer the same after it came from USB, and sunk data is not looped back.
+ ##
+ ##  The vendor requests for the geometry, profile, burst length and data mode
+ ##  are answered like the firmware does. SET_WORKER_COST is taken as by a firmware
+ ##  built with CY_FX_SLFIFO_DEFERRED_PROCESSING, where the worker only runs for
+ ##  MANUAL channels; the remaining FX3 requests are accepted and ignored. If FX3_MODEL_STATE names a file, the configuration is kept
+ ##  there between runs, as the device keeps it between tool invocations.
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <time.h>
+#include "fx3host.h"
+#include "fx3verify.h"
+
+#define MODEL_PKT_SIZE          (1024)      /* SuperSpeed bulk packet */
+#define MODEL_MAX_BURST         (16)        /* CY_FX_SLFIFO_SS_BURST_LENGTH */
+
+#define MODEL_GPIF_MBPS         (200.0)
+#define MODEL_AUTO_NS           (500.0)
+#define MODEL_MANUAL_NS         (8000.0)
+#define MODEL_PASS_NS           (5000.0)    /* One CyFxSlFifoProcessBuffer pass over 1 KB */
+#define MODEL_PACKET_NS         (2100.0)
+#define MODEL_BURST_NS          (4000.0)
+#define MODEL_HOST_NS           (20000.0)
+#define MODEL_HOST_JITTER_NS    (5000.0)
+
+/* The last part of a wait is spun rather than slept: sleeps can overshoot by
+ * a timer tick, which would swamp the latencies of the model. */
+#define MODEL_SPIN_NS           (2000000.0)
+
+struct libusb_context
+{
+    int unused;
+};
+
+struct libusb_device
+{
+    int unused;
+};
+
+struct libusb_device_handle
+{
+    int unused;
+};
+
+/* Transfer with the model bookkeeping in front. The libusb transfer has to
+ * come last, it ends in the iso packet array. */
+typedef struct model_xfer
+{
+    struct model_xfer *next;
+    double submitted;
+    double due;                 /* Completion time, 0 while the data is not there yet */
+    double last;                /* Last packet of the data so far */
+    int cancelled;
+    struct libusb_transfer xfer;
+} model_xfer;
+
+#define MODEL_XFER(t)           ((model_xfer *) ((char *) (t) - offsetof(model_xfer, xfer)))
+
+/* Data read by the loopback FPGA, waiting to be written back into P2U buffers. */
+typedef struct model_chunk
+{
+    struct model_chunk *next;
+    double ready;               /* Time the FPGA has it */
+    double sent;                /* Last packet on IN, 0 before it reached a P2U buffer */
+    unsigned len;
+    unsigned offset;            /* Bytes already handed to IN transfers */
+    uint8_t data[];
+} model_chunk;
+
+/* Time at which each stage, and each buffer, is free again */
+typedef struct model_timing
+{
+    double gpif_rd;
+    double gpif_wr;
+    double cpu_p2u;
+    double cpu_u2p;
+    double usb_in;
+    double usb_out;
+    double *p2u_free;
+    double *u2p_free;
+    unsigned p2u_next;
+    unsigned u2p_next;
+} model_timing;
+
+typedef struct model_state
+{
+    fx3_dma_config cfg;
+    unsigned worker_cost;       /* Worker passes per buffer */
+    unsigned data_mode;         /* FX3_DATA_xxx flags */
+    unsigned source_pattern;    /* FX3_SOURCE_xxx */
+    uint32_t source_state;      /* Last word of the source pattern */
+    model_timing t;
+    model_xfer *in_head, *in_tail;
+    model_xfer *out_head, *out_tail;
+    model_chunk *fifo_head, *fifo_tail;
+    double in_due;              /* Completions of an endpoint stay in order */
+    double out_due;
+    uint32_t rng;
+} model_state;
+
+static struct libusb_context model_ctx;
+static struct libusb_device model_dev;
+static struct libusb_device_handle model_handle;
+static model_state model;
+
+static double max2(double a, double b)
+{
+    return (a > b) ? a : b;
+}
+
+static unsigned buf_bytes(void)
+{
+    return (unsigned) model.cfg.buf_size * model.cfg.pkt_size;
+}
+
+static double gpif_time(unsigned bytes)
+{
+    return bytes / (MODEL_GPIF_MBPS * 1e6);
+}
+
+static double usb_time(unsigned bytes)
+{
+    unsigned packets = (bytes + model.cfg.pkt_size - 1) / model.cfg.pkt_size;
+    unsigned bursts = (packets + model.cfg.burst - 1) / model.cfg.burst;
+
+    return (packets * MODEL_PACKET_NS + bursts * MODEL_BURST_NS) * 1e-9;
+}
+
+/* Time the buffer of bytes filled at t is available to the consumer. */
+static double commit(double t, double *cpu, unsigned bytes)
+{
+    if (!model.cfg.manual)
+        return t + MODEL_AUTO_NS * 1e-9;
+    *cpu = max2(t, *cpu) + (MODEL_MANUAL_NS
+            + model.worker_cost * MODEL_PASS_NS * bytes / 1024) * 1e-9;
+    return *cpu;
+}
+
+/* Completion delay on the host: fixed part plus exponential jitter. */
+static double host_delay(void)
+{
+    double u;
+
+    model.rng ^= model.rng << 13;
+    model.rng ^= model.rng >> 17;
+    model.rng ^= model.rng << 5;
+    u = (model.rng + 1.0) / 4294967297.0;
+    return (MODEL_HOST_NS - MODEL_HOST_JITTER_NS * log(u)) * 1e-9;
+}
+
+/* P2U path: bytes the FPGA has at ready go into the next P2U buffer and are
+ * sent once the host has an IN transfer queued (from host on). Returns the
+ * time of the last packet. */
+static double model_p2u(double ready, double host, unsigned bytes)
+{
+    model_timing *t = &model.t;
+    double *slot = &t->p2u_free[t->p2u_next];
+    double start;
+
+    if (model.data_mode & FX3_DATA_SOURCE)
+    {
+        t->cpu_p2u = max2(*slot, t->cpu_p2u) + MODEL_MANUAL_NS * 1e-9;
+        start = t->cpu_p2u;
+    }
+    else
+    {
+        start = max2(max2(ready, t->gpif_wr), *slot);
+        t->gpif_wr = start + gpif_time(bytes);
+        start = commit(t->gpif_wr, &t->cpu_p2u, bytes);
+    }
+    start = max2(max2(start, t->usb_in), host);
+    t->usb_in = start + usb_time(bytes);
+    *slot = t->usb_in;
+    t->p2u_next = (t->p2u_next + 1) % model.cfg.count_p2u;
+    return t->usb_in;
+}
+
+/* U2P path: bytes sent by the host from host on go through the next U2P buffer
+ * to the FPGA. Returns the time of the last packet; *fpga is the time the FPGA
+ * has read the buffer. */
+static double model_u2p(double host, unsigned bytes, double *fpga)
+{
+    model_timing *t = &model.t;
+    double *slot = &t->u2p_free[t->u2p_next];
+    double start;
+
+    start = max2(max2(host, t->usb_out), *slot);
+    t->usb_out = start + usb_time(bytes);
+    if (model.data_mode & FX3_DATA_SINK)
+    {
+        t->cpu_u2p = max2(t->usb_out, t->cpu_u2p) + MODEL_MANUAL_NS * 1e-9;
+        *fpga = t->cpu_u2p;
+    }
+    else
+    {
+        start = max2(commit(t->usb_out, &t->cpu_u2p, bytes), t->gpif_rd);
+        t->gpif_rd = start + gpif_time(bytes);
+        *fpga = t->gpif_rd;
+    }
+    *slot = *fpga;
+    t->u2p_next = (t->u2p_next + 1) % model.cfg.count_u2p;
+    return t->usb_out;
+}
+
+static void fifo_clear(void)
+{
+    model_chunk *c;
+
+    while ((c = model.fifo_head) != NULL)
+    {
+        model.fifo_head = c->next;
+        free(c);
+    }
+    model.fifo_tail = NULL;
+}
+
+/* The channels are re-created: all buffers are empty and free from now on. */
+static int timing_reset(void)
+{
+    model_timing *t = &model.t;
+    double now = fx3_now();
+    unsigned i;
+
+    free(t->p2u_free);
+    free(t->u2p_free);
+    memset(t, 0, sizeof(*t));
+    t->p2u_free = calloc(model.cfg.count_p2u, sizeof(double));
+    t->u2p_free = calloc(model.cfg.count_u2p, sizeof(double));
+    if ((t->p2u_free == NULL) || (t->u2p_free == NULL))
+        return -1;
+
+    for (i = 0; i < model.cfg.count_p2u; i++)
+        t->p2u_free[i] = now;
+    for (i = 0; i < model.cfg.count_u2p; i++)
+        t->u2p_free[i] = now;
+    t->gpif_rd = t->gpif_wr = t->cpu_p2u = t->cpu_u2p = t->usb_in = t->usb_out = now;
+    model.source_state = 0;
+    fifo_clear();
+    return 0;
+}
+
+static void state_save(void)
+{
+    const char *path = getenv("FX3_MODEL_STATE");
+    FILE *f;
+
+    if ((path == NULL) || ((f = fopen(path, "w")) == NULL))
+        return;
+    fprintf(f, "%u %u %u %u %u %u %u %u %u\n", model.cfg.buf_size, model.cfg.count_p2u,
+            model.cfg.count_u2p, model.cfg.profile, model.cfg.manual, model.cfg.burst,
+            model.worker_cost, model.data_mode, model.source_pattern);
+    fclose(f);
+}
+
+static void state_load(void)
+{
+    const char *path = getenv("FX3_MODEL_STATE");
+    unsigned v[9];
+    FILE *f;
+
+    if ((path == NULL) || ((f = fopen(path, "r")) == NULL))
+        return;
+    if (fscanf(f, "%u %u %u %u %u %u %u %u %u", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5],
+            &v[6], &v[7], &v[8]) == 9)
+    {
+        model.cfg.buf_size = (uint16_t) v[0];
+        model.cfg.count_p2u = (uint8_t) v[1];
+        model.cfg.count_u2p = (uint8_t) v[2];
+        model.cfg.profile = (uint8_t) v[3];
+        model.cfg.manual = (uint8_t) v[4];
+        model.cfg.burst = (uint8_t) v[5];
+        model.worker_cost = v[6];
+        model.data_mode = v[7];
+        model.source_pattern = v[8];
+    }
+    fclose(f);
+}
+
+/* Geometry check of CyFxSlFifoApplnSetDmaConfig. */
+static int model_set_geometry(uint16_t buf_size, uint16_t count_p2u, uint16_t count_u2p)
+{
+    if (fx3_dma_geometry_fits(buf_size, model.cfg.pkt_size, count_p2u, count_u2p) != 0)
+        return -1;
+
+    model.cfg.buf_size = buf_size;
+    model.cfg.count_p2u = (uint8_t) count_p2u;
+    model.cfg.count_u2p = (uint8_t) count_u2p;
+    return 0;
+}
+
+/* The STREAM profile gets as many P2U buffers as fit, like the firmware. */
+static int model_set_profile(uint16_t profile, uint16_t manual)
+{
+    unsigned count_p2u;
+
+    if (profile > FX3_PROFILE_LOOPBACK)
+        return -1;
+    if (profile == FX3_PROFILE_LOOPBACK)
+    {
+        if (model_set_geometry(FX3_LOOPBACK_BUF_SIZE, FX3_LOOPBACK_COUNT_P2U,
+                FX3_LOOPBACK_COUNT_U2P) != 0)
+            return -1;
+    }
+    else
+    {
+        count_p2u = fx3_dma_max_count_p2u(FX3_STREAM_BUF_SIZE * model.cfg.pkt_size,
+                FX3_STREAM_COUNT_U2P);
+        if (model_set_geometry(FX3_STREAM_BUF_SIZE, (uint16_t) count_p2u,
+                FX3_STREAM_COUNT_U2P) != 0)
+            return -1;
+    }
+
+    model.cfg.profile = (uint8_t) profile;
+    model.cfg.manual = (manual != 0) ? FX3_DMA_MANUAL : FX3_DMA_AUTO;
+    model.cfg.burst = (profile == FX3_PROFILE_LOOPBACK) ? 1 : MODEL_MAX_BURST;
+    return 0;
+}
+
+/* Argument check of CyFxSlFifoApplnSetDataMode. */
+static int model_set_data_mode(uint16_t mode, uint16_t pattern)
+{
+    if ((mode & ~(FX3_DATA_SOURCE | FX3_DATA_SINK)) || (pattern > FX3_SOURCE_COUNTER))
+        return -1;
+    model.data_mode = mode;
+    model.source_pattern = pattern;
+    return 0;
+}
+
+static int model_set_burst(uint16_t burst)
+{
+    if (burst > MODEL_MAX_BURST)
+        return -1;
+    if (burst == 0)
+        burst = (model.cfg.profile == FX3_PROFILE_LOOPBACK) ? 1 : MODEL_MAX_BURST;
+    model.cfg.burst = (uint8_t) burst;
+    return 0;
+}
+
+/* Try to give the oldest IN transfers their data in the LOOPBACK profile. A
+ * transfer is done when it is full or has taken a short packet. */
+static void loopback_schedule(void)
+{
+    model_xfer *x;
+    model_chunk *c;
+    unsigned n;
+    int done;
+
+    for (x = model.in_head; x != NULL; x = x->next)
+    {
+        if ((x->due != 0) || x->cancelled)
+            continue;
+
+        done = 0;
+        while (!done && ((c = model.fifo_head) != NULL))
+        {
+            if (c->sent == 0)
+                c->sent = model_p2u(c->ready, x->submitted, c->len);
+            n = c->len - c->offset;
+            if (n > (unsigned) (x->xfer.length - x->xfer.actual_length))
+                n = (unsigned) (x->xfer.length - x->xfer.actual_length);
+            memcpy(x->xfer.buffer + x->xfer.actual_length, c->data + c->offset, n);
+            x->xfer.actual_length += (int) n;
+            x->last = max2(x->last, c->sent);
+            c->offset += n;
+
+            if (c->offset == c->len)
+            {
+                done = (c->len % model.cfg.pkt_size) != 0;
+                model.fifo_head = c->next;
+                if (model.fifo_head == NULL)
+                    model.fifo_tail = NULL;
+                free(c);
+            }
+            if (x->xfer.actual_length == x->xfer.length)
+                done = 1;
+        }
+
+        if (!done)
+            return;
+        x->due = max2(x->last + host_delay(), model.in_due);
+        model.in_due = x->due;
+    }
+}
+
+static int schedule_in(model_xfer *x)
+{
+    unsigned bytes = buf_bytes();
+    unsigned n;
+    int offset;
+    uint32_t state = FX3_PATTERN_MW;
+
+    if ((model.cfg.profile == FX3_PROFILE_LOOPBACK) && !(model.data_mode & FX3_DATA_SOURCE))
+    {
+        loopback_schedule();
+        return 0;
+    }
+
+    /* STREAM: the FPGA always has data, the "MW" word. The CPU source always
+     * has its pattern, filled in on completion. */
+    for (offset = 0; offset < x->xfer.length; offset += (int) n)
+    {
+        n = (unsigned) (x->xfer.length - offset);
+        if (n > bytes)
+            n = bytes;
+        x->last = model_p2u(0, x->submitted, n);
+    }
+    if (!(model.data_mode & FX3_DATA_SOURCE))
+        fx3_pattern_fill(FX3_PATTERN_CONSTANT, FX3_PATTERN_MW, &state, x->xfer.buffer,
+                (size_t) x->xfer.length);
+    x->xfer.actual_length = x->xfer.length;
+    x->due = max2(x->last + host_delay(), model.in_due);
+    model.in_due = x->due;
+    return 0;
+}
+
+static int schedule_out(model_xfer *x)
+{
+    unsigned bytes = buf_bytes();
+    model_chunk *c;
+    double fpga;
+    unsigned n;
+    int offset;
+
+    for (offset = 0; offset < x->xfer.length; offset += (int) n)
+    {
+        n = (unsigned) (x->xfer.length - offset);
+        if (n > bytes)
+            n = bytes;
+        x->last = model_u2p(x->submitted, n, &fpga);
+
+        if ((model.cfg.profile != FX3_PROFILE_LOOPBACK) || (model.data_mode & FX3_DATA_SINK))
+            continue;
+        c = malloc(sizeof(*c) + n);
+        if (c == NULL)
+            return LIBUSB_ERROR_NO_MEM;
+        c->next = NULL;
+        c->ready = fpga;
+        c->sent = 0;
+        c->len = n;
+        c->offset = 0;
+        memcpy(c->data, x->xfer.buffer + offset, n);
+        if (model.fifo_tail != NULL)
+            model.fifo_tail->next = c;
+        else
+            model.fifo_head = c;
+        model.fifo_tail = c;
+    }
+
+    x->xfer.actual_length = x->xfer.length;
+    x->due = max2(x->last + host_delay(), model.out_due);
+    model.out_due = x->due;
+
+    if ((model.cfg.profile == FX3_PROFILE_LOOPBACK) && !(model.data_mode & FX3_DATA_SOURCE))
+        loopback_schedule();
+    return 0;
+}
+
+/* Time at which x completes, 0 if not known yet. */
+static double event_time(const model_xfer *x)
+{
+    if (x->cancelled)
+        return x->submitted;
+    if (x->due != 0)
+        return x->due;
+    if (x->xfer.timeout != 0)
+        return x->submitted + x->xfer.timeout * 1e-3;
+    return 0;
+}
+
+static model_xfer *next_event(double *when)
+{
+    model_xfer *lists[2] = { model.in_head, model.out_head };
+    model_xfer *best = NULL;
+    model_xfer *x;
+    double t;
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        for (x = lists[i]; x != NULL; x = x->next)
+        {
+            t = event_time(x);
+            if ((t != 0) && ((best == NULL) || (t < *when)))
+            {
+                best = x;
+                *when = t;
+            }
+        }
+    }
+    return best;
+}
+
+static void unlink_xfer(model_xfer *x)
+{
+    int is_in = (x->xfer.endpoint & LIBUSB_ENDPOINT_IN) != 0;
+    model_xfer **head = is_in ? &model.in_head : &model.out_head;
+    model_xfer **tail = is_in ? &model.in_tail : &model.out_tail;
+    model_xfer *prev = NULL;
+    model_xfer *p;
+
+    for (p = *head; (p != NULL) && (p != x); p = p->next)
+        prev = p;
+    if (p == NULL)
+        return;
+    if (prev != NULL)
+        prev->next = x->next;
+    else
+        *head = x->next;
+    if (*tail == x)
+        *tail = prev;
+    x->next = NULL;
+}
+
+static void complete(model_xfer *x)
+{
+    struct libusb_transfer *xfer = &x->xfer;
+    int source = (xfer->endpoint & LIBUSB_ENDPOINT_IN) && (model.data_mode & FX3_DATA_SOURCE);
+    uint32_t state = FX3_PATTERN_MW;
+
+    unlink_xfer(x);
+    if (x->cancelled)
+    {
+        xfer->status = LIBUSB_TRANSFER_CANCELLED;
+        /* The source pattern continues with the data the host received; a
+         * cancelled transfer leaves its data on the device. */
+        if (source)
+            xfer->actual_length = 0;
+    }
+    else if (x->due != 0)
+    {
+        xfer->status = LIBUSB_TRANSFER_COMPLETED;
+        if (source)
+        {
+            if (model.source_pattern == FX3_SOURCE_COUNTER)
+                fx3_pattern_fill(FX3_PATTERN_COUNTER, 0, &model.source_state, xfer->buffer,
+                        (size_t) xfer->actual_length);
+            else
+                fx3_pattern_fill(FX3_PATTERN_CONSTANT, FX3_PATTERN_MW, &state, xfer->buffer,
+                        (size_t) xfer->actual_length);
+        }
+    }
+    else
+        xfer->status = LIBUSB_TRANSFER_TIMED_OUT;
+
+    xfer->callback(xfer);
+}
+
+static void wait_until(double when)
+{
+    struct timespec ts;
+    double sleep_to = when - MODEL_SPIN_NS * 1e-9;
+
+    if (sleep_to > fx3_now())
+    {
+        ts.tv_sec = (time_t) sleep_to;
+        ts.tv_nsec = (long) ((sleep_to - ts.tv_sec) * 1e9);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+    while (fx3_now() < when)
+        ;
+}
+
+int LIBUSB_CALL libusb_init(libusb_context **ctx)
+{
+    memset(&model, 0, sizeof(model));
+    model.rng = 0x12345678;
+    model.cfg.pkt_size = MODEL_PKT_SIZE;
+    model.cfg.heap_kb = FX3_HEAP_KB;
+    model_set_profile(FX3_PROFILE_STREAM, FX3_DMA_MANUAL);
+    state_load();
+    if (timing_reset() != 0)
+        return LIBUSB_ERROR_NO_MEM;
+
+    if (ctx != NULL)
+        *ctx = &model_ctx;
+    return 0;
+}
+
+void LIBUSB_CALL libusb_exit(libusb_context *ctx)
+{
+    (void) ctx;
+    fifo_clear();
+    free(model.t.p2u_free);
+    free(model.t.u2p_free);
+    model.t.p2u_free = model.t.u2p_free = NULL;
+}
+
+libusb_device_handle * LIBUSB_CALL libusb_open_device_with_vid_pid(libusb_context *ctx,
+        uint16_t vendor_id, uint16_t product_id)
+{
+    (void) ctx;
+    if ((vendor_id != FX3_VID) || (product_id != FX3_PID))
+        return NULL;
+    return &model_handle;
+}
+
+void LIBUSB_CALL libusb_close(libusb_device_handle *dev)
+{
+    (void) dev;
+}
+
+libusb_device * LIBUSB_CALL libusb_get_device(libusb_device_handle *dev)
+{
+    (void) dev;
+    return &model_dev;
+}
+
+int LIBUSB_CALL libusb_set_auto_detach_kernel_driver(libusb_device_handle *dev, int enable)
+{
+    (void) dev;
+    (void) enable;
+    return 0;
+}
+
+int LIBUSB_CALL libusb_claim_interface(libusb_device_handle *dev, int interface_number)
+{
+    (void) dev;
+    return (interface_number == FX3_INTERFACE) ? 0 : LIBUSB_ERROR_NOT_FOUND;
+}
+
+int LIBUSB_CALL libusb_release_interface(libusb_device_handle *dev, int interface_number)
+{
+    (void) dev;
+    (void) interface_number;
+    return 0;
+}
+
+/* No descriptors: fx3_find_endpoints falls back to the FX3 addresses. */
+int LIBUSB_CALL libusb_get_active_config_descriptor(libusb_device *dev,
+        struct libusb_config_descriptor **config)
+{
+    (void) dev;
+    (void) config;
+    return LIBUSB_ERROR_NOT_SUPPORTED;
+}
+
+void LIBUSB_CALL libusb_free_config_descriptor(struct libusb_config_descriptor *config)
+{
+    (void) config;
+}
+
+unsigned char * LIBUSB_CALL libusb_dev_mem_alloc(libusb_device_handle *dev, size_t length)
+{
+    (void) dev;
+    (void) length;
+    return NULL;
+}
+
+/* Never called: the model hands out no dev_mem buffers. */
+int LIBUSB_CALL libusb_dev_mem_free(libusb_device_handle *dev, unsigned char *buffer, size_t length)
+{
+    (void) dev;
+    (void) buffer;
+    (void) length;
+    return LIBUSB_ERROR_NOT_SUPPORTED;
+}
+
+/* The vendor requests that change the configuration re-create the channels,
+ * which drops whatever the loopback FPGA still holds. */
+int LIBUSB_CALL libusb_control_transfer(libusb_device_handle *dev, uint8_t request_type,
+        uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned char *data,
+        uint16_t wLength, unsigned int timeout)
+{
+    uint8_t buf[FX3_DMA_CONFIG_LEN];
+    int is_in = (request_type & LIBUSB_ENDPOINT_IN) != 0;
+    int status = 0;
+    int len = 0;
+
+    (void) dev;
+    (void) timeout;
+    if ((request_type & (0x03 << 5)) != LIBUSB_REQUEST_TYPE_VENDOR)
+        return LIBUSB_ERROR_PIPE;
+
+    switch (bRequest)
+    {
+    case FX3_RQT_SET_DMA_CONFIG:
+        status = model_set_geometry(wValue, wIndex & 0xFF, wIndex >> 8);
+        break;
+    case FX3_RQT_GET_DMA_CONFIG:
+        buf[0] = model.cfg.buf_size & 0xFF;
+        buf[1] = model.cfg.buf_size >> 8;
+        buf[2] = model.cfg.pkt_size & 0xFF;
+        buf[3] = model.cfg.pkt_size >> 8;
+        buf[4] = model.cfg.count_p2u;
+        buf[5] = model.cfg.count_u2p;
+        buf[6] = FX3_HEAP_KB & 0xFF;
+        buf[7] = FX3_HEAP_KB >> 8;
+        buf[8] = model.cfg.profile;
+        buf[9] = model.cfg.manual;
+        buf[10] = model.cfg.burst;
+        len = (wLength < sizeof(buf)) ? wLength : (int) sizeof(buf);
+        memcpy(data, buf, len);
+        break;
+    case FX3_RQT_SET_PROFILE:
+        status = model_set_profile(wValue, wIndex);
+        break;
+    case FX3_RQT_SET_BURST_LENGTH:
+        status = model_set_burst(wValue);
+        break;
+    case FX3_RQT_SET_WORKER_COST:
+        model.worker_cost = wValue;
+        break;
+    case FX3_RQT_SET_DATA_MODE:
+        status = model_set_data_mode(wValue, wIndex);
+        break;
+    case FX3_RQT_SET_P2U_FRAMING:
+    case FX3_RQT_SET_WRAPUP_TIMEOUT:
+    case FX3_RQT_SET_TRACE_MASK:
+    case FX3_RQT_SET_CRC_CHECK:
+        break;
+    default:
+        return LIBUSB_ERROR_PIPE;
+    }
+
+    if (status != 0)
+        return LIBUSB_ERROR_PIPE;
+    if (!is_in)
+    {
+        state_save();
+        if (timing_reset() != 0)
+            return LIBUSB_ERROR_NO_MEM;
+    }
+    return len;
+}
+
+const char * LIBUSB_CALL libusb_error_name(int errcode)
+{
+    switch (errcode)
+    {
+    case LIBUSB_SUCCESS:                return "LIBUSB_SUCCESS";
+    case LIBUSB_ERROR_IO:               return "LIBUSB_ERROR_IO";
+    case LIBUSB_ERROR_INVALID_PARAM:    return "LIBUSB_ERROR_INVALID_PARAM";
+    case LIBUSB_ERROR_NOT_FOUND:        return "LIBUSB_ERROR_NOT_FOUND";
+    case LIBUSB_ERROR_PIPE:             return "LIBUSB_ERROR_PIPE";
+    case LIBUSB_ERROR_NO_MEM:           return "LIBUSB_ERROR_NO_MEM";
+    case LIBUSB_ERROR_NOT_SUPPORTED:    return "LIBUSB_ERROR_NOT_SUPPORTED";
+    default:                            return "LIBUSB_ERROR_OTHER";
+    }
+}
+
+struct libusb_transfer * LIBUSB_CALL libusb_alloc_transfer(int iso_packets)
+{
+    model_xfer *x;
+
+    x = calloc(1, sizeof(*x) + iso_packets * sizeof(struct libusb_iso_packet_descriptor));
+    if (x == NULL)
+        return NULL;
+    x->xfer.num_iso_packets = iso_packets;
+    return &x->xfer;
+}
+
+void LIBUSB_CALL libusb_free_transfer(struct libusb_transfer *transfer)
+{
+    if (transfer == NULL)
+        return;
+    if (transfer->flags & LIBUSB_TRANSFER_FREE_BUFFER)
+        free(transfer->buffer);
+    free(MODEL_XFER(transfer));
+}
+
+int LIBUSB_CALL libusb_submit_transfer(struct libusb_transfer *transfer)
+{
+    model_xfer *x = MODEL_XFER(transfer);
+    int is_in = (transfer->endpoint & LIBUSB_ENDPOINT_IN) != 0;
+
+    if ((transfer->endpoint != (is_in ? FX3_EP_IN : FX3_EP_OUT))
+            || (transfer->type != LIBUSB_TRANSFER_TYPE_BULK))
+        return LIBUSB_ERROR_NOT_FOUND;
+
+    x->next = NULL;
+    x->submitted = fx3_now();
+    x->due = 0;
+    x->last = 0;
+    x->cancelled = 0;
+    transfer->actual_length = 0;
+
+    if (is_in)
+    {
+        if (model.in_tail != NULL)
+            model.in_tail->next = x;
+        else
+            model.in_head = x;
+        model.in_tail = x;
+        return schedule_in(x);
+    }
+
+    if (model.out_tail != NULL)
+        model.out_tail->next = x;
+    else
+        model.out_head = x;
+    model.out_tail = x;
+    return schedule_out(x);
+}
+
+int LIBUSB_CALL libusb_cancel_transfer(struct libusb_transfer *transfer)
+{
+    model_xfer *x = MODEL_XFER(transfer);
+    model_xfer *p;
+
+    for (p = model.in_head; p != NULL; p = p->next)
+        if (p == x)
+            break;
+    if (p == NULL)
+        for (p = model.out_head; p != NULL; p = p->next)
+            if (p == x)
+                break;
+    if ((p == NULL) || x->cancelled)
+        return LIBUSB_ERROR_NOT_FOUND;
+
+    x->cancelled = 1;
+    x->submitted = fx3_now();
+    return 0;
+}
+
+/* Run the callbacks of the transfers that are due until tv has passed, or
+ * return after the first batch of completions. */
+int LIBUSB_CALL libusb_handle_events_timeout_completed(libusb_context *ctx,
+        struct timeval *tv, int *completed)
+{
+    double deadline = fx3_now() + tv->tv_sec + tv->tv_usec * 1e-6;
+    model_xfer *x;
+    double when = 0;
+
+    (void) ctx;
+    if ((completed != NULL) && *completed)
+        return 0;
+
+    x = next_event(&when);
+    if ((x == NULL) || (when > deadline))
+    {
+        wait_until(deadline);
+        return 0;
+    }
+
+    wait_until(when);
+    while (((x = next_event(&when)) != NULL) && (when <= fx3_now()))
+    {
+        complete(x);
+        if ((completed != NULL) && *completed)
+            break;
+    }
+    return 0;
+}
+
+int LIBUSB_CALL libusb_handle_events(libusb_context *ctx)
+{
+    struct timeval tv = { 60, 0 };
+
+    if ((model.in_head == NULL) && (model.out_head == NULL))
+        return 0;
+    return libusb_handle_events_timeout_completed(ctx, &tv, NULL);
+}
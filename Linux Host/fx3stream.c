@@ -0,0 +1,375 @@
+/*
+ ## fx3stream: asynchronous bulk streaming client for the FX3 slave FIFO firmware
+ ## ===========================
+ ##
+ ##  Keeps a queue of libusb asynchronous transfers in flight on the P2U (0x81)
+ ##  and/or U2P (0x01) bulk endpoint and reports the sustained rate in MB/s
+ ##  (10^6 bytes per second), once per interval and averaged over the whole run.
+ ##
+ ##  Usage: fx3stream [-d in|out|both] [-q depth] [-b buffers] [-s bytes]
+ ##                   [-t seconds] [-i interval_ms] [-v pattern] [-f]
+ ##
+ ##  -q  transfers queued per endpoint (default 16)
+ ##  -b  transfer size in DMA buffers (default 4); the buffer size is read from
+ ##      the device with GET_DMA_CONFIG, so a transfer always ends on a buffer
+ ##      boundary of the firmware
+ ##  -s  transfer size in bytes, overrides -b; must be a multiple of 1024
+ ##  -v  check the IN data against a pattern of fx3verify.h (constant for the
+ ##      "MW" word, counter, prbs31)
+ ##  -f  the IN stream is framed (fx3config -f on): parse the frame headers,
+ ##      report lost, reordered and discontinuous frames and the device time
+ ##      between frames, and check only the payload with -v
+ ##
+ ##  The OUT data is the FPGA "MW" word 0x574D repeated, the same as the
+ ##  512B.txt/1024B.txt test files.
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include "fx3host.h"
+#include "fx3verify.h"
+#include "fx3frame.h"
+
+#define STREAM_TIMEOUT          (1000)      /* Transfer timeout in ms */
+#define STREAM_PATTERN          (0x574D)    /* "MW" */
+
+static volatile sig_atomic_t stop = 0;
+
+typedef struct stream_dir
+{
+    const char *name;
+    unsigned char endpoint;
+    struct libusb_transfer **xfers;
+    unsigned char *dev_mem;     /* Per transfer: 1 if the buffer is from libusb_dev_mem_alloc */
+    int active;                 /* Transfers submitted and not yet returned */
+    unsigned long long bytes;   /* Bytes moved since the start */
+    unsigned long long last_bytes;
+    unsigned long timeouts;
+    int error;                  /* First fatal transfer status, 0 if none */
+    fx3_verifier *verify;       /* IN data check, NULL if off */
+    fx3_frame_parser *frames;   /* IN frame headers, NULL if not framed */
+} stream_dir;
+
+static void on_signal(int sig)
+{
+    (void) sig;
+    stop = 1;
+}
+
+static void LIBUSB_CALL stream_callback(struct libusb_transfer *xfer)
+{
+    stream_dir *dir = (stream_dir *) xfer->user_data;
+
+    dir->bytes += xfer->actual_length;
+    if (dir->frames != NULL)
+        fx3_frame_parse(dir->frames, xfer->buffer, xfer->actual_length);
+    else if (dir->verify != NULL)
+        fx3_verify(dir->verify, xfer->buffer, xfer->actual_length);
+
+    switch (xfer->status)
+    {
+    case LIBUSB_TRANSFER_COMPLETED:
+        break;
+    case LIBUSB_TRANSFER_TIMED_OUT:
+        /* The device did not keep up; whatever was moved is still counted. */
+        dir->timeouts++;
+        break;
+    case LIBUSB_TRANSFER_CANCELLED:
+        dir->active--;
+        return;
+    default:
+        if (dir->error == 0)
+            dir->error = xfer->status;
+        stop = 1;
+        dir->active--;
+        return;
+    }
+
+    if (stop || (libusb_submit_transfer(xfer) != 0))
+        dir->active--;
+}
+
+/* The transfers must no longer be active, and the device must still be open
+ * for the dev_mem buffers to be released. A transfer that never got its
+ * buffer still has a NULL one from libusb_alloc_transfer. */
+static void stream_free(stream_dir *dir, int depth)
+{
+    struct libusb_transfer *xfer;
+    int i;
+
+    if (dir->xfers != NULL)
+    {
+        for (i = 0; i < depth; i++)
+        {
+            xfer = dir->xfers[i];
+            if (xfer == NULL)
+                continue;
+            if ((xfer->buffer != NULL) && dir->dev_mem[i])
+                libusb_dev_mem_free(xfer->dev_handle, xfer->buffer, xfer->length);
+            else
+                free(xfer->buffer);
+            libusb_free_transfer(xfer);
+        }
+    }
+    free(dir->xfers);
+    free(dir->dev_mem);
+    dir->xfers = NULL;
+    dir->dev_mem = NULL;
+}
+
+/* Allocate and submit depth transfers of length bytes. The buffers come from
+ * libusb_dev_mem_alloc where the kernel supports it, so usbfs does not copy
+ * the data; otherwise from the heap. */
+static int stream_start(libusb_device_handle *dev, stream_dir *dir, int depth, int length)
+{
+    unsigned char *buf;
+    uint16_t *word;
+    int i, j, status;
+
+    dir->xfers = calloc(depth, sizeof(*dir->xfers));
+    dir->dev_mem = calloc(depth, sizeof(*dir->dev_mem));
+    if ((dir->xfers == NULL) || (dir->dev_mem == NULL))
+    {
+        stream_free(dir, 0);
+        return LIBUSB_ERROR_NO_MEM;
+    }
+
+    for (i = 0; i < depth; i++)
+    {
+        dir->xfers[i] = libusb_alloc_transfer(0);
+        if (dir->xfers[i] == NULL)
+            return LIBUSB_ERROR_NO_MEM;
+        buf = libusb_dev_mem_alloc(dev, length);
+        dir->dev_mem[i] = (buf != NULL);
+        if (buf == NULL)
+            buf = malloc(length);
+        if (buf == NULL)
+            return LIBUSB_ERROR_NO_MEM;
+
+        if ((dir->endpoint & LIBUSB_ENDPOINT_IN) == 0)
+        {
+            word = (uint16_t *) buf;
+            for (j = 0; j < length / 2; j++)
+                word[j] = STREAM_PATTERN;
+        }
+
+        libusb_fill_bulk_transfer(dir->xfers[i], dev, dir->endpoint, buf, length,
+                stream_callback, dir, STREAM_TIMEOUT);
+    }
+
+    for (i = 0; i < depth; i++)
+    {
+        status = libusb_submit_transfer(dir->xfers[i]);
+        if (status != 0)
+            return status;
+        dir->active++;
+    }
+
+    return 0;
+}
+
+static void stream_cancel(stream_dir *dir, int depth)
+{
+    int i;
+
+    if (dir->xfers == NULL)
+        return;
+    for (i = 0; i < depth; i++)
+        if (dir->xfers[i] != NULL)
+            libusb_cancel_transfer(dir->xfers[i]);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-d in|out|both] [-q depth] [-b buffers] [-s bytes]\n"
+            "       %*s [-t seconds] [-i interval_ms] [-v pattern] [-f]\n", prog, (int) strlen(prog), "");
+}
+
+int main(int argc, char **argv)
+{
+    libusb_context *ctx = NULL;
+    libusb_device_handle *dev;
+    stream_dir dirs[2];
+    fx3_verifier verify;
+    fx3_frame_parser frames;
+    int pattern = -1, framed = 0;
+    struct timeval tv;
+    int use_in = 1, use_out = 0;
+    int depth = 16, buffers = 4, length = 0;
+    unsigned seconds = 0, interval = 1000;
+    unsigned buf_bytes;
+    double start, last, now;
+    int opt, i, status = 0;
+
+    while ((opt = getopt(argc, argv, "d:q:b:s:t:i:v:f")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            use_in = (strcmp(optarg, "in") == 0) || (strcmp(optarg, "both") == 0);
+            use_out = (strcmp(optarg, "out") == 0) || (strcmp(optarg, "both") == 0);
+            if (!use_in && !use_out)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'q':
+            depth = atoi(optarg);
+            break;
+        case 'b':
+            buffers = atoi(optarg);
+            break;
+        case 's':
+            length = atoi(optarg);
+            break;
+        case 't':
+            seconds = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 'i':
+            interval = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 'v':
+            pattern = fx3_pattern_parse(optarg);
+            if (pattern < 0)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'f':
+            framed = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if ((depth <= 0) || (buffers <= 0) || (length < 0) || ((length % 1024) != 0) || (interval == 0))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (libusb_init(&ctx) != 0)
+        return 1;
+    dev = fx3_open(ctx);
+    if (dev == NULL)
+    {
+        libusb_exit(ctx);
+        return 1;
+    }
+
+    buf_bytes = fx3_dma_buf_bytes(dev);
+    if (length == 0)
+        length = buffers * buf_bytes;
+    else if ((length % buf_bytes) != 0)
+        fprintf(stderr, "Warning: %d bytes is not a multiple of the %u byte DMA buffer\n",
+                length, buf_bytes);
+
+    memset(dirs, 0, sizeof(dirs));
+    dirs[0].name = "in";
+    dirs[1].name = "out";
+    fx3_find_endpoints(dev, &dirs[0].endpoint, &dirs[1].endpoint);
+    if (pattern >= 0)
+    {
+        fx3_verify_init(&verify, pattern, FX3_PATTERN_MW);
+        dirs[0].verify = &verify;
+    }
+    if (framed)
+    {
+        fx3_frame_init(&frames, dirs[0].verify);
+        dirs[0].frames = &frames;
+    }
+
+    printf("DMA buffer %u bytes, %d transfers of %d bytes queued on 0x%02x/0x%02x\n",
+            buf_bytes, depth, length, dirs[0].endpoint, dirs[1].endpoint);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    for (i = 0; i < 2; i++)
+    {
+        if (((i == 0) && !use_in) || ((i == 1) && !use_out))
+            continue;
+        status = stream_start(dev, &dirs[i], depth, length);
+        if (status != 0)
+        {
+            fprintf(stderr, "Starting the %s transfers failed: %s\n", dirs[i].name,
+                    libusb_error_name(status));
+            stop = 1;
+            break;
+        }
+    }
+
+    start = last = fx3_now();
+    while (!stop)
+    {
+        tv.tv_sec = 0;
+        tv.tv_usec = 100000;
+        libusb_handle_events_timeout_completed(ctx, &tv, NULL);
+
+        now = fx3_now();
+        if ((seconds != 0) && (now - start >= seconds))
+            stop = 1;
+        if ((now - last) * 1000 < interval)
+            continue;
+
+        printf("%8.1f s", now - start);
+        for (i = 0; i < 2; i++)
+        {
+            if (dirs[i].xfers == NULL)
+                continue;
+            printf("  %s %8.2f MB/s", dirs[i].name,
+                    (dirs[i].bytes - dirs[i].last_bytes) / (now - last) / 1e6);
+            dirs[i].last_bytes = dirs[i].bytes;
+        }
+        printf("\n");
+        fflush(stdout);
+        last = now;
+    }
+
+    /* Drain the queue before the buffers go away. */
+    now = fx3_now();
+    stream_cancel(&dirs[0], depth);
+    stream_cancel(&dirs[1], depth);
+    while ((dirs[0].active > 0) || (dirs[1].active > 0))
+        libusb_handle_events(ctx);
+
+    for (i = 0; i < 2; i++)
+    {
+        if (dirs[i].xfers == NULL)
+            continue;
+        printf("%s: %llu bytes in %.2f s, %.2f MB/s, %lu timeouts\n", dirs[i].name,
+                dirs[i].bytes, now - start, dirs[i].bytes / (now - start) / 1e6, dirs[i].timeouts);
+        if (dirs[i].verify != NULL)
+        {
+            printf("%s: %llu pattern errors", dirs[i].name, verify.errors);
+            if (verify.errors != 0)
+                printf(", first at byte %llu: expected 0x%08x, got 0x%08x", verify.first_offset,
+                        verify.first_expected, verify.first_actual);
+            printf("\n");
+        }
+        if (dirs[i].frames != NULL)
+        {
+            fx3_frame_print(&frames, dirs[i].name);
+            if (fx3_frame_errors(&frames))
+                status = 1;
+        }
+        if (dirs[i].error != 0)
+        {
+            fprintf(stderr, "%s: transfer failed with status %d\n", dirs[i].name, dirs[i].error);
+            status = 1;
+        }
+        stream_free(&dirs[i], depth);
+    }
+
+    fx3_close(dev);
+    libusb_exit(ctx);
+    return (status != 0) ? 1 : 0;
+}
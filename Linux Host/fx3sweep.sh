@@ -0,0 +1,268 @@
+#!/bin/sh
+#
+# Measure every combination of a set of DMA configurations:
+#
+#   ./fx3sweep.sh [-M] [-T both|throughput|latency] [-t seconds] [-n probes]
+#                 [-S sizes] [-P p2u_counts] [-U u2p_counts] [-B bursts]
+#                 [-C channel_types] [-W worker_costs] [-D data_modes]
+#                 [-V pattern] [-o prefix]
+#
+# Each combination of buffer size (in packets), P2U and U2P buffer count,
+# burst length, channel type (auto, manual) and, with -W, worker cost
+# (CyFxSlFifoProcessBuffer passes per buffer) is set at runtime with
+# fx3config, so the firmware is neither rebuilt nor reloaded, and measured
+# with fx3stream (IN throughput in the STREAM profile) and fx3latency (round
+# trips of one DMA buffer in the LOOPBACK profile). Combinations the device
+# refuses, usually because they do not fit into the DMA buffer heap, are
+# recorded as rejected.
+#
+# The worker cost only changes MANUAL channels and needs a firmware built with
+# CY_FX_SLFIFO_DEFERRED_PROCESSING; other firmware rejects every row of a -W
+# sweep. Without -W the cost is left as it is and recorded as empty.
+#
+# -D sweeps the data mode of fx3config -d (gpif, source, sink, source+sink).
+# The USB link test modes replace the GPIF side of EP 1 by a CPU source or
+# sink, so they measure the link without the FPGA: the throughput is that of
+# OUT in sink mode and of IN otherwise, the source data is checked against
+# the -V pattern (constant or counter, default constant) and a row with
+# pattern errors is recorded as error. The latency test needs the FPGA
+# loopback and only runs in gpif mode. After a -D sweep the device is set back
+# to gpif mode. Without -D the data mode is left as it is and recorded as gpif.
+#
+# The matrix goes to prefix.csv and prefix.json (default prefix: fx3sweep).
+# The Pareto frontier over throughput (higher is better), p99 round trip and
+# buffer memory (lower is better), taken per data mode, is printed and written
+# to prefix.pareto.csv.
+# A -W sweep also prints the best throughput measured at each worker cost.
+#
+# -M runs the fx3xxx-model binaries ("make model") against the device model
+# of fx3model.c; without it the same sweep runs against the FX3. The stream
+# and loopback FPGA images differ, so on hardware run the throughput and the
+# latency sweep separately with -T and the matching image.
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+SUFFIX=
+TESTS=both
+DURATION=1
+PROBES=1000
+SIZES="1 2 4 8 16"
+P2U_COUNTS="2 4 8"
+U2P_COUNTS="2 4"
+BURSTS="1 4 16"
+CHANNELS="auto manual"
+COSTS=
+DATA_MODES=gpif
+SET_DATA=
+PATTERN=constant
+PREFIX=fx3sweep
+
+usage()
+{
+    echo "usage: $0 [-M] [-T both|throughput|latency] [-t seconds] [-n probes]" >&2
+    echo "       [-S sizes] [-P p2u_counts] [-U u2p_counts] [-B bursts] [-C channel_types]" >&2
+    echo "       [-W worker_costs] [-D data_modes] [-V pattern] [-o prefix]" >&2
+    exit 2
+}
+
+while getopts "MT:t:n:S:P:U:B:C:W:D:V:o:" opt; do
+    case $opt in
+    M) SUFFIX=-model ;;
+    T) TESTS=$OPTARG ;;
+    t) DURATION=$OPTARG ;;
+    n) PROBES=$OPTARG ;;
+    S) SIZES=$OPTARG ;;
+    P) P2U_COUNTS=$OPTARG ;;
+    U) U2P_COUNTS=$OPTARG ;;
+    B) BURSTS=$OPTARG ;;
+    C) CHANNELS=$OPTARG ;;
+    W) COSTS=$OPTARG ;;
+    D) DATA_MODES=$OPTARG SET_DATA=1 ;;
+    V) PATTERN=$OPTARG ;;
+    o) PREFIX=$OPTARG ;;
+    *) usage ;;
+    esac
+done
+
+case $TESTS in
+both|throughput|latency) ;;
+*) usage ;;
+esac
+case $PATTERN in
+constant|counter) ;;
+*) usage ;;
+esac
+
+# The model keeps the configuration set by fx3config for the tools run after it.
+if [ -n "$SUFFIX" ]; then
+    FX3_MODEL_STATE=$(mktemp) || exit 1
+    export FX3_MODEL_STATE
+    trap 'rm -f "$FX3_MODEL_STATE"' EXIT
+fi
+
+# configure profile: set the current combination with the given profile.
+configure()
+{
+    "$DIR/fx3config$SUFFIX" -p "$1" -m "$channels" -g "$size,$p2u,$u2p" -B "$burst" \
+        ${cost:+-c "$cost"} ${SET_DATA:+-d "$data" -P "$PATTERN"} > /dev/null 2>&1
+}
+
+# Throughput in MB/s, with transfers of at least 256 KB: OUT in sink mode, IN
+# otherwise. The source pattern is checked; pattern errors print nothing.
+throughput()
+{
+    case $data in
+    sink) dir=out check= ;;
+    source*) dir=in check=$PATTERN ;;
+    *) dir=in check= ;;
+    esac
+    "$DIR/fx3stream$SUFFIX" -d "$dir" -t "$DURATION" -b $(( (256 + size - 1) / size )) \
+        ${check:+-v "$check"} 2> /dev/null |
+        awk -v dir="$dir:" '
+        $1 == dir && $3 == "bytes" { mbps = $7 }
+        $1 == dir && $3 == "pattern" { errors = $2 }
+        END { if (mbps != "" && errors + 0 == 0) print mbps }'
+}
+
+# p50, p99 and p99.9 round trip of one DMA buffer in us.
+latency()
+{
+    "$DIR/fx3latency$SUFFIX" -s $(( size * 1024 )) -n "$PROBES" -L 1 2> /dev/null |
+        awk '{
+            for (i = 1; i < NF; i++)
+            {
+                if ($i == "p50") p50 = $(i + 1)
+                if ($i == "p99") p99 = $(i + 1)
+                if ($i == "p99.9") p999 = $(i + 1)
+            }
+        }
+        END { if (p50 != "") print p50, p99, p999 }'
+}
+
+CSV=$PREFIX.csv
+echo "buf_packets,buf_bytes,count_p2u,count_u2p,burst,channels,buffer_kb,status,mbps,p50_us,p99_us,p999_us,worker_cost,data_mode" > "$CSV"
+
+# Without -W one pass with cost empty, which leaves the cost of the device alone.
+for data in $DATA_MODES; do
+for cost in ${COSTS:--}; do
+[ "$cost" = - ] && cost=
+for channels in $CHANNELS; do
+for burst in $BURSTS; do
+for size in $SIZES; do
+for p2u in $P2U_COUNTS; do
+for u2p in $U2P_COUNTS; do
+    status=ok
+    mbps=
+    p50=
+    p99=
+    p999=
+
+    if [ "$TESTS" != latency ]; then
+        if ! configure stream; then
+            status=rejected
+        else
+            mbps=$(throughput)
+            [ -n "$mbps" ] || status=error
+        fi
+    fi
+    if [ "$TESTS" != throughput ] && [ "$status" = ok ] && [ "$data" = gpif ]; then
+        if ! configure loopback; then
+            status=rejected
+        else
+            set -- $(latency)
+            if [ $# -eq 3 ]; then
+                p50=$1 p99=$2 p999=$3
+            else
+                status=error
+            fi
+        fi
+    fi
+
+    printf '%s: size %s, %s P2U, %s U2P, burst %s, %s%s, %s: %s MB/s, p99 %s us\n' "$status" \
+        "$size" "$p2u" "$u2p" "$burst" "$channels" "${cost:+, cost $cost}" "$data" \
+        "${mbps:--}" "${p99:--}" >&2
+    echo "$size,$((size * 1024)),$p2u,$u2p,$burst,$channels,$((size * (p2u + u2p))),$status,$mbps,$p50,$p99,$p999,$cost,$data" >> "$CSV"
+done
+done
+done
+done
+done
+done
+done
+
+# Leave the device in normal operation.
+if [ -n "$SET_DATA" ]; then
+    "$DIR/fx3config$SUFFIX" -d gpif > /dev/null 2>&1
+fi
+
+# JSON: one object per row, empty fields as null.
+awk -F, '
+NR == 1 { n = split($0, key, ","); print "["; next }
+{
+    line = "  {"
+    for (i = 1; i <= n; i++)
+    {
+        if ($i == "")
+            v = "null"
+        else if ($i ~ /^[0-9.]+$/)
+            v = $i
+        else
+            v = "\"" $i "\""
+        line = line sprintf("%s\"%s\": %s", (i > 1) ? ", " : "", key[i], v)
+    }
+    if (rows++)
+        print prev ","
+    prev = line "}"
+}
+END { if (rows) print prev; print "]" }' "$CSV" > "$PREFIX.json"
+
+# Pareto frontier of the measured rows. A row is dominated if another one of
+# the same data mode is at least as good in every measured metric and better
+# in one; the link test modes measure something else than the GPIF path.
+awk -F, '
+BEGIN { n = 0 }
+NR == 1 { header = $0; next }
+$8 == "ok" { row[n] = $0; mbps[n] = $9; p99[n] = $11; kb[n] = $7; data[n] = $14; n++ }
+function no_worse(a, b)
+{
+    return data[a] == data[b] && (mbps[a] == "" || mbps[a] + 0 >= mbps[b] + 0) &&
+           (p99[a] == "" || p99[a] + 0 <= p99[b] + 0) && kb[a] + 0 <= kb[b] + 0
+}
+function better(a, b)
+{
+    return (mbps[a] != "" && mbps[a] + 0 > mbps[b] + 0) ||
+           (p99[a] != "" && p99[a] + 0 < p99[b] + 0) || kb[a] + 0 < kb[b] + 0
+}
+END {
+    print header
+    for (i = 0; i < n; i++)
+    {
+        dominated = 0
+        for (j = 0; j < n && !dominated; j++)
+            if (j != i && no_worse(j, i) && better(j, i))
+                dominated = 1
+        if (!dominated)
+            print row[i]
+    }
+}' "$CSV" > "$PREFIX.pareto.csv"
+
+echo "Pareto frontier ($(($(wc -l < "$PREFIX.pareto.csv") - 1)) of $(($(wc -l < "$CSV") - 1)) combinations):"
+awk -F, 'NR > 1 {
+    printf "  %6d B x %2d P2U + %2d U2P (%4d KB)  burst %2d  %-6s  %-11s  %8s MB/s  p99 %9s us\n",
+        $2, $3, $4, $7, $5, $6, $14, ($9 == "") ? "-" : $9, ($11 == "") ? "-" : $11
+}' "$PREFIX.pareto.csv"
+if [ -n "$COSTS" ]; then
+    echo "Throughput per worker cost:"
+    awk -F, 'NR > 1 && $8 == "ok" && $9 != "" {
+        if (!($13 in best)) order[n++] = $13
+        if (!($13 in best) || $9 + 0 > best[$13] + 0)
+        {
+            best[$13] = $9
+            row[$13] = sprintf("%d B x %d P2U, burst %d, %s", $2, $3, $5, $6)
+        }
+    }
+    END {
+        for (i = 0; i < n; i++)
+            printf "  %5s passes  %8s MB/s  (%s)\n", order[i], best[order[i]], row[order[i]]
+    }' "$CSV"
+fi
+echo "Results in $CSV, $PREFIX.json and $PREFIX.pareto.csv"
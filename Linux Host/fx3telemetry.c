@@ -0,0 +1,234 @@
+/*
+ ## fx3telemetry: live throughput from the telemetry counters of the FX3
+ ## ===========================
+ ##
+ ##  Polls CY_FX_RQT_GET_TELEMETRY, by default every 10 ms (100 Hz), and prints
+ ##  the P2U and U2P rate in MB/s (10^6 bytes per second) once per print
+ ##  interval. The rates are computed from the byte counters and the device
+ ##  timestamp (us) of successive snapshots, so USB scheduling jitter on the
+ ##  host does not show up in them. Next to the average over the print interval
+ ##  the lowest and highest rate seen between two polls are printed, which shows
+ ##  stalls too short for a 1 s average. The P2U inter-buffer interval
+ ##  statistics (us), the GPIF error counters and the recoveries, with the
+ ##  failed state machine starts among them, follow on the same line. With the
+ ##  loopback CRC check on (fx3config -k on) the check points passed and the
+ ##  mismatches are added, with the CRCs of the last mismatch. Once the firmware
+ ##  has measured them, the longest U1 and U2 exit latencies (us) end the line;
+ ##  build the firmware with them (make U1_EXIT=us U2_EXIT=us) to report them
+ ##  in the BOS descriptor from the first enumeration on.
+ ##
+ ##  Usage: fx3telemetry [-i poll_ms] [-p print_ms] [-t seconds] [-c]
+ ##
+ ##  -c  clear the device counters with every printed line, so the interval
+ ##      statistics cover the last print interval instead of the whole run
+ ##
+ ##  The byte counters only move with MANUAL channels (fx3config -m manual).
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include "fx3host.h"
+
+static volatile sig_atomic_t stop = 0;
+
+/* Rate of one direction over the print interval and between two polls */
+typedef struct telemetry_rate
+{
+    uint64_t window_bytes;      /* Counter at the start of the print interval */
+    uint64_t last_bytes;        /* Counter at the previous poll */
+    double min;                 /* Lowest poll to poll rate in the print interval */
+    double max;                 /* Highest poll to poll rate in the print interval */
+} telemetry_rate;
+
+static void on_signal(int sig)
+{
+    (void) sig;
+    stop = 1;
+}
+
+static void rate_restart(telemetry_rate *rate, uint64_t bytes)
+{
+    rate->window_bytes = bytes;
+    rate->last_bytes = bytes;
+    rate->min = -1;
+    rate->max = 0;
+}
+
+/* Account for one poll; dt is the device time since the previous poll in us.
+ * Bytes per us are MB/s. */
+static void rate_sample(telemetry_rate *rate, uint64_t bytes, uint32_t dt)
+{
+    double mbps;
+
+    if (dt != 0)
+    {
+        mbps = (double) (bytes - rate->last_bytes) / dt;
+        if ((rate->min < 0) || (mbps < rate->min))
+            rate->min = mbps;
+        if (mbps > rate->max)
+            rate->max = mbps;
+    }
+    rate->last_bytes = bytes;
+}
+
+static void rate_print(const char *name, const telemetry_rate *rate, uint64_t bytes,
+        uint32_t window_us)
+{
+    printf("  %s %8.2f MB/s (%7.2f..%7.2f)", name,
+            window_us ? (double) (bytes - rate->window_bytes) / window_us : 0.0,
+            (rate->min < 0) ? 0.0 : rate->min, rate->max);
+}
+
+static void sleep_until(double when)
+{
+    struct timespec ts;
+    double delay = when - fx3_now();
+
+    if (delay <= 0)
+        return;
+    ts.tv_sec = (time_t) delay;
+    ts.tv_nsec = (long) ((delay - ts.tv_sec) * 1e9);
+    nanosleep(&ts, NULL);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-i poll_ms] [-p print_ms] [-t seconds] [-c]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    libusb_context *ctx = NULL;
+    libusb_device_handle *dev;
+    fx3_telemetry tel;
+    telemetry_rate p2u, u2p;
+    unsigned poll = 10, print = 1000, seconds = 0;
+    uint32_t window_start, last_timestamp;
+    double start, next, last_print, now;
+    int clear = 0, opt, status = 0, i;
+    unsigned long overruns, underruns;
+
+    while ((opt = getopt(argc, argv, "i:p:t:c")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            poll = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            print = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            seconds = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            clear = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if ((poll == 0) || (print < poll))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (libusb_init(&ctx) != 0)
+        return 1;
+    dev = fx3_open(ctx);
+    if (dev == NULL)
+    {
+        libusb_exit(ctx);
+        return 1;
+    }
+
+    status = fx3_get_telemetry(dev, &tel, clear);
+    if (status != 0)
+    {
+        fprintf(stderr, "Reading the telemetry failed: %s\n", libusb_error_name(status));
+        fx3_close(dev);
+        libusb_exit(ctx);
+        return 1;
+    }
+    if (clear)
+        tel.bytesPtoU = tel.bytesUtoP = 0;
+    rate_restart(&p2u, tel.bytesPtoU);
+    rate_restart(&u2p, tel.bytesUtoP);
+    window_start = last_timestamp = tel.timestamp;
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    start = last_print = next = fx3_now();
+    while (!stop)
+    {
+        next += poll / 1000.0;
+        sleep_until(next);
+        now = fx3_now();
+        if ((seconds != 0) && (now - start >= seconds))
+            stop = 1;
+
+        /* The counters are only cleared on the poll that ends a print interval. */
+        status = fx3_get_telemetry(dev, &tel,
+                clear && (stop || ((now - last_print) * 1000 >= print)));
+        if (status != 0)
+        {
+            fprintf(stderr, "Reading the telemetry failed: %s\n", libusb_error_name(status));
+            status = 1;
+            break;
+        }
+        rate_sample(&p2u, tel.bytesPtoU, tel.timestamp - last_timestamp);
+        rate_sample(&u2p, tel.bytesUtoP, tel.timestamp - last_timestamp);
+        last_timestamp = tel.timestamp;
+
+        /* Fell behind (e.g. the process was stopped): poll again right away. */
+        if (next < now)
+            next = now;
+        if (!stop && ((now - last_print) * 1000 < print))
+            continue;
+
+        overruns = underruns = 0;
+        for (i = 0; i < 4; i++)
+        {
+            overruns += tel.overrun[i];
+            underruns += tel.underrun[i];
+        }
+        printf("%8.1f s", now - start);
+        rate_print("in", &p2u, tel.bytesPtoU, tel.timestamp - window_start);
+        rate_print("out", &u2p, tel.bytesUtoP, tel.timestamp - window_start);
+        printf("  interval %u/%u/%u us  overruns %lu underruns %lu  recoveries %u",
+                tel.intervalMin, tel.intervalAvg, tel.intervalMax, overruns, underruns,
+                tel.recoveries);
+        if (tel.gpifStartFail != 0)
+            printf(" (%u failed starts)", tel.gpifStartFail);
+        if (tel.crcChecked != 0)
+        {
+            printf("  crc %u checked %u mismatches", tel.crcChecked, tel.crcMismatch);
+            if (tel.crcMismatch != 0)
+                printf(" (last 0x%08x, expected 0x%08x)", tel.crcActual, tel.crcExpected);
+        }
+        if ((tel.lpmExitU1 != 0) || (tel.lpmExitU2 != 0))
+            printf("  U1/U2 exit %u/%u us", tel.lpmExitU1, tel.lpmExitU2);
+        printf("\n");
+        fflush(stdout);
+
+        if (clear)
+            tel.bytesPtoU = tel.bytesUtoP = 0;
+        rate_restart(&p2u, tel.bytesPtoU);
+        rate_restart(&u2p, tel.bytesUtoP);
+        window_start = tel.timestamp;
+        last_print = now;
+    }
+
+    fx3_close(dev);
+    libusb_exit(ctx);
+    return status;
+}
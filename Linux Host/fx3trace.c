@@ -0,0 +1,287 @@
+/*
+ ## fx3trace: drain and decode the binary event trace of the FX3 firmware
+ ## ===========================
+ ##
+ ##  Polls CY_FX_RQT_GET_TRACE and prints one line per event: device time and
+ ##  time since the previous event in us, sequence number, event name and
+ ##  arguments.
+ ##  Gaps in the sequence numbers (records dropped on a full ring, or events
+ ##  recorded while they were masked out) are reported inline.
+ ##
+ ##  Usage: fx3trace [-m mask] [-i interval_ms] [-t seconds] [-w raw_file]
+ ##         fx3trace -r raw_file
+ ##
+ ##  -w saves the undecoded responses, so a capture can be taken with as little
+ ##  host overhead as possible and decoded later with -r.
+ ## ===========================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include "fx3host.h"
+
+static volatile sig_atomic_t stop = 0;
+
+typedef struct trace_state
+{
+    int have_last;
+    uint16_t last_sequence;
+    uint32_t last_timestamp;
+    unsigned long events;
+    unsigned long lost;
+} trace_state;
+
+static const char *event_name(uint16_t event)
+{
+    switch (event)
+    {
+    case FX3_TRACE_UTOP_BUF:        return "UTOP_BUF";
+    case FX3_TRACE_PTOU_BUF:        return "PTOU_BUF";
+    case FX3_TRACE_PTOU_EMPTY:      return "PTOU_EMPTY";
+    case FX3_TRACE_PIB_ERROR:       return "PIB_ERROR";
+    case FX3_TRACE_PIB_OTHER:       return "PIB_OTHER";
+    case FX3_TRACE_PIB_RECOVERY:    return "PIB_RECOVERY";
+    case FX3_TRACE_WRAPUP:          return "WRAPUP";
+    case FX3_TRACE_USB_EVENT:       return "USB_EVENT";
+    case FX3_TRACE_DMA_START:       return "DMA_START";
+    case FX3_TRACE_DMA_STOP:        return "DMA_STOP";
+    case FX3_TRACE_WORKER_QUEUE:    return "WORKER_QUEUE";
+    default:                        return "UNKNOWN";
+    }
+}
+
+static void print_args(const fx3_trace_record *rec)
+{
+    switch (rec->event)
+    {
+    case FX3_TRACE_UTOP_BUF:
+    case FX3_TRACE_PTOU_BUF:
+        printf("bytes=%u status=%u", rec->arg0, rec->arg1);
+        break;
+    case FX3_TRACE_PIB_ERROR:
+        printf("thread=%u %s", rec->arg0, rec->arg1 ? "overrun" : "underrun");
+        break;
+    case FX3_TRACE_PIB_OTHER:
+        printf("error=0x%x", rec->arg0);
+        break;
+    case FX3_TRACE_PIB_RECOVERY:
+        printf("threads=0x%x", rec->arg0);
+        break;
+    case FX3_TRACE_USB_EVENT:
+        printf("type=%u data=0x%x", rec->arg0, rec->arg1);
+        break;
+    case FX3_TRACE_DMA_START:
+        printf("buffer=%u p2u=%u u2p=%u", rec->arg0, rec->arg1 & 0xFFFF, rec->arg1 >> 16);
+        break;
+    case FX3_TRACE_WORKER_QUEUE:
+        printf("%s bytes=%u", rec->arg0 ? "p2u" : "u2p", rec->arg1);
+        break;
+    case FX3_TRACE_PTOU_EMPTY:
+    case FX3_TRACE_WRAPUP:
+    case FX3_TRACE_DMA_STOP:
+        break;
+    default:
+        printf("event=%u arg0=0x%x arg1=0x%x", rec->event, rec->arg0, rec->arg1);
+        break;
+    }
+}
+
+static void decode_record(trace_state *st, const fx3_trace_record *rec)
+{
+    uint16_t gap;
+
+    if (st->have_last)
+    {
+        gap = (uint16_t) (rec->sequence - st->last_sequence - 1);
+        if (gap != 0)
+        {
+            printf("%*s-- %u events not recorded --\n", 33, "", gap);
+            st->lost += gap;
+        }
+    }
+
+    printf("%10u us %+9d  #%5u  %-13s ", rec->timestamp,
+            st->have_last ? (int32_t) (rec->timestamp - st->last_timestamp) : 0,
+            rec->sequence, event_name(rec->event));
+    print_args(rec);
+    printf("\n");
+
+    st->have_last = 1;
+    st->last_sequence = rec->sequence;
+    st->last_timestamp = rec->timestamp;
+    st->events++;
+}
+
+/* Decode one GET_TRACE response. Returns the number of records it held, or
+ * -1 if the response is malformed. */
+static int decode_response(trace_state *st, const uint8_t *buf, int len)
+{
+    const fx3_trace_header *hdr = (const fx3_trace_header *) buf;
+    fx3_trace_record rec;
+    int i;
+
+    if ((len < (int) sizeof(*hdr)) || (hdr->recordSize != sizeof(rec))
+            || (len < (int) (sizeof(*hdr) + hdr->recordCount * sizeof(rec))))
+        return -1;
+
+    if (hdr->dropped != 0)
+        printf("%*s-- ring full, %u records dropped --\n", 33, "", hdr->dropped);
+
+    for (i = 0; i < hdr->recordCount; i++)
+    {
+        memcpy(&rec, buf + sizeof(*hdr) + i * sizeof(rec), sizeof(rec));
+        decode_record(st, &rec);
+    }
+
+    return hdr->recordCount;
+}
+
+static int decode_file(const char *path)
+{
+    trace_state st;
+    fx3_trace_header hdr;
+    uint8_t buf[FX3_EP0_BUFFER_SIZE];
+    size_t body;
+    FILE *f;
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+
+    memset(&st, 0, sizeof(st));
+    while (fread(&hdr, sizeof(hdr), 1, f) == 1)
+    {
+        body = (size_t) hdr.recordCount * hdr.recordSize;
+        if ((hdr.recordSize != sizeof(fx3_trace_record)) || (sizeof(hdr) + body > sizeof(buf)))
+        {
+            fprintf(stderr, "%s: bad trace header\n", path);
+            break;
+        }
+        memcpy(buf, &hdr, sizeof(hdr));
+        if (fread(buf + sizeof(hdr), 1, body, f) != body)
+        {
+            fprintf(stderr, "%s: truncated\n", path);
+            break;
+        }
+        decode_response(&st, buf, (int) (sizeof(hdr) + body));
+    }
+
+    fclose(f);
+    printf("%lu events, %lu not recorded\n", st.events, st.lost);
+    return 0;
+}
+
+static void on_signal(int sig)
+{
+    (void) sig;
+    stop = 1;
+}
+
+int main(int argc, char **argv)
+{
+    libusb_context *ctx = NULL;
+    libusb_device_handle *dev;
+    trace_state st;
+    uint8_t buf[FX3_EP0_BUFFER_SIZE];
+    const fx3_trace_header *hdr = (const fx3_trace_header *) buf;
+    const char *raw_path = NULL;
+    FILE *raw = NULL;
+    long mask = -1;
+    unsigned interval = 100;
+    unsigned seconds = 0;
+    time_t end = 0;
+    int opt, len;
+
+    while ((opt = getopt(argc, argv, "m:i:t:w:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            mask = strtol(optarg, NULL, 0);
+            break;
+        case 'i':
+            interval = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            seconds = (unsigned) strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            raw_path = optarg;
+            break;
+        case 'r':
+            return decode_file(optarg);
+        default:
+            fprintf(stderr, "usage: %s [-m mask] [-i interval_ms] [-t seconds] [-w raw_file]\n"
+                    "       %s -r raw_file\n", argv[0], argv[0]);
+            return 2;
+        }
+    }
+
+    if (libusb_init(&ctx) != 0)
+        return 1;
+    dev = fx3_open(ctx);
+    if (dev == NULL)
+    {
+        libusb_exit(ctx);
+        return 1;
+    }
+
+    if (raw_path != NULL)
+    {
+        raw = fopen(raw_path, "wb");
+        if (raw == NULL)
+        {
+            perror(raw_path);
+            fx3_close(dev);
+            libusb_exit(ctx);
+            return 1;
+        }
+    }
+
+    if ((mask >= 0) && (fx3_vendor_out(dev, FX3_RQT_SET_TRACE_MASK, (uint16_t) mask, 0) != 0))
+        fprintf(stderr, "Setting the trace mask failed, is the trace enabled in the firmware?\n");
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    if (seconds != 0)
+        end = time(NULL) + seconds;
+
+    memset(&st, 0, sizeof(st));
+    while (!stop && ((end == 0) || (time(NULL) < end)))
+    {
+        len = fx3_vendor_in(dev, FX3_RQT_GET_TRACE, 0, 0, buf, sizeof(buf));
+        if (len < 0)
+        {
+            fprintf(stderr, "GET_TRACE failed: %s\n", libusb_error_name(len));
+            break;
+        }
+
+        if (decode_response(&st, buf, len) < 0)
+        {
+            fprintf(stderr, "Malformed trace response (%d bytes)\n", len);
+            break;
+        }
+        if ((raw != NULL) && (hdr->recordCount != 0 || hdr->dropped != 0))
+            fwrite(buf, 1, len, raw);
+        fflush(stdout);
+
+        /* Keep reading while the ring has more; sleep once it is drained. */
+        if (hdr->pending == 0)
+            usleep(interval * 1000);
+    }
+
+    printf("%lu events, %lu not recorded\n", st.events, st.lost);
+
+    if (raw != NULL)
+        fclose(raw);
+    fx3_close(dev);
+    libusb_exit(ctx);
+    return 0;
+}
@@ -0,0 +1,307 @@
+/*
+ ## Data pattern checker for the FX3 slave FIFO streams
+ ## ===========================
+ ##
+ ##  The vector code only answers "is this block clean": it runs over the
+ ##  buffer until a vector holds a word that does not match, and the scalar
+ ##  code then checks the next VERIFY_SLOW_WORDS words one by one, counting the
+ ##  errors and recording the first. Clean data therefore runs at the speed of
+ ##  the vector loop, and a burst of errors costs no more than scalar code.
+ ##
+ ##  For every pattern the expected word follows from the word before it:
+ ##  constant  c
+ ##  counter   prev + 1
+ ##  prbs31    ((prev << 4) | (cur >> 28)) ^ ((prev << 1) | (cur >> 31)), i.e. the
+ ##            recurrence s[n] = s[n-28] ^ s[n-31] on the bits of prev and cur
+ ##
+ ##  The vector code compares each word with the one expected from the word
+ ##  received before it. The scalar code instead generates the expected word
+ ##  from the last good (or expected) word alone, as fx3_pattern_fill does, so
+ ##  that a corrupted word is not also blamed for the word after it.
+ ## ===========================
+ */
+
+#include <string.h>
+#include "fx3verify.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VERIFY_X86
+#endif
+
+#define VERIFY_SLOW_WORDS       (64)
+
+/* Index of the first vector at or after word i (i >= 1) that holds a
+ * mismatch, or the index from where fewer than a vector of words is left. */
+typedef size_t (*scan_fn)(int pattern, uint32_t constant, const uint8_t *buf, size_t i, size_t n);
+
+static inline uint32_t load_word(const uint8_t *buf, size_t i)
+{
+    uint32_t word;
+
+    memcpy(&word, buf + i * 4, sizeof(word));
+    return word;
+}
+
+static inline uint32_t expected_word(int pattern, uint32_t constant, uint32_t prev, uint32_t cur)
+{
+    switch (pattern)
+    {
+    case FX3_PATTERN_COUNTER:
+        return prev + 1;
+    case FX3_PATTERN_PRBS31:
+        return ((prev << 4) | (cur >> 28)) ^ ((prev << 1) | (cur >> 31));
+    default:
+        return constant;
+    }
+}
+
+/* The word that follows prev in the pattern, computed from prev alone. For
+ * PRBS31 the top 28 bits only depend on prev; the low 4 bits also depend on
+ * the top 4 bits of the new word, which hi already has. */
+static inline uint32_t next_word(int pattern, uint32_t constant, uint32_t prev)
+{
+    uint32_t hi;
+
+    switch (pattern)
+    {
+    case FX3_PATTERN_COUNTER:
+        return prev + 1;
+    case FX3_PATTERN_PRBS31:
+        hi = (prev << 4) ^ (prev << 1);
+        return hi ^ (hi >> 28) ^ (hi >> 31);
+    default:
+        return constant;
+    }
+}
+
+static size_t scan_scalar(int pattern, uint32_t constant, const uint8_t *buf, size_t i, size_t n)
+{
+    uint32_t prev = load_word(buf, i - 1);
+    uint32_t cur;
+
+    for (; i < n; i++)
+    {
+        cur = load_word(buf, i);
+        if (cur != expected_word(pattern, constant, prev, cur))
+            break;
+        prev = cur;
+    }
+    return i;
+}
+
+#ifdef VERIFY_X86
+
+__attribute__ ((target("sse2")))
+static size_t scan_sse2(int pattern, uint32_t constant, const uint8_t *buf, size_t i, size_t n)
+{
+    const __m128i c = _mm_set1_epi32((int) constant);
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i cur, prev, exp;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        cur = _mm_loadu_si128((const __m128i *) (buf + i * 4));
+        if (pattern == FX3_PATTERN_CONSTANT)
+            exp = c;
+        else
+        {
+            prev = _mm_loadu_si128((const __m128i *) (buf + i * 4 - 4));
+            if (pattern == FX3_PATTERN_COUNTER)
+                exp = _mm_add_epi32(prev, one);
+            else
+                exp = _mm_xor_si128(
+                        _mm_or_si128(_mm_slli_epi32(prev, 4), _mm_srli_epi32(cur, 28)),
+                        _mm_or_si128(_mm_slli_epi32(prev, 1), _mm_srli_epi32(cur, 31)));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(cur, exp)) != 0xFFFF)
+            break;
+    }
+    return i;
+}
+
+__attribute__ ((target("avx2")))
+static size_t scan_avx2(int pattern, uint32_t constant, const uint8_t *buf, size_t i, size_t n)
+{
+    const __m256i c = _mm256_set1_epi32((int) constant);
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i cur, prev, exp;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        cur = _mm256_loadu_si256((const __m256i *) (buf + i * 4));
+        if (pattern == FX3_PATTERN_CONSTANT)
+            exp = c;
+        else
+        {
+            prev = _mm256_loadu_si256((const __m256i *) (buf + i * 4 - 4));
+            if (pattern == FX3_PATTERN_COUNTER)
+                exp = _mm256_add_epi32(prev, one);
+            else
+                exp = _mm256_xor_si256(
+                        _mm256_or_si256(_mm256_slli_epi32(prev, 4), _mm256_srli_epi32(cur, 28)),
+                        _mm256_or_si256(_mm256_slli_epi32(prev, 1), _mm256_srli_epi32(cur, 31)));
+        }
+        if ((unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi32(cur, exp)) != 0xFFFFFFFFu)
+            break;
+    }
+    return i;
+}
+
+#endif /* VERIFY_X86 */
+
+static int verify_impl = FX3_VERIFY_SCALAR;
+static scan_fn verify_scan = NULL;
+
+int fx3_verify_select(int impl)
+{
+    int best = FX3_VERIFY_SCALAR;
+
+#ifdef VERIFY_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        best = FX3_VERIFY_SSE2;
+    if (__builtin_cpu_supports("avx2"))
+        best = FX3_VERIFY_AVX2;
+#endif
+
+    if ((impl == FX3_VERIFY_AUTO) || (impl > best))
+        impl = best;
+
+    verify_impl = impl;
+    switch (impl)
+    {
+#ifdef VERIFY_X86
+    case FX3_VERIFY_SSE2:
+        verify_scan = scan_sse2;
+        break;
+    case FX3_VERIFY_AVX2:
+        verify_scan = scan_avx2;
+        break;
+#endif
+    default:
+        verify_scan = scan_scalar;
+        break;
+    }
+    return impl;
+}
+
+const char *fx3_verify_impl_name(int impl)
+{
+    switch (impl)
+    {
+    case FX3_VERIFY_SCALAR:     return "scalar";
+    case FX3_VERIFY_SSE2:       return "sse2";
+    case FX3_VERIFY_AVX2:       return "avx2";
+    default:                    return "auto";
+    }
+}
+
+int fx3_pattern_parse(const char *name)
+{
+    if (strcmp(name, "constant") == 0)
+        return FX3_PATTERN_CONSTANT;
+    if (strcmp(name, "counter") == 0)
+        return FX3_PATTERN_COUNTER;
+    if (strcmp(name, "prbs31") == 0)
+        return FX3_PATTERN_PRBS31;
+    return -1;
+}
+
+const char *fx3_pattern_name(int pattern)
+{
+    switch (pattern)
+    {
+    case FX3_PATTERN_CONSTANT:  return "constant";
+    case FX3_PATTERN_COUNTER:   return "counter";
+    case FX3_PATTERN_PRBS31:    return "prbs31";
+    default:                    return "unknown";
+    }
+}
+
+void fx3_pattern_fill(int pattern, uint32_t constant, uint32_t *state, void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *) buf;
+    uint32_t word = *state;
+    size_t i;
+
+    for (i = 0; i < len / 4; i++)
+    {
+        word = next_word(pattern, constant, word);
+        memcpy(p + i * 4, &word, sizeof(word));
+    }
+    memset(p + i * 4, 0, len & 3);
+    *state = word;
+}
+
+void fx3_verify_init(fx3_verifier *v, int pattern, uint32_t constant)
+{
+    memset(v, 0, sizeof(*v));
+    v->pattern = pattern;
+    v->constant = constant;
+    if (verify_scan == NULL)
+        fx3_verify_select(FX3_VERIFY_AUTO);
+}
+
+/* Check one word against the one that follows v->prev. After a wrong word the
+ * next one is also accepted if it follows the wrong word (v->alt): then the
+ * stream has jumped and the checker resynchronises on it. */
+static void check_word(fx3_verifier *v, uint32_t cur, unsigned long long offset)
+{
+    uint32_t exp = next_word(v->pattern, v->constant, v->prev);
+
+    if ((cur == exp) || (v->have_alt && (cur == next_word(v->pattern, v->constant, v->alt))))
+    {
+        v->prev = cur;
+        v->have_alt = 0;
+        return;
+    }
+
+    if (v->errors == 0)
+    {
+        v->first_offset = offset;
+        v->first_expected = exp;
+        v->first_actual = cur;
+    }
+    v->errors++;
+    v->prev = exp;
+    v->alt = cur;
+    v->have_alt = 1;
+}
+
+void fx3_verify(fx3_verifier *v, const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *) buf;
+    size_t n = len / 4;
+    size_t i, start, end;
+
+    if (n != 0)
+    {
+        /* The first word of the stream only seeds the counter and PRBS checks. */
+        if (v->have_prev || (v->pattern == FX3_PATTERN_CONSTANT))
+            check_word(v, load_word(p, 0), v->bytes);
+        else
+            v->prev = load_word(p, 0);
+        v->have_prev = 1;
+
+        i = 1;
+        while (i < n)
+        {
+            /* Words the vector code passes follow the words received before
+             * them, so the scalar check goes on from the last of them. */
+            start = i;
+            i = verify_scan(v->pattern, v->constant, p, i, n);
+            if (i != start)
+            {
+                v->prev = load_word(p, i - 1);
+                v->have_alt = 0;
+            }
+
+            end = (i + VERIFY_SLOW_WORDS < n) ? i + VERIFY_SLOW_WORDS : n;
+            for (; i < end; i++)
+                check_word(v, load_word(p, i), v->bytes + i * 4);
+        }
+    }
+
+    v->bytes += len;
+}
@@ -0,0 +1,81 @@
+/*
+ ## Data pattern checker for the FX3 slave FIFO streams
+ ## ===========================
+ ##
+ ##  The stream is checked as little endian 32 bit words. Every word is compared
+ ##  with the value expected from the pattern and, for the counter and PRBS
+ ##  patterns, from the word before it, so the checker locks onto the stream
+ ##  from its first word and resynchronises by itself after an error:
+ ##
+ ##  constant  every word is the constant; the FPGA "MW" word 0x574D is checked
+ ##            as 0x574D574D
+ ##  counter   every word is its predecessor plus one, as sent by the firmware
+ ##            pattern source (CY_FX_SLFIFO_PATTERN_COUNTER)
+ ##  prbs31    PRBS31 (x^31 + x^28 + 1), 32 bits per word, first bit in the MSB
+ ##
+ ##  A word that is not the expected one counts as one error. The check then
+ ##  goes on from the expected word, so a corrupted word in a counter or PRBS
+ ##  stream counts once; if the next word follows from the received one
+ ##  instead, the stream has jumped (data was lost) and the checker
+ ##  resynchronises on it. The checks use AVX2 or SSE2 where the CPU has them.
+ ## ===========================
+ */
+
+#ifndef _INCLUDED_FX3VERIFY_H_
+#define _INCLUDED_FX3VERIFY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FX3_PATTERN_CONSTANT            (0)
+#define FX3_PATTERN_COUNTER             (1)
+#define FX3_PATTERN_PRBS31              (2)
+
+#define FX3_PATTERN_MW                  (0x574D574D)
+
+/* Implementations, for fx3_verify_select */
+#define FX3_VERIFY_AUTO                 (0)
+#define FX3_VERIFY_SCALAR               (1)
+#define FX3_VERIFY_SSE2                 (2)
+#define FX3_VERIFY_AVX2                 (3)
+
+typedef struct fx3_verifier
+{
+    int pattern;
+    uint32_t constant;
+    int have_prev;                  /* prev holds the last word checked */
+    uint32_t prev;                  /* Last word checked, or the expected one if it was wrong */
+    int have_alt;                   /* The last word was wrong; alt holds the received one */
+    uint32_t alt;
+
+    unsigned long long bytes;       /* Bytes checked, including a partial last word */
+    unsigned long long errors;      /* Words that did not match */
+    unsigned long long first_offset;    /* Byte offset of the first error */
+    uint32_t first_expected;
+    uint32_t first_actual;
+} fx3_verifier;
+
+/* Parse a pattern name (constant, counter, prbs31). Returns -1 if unknown. */
+extern int fx3_pattern_parse(const char *name);
+
+extern const char *fx3_pattern_name(int pattern);
+
+/* Fill buf with len bytes of the pattern. *state is the last word generated and
+ * is updated, so consecutive calls continue the stream; for PRBS31 it must not
+ * be 0. */
+extern void fx3_pattern_fill(int pattern, uint32_t constant, uint32_t *state,
+        void *buf, size_t len);
+
+/* Select the implementation. Returns the one in use, which is the best the CPU
+ * has if the requested one is not available. */
+extern int fx3_verify_select(int impl);
+
+extern const char *fx3_verify_impl_name(int impl);
+
+extern void fx3_verify_init(fx3_verifier *v, int pattern, uint32_t constant);
+
+/* Check the next len bytes of the stream. The buffers have to hold whole
+ * words; the bytes of a partial last word are counted but not checked. */
+extern void fx3_verify(fx3_verifier *v, const void *buf, size_t len);
+
+#endif /* _INCLUDED_FX3VERIFY_H_ */